@@ -18,15 +18,28 @@
 #include <ESPAsyncWebServer.h>
 #include "esp_sleep.h"
 #include "driver/gpio.h"
+#include "board_profile.h"
+#include "button_inputs.h"
 #include "wifi_manager.h"
 #include "osc_manager.h"
+#include "macro_engine.h"
+#include "preset_bank.h"
+#include "analog_inputs.h"
+#include "oscquery_server.h"
+#include "fleet_presence.h"
+#include "fleet_config.h"
+#include "arp_keeper.h"
+#include "power_governor.h"
+#include "event_hub.h"
+#include "log_ring.h"
+#include "telemetry.h"
+#include "alloc_audit.h"
 
 // === Configuration ===
 // OSC port is now configurable via web interface (default: 8001 for LuPlayer)
 
-// Button pins (directly next to 5V and GND on XIAO ESP32C3)
-const int BUTTON_1_PIN = D1;  // GPIO3
-const int BUTTON_2_PIN = D2;  // GPIO4
+// Button pins, wiring and wake sources come from the board profile
+// (board_profile.h); the default is the two buttons next to 5V and GND
 
 // Reed switch pin — NO switch between D3 and GND
 // No magnet (in use): switch open → HIGH (pull-up) → normal operation
@@ -43,83 +56,166 @@ const int REED_SWITCH_PIN = D3;  // GPIO5
 //      LOW that long, but noise won't)
 //   3. Both — belt and suspenders
 const bool REED_SENSOR_ENABLED = false;
+static_assert(!REED_SENSOR_ENABLED || !BOARD.uses(REED_SWITCH_PIN), "The reed switch pin is taken by a button");
 
 // Debounce settings
 // This is a cooldown after the initial press — the ISR fires instantly (no lag),
 // but then ignores all edges (including release bounce) for this duration.
+// Applies to every button.
 const unsigned long DEBOUNCE_MS = 800;
 const unsigned long DOCK_DEBOUNCE_MS = 500;  // Reed switch debounce for dock detection
 
 // === Global variables ===
-WiFiUDP udp;
+WiFiUDP udp;            // Best-effort path, kept for the latency bench
+ButtonInputs buttons;   // The board profile's buttons (generated ISRs)
 WiFiManager wifiManager;
 OSCManager oscManager;
-AsyncEventSource events("/events");  // SSE endpoint — replaces HTTP polling
-
-volatile bool button1Pressed = false;
-volatile bool button2Pressed = false;
-volatile unsigned long lastButton1Interrupt = 0;
-volatile unsigned long lastButton2Interrupt = 0;
+MacroEngine macros;     // Per-button timed OSC sequences
+PresetBank presets;     // Named OSC settings, switched between acts
+AnalogInputs analogInputs;  // Faders/FSRs of the board profile, streamed as OSC floats
+OSCQueryServer oscQuery;    // Namespace + LISTEN stream for zero-config hosts (portal mode)
+FleetPresence fleet;        // Jittered presence announcements for the host tool
+FleetConfig fleetConfig;    // Signed settings/preset bundles pushed to the whole fleet
+ArpKeeper arpKeeper;    // Keeps ARP for the unicast target/gateway warm under modem sleep
+PowerGovernor powerGovernor;  // Standby <-> show profile switching
+EventHub events("/events");  // Coalesced SSE endpoint — replaces HTTP polling
 
 // Set by the /sleep web endpoint; loop() picks it up and enters deep sleep
 // after a short delay so the HTTP response makes it back to the browser.
 volatile bool sleepRequested = false;
 unsigned long sleepRequestedAt = 0;
 
-// === Interrupt handlers (with debounce) ===
-void IRAM_ATTR onButton1Press() {
-    unsigned long now = millis();
-    if (now - lastButton1Interrupt > DEBOUNCE_MS) {
-        button1Pressed = true;
-        lastButton1Interrupt = now;
+// Set when headless mode is switched on/off; loop() reboots into the new
+// mode after the same short delay.
+volatile bool restartRequested = false;
+unsigned long restartRequestedAt = 0;
+
+// === OSC Functions ===
+void sendOSCButton(int buttonNumber) {
+    // Audit build: any heap allocation from here on is a hard failure
+    ALLOC_AUDIT_CRITICAL("button path");
+    // A button with a macro starts (or cancels) it instead of its single message
+    if (!macros.press(buttonNumber)) {
+        oscManager.sendButton(buttonNumber);
     }
+    powerGovernor.notifyActivity();
 }
 
-void IRAM_ATTR onButton2Press() {
-    unsigned long now = millis();
-    if (now - lastButton2Interrupt > DEBOUNCE_MS) {
-        button2Pressed = true;
-        lastButton2Interrupt = now;
+// Incoming OSC: /muis/power "auto" | "show" | "standby"
+void onPowerCommand(OSCMessage& msg) {
+    char name[12];
+    PowerMode mode;
+    if (msg.isString(0)) {
+        msg.getString(0, name, sizeof(name));
+        if (PowerGovernor::parseMode(name, mode)) powerGovernor.setMode(mode);
     }
 }
 
-// === OSC Functions ===
-void sendOSCButton(int buttonNumber) {
-    oscManager.sendButton(udp, buttonNumber);
+// Incoming OSC: /muis/showlock 1 | 0 — the only way to lift an engaged show
+// lock from outside, since the portal itself is locked out mid-scene
+void onShowLockCommand(OSCMessage& msg) {
+    if (msg.isInt(0)) {
+        wifiManager.getAdmission().setShowLockArmed(msg.getInt(0) != 0);
+    }
+}
+
+// Incoming OSC: /muis/headless 1 | 0 — reboot into (or out of) headless mode
+void onHeadlessCommand(OSCMessage& msg) {
+    if (!msg.isInt(0)) return;
+    bool headless = msg.getInt(0) != 0;
+    if (headless == wifiManager.isHeadless()) return;
+    if (headless && !wifiManager.getState().staEnabled) {
+        Serial.println("Headless refused: no saved network");
+        return;
+    }
+    wifiManager.setHeadless(headless);
+    restartRequested = true;
+    restartRequestedAt = millis();
+}
+
+// Incoming OSC: /muis/status — replies
+// "/muis/status mode ip battery% rssi power-profile free-heap min-free-heap"
+void onStatusCommand(OSCMessage& msg) {
+    OSCMessage out("/muis/status");
+    out.add(wifiManager.isHeadless() ? "headless" : "portal");
+    out.add(wifiManager.getSTAIP().toString().c_str());
+    out.add((int32_t)wifiManager.getBatteryPercent());
+    out.add((int32_t)(wifiManager.isSTAConnected() ? WiFi.RSSI() : 0));
+    out.add(PowerGovernor::profileName(powerGovernor.getProfile()));
+    out.add((int32_t)ESP.getFreeHeap());
+    out.add((int32_t)ESP.getMinFreeHeap());
+    oscManager.reply(out);
+}
+
+// Incoming OSC: /muis/telemetry — replies with the previous session (RTC
+// journal): "/muis/telemetry reset phase boots uptime-s presses
+// send-failures worst-press-us worst-loop-us wifi-outages wifi-outage-ms"
+void onTelemetryCommand(OSCMessage& msg) {
+    const TelemetryCounters& p = telemetry.getPrevious();
+    uint32_t presses = 0;
+    for (int i = 0; i < BOARD_BUTTONS; i++) presses += p.presses[i];
+    OSCMessage out("/muis/telemetry");
+    out.add(telemetry.getResetReasonName());
+    out.add(telemetry.getLastPhaseName());
+    out.add((int32_t)telemetry.getBootCount());
+    out.add((int32_t)p.uptimeS);
+    out.add((int32_t)presses);
+    out.add((int32_t)p.sendFailures);
+    out.add((int32_t)p.worstPressUs);
+    out.add((int32_t)p.worstLoopUs);
+    out.add((int32_t)p.wifiOutages);
+    out.add((int32_t)p.wifiOutageMs);
+    oscManager.reply(out);
 }
 
 // === Button Handling ===
 void handleButtons() {
-    // Handle button 1 (debouncing done in ISR)
-    if (button1Pressed) {
-        button1Pressed = false;
-        if (digitalRead(BUTTON_1_PIN) == LOW) {
-            sendOSCButton(1);
+    // Debouncing done in the ISRs
+    for (int i = 0; i < BOARD_BUTTONS; i++) {
+        if (buttons.takePress(i)) {
+            uint32_t start = micros();
+            sendOSCButton(i + 1);
+            telemetry.notePress(i, micros() - start);
         }
     }
+}
+
+// At most 17 characters per button ("button16":false,), plus braces
+constexpr size_t BUTTON_STATUS_JSON_MAX = 17 * BOARD_BUTTONS + 4;
+
+// Button states as JSON ({"button1":true,...}) into out
+void buttonStatusJson(uint32_t down, char* out, size_t len) {
+    size_t n = snprintf(out, len, "{");
+    for (int i = 0; i < BOARD_BUTTONS && n < len; i++) {
+        n += snprintf(out + n, len - n, "%s\"button%d\":%s", i ? "," : "", i + 1,
+                      (down & (1u << i)) ? "true" : "false");
+    }
+    if (n < len) snprintf(out + n, len - n, "}");
+}
 
-    // Handle button 2 (debouncing done in ISR)
-    if (button2Pressed) {
-        button2Pressed = false;
-        if (digitalRead(BUTTON_2_PIN) == LOW) {
-            sendOSCButton(2);
-        }
+uint32_t readButtons() {
+    uint32_t down = 0;
+    for (int i = 0; i < BOARD_BUTTONS; i++) {
+        if (buttons.isDown(i)) down |= 1u << i;
     }
+    return down;
 }
 
 
 // === Deep Sleep ===
 void enterDeepSleep() {
+    telemetry.prepareReset(LOOP_PHASE_SLEEP);
+    logRing.flush();
     Serial.println("Entering deep sleep");
-    Serial.println("Press button 1 (D1) to wake");
+    Serial.println("Press a wake button (button 1) to wake");
     Serial.flush();
 
     // Clean WiFi shutdown
     WiFi.disconnect(true);
     WiFi.mode(WIFI_OFF);
 
-    // Configure D1 (GPIO3) as wake source — wake on LOW (button press)
-    esp_deep_sleep_enable_gpio_wakeup(BIT(D1), ESP_GPIO_WAKEUP_GPIO_LOW);
+    // The profile's wake buttons (pads were latched in setup())
+    buttons.enableWake();
 
     esp_deep_sleep_start();
 }
@@ -158,9 +254,14 @@ static int lipoPercentFromMillivolts(int mv) {
 int getBatteryPercent() {
     // analogReadMilliVolts() applies the factory eFuse ADC calibration, so we
     // skip the raw->mV math and get a much more accurate absolute voltage.
-    long sumMv = 0;
-    for (int i = 0; i < 16; i++) sumMv += analogReadMilliVolts(A0);
-    int adcMv = sumMv / 16;
+    // On boards with analog inputs A0 is sampled with them (calibrated the
+    // same way): a one-shot read would stop their continuous sampling.
+    int adcMv;
+    if (!analogInputs.getBatteryMillivolts(adcMv)) {
+        long sumMv = 0;
+        for (int i = 0; i < 16; i++) sumMv += analogReadMilliVolts(A0);
+        adcMv = sumMv / 16;
+    }
     // 2x 220k resistor divider: Vbat = ADC voltage * 2
     int batMv = adcMv * 2;
 
@@ -177,6 +278,49 @@ int getBatteryPercent() {
     return lipoPercentFromMillivolts(emaMv);
 }
 
+// Sketch-level portal routes: button status, sleep, headless switch, SSE
+void registerPortalRoutes() {
+    // Button status endpoint (kept for external/debug use)
+    AsyncWebServer& server = wifiManager.getWebServer();
+    server.on("/buttonstatus", HTTP_GET, [](AsyncWebServerRequest *request) {
+        char json[BUTTON_STATUS_JSON_MAX];
+        buttonStatusJson(readButtons(), json, sizeof(json));
+        request->send(200, "application/json", json);
+    });
+
+    // Deep sleep on request — flag is picked up by loop() after a short delay
+    // so this response reaches the browser before WiFi is torn down.
+    wifiManager.getControlChannel().registerAction("sleep", "/sleep", HTTP_POST, [](const ControlRequest&) -> String {
+        sleepRequested = true;
+        sleepRequestedAt = millis();
+        Serial.println("Deep sleep requested via web UI");
+        return "{\"success\":true}";
+    });
+
+    // Headless mode — persisted, then a deferred reboot (same delay as sleep)
+    wifiManager.getControlChannel().registerAction("headless", "/headless", HTTP_POST, [](const ControlRequest&) -> String {
+        if (!wifiManager.getState().staEnabled) {
+            return "{\"success\":false,\"message\":\"Connect to a network first — headless mode has no access point\"}";
+        }
+        wifiManager.setHeadless(true);
+        restartRequested = true;
+        restartRequestedAt = millis();
+        return "{\"success\":true}";
+    });
+
+    // Server-Sent Events — pushes button + battery state over a single persistent
+    // connection instead of the client polling /buttonstatus every 500 ms.
+    // This avoids the memory fragmentation that kills ESPAsyncWebServer over hours.
+    // New clients get the current state from the hub on its next frame.
+    events.begin(server);
+    logRing.begin(server);  // /log: the deferred log as an event stream
+
+    // Last session from the RTC journal (see telemetry.h)
+    wifiManager.getControlChannel().registerAction("telemetry", "/telemetry", HTTP_GET, [](const ControlRequest&) -> String {
+        return telemetry.getJson();
+    });
+}
+
 // === Setup ===
 void setup() {
     // === EARLY DOCK CHECK ===
@@ -184,17 +328,16 @@ void setup() {
     // check whether we're booting in the dock. If so, sleep immediately — otherwise
     // every dock-while-powered cycle would burn ~10 s of WiFi setup.
     //
-    // We still need to configure D1 (wake source) so we can come back out of sleep:
-    // pull-up enabled and latched, just like the normal sleep path.
-    pinMode(BUTTON_1_PIN, INPUT_PULLUP);
+    // The button pads are configured (pulls enabled and latched across deep
+    // sleep) first, so the wake buttons can bring us back out of sleep.
+    // REED_SWITCH_PIN isn't latched — we're never asleep when it matters.
+    buttons.configurePins();
     if (REED_SENSOR_ENABLED) pinMode(REED_SWITCH_PIN, INPUT_PULLUP);
     delayMicroseconds(100);  // Let pull-ups settle before reading
 
     if (REED_SENSOR_ENABLED && digitalRead(REED_SWITCH_PIN) == LOW) {
         // Docked — sleep immediately. No serial output (Serial not yet up).
-        gpio_hold_en(GPIO_NUM_3);  // hold D1 pull-up across deep sleep
-        gpio_deep_sleep_hold_en();
-        esp_deep_sleep_enable_gpio_wakeup(BIT(D1), ESP_GPIO_WAKEUP_GPIO_LOW);
+        buttons.enableWake();
         esp_deep_sleep_start();
     }
 
@@ -208,143 +351,195 @@ void setup() {
 
     Serial.println("\n\n=== ESP32-C3 OSC Button Controller ===");
     Serial.println("Serial connected!");
+    Serial.printf("Board: %s\n", BOARD.name);
 
-    // Button 2 pin (BUTTON_1_PIN and REED_SWITCH_PIN already configured above)
-    pinMode(BUTTON_2_PIN, INPUT_PULLUP);
-
-    // Latch the button pads so their pull-ups survive deep sleep.
-    // D1 is the wake source; D2 is held too so its input doesn't float during sleep
-    // (saves a tiny bit of leakage current). REED_SWITCH_PIN doesn't need this —
-    // we're never asleep when the reed switch matters.
-    gpio_hold_en(GPIO_NUM_3);  // D1 / BUTTON_1_PIN
-    gpio_hold_en(GPIO_NUM_4);  // D2 / BUTTON_2_PIN
-    gpio_deep_sleep_hold_en();
+    // Previous session's counters from RTC memory, before anything counts
+    telemetry.begin();
 
-    // Attach interrupts for immediate response
-    attachInterrupt(digitalPinToInterrupt(BUTTON_1_PIN), onButton1Press, FALLING);
-    attachInterrupt(digitalPinToInterrupt(BUTTON_2_PIN), onButton2Press, FALLING);
+    // Attach interrupts for immediate response (pins configured above)
+    buttons.begin(DEBOUNCE_MS);
 
     // Configure and start WiFi manager
     WiFiManagerConfig wifiConfig = {
         .apSSID = "OSC-MUIS",
         .apPassword = "oscbuttons",  // Min 8 characters, or "" for open network
-        .apChannel = 6,
+        .apChannel = 0,  // 0 = least congested channel / follow the STA channel
         .countryCode = "NL",
         .portalTitle = "OSC-MUIS",
         .portalSubtitle = "Button Controller",
-        .displayPort = 0  // Will show configured OSC port in portal
+        .displayPort = 0,  // Will show configured OSC port in portal
+        .appendDeviceId = true  // "OSC-MUIS-A1B2C3" / osc-muis-a1b2c3.local: units of a fleet stay apart
     };
     wifiManager.begin(wifiConfig);
 
-    // Initialize OSC manager (registers web endpoints and template callback)
+    // Initialize OSC manager (registers web endpoints and template callback,
+    // or only the /muis/config commands when headless)
     oscManager.begin(wifiManager.getWebServer(), wifiManager);
+    macros.begin(oscManager, wifiManager);
+    presets.begin(oscManager, wifiManager);
+    analogInputs.begin(oscManager, wifiManager);
+    fleet.begin(oscManager, wifiManager);
+    fleetConfig.begin(oscManager, presets, wifiManager);
+
+    // Status and mode switching over OSC — the only interface when headless
+    oscManager.registerCommand("/muis/status", onStatusCommand);
+    oscManager.registerCommand("/muis/headless", onHeadlessCommand);
+    oscManager.registerCommand("/muis/telemetry", onTelemetryCommand);
+
+    // Headless: none of the portal's routes, SSE or actions are registered,
+    // so the web server never allocates anything (see WiFiManager::setHeadless)
+    if (!wifiManager.isHeadless()) {
+        registerPortalRoutes();
+    }
 
-    // Button status endpoint (kept for external/debug use)
-    AsyncWebServer& server = wifiManager.getWebServer();
-    server.on("/buttonstatus", HTTP_GET, [](AsyncWebServerRequest *request) {
-        String json = "{\"button1\":";
-        json += (digitalRead(BUTTON_1_PIN) == LOW) ? "true" : "false";
-        json += ",\"button2\":";
-        json += (digitalRead(BUTTON_2_PIN) == LOW) ? "true" : "false";
-        json += "}";
-        request->send(200, "application/json", json);
-    });
-
-    // Deep sleep on request — flag is picked up by loop() after a short delay
-    // so this response reaches the browser before WiFi is torn down.
-    server.on("/sleep", HTTP_POST, [](AsyncWebServerRequest *request) {
-        request->send(200, "application/json", "{\"success\":true}");
-        sleepRequested = true;
-        sleepRequestedAt = millis();
-        Serial.println("Deep sleep requested via web UI");
-    });
+    // Start in the standby profile now that WiFi setup is done: 80 MHz halves
+    // the active-mode current draw. The governor switches to the show profile
+    // (160 MHz, no modem sleep) on button activity, portal or OSC request.
+    // Registers /power, so it has to come before startWebServer().
+    powerGovernor.begin(wifiManager, arpKeeper);
+    // Power mode is show control (scene start/end): its sender proves the
+    // receiver's network, unlike the status and configuration commands
+    oscManager.registerCommand("/muis/power", onPowerCommand, true);
+    oscManager.registerCommand("/muis/showlock", onShowLockCommand);
 
-    // Server-Sent Events — pushes button + battery state over a single persistent
-    // connection instead of the client polling /buttonstatus every 500 ms.
-    // This avoids the memory fragmentation that kills ESPAsyncWebServer over hours.
-    events.onConnect([](AsyncEventSourceClient *client) {
-        // Send current state immediately so the UI doesn't show stale data
-        String btn = "{\"button1\":";
-        btn += (digitalRead(BUTTON_1_PIN) == LOW) ? "true" : "false";
-        btn += ",\"button2\":";
-        btn += (digitalRead(BUTTON_2_PIN) == LOW) ? "true" : "false";
-        btn += "}";
-        client->send(btn.c_str(), "buttons", millis(), 10000);
-
-        String bat = String(wifiManager.getBatteryPercent());
-        client->send(bat.c_str(), "battery", millis());
-    });
-    server.addHandler(&events);
+    // OSCQuery lists the commands registered so far, so it comes last
+    oscQuery.begin(oscManager, wifiManager);
 
     // Now that all routes are registered, start the web server.
     // (Routes must be added before begin() — onNotFound can otherwise intercept them.)
     wifiManager.startWebServer();
 
-    // Start UDP for OSC (use configured port for listening, though we mainly send)
-    udp.begin(oscManager.getPort());
-
-    // Drop CPU from default 160 MHz to 80 MHz now that WiFi setup is done.
-    // Halves the active-mode current draw with no perceptible cost for this
-    // workload (button ISRs + occasional UDP send + low-traffic web UI).
-    setCpuFrequencyMhz(80);
-    Serial.printf("CPU clock set to %u MHz\n", getCpuFrequencyMhz());
+    // OSC sockets on the configured port, one per WiFi interface: presses go
+    // out through them (QoS-tagged) and /muis/* commands come in on them,
+    // without WiFiUDP's per-poll malloc. Rebuilt on WiFi events.
+    oscManager.beginRouting();
+    arpKeeper.begin();
 
+    Serial.printf("Free heap after setup: %u bytes (%s)\n",
+                  ESP.getFreeHeap(), wifiManager.isHeadless() ? "headless" : "portal");
     Serial.println("Ready! Waiting for button presses...");
+
+    // Audit build: from here on, loop() is expected not to allocate
+    ALLOC_AUDIT_ARM();
 }
 
+
 // === Main Loop ===
 void loop() {
+    // Phase markers: the RTC journal names the one a crash or watchdog hits
+    uint32_t passStart = micros();
+    telemetry.phase(LOOP_PHASE_WIFI);
+
     // Process WiFi manager (captive portal, DNS, connection monitoring)
     wifiManager.loop();
 
-    // Update battery level periodically and push to connected web clients
+    // Keep ARP entries for our unicast peers fresh (cheap; mostly a no-op).
+    // Target follows the portal setting; broadcast mode leaves only the gateway.
+    arpKeeper.setTarget(oscManager.getUnicastTarget());
+    arpKeeper.loop();
+
+    // Update battery level periodically and publish it to connected web clients
+    telemetry.phase(LOOP_PHASE_STATUS);
     static unsigned long lastBatteryUpdate = 0;
     if (millis() - lastBatteryUpdate > 10000) {
         int pct = getBatteryPercent();
         wifiManager.setBatteryPercent(pct);
-        events.send(String(pct).c_str(), "battery", millis());
+        char bat[8];
+        snprintf(bat, sizeof(bat), "%d", pct);
+        events.publish("battery", bat);
         lastBatteryUpdate = millis();
     }
 
-    // Push button state changes to connected web clients
-    static bool lastBtn1State = false, lastBtn2State = false;
-    bool btn1 = (digitalRead(BUTTON_1_PIN) == LOW);
-    bool btn2 = (digitalRead(BUTTON_2_PIN) == LOW);
-    if (btn1 != lastBtn1State || btn2 != lastBtn2State) {
-        lastBtn1State = btn1;
-        lastBtn2State = btn2;
-        String json = "{\"button1\":";
-        json += btn1 ? "true" : "false";
-        json += ",\"button2\":";
-        json += btn2 ? "true" : "false";
-        json += "}";
-        events.send(json.c_str(), "buttons", millis());
+    // Publish button state changes; the hub coalesces them per frame (latest wins)
+    static uint32_t lastButtonState = 0;
+    uint32_t buttonState = readButtons();  // bit i = button i+1 down
+    static bool buttonsPublished = false;
+    if (buttonState != lastButtonState || !buttonsPublished) {
+        lastButtonState = buttonState;
+        buttonsPublished = true;
+        char json[BUTTON_STATUS_JSON_MAX];
+        buttonStatusJson(buttonState, json, sizeof(json));
+        events.publish("buttons", json);
+        oscQuery.setButtons(buttonState);
     }
-
-    // Hold-both-buttons soft reboot. The two OSC pulses fired at press-start
-    // are unavoidable (press is interrupt-driven) but acceptable for what is
-    // essentially an emergency-reboot gesture.
+    events.loop();
+    oscQuery.loop();
+
+    // Hold-both-buttons gestures (buttons 1 and 2, whatever the board):
+    // 1-3 s switches to the next preset (on release), longer is a soft
+    // reboot. The two OSC pulses fired at press-start are unavoidable (press
+    // is interrupt-driven) but acceptable for what are deliberate
+    // between-acts gestures.
+    telemetry.phase(LOOP_PHASE_GESTURES);
+    bool btn1 = buttonState & 1;
+    bool btn2 = buttonState & 2;
     static unsigned long bothPressedSince = 0;
+    const unsigned long PRESET_HOLD_MS = 1000;
     const unsigned long REBOOT_HOLD_MS = 3000;
     if (btn1 && btn2) {
         if (bothPressedSince == 0) {
             bothPressedSince = millis();
         } else if (millis() - bothPressedSince > REBOOT_HOLD_MS) {
+            // Also the way back from headless mode: the portal returns on reboot
+            if (wifiManager.isHeadless()) {
+                wifiManager.setHeadless(false);
+            }
+            telemetry.prepareReset(LOOP_PHASE_RESTART);
+            logRing.flush();
             Serial.println("Both buttons held — rebooting");
             Serial.flush();
             delay(50);
             ESP.restart();
         }
     } else {
+        if (bothPressedSince != 0 && millis() - bothPressedSince >= PRESET_HOLD_MS) {
+            presets.recallNext();
+        }
         bothPressedSince = 0;
     }
 
     // Handle any pending button presses
+    telemetry.phase(LOOP_PHASE_BUTTONS);
     handleButtons();
 
+    // Due macro steps (timer wheel, no delay())
+    telemetry.phase(LOOP_PHASE_MACROS);
+    macros.loop();
+
+    // Preset switches and saves requested from the portal
+    telemetry.phase(LOOP_PHASE_PRESETS);
+    presets.loop();
+
+    // Faders: filter the latest ADC frame, send the inputs that moved (rate
+    // limited; after the buttons so they never wait on a fader)
+    telemetry.phase(LOOP_PHASE_ANALOG);
+    if (analogInputs.loop()) {
+        powerGovernor.notifyActivity();
+        char values[8 * ANALOG_SLOTS + 4];
+        analogInputs.valuesJson(values, sizeof(values));
+        events.publish("analog", values);
+        for (int i = 0; i < BOARD_ANALOG_INPUTS; i++) oscQuery.setFader(i, analogInputs.getValue(i));
+    }
+
+    // Routing table changes and incoming OSC commands (e.g. /muis/power),
+    // then re-evaluate the power profile; presence announcement when due,
+    // fleet config bundles in and out
+    telemetry.phase(LOOP_PHASE_OSC);
+    oscManager.loop();
+    powerGovernor.loop();
+    telemetry.phase(LOOP_PHASE_FLEET);
+    fleet.loop();
+    fleetConfig.loop();
+
     // Handle test request from web interface
+    telemetry.phase(LOOP_PHASE_DIAGNOSTICS);
     if (oscManager.checkAndClearTestRequest()) {
-        sendOSCButton(1);
+        oscManager.sendTest();
+    }
+
+    // Handle latency bench request from web interface (diagnostic, blocks ~1 s)
+    if (oscManager.checkAndClearBenchRequest()) {
+        oscManager.runLatencyBench(udp);
     }
 
     // Web-requested deep sleep — wait briefly so the HTTP response is flushed.
@@ -352,6 +547,15 @@ void loop() {
         enterDeepSleep();
     }
 
+    // Headless mode switched on/off — reboot into it once the reply is out
+    if (restartRequested && millis() - restartRequestedAt > 500) {
+        telemetry.prepareReset(LOOP_PHASE_RESTART);
+        logRing.flush();
+        Serial.println("Rebooting to change headless mode");
+        Serial.flush();
+        ESP.restart();
+    }
+
     // Check reed switch for dock detection (magnet closes NO switch → LOW)
     if (REED_SENSOR_ENABLED) {
         static unsigned long reedLowSince = 0;
@@ -364,4 +568,14 @@ void loop() {
             reedLowSince = 0;
         }
     }
+
+    // Log lines queued this pass, formatted now that the button path is done
+    telemetry.phase(LOOP_PHASE_LOG);
+    logRing.loop();
+
+    // Worst pass time; the journal is copied to RTC memory if anything changed
+    telemetry.endPass(micros() - passStart);
+
+    // Audit build: periodic allocation totals for loop()
+    ALLOC_AUDIT_REPORT();
 }
@@ -0,0 +1,161 @@
+// OSC-Muis - Niels van der Hulst 2026
+
+#include "admission_control.h"
+#include <Preferences.h>
+
+AdmissionControl::AdmissionControl() {
+    memset(_buckets, 0, sizeof(_buckets));
+    _armed = false;
+    _sceneActive = false;
+    _inflight = 0;
+    _admitted = 0;
+    _rateLimited = 0;
+    _busy = 0;
+    _locked = 0;
+}
+
+void AdmissionControl::begin() {
+    Preferences prefs;
+    prefs.begin("admission", true);
+    _armed = prefs.getBool("showlock", false);
+    prefs.end();
+    Serial.printf("Admission control: %d req/s per client (burst %d), %d in flight, show lock %s\n",
+                  ADMISSION_RATE_PER_S, ADMISSION_BURST, ADMISSION_MAX_INFLIGHT,
+                  _armed ? "armed" : "off");
+}
+
+bool AdmissionControl::takeToken(uint32_t ip) {
+    uint32_t now = millis();
+
+    // Find this client's bucket, or recycle the least recently refilled one
+    Bucket* b = nullptr;
+    Bucket* oldest = &_buckets[0];
+    for (int i = 0; i < ADMISSION_MAX_CLIENTS; i++) {
+        if (_buckets[i].ip == ip) {
+            b = &_buckets[i];
+            break;
+        }
+        if ((int32_t)(_buckets[i].lastRefill - oldest->lastRefill) < 0) oldest = &_buckets[i];
+    }
+    if (!b) {
+        b = oldest;
+        b->ip = ip;
+        b->tokens = ADMISSION_BURST;
+        b->lastRefill = now;
+    }
+
+    uint32_t refill = (now - b->lastRefill) * ADMISSION_RATE_PER_S / 1000;
+    if (refill > 0) {
+        uint32_t tokens = b->tokens + refill;
+        b->tokens = tokens > ADMISSION_BURST ? ADMISSION_BURST : tokens;
+        b->lastRefill = now;
+    }
+    if (b->tokens == 0) return false;
+    b->tokens--;
+    return true;
+}
+
+void AdmissionControl::reject(AsyncWebServerRequest* request, int code, const char* message) {
+    AsyncWebServerResponse* response = request->beginResponse(code, "application/json",
+        String("{\"success\":false,\"message\":\"") + message + "\"}");
+    if (code != 423) response->addHeader("Retry-After", ADMISSION_RETRY_AFTER_S);
+    request->send(response);
+}
+
+void AdmissionControl::run(AsyncWebServerRequest* request, ArMiddlewareNext next) {
+    const String& url = request->url();
+    bool events = (url == "/events");
+
+    // Show lock first: it's the cheapest check and the one that matters mid-scene
+    if (!events && isLocked()) {
+        _locked++;
+        reject(request, 423, "Show lock active");
+        return;
+    }
+
+    if (!takeToken((uint32_t)request->client()->remoteIP())) {
+        _rateLimited++;
+        reject(request, 429, "Too many requests");
+        return;
+    }
+
+    // SSE (/events, /log) and the sockets (control, OSCQuery LISTEN) stay open
+    // for the whole session
+    bool longLived = events || request->requestedConnType() == RCT_EVENT ||
+                     request->requestedConnType() == RCT_WS;
+    if (!longLived) {
+        if (_inflight >= ADMISSION_MAX_INFLIGHT) {
+            _busy++;
+            reject(request, 503, "Busy");
+            return;
+        }
+        _inflight++;
+        request->onDisconnect([this]() { _inflight--; });
+    }
+
+    _admitted++;
+    next();
+}
+
+bool AdmissionControl::admitMessage(const IPAddress& ip) {
+    if (isLocked()) {
+        _locked++;
+        return false;
+    }
+    if (!takeToken((uint32_t)ip)) {
+        _rateLimited++;
+        return false;
+    }
+    _admitted++;
+    return true;
+}
+
+void AdmissionControl::setShowLockArmed(bool armed) {
+    if (armed == _armed) return;
+    _armed = armed;
+
+    Preferences prefs;
+    prefs.begin("admission", false);
+    prefs.putBool("showlock", armed);
+    prefs.end();
+    Serial.printf("Show lock %s\n", armed ? "armed" : "off");
+}
+
+bool AdmissionControl::isShowLockArmed() const {
+    return _armed;
+}
+
+void AdmissionControl::setSceneActive(bool active) {
+    if (_armed && active != _sceneActive) {
+        Serial.println(active ? "Show lock engaged (scene running)" : "Show lock released (scene ended)");
+    }
+    _sceneActive = active;
+}
+
+bool AdmissionControl::isLocked() const {
+    return _armed && _sceneActive;
+}
+
+uint32_t AdmissionControl::getRateLimitedCount() const {
+    return _rateLimited;
+}
+
+uint32_t AdmissionControl::getBusyCount() const {
+    return _busy;
+}
+
+uint32_t AdmissionControl::getLockedCount() const {
+    return _locked;
+}
+
+String AdmissionControl::getStatsJson() const {
+    String json = "{\"showLock\":";
+    json += _armed ? "true" : "false";
+    json += ",\"locked\":";
+    json += isLocked() ? "true" : "false";
+    json += ",\"admitted\":" + String(_admitted);
+    json += ",\"rejected\":{\"rateLimited\":" + String(_rateLimited);
+    json += ",\"busy\":" + String(_busy);
+    json += ",\"locked\":" + String(_locked) + "}}";
+    return json;
+}
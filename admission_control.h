@@ -0,0 +1,78 @@
+// OSC-Muis - Niels van der Hulst 2026
+
+#ifndef ADMISSION_CONTROL_H
+#define ADMISSION_CONTROL_H
+
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+
+#define ADMISSION_MAX_CLIENTS 8       // Rate-limit buckets (AP allows 4 stations + STA-side clients)
+#define ADMISSION_BURST 16            // Requests a client may send back-to-back (a portal load is ~6)
+#define ADMISSION_RATE_PER_S 4        // Sustained requests per second per client
+#define ADMISSION_MAX_INFLIGHT 4      // Short requests being served at once, all clients together
+#define ADMISSION_RETRY_AFTER_S "2"
+
+// Admission control for the web server, installed as middleware in front of
+// every route (portal, OSC, power, control socket handshake).
+//
+// The web server, lwIP and the button path all share the C3's single core, so
+// a captive-portal probe loop or a refresh storm shows up as press latency.
+// Requests are turned away cheaply, before any handler runs:
+//
+// - Per-client token bucket: a client over its rate gets 429.
+// - Global cap on concurrently served requests: beyond it, 503.
+// - Show lock: when armed, everything except /events is refused with 423
+//   while a scene is running (power governor in the show profile), so nobody
+//   can reconfigure the device mid-show. It lifts by itself when the scene
+//   ends, or via OSC.
+//
+// Long-lived connections (/events and the WebSockets) don't count towards the
+// cap; messages on an open control socket go through admitMessage() instead.
+class AdmissionControl : public AsyncMiddleware {
+public:
+    AdmissionControl();
+
+    // Load the persisted show lock setting
+    void begin();
+
+    // Middleware entry point (AsyncTCP task)
+    void run(AsyncWebServerRequest* request, ArMiddlewareNext next) override;
+
+    // Rate limit + show lock for a control socket message from this client
+    bool admitMessage(const IPAddress& ip);
+
+    // Show lock: armed is the persisted setting, the lock itself only applies
+    // while a scene is active
+    void setShowLockArmed(bool armed);
+    bool isShowLockArmed() const;
+    void setSceneActive(bool active);
+    bool isLocked() const;
+
+    uint32_t getRateLimitedCount() const;
+    uint32_t getBusyCount() const;
+    uint32_t getLockedCount() const;
+    String getStatsJson() const;
+
+private:
+    struct Bucket {
+        uint32_t ip;
+        uint32_t lastRefill;   // millis()
+        uint16_t tokens;
+    };
+    Bucket _buckets[ADMISSION_MAX_CLIENTS];
+
+    volatile bool _armed;
+    volatile bool _sceneActive;
+
+    // Only changed on the AsyncTCP task, read from loop() for stats
+    volatile int _inflight;
+    volatile uint32_t _admitted;
+    volatile uint32_t _rateLimited;
+    volatile uint32_t _busy;
+    volatile uint32_t _locked;
+
+    bool takeToken(uint32_t ip);
+    static void reject(AsyncWebServerRequest* request, int code, const char* message);
+};
+
+#endif
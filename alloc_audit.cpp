@@ -0,0 +1,101 @@
+// OSC-Muis - Niels van der Hulst 2026
+
+#include "alloc_audit.h"
+
+#ifdef OSC_MUIS_ALLOC_AUDIT
+
+#include "esp_rom_sys.h"
+
+// Individual allocations logged before the audit only counts (a leak in a
+// hot path would otherwise flood the console)
+#define ALLOC_AUDIT_LOG_LIMIT 32
+
+// Arduino core's loop task (cores/esp32/main.cpp)
+extern TaskHandle_t loopTaskHandle;
+
+static volatile bool _armed = false;
+static const char* volatile _critical = nullptr;
+static volatile uint32_t _allocs = 0;
+static volatile uint32_t _bytes = 0;
+static volatile uint32_t _frees = 0;
+static volatile uint32_t _logged = 0;
+
+// Called from inside the allocator: no Serial, no String, nothing that
+// could allocate — esp_rom_printf writes straight to the console.
+static void audit(const char* what, size_t size, void* caller) {
+    if (!_armed || xTaskGetCurrentTaskHandle() != loopTaskHandle) return;
+
+    _allocs++;
+    _bytes += size;
+
+    if (_critical) {
+        esp_rom_printf("ALLOC AUDIT FAILED: %s(%u) in %s from %p\n", what, (unsigned)size, _critical, caller);
+        abort();
+    }
+    if (_logged < ALLOC_AUDIT_LOG_LIMIT) {
+        _logged++;
+        esp_rom_printf("ALLOC AUDIT: %s(%u) in loop() from %p\n", what, (unsigned)size, caller);
+    }
+}
+
+extern "C" {
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t n, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+void __real_free(void* ptr);
+
+void* __wrap_malloc(size_t size) {
+    audit("malloc", size, __builtin_return_address(0));
+    return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t n, size_t size) {
+    audit("calloc", n * size, __builtin_return_address(0));
+    return __real_calloc(n, size);
+}
+
+void* __wrap_realloc(void* ptr, size_t size) {
+    audit("realloc", size, __builtin_return_address(0));
+    return __real_realloc(ptr, size);
+}
+
+void __wrap_free(void* ptr) {
+    if (ptr && _armed && xTaskGetCurrentTaskHandle() == loopTaskHandle) _frees++;
+    __real_free(ptr);
+}
+}
+
+void allocAuditArm() {
+    _allocs = 0;
+    _bytes = 0;
+    _frees = 0;
+    _logged = 0;
+    _armed = true;
+    Serial.println("Allocation audit armed for loop()");
+}
+
+void allocAuditReport() {
+    static unsigned long lastReport = 0;
+    if (millis() - lastReport < 10000) return;
+    lastReport = millis();
+
+    // Copy first: printing may itself allocate and move the counters
+    uint32_t allocs = _allocs, bytes = _bytes, frees = _frees;
+    esp_rom_printf("ALLOC AUDIT: %u allocations (%u bytes), %u frees in loop() since setup\n",
+                   (unsigned)allocs, (unsigned)bytes, (unsigned)frees);
+}
+
+uint32_t allocAuditCount() {
+    return _allocs;
+}
+
+AllocAuditCritical::AllocAuditCritical(const char* name) {
+    _previous = _critical;
+    _critical = name;
+}
+
+AllocAuditCritical::~AllocAuditCritical() {
+    _critical = _previous;
+}
+
+#endif
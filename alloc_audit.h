@@ -0,0 +1,61 @@
+// OSC-Muis - Niels van der Hulst 2026
+
+#ifndef ALLOC_AUDIT_H
+#define ALLOC_AUDIT_H
+
+// Allocation audit build: checks that the steady state really is
+// allocation-free. Off by default; enable with these two arduino-cli
+// compile options:
+//
+//   --build-property "build.extra_flags=-DOSC_MUIS_ALLOC_AUDIT"
+//   --build-property "compiler.c.elf.extra_flags=-Wl,--wrap=malloc,--wrap=free,--wrap=calloc,--wrap=realloc"
+//
+// The linker then routes every malloc/free/calloc/realloc through the
+// wrappers in alloc_audit.cpp. Once armed at the end of setup(), every
+// allocation made from the loop task is logged with its caller address
+// (decode with addr2line against the .elf). Allocations on other tasks
+// (AsyncTCP, lwIP, WiFi driver) are not ours to police and aren't counted.
+//
+// Inside an ALLOC_AUDIT_CRITICAL scope (the button path) an allocation is a
+// hard failure: the audit prints the caller and aborts.
+//
+// Expected after arming: nothing while idle or on a press. Portal actions,
+// incoming OSC commands and connection changes do allocate and show up in
+// the log, which is the point of logging rather than aborting there.
+
+#ifdef OSC_MUIS_ALLOC_AUDIT
+
+#include <Arduino.h>
+
+// Start auditing the loop task (call last thing in setup())
+void allocAuditArm();
+
+// Print loop-task allocation totals every 10 s (call from loop())
+void allocAuditReport();
+
+// Loop-task allocations since arming (host tests)
+uint32_t allocAuditCount();
+
+// Marks a region where any allocation aborts (see ALLOC_AUDIT_CRITICAL)
+class AllocAuditCritical {
+public:
+    explicit AllocAuditCritical(const char* name);
+    ~AllocAuditCritical();
+
+private:
+    const char* _previous;
+};
+
+#define ALLOC_AUDIT_ARM() allocAuditArm()
+#define ALLOC_AUDIT_REPORT() allocAuditReport()
+#define ALLOC_AUDIT_CRITICAL(name) AllocAuditCritical _allocAuditScope(name)
+
+#else
+
+#define ALLOC_AUDIT_ARM()
+#define ALLOC_AUDIT_REPORT()
+#define ALLOC_AUDIT_CRITICAL(name)
+
+#endif
+
+#endif
@@ -0,0 +1,316 @@
+// OSC-Muis - Niels van der Hulst 2026
+
+#include "analog_inputs.h"
+#include "wifi_manager.h"
+#include <OSCMessage.h>
+
+// Static instance pointer for web/OSC callbacks
+static AnalogInputs* _analogInstance = nullptr;
+
+volatile bool AnalogInputs::_frameReady = false;
+
+AnalogInputs::AnalogInputs() {
+    memset(_inputs, 0, sizeof(_inputs));
+    memset(_format, 0, sizeof(_format));
+    memset(&_program, 0, sizeof(_program));
+    _running = false;
+    _seeded = false;
+    _batteryMv = 0;
+    _sentCount = 0;
+    _droppedCount = 0;
+    memset(_requestedFormat, 0, sizeof(_requestedFormat));
+    memset(_requestedChannels, 0, sizeof(_requestedChannels));
+    _requested = false;
+    _oscManager = nullptr;
+    _wifiManager = nullptr;
+}
+
+void AnalogInputs::begin(OSCManager& oscManager, WiFiManager& wifiManager) {
+    _oscManager = &oscManager;
+    _wifiManager = &wifiManager;
+    _analogInstance = this;
+    if (BOARD_ANALOG_INPUTS == 0) return;
+    _json.begin();
+
+    _preferences.begin("analog", true);
+    _preferences.getString("fmt", _format, sizeof(_format));
+    char key[4] = "ch1";
+    for (int i = 0; i < BOARD_ANALOG_INPUTS; i++) {
+        key[2] = '1' + i;
+        _inputs[i].channel = _preferences.getUChar(key, i + 1);
+    }
+    _preferences.end();
+
+    const char* error = compile(_format, _program);
+    if (_format[0] == '\0' || error) {
+        if (_format[0]) Serial.printf("Analog template \"%s\" rejected: %s\n", _format, error);
+        strlcpy(_format, ANALOG_DEFAULT_FORMAT, sizeof(_format));
+        compile(_format, _program);
+    }
+
+    // Last one-shot read of A0: from here on continuous mode owns ADC1
+    long sumMv = 0;
+    for (int i = 0; i < 16; i++) sumMv += analogReadMilliVolts(A0);
+    _batteryMv = sumMv / 16;
+
+    // The inputs, then the battery; the frame results come in this order
+    uint8_t pins[BOARD_ANALOG_INPUTS + 1];
+    for (int i = 0; i < BOARD_ANALOG_INPUTS; i++) pins[i] = BOARD_ANALOG[i].pin;
+    pins[BOARD_ANALOG_INPUTS] = A0;
+
+    analogContinuousSetAtten(ADC_11db);
+    if (!analogContinuous(pins, BOARD_ANALOG_INPUTS + 1, ANALOG_CONVERSIONS_PER_PIN,
+                          ANALOG_SAMPLE_RATE_HZ, onFrame) ||
+        !analogContinuousStart()) {
+        Serial.println("Analog inputs: ADC continuous mode failed to start");
+        return;
+    }
+    _running = true;
+    publish();
+
+    oscManager.registerCommand("/muis/analog", onAnalogCommand);
+    if (!wifiManager.isHeadless()) {
+        registerActions();
+    }
+    Serial.printf("Analog inputs: %d, template %s\n", BOARD_ANALOG_INPUTS, _format);
+}
+
+// DMA frame complete (interrupt context): only raise the flag
+void IRAM_ATTR AnalogInputs::onFrame() {
+    _frameReady = true;
+}
+
+const char* AnalogInputs::compile(const char* format, OSCTemplate& out) {
+    // A plain address ("/fader") gets the channel and the value appended
+    char source[OSC_ADDRESS_FORMAT_MAX + 12];
+    if (strlen(format) >= OSC_ADDRESS_FORMAT_MAX) return "Template too long";
+    if (strchr(format, ',')) {
+        strlcpy(source, format, sizeof(source));
+    } else {
+        snprintf(source, sizeof(source), "%s ,f{value}", format);
+    }
+
+    const char* error = out.compile(source);
+    if (error) return error;
+    for (int i = 0; i < out.argCount; i++) {
+        if (out.args[i].source == OSC_PIECE_VALUE) return nullptr;
+    }
+    memset(&out, 0, sizeof(out));
+    return "The template needs a ,f{value} argument";
+}
+
+const char* AnalogInputs::validate(const char* format) {
+    OSCTemplate program;
+    return compile(format, program);
+}
+
+void AnalogInputs::readFrame() {
+    adc_continuous_data_t* result = nullptr;
+    if (!analogContinuousRead(&result, 0)) return;
+
+    for (int i = 0; i < BOARD_ANALOG_INPUTS; i++) {
+        Input& input = _inputs[i];
+        int32_t sample = (int32_t)result[i].avg_read_raw << 4;
+        if (!_seeded) {
+            // Start from where the fader is: nothing is sent until it moves
+            input.filtered = sample;
+            input.sent = position(input);
+        } else {
+            input.filtered += (sample - input.filtered) >> ANALOG_FILTER_SHIFT;
+        }
+    }
+    _batteryMv = result[BOARD_ANALOG_INPUTS].avg_read_mvolts;
+    _seeded = true;
+}
+
+int AnalogInputs::position(const Input& input) const {
+    int value = input.filtered >> 4;
+    if (value < ANALOG_END_ZONE) return 0;
+    if (value > ANALOG_FULL_SCALE - ANALOG_END_ZONE) return ANALOG_FULL_SCALE;
+    return value;
+}
+
+bool AnalogInputs::send(int index, int position) {
+    OSCTemplateContext ctx;
+    _oscManager->makeContext(0, ctx);
+    ctx.channel = _inputs[index].channel;
+    ctx.button = index + 1;
+    ctx.value = (float)position / ANALOG_FULL_SCALE;
+    return _oscManager->sendUpdate(_program, ctx);
+}
+
+bool AnalogInputs::loop() {
+    // Saved from the portal (validated there)
+    if (_requested) {
+        // Empty template, channel 0: left as they are
+        char format[OSC_ADDRESS_FORMAT_MAX];
+        strlcpy(format, _requestedFormat[0] ? _requestedFormat : _format, sizeof(format));
+        for (int i = 0; i < BOARD_ANALOG_INPUTS; i++) setChannel(i + 1, _requestedChannels[i]);
+        _requested = false;
+        const char* error = setFormat(format);
+        if (error) Serial.printf("Analog template not saved: %s\n", error);
+    }
+    if (_json.refreshRequested()) publish();
+
+    if (!_running) return false;
+    if (_frameReady) {
+        _frameReady = false;
+        readFrame();
+    }
+    if (!_seeded) return false;
+
+    bool sent = false;
+    unsigned long now = millis();
+    for (int i = 0; i < BOARD_ANALOG_INPUTS; i++) {
+        Input& input = _inputs[i];
+        int value = position(input);
+        if (value == input.sent) continue;
+        bool atEnd = value == 0 || value == ANALOG_FULL_SCALE;
+        if (!atEnd && abs(value - input.sent) < ANALOG_DEADBAND) continue;
+
+        // Still moving within the interval: the latest value goes out when
+        // it's up (a refused send is retried the same way)
+        if (now - input.lastSentAt < ANALOG_MIN_INTERVAL_MS) continue;
+        input.lastSentAt = now;
+        if (send(i, value)) {
+            input.sent = value;
+            _sentCount++;
+            sent = true;
+        } else {
+            _droppedCount++;
+        }
+    }
+    return sent;
+}
+
+bool AnalogInputs::getBatteryMillivolts(int& mv) const {
+    if (!_running) return false;
+    mv = _batteryMv;
+    return true;
+}
+
+const char* AnalogInputs::setFormat(const char* format) {
+    OSCTemplate program;
+    const char* error = compile(format, program);
+    if (error) return error;
+
+    _program = program;
+    strlcpy(_format, format, sizeof(_format));
+    _preferences.begin("analog", false);
+    _preferences.putString("fmt", _format);
+    _preferences.end();
+    Serial.printf("Analog template: %s\n", _format);
+    publish();
+    return nullptr;
+}
+
+void AnalogInputs::setChannel(int input, int channel) {
+    if (input < 1 || input > BOARD_ANALOG_INPUTS || channel < 1 || channel > 99) return;
+    if (_inputs[input - 1].channel == channel) return;
+    _inputs[input - 1].channel = channel;
+
+    char key[4] = "ch1";
+    key[2] = '0' + input;
+    _preferences.begin("analog", false);
+    _preferences.putUChar(key, channel);
+    _preferences.end();
+}
+
+float AnalogInputs::getValue(int index) const {
+    return (float)_inputs[index].sent / ANALOG_FULL_SCALE;
+}
+
+void AnalogInputs::valuesJson(char* out, size_t len) const {
+    size_t n = snprintf(out, len, "[");
+    for (int i = 0; i < BOARD_ANALOG_INPUTS && n < len; i++) {
+        n += snprintf(out + n, len - n, "%s%.3f", i ? "," : "",
+                      (float)_inputs[i].sent / ANALOG_FULL_SCALE);
+    }
+    if (n < len) snprintf(out + n, len - n, "]");
+}
+
+void AnalogInputs::publish() {
+    String json = getJson();
+    if (_wifiManager) _wifiManager->getControlChannel().push("analog", json);
+    _json.set(std::move(json));
+}
+
+String AnalogInputs::getJson() const {
+    char values[8 * ANALOG_SLOTS + 4];
+    valuesJson(values, sizeof(values));
+
+    String json = "{\"format\":\"" + String(_format) + "\"";
+    json += ",\"running\":";
+    json += _running ? "true" : "false";
+    json += ",\"inputs\":[";
+    for (int i = 0; i < BOARD_ANALOG_INPUTS; i++) {
+        if (i > 0) json += ",";
+        json += "{\"input\":" + String(i + 1);
+        json += ",\"pin\":" + String(BOARD_ANALOG[i].pin);
+        json += ",\"channel\":" + String(_inputs[i].channel);
+        json += "}";
+    }
+    json += "],\"values\":" + String(values);
+    json += ",\"sent\":" + String(_sentCount);
+    json += ",\"dropped\":" + String(_droppedCount);
+    json += "}";
+    return json;
+}
+
+void AnalogInputs::registerActions() {
+    ControlChannel& control = _wifiManager->getControlChannel();
+
+    control.registerAction("analog.get", "/analog", HTTP_GET, [](const ControlRequest&) -> String {
+        return _analogInstance->_json.get();
+    });
+
+    // Validated here so the portal gets the error; applied from loop()
+    control.registerAction("analog.set", "/analog", HTTP_POST, [](const ControlRequest& req) -> String {
+        AnalogInputs* self = _analogInstance;
+        // Missing fields keep their value (filled in by loop(), which owns
+        // the settings)
+        String format = req.hasParam("format") ? req.getParam("format") : String();
+        const char* error = format.length() ? validate(format.c_str()) : nullptr;
+        if (error) {
+            return String("{\"success\":false,\"message\":\"") + error + "\"}";
+        }
+        if (self->_requested) {
+            return "{\"success\":false,\"message\":\"Previous save still pending, try again\"}";
+        }
+        for (int i = 0; i < BOARD_ANALOG_INPUTS; i++) {
+            char name[16];
+            snprintf(name, sizeof(name), "input%dChannel", i + 1);
+            int channel = req.hasParam(name) ? req.getParam(name).toInt() : 0;
+            if (req.hasParam(name) && (channel < 1 || channel > 99)) {
+                return "{\"success\":false,\"message\":\"Channels are 1-99\"}";
+            }
+            self->_requestedChannels[i] = channel;
+        }
+        strlcpy(self->_requestedFormat, format.c_str(), OSC_ADDRESS_FORMAT_MAX);
+        self->_requested = true;
+        return "{\"success\":true}";
+    });
+}
+
+// /muis/analog          -> reply "/muis/analog template ch1 value1 ch2 value2 ..."
+// /muis/analog s        -> set the template, then reply
+// /muis/analog i i      -> input, channel (1-99), then reply
+void AnalogInputs::onAnalogCommand(OSCMessage& msg) {
+    AnalogInputs* self = _analogInstance;
+    if (msg.isString(0)) {
+        char format[OSC_ADDRESS_FORMAT_MAX + 1];  // one over, so a too-long template is caught
+        msg.getString(0, format, sizeof(format));
+        const char* error = self->setFormat(format);
+        if (error) Serial.printf("Analog template rejected via OSC: %s\n", error);
+    } else if (msg.isInt(0) && msg.isInt(1)) {
+        self->setChannel(msg.getInt(0), msg.getInt(1));
+    }
+
+    OSCMessage out("/muis/analog");
+    out.add(self->_format);
+    for (int i = 0; i < BOARD_ANALOG_INPUTS; i++) {
+        out.add((int32_t)self->_inputs[i].channel);
+        out.add((float)self->_inputs[i].sent / ANALOG_FULL_SCALE);
+    }
+    self->_oscManager->reply(out);
+}
@@ -0,0 +1,122 @@
+// OSC-Muis - Niels van der Hulst 2026
+
+#ifndef ANALOG_INPUTS_H
+#define ANALOG_INPUTS_H
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include "board_profile.h"
+#include "osc_manager.h"
+#include "json_cache.h"
+
+class WiFiManager;
+class OSCMessage;
+
+#define ANALOG_SLOTS (BOARD_ANALOG_INPUTS > 0 ? BOARD_ANALOG_INPUTS : 1)  // Arrays can't be empty
+#define ANALOG_SAMPLE_RATE_HZ 10000    // ADC conversions per second, all channels together
+#define ANALOG_CONVERSIONS_PER_PIN 32  // Averaged per DMA frame: ~100 frames/s with three channels
+#define ANALOG_FULL_SCALE 4095         // 12-bit readings
+#define ANALOG_FILTER_SHIFT 1          // Moving average over frames, alpha = 1/2
+#define ANALOG_DEADBAND 16             // Counts (~0.4%) a value has to move from the last one sent
+#define ANALOG_END_ZONE 32             // Counts from either end that read as exactly 0.0 / 1.0
+#define ANALOG_MIN_INTERVAL_MS 20      // Per input: at most 50 updates a second
+#define ANALOG_DEFAULT_FORMAT "/fader/{ch} ,f{value}"
+
+// Faders and FSR pads on the board profile's analog pins, streamed as OSC
+// floats (0.0-1.0) through an address template with {value}:
+//
+//   /fader/{ch} ,f{value}
+//
+// A plain address gets the input's channel and ,f{value} appended.
+//
+// - Sampled by the ADC's DMA (continuous mode), ~100 frames a second of 32
+//   averaged conversions per pin; the CPU only sees one interrupt per frame,
+//   which raises a flag. loop() filters the frame (moving average), so the
+//   button ISRs and the press path are never held up by the ADC.
+// - Deadband: an input is only sent once it moved ANALOG_DEADBAND counts
+//   from the value last sent; the ends snap to exactly 0.0 and 1.0 and
+//   always go out, so a fader pulled all the way down does reach 0.
+// - Rate limit per input, coalesced: while a fader moves faster than one
+//   update per ANALOG_MIN_INTERVAL_MS, the values in between are skipped
+//   and the latest one goes out when the interval is up. A send the socket
+//   refuses (TX queue full) is retried the same way with whatever the
+//   latest value is by then, never queued.
+// - A0 (battery divider) is sampled in the same DMA frames: once continuous
+//   mode owns ADC1 a one-shot read would take the pin away from it, so
+//   getBatteryPercent() reads the battery from here.
+//
+// Nothing is sent at boot: an input only sends once it is moved.
+class AnalogInputs {
+public:
+    AnalogInputs();
+
+    // Load settings and start sampling; register /muis/analog (and portal
+    // actions unless headless). Does nothing on profiles without analog
+    // inputs.
+    void begin(OSCManager& oscManager, WiFiManager& wifiManager);
+
+    // Filter new frames and send inputs that moved; apply portal saves (call
+    // from loop(), after the buttons). True if an update went out.
+    bool loop();
+
+    // Battery divider voltage at A0 (mV) from the last frame. False when not
+    // sampling: read A0 directly then.
+    bool getBatteryMillivolts(int& mv) const;
+
+    // Validate an address template. Returns nullptr or a message.
+    static const char* validate(const char* format);
+
+    // Store and persist the template / an input's channel. Loop task only.
+    const char* setFormat(const char* format);
+    void setChannel(int input, int channel);
+
+    // Position last sent for an input (0-based), 0.0-1.0
+    float getValue(int index) const;
+
+    // Positions as a JSON array ("[0.420,1.000]", "analog" SSE event)
+    void valuesJson(char* out, size_t len) const;
+
+    // Template, channels and positions as JSON ("analog" event; loop task
+    // only, GET /analog serves the published copy)
+    String getJson() const;
+
+private:
+    struct Input {
+        int32_t filtered;         // Moving average, counts << 4
+        int16_t sent;             // Last position sent (counts)
+        uint8_t channel;          // {ch}
+        unsigned long lastSentAt;
+    };
+    Input _inputs[ANALOG_SLOTS];
+    char _format[OSC_ADDRESS_FORMAT_MAX];
+    OSCTemplate _program;
+    bool _running;
+    bool _seeded;                 // First frame read (positions valid)
+    int _batteryMv;
+    uint32_t _sentCount;
+    uint32_t _droppedCount;
+
+    // Set by the DMA frame interrupt, cleared by loop()
+    static volatile bool _frameReady;
+
+    // Portal saves arrive on the AsyncTCP task; loop() applies them
+    char _requestedFormat[OSC_ADDRESS_FORMAT_MAX];
+    uint8_t _requestedChannels[ANALOG_SLOTS];
+    volatile bool _requested;
+    JsonCache _json;              // getJson() as last published
+
+    OSCManager* _oscManager;
+    WiFiManager* _wifiManager;
+    Preferences _preferences;
+
+    static void onFrame();
+    static const char* compile(const char* format, OSCTemplate& out);
+    void publish();
+    void readFrame();
+    int position(const Input& input) const;
+    bool send(int index, int position);
+    void registerActions();
+    static void onAnalogCommand(OSCMessage& msg);
+};
+
+#endif
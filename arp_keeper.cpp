@@ -0,0 +1,120 @@
+// OSC-Muis - Niels van der Hulst 2026
+
+#include "arp_keeper.h"
+#include <WiFi.h>
+#include "esp_netif.h"
+#include "lwip/etharp.h"
+#include "lwip/tcpip.h"
+
+// lwIP's ARP cache lifetime in ms (entries expire after ARP_MAXAGE timer ticks)
+static const unsigned long ARP_CACHE_LIFETIME_MS = (unsigned long)ARP_MAXAGE * ARP_TMR_INTERVAL;
+
+// Work item handed to the tcpip thread. Only one refresh is ever in flight,
+// so a single static instance is enough, posted with a tcpip message
+// allocated once in begin() — tcpip_callback() would allocate one per call.
+static struct {
+    struct netif* netif;
+    ip4_addr_t addrs[2];
+    uint8_t count;
+    bool announce;
+    volatile bool pending;
+    struct tcpip_callback_msg* msg;
+} _job;
+
+// Runs on the tcpip thread — the only place lwIP's raw ARP API may be called
+static void arpJob(void*) {
+    if (_job.announce) {
+        etharp_gratuitous(_job.netif);
+    }
+    for (uint8_t i = 0; i < _job.count; i++) {
+        etharp_request(_job.netif, &_job.addrs[i]);
+    }
+    _job.pending = false;
+}
+
+ArpKeeper::ArpKeeper() {
+    _target = IPAddress(0, 0, 0, 0);
+    _refreshMs = 0;
+    _lastRefresh = 0;
+    _wasConnected = false;
+    _announcePending = false;
+}
+
+void ArpKeeper::setTarget(const IPAddress& ip) {
+    _target = ip;
+}
+
+void ArpKeeper::setRefreshInterval(unsigned long ms) {
+    _refreshMs = ms;
+}
+
+void ArpKeeper::begin() {
+    if (!_job.msg) {
+        _job.msg = tcpip_callbackmsg_new(arpJob, nullptr);
+    }
+}
+
+unsigned long ArpKeeper::getRefreshInterval() const {
+    return _refreshMs > 0 ? _refreshMs : ARP_CACHE_LIFETIME_MS / 2;
+}
+
+void ArpKeeper::loop() {
+    bool connected = (WiFi.status() == WL_CONNECTED);
+    if (!connected) {
+        _wasConnected = false;
+        _announcePending = false;
+        return;
+    }
+
+    if (!_wasConnected) {
+        // Fresh association: announce ourselves so peers update their caches
+        // for our (possibly new) MAC/IP, and resolve our peers right away.
+        _wasConnected = true;
+        _announcePending = true;
+    }
+    if (_announcePending) {
+        // Owed until a job carrying it is actually queued
+        if (refresh(true)) _announcePending = false;
+        return;
+    }
+
+    if (millis() - _lastRefresh > getRefreshInterval()) {
+        refresh(false);
+    }
+}
+
+bool ArpKeeper::refresh(bool announce) {
+    if (_job.pending || !_job.msg) return false;  // previous job not yet run — try again next pass
+
+    esp_netif_t* staNetif = esp_netif_get_handle_from_ifkey("WIFI_STA_DEF");
+    if (!staNetif) return false;
+    struct netif* netif = (struct netif*)esp_netif_get_netif_impl(staNetif);
+    if (!netif) return false;
+
+    IPAddress local = WiFi.localIP();
+    IPAddress mask = WiFi.subnetMask();
+    IPAddress gateway = WiFi.gatewayIP();
+
+    _job.netif = netif;
+    _job.count = 0;
+    _job.announce = announce;
+
+    // Off-subnet targets are reached through the gateway, so the gateway is
+    // always worth keeping; an on-subnet unicast target is resolved directly.
+    if ((uint32_t)gateway != 0) {
+        _job.addrs[_job.count++].addr = (uint32_t)gateway;
+    }
+    if ((uint32_t)_target != 0 &&
+        ((uint32_t)_target & (uint32_t)mask) == ((uint32_t)local & (uint32_t)mask) &&
+        _target != gateway) {
+        _job.addrs[_job.count++].addr = (uint32_t)_target;
+    }
+
+    _job.pending = true;
+    if (tcpip_callbackmsg_trycallback(_job.msg) != ERR_OK) {
+        _job.pending = false;
+        return false;
+    }
+    _lastRefresh = millis();
+    return true;
+}
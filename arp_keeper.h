@@ -0,0 +1,50 @@
+// OSC-Muis - Niels van der Hulst 2026
+
+#ifndef ARP_KEEPER_H
+#define ARP_KEEPER_H
+
+#include <Arduino.h>
+
+// Keeps the ARP entries for our unicast peers (OSC target, STA gateway) warm
+// so a press never waits on address resolution over a modem-sleeping link.
+//
+// Without this, an entry that ages out during a quiet stretch makes the next
+// send queue behind an ARP request/response round trip — and with
+// WIFI_PS_MIN_MODEM that round trip waits for the next DTIM beacon.
+//
+// Self-contained: watches the STA link itself, so WiFiManager doesn't need to
+// know about it. All lwIP calls are marshalled onto the tcpip thread.
+class ArpKeeper {
+public:
+    ArpKeeper();
+
+    // Preallocate the tcpip message used for every refresh (call in setup(),
+    // after WiFi is up, so refreshes never allocate)
+    void begin();
+
+    // Unicast OSC target (0.0.0.0 = broadcast mode, only the gateway is kept warm)
+    void setTarget(const IPAddress& ip);
+
+    // Override the refresh period. 0 (default) = half of lwIP's ARP cache
+    // lifetime (ARP_MAXAGE ticks of ARP_TMR_INTERVAL ms, 5 min on ESP32), so
+    // entries are re-confirmed well before they expire.
+    void setRefreshInterval(unsigned long ms);
+    unsigned long getRefreshInterval() const;
+
+    // Call from loop(). Sends a gratuitous ARP + immediate refresh after every
+    // (re)connect, then refreshes on the configured period.
+    void loop();
+
+private:
+    IPAddress _target;
+    unsigned long _refreshMs;
+    unsigned long _lastRefresh;
+    bool _wasConnected;
+    bool _announcePending;        // Gratuitous ARP owed since the association
+
+    // Queue a refresh on the tcpip thread. False if it couldn't be queued
+    // (previous job still in flight, no STA netif, tcpip queue full).
+    bool refresh(bool announce);
+};
+
+#endif
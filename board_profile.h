@@ -0,0 +1,222 @@
+// OSC-Muis - Niels van der Hulst 2026
+
+#ifndef BOARD_PROFILE_H
+#define BOARD_PROFILE_H
+
+#include <Arduino.h>
+#include <array>
+#include <utility>
+
+// Board profiles: which pins carry buttons, how they are wired and which of
+// them wake the board from deep sleep. Everything per button (ISRs, state
+// arrays, channel settings, NVS keys, portal fields) is sized from the
+// selected profile at compile time; nothing is looked up at runtime.
+//
+// Select a profile with a build flag (default: 2 buttons):
+//   -DBOARD_XIAO_C3_6_BUTTONS
+//   -DBOARD_XIAO_C3_4X4_MATRIX
+//   -DBOARD_XIAO_C3_2_BUTTONS_2_FADERS
+// or, from the Arduino IDE, by uncommenting one here:
+// #define BOARD_XIAO_C3_6_BUTTONS
+// #define BOARD_XIAO_C3_4X4_MATRIX
+// #define BOARD_XIAO_C3_2_BUTTONS_2_FADERS
+
+// One button input
+struct ButtonPin {
+    uint8_t pin;
+    uint8_t activeLevel;      // LOW: switch to GND, pull-up; HIGH: switch to 3V3, pull-down
+    bool wake;                // Wakes the board from deep sleep
+};
+
+template <size_t N>
+struct BoardProfile {
+    static constexpr size_t buttonCount = N;
+
+    const char* name;
+    ButtonPin buttons[N];
+
+    // Deep-sleep wake mask (BIT(gpio)) of the wake buttons active at level
+    constexpr uint64_t wakeMask(uint8_t level) const {
+        uint64_t mask = 0;
+        for (size_t i = 0; i < N; i++) {
+            if (buttons[i].wake && buttons[i].activeLevel == level) mask |= 1ULL << buttons[i].pin;
+        }
+        return mask;
+    }
+
+    // The C3 can only wake from deep sleep on GPIO0-5
+    constexpr bool wakePinsValid() const {
+        for (size_t i = 0; i < N; i++) {
+            if (buttons[i].wake && buttons[i].pin > 5) return false;
+        }
+        return wakeMask(LOW) || wakeMask(HIGH);
+    }
+
+    constexpr bool uses(uint8_t pin) const {
+        for (size_t i = 0; i < N; i++) {
+            if (buttons[i].pin == pin) return true;
+        }
+        return false;
+    }
+};
+
+// One continuous analog input (fader, FSR), streamed as OSC floats (see
+// analog_inputs.h). ADC1 only (GPIO0-4): ADC2 can't be read while WiFi is on.
+struct AnalogPin {
+    uint8_t pin;
+};
+
+constexpr std::array<AnalogPin, 0> NO_ANALOG_PINS = {};
+
+// Key matrix for cue pads with more keys than free GPIOs: R rows by C
+// columns, scanned on a timer (see matrix_scanner.h). Key r*C+c is button
+// r*C+c+1. Each key needs a diode (anode at the column, cathode at the
+// row) for n-key rollover; without them three keys on a rectangle ghost
+// a fourth.
+template <size_t R, size_t C>
+struct MatrixProfile {
+    static constexpr size_t rowCount = R;
+    static constexpr size_t colCount = C;
+    static constexpr size_t buttonCount = R * C;
+
+    const char* name;
+    uint8_t rows[R];          // Open-drain outputs, pulled LOW one at a time
+    uint8_t cols[C];          // Inputs with pull-up; a held key pulls its column LOW
+    uint8_t wakeCols;         // Bit c: keys in column c wake the board (all rows are held LOW in sleep)
+
+    constexpr uint64_t wakeMask(uint8_t level) const {
+        uint64_t mask = 0;
+        if (level != LOW) return mask;
+        for (size_t c = 0; c < C; c++) {
+            if (wakeCols & (1u << c)) mask |= 1ULL << cols[c];
+        }
+        return mask;
+    }
+
+    constexpr bool wakePinsValid() const {
+        for (size_t c = 0; c < C; c++) {
+            if ((wakeCols & (1u << c)) && cols[c] > 5) return false;
+        }
+        return wakeMask(LOW) != 0;
+    }
+
+    constexpr bool uses(uint8_t pin) const {
+        for (size_t r = 0; r < R; r++) {
+            if (rows[r] == pin) return true;
+        }
+        for (size_t c = 0; c < C; c++) {
+            if (cols[c] == pin) return true;
+        }
+        return false;
+    }
+};
+
+// Seeed XIAO ESP32-C3, the original two buttons next to 5V/GND. Only D1
+// wakes, as before.
+constexpr BoardProfile<2> XIAO_C3_2_BUTTONS = {
+    "XIAO ESP32-C3, 2 buttons",
+    {
+        {D1, LOW, true},      // GPIO3
+        {D2, LOW, false},     // GPIO4
+    },
+};
+
+// Seeed XIAO ESP32-C3 with six buttons. Leaves D0 (battery ADC), D3 (reed
+// switch), D6 (UART TX, driven at boot) and the strapping pins D8/D9 free.
+constexpr BoardProfile<6> XIAO_C3_6_BUTTONS = {
+    "XIAO ESP32-C3, 6 buttons",
+    {
+        {D1, LOW, true},      // GPIO3
+        {D2, LOW, true},      // GPIO4
+        {D4, LOW, false},     // GPIO6
+        {D5, LOW, false},     // GPIO7
+        {D7, LOW, false},     // GPIO20
+        {D10, LOW, false},    // GPIO10
+    },
+};
+
+// Seeed XIAO ESP32-C3 as a 16-key cue pad: every free pin except D0
+// (battery ADC), D3 (reed switch) and D9 (strapping, BOOT button). Rows may
+// use D6 (UART TX) and D8 (strapping): they are only pulled LOW after boot,
+// and a held key only connects them to a pulled-up input. Keys in the D1
+// and D2 columns wake the board.
+constexpr MatrixProfile<4, 4> XIAO_C3_4X4_MATRIX = {
+    "XIAO ESP32-C3, 4x4 key matrix",
+    {D6, D7, D8, D10},        // Rows: GPIO21, GPIO20, GPIO8, GPIO10
+    {D1, D2, D4, D5},         // Columns: GPIO3, GPIO4, GPIO6, GPIO7
+    0x03,
+};
+
+// Seeed XIAO ESP32-C3 with two buttons and two faders. The only ADC1 pins
+// on the XIAO besides the battery input are D1 and D2, so the faders take
+// those and the buttons move to D3 (wake; the reed switch must stay
+// disabled) and D4.
+constexpr BoardProfile<2> XIAO_C3_2_BUTTONS_2_FADERS = {
+    "XIAO ESP32-C3, 2 buttons + 2 faders",
+    {
+        {D3, LOW, true},      // GPIO5
+        {D4, LOW, false},     // GPIO6
+    },
+};
+
+constexpr std::array<AnalogPin, 2> XIAO_C3_FADERS = {{
+    {D1},                     // GPIO3, ADC1 channel 3
+    {D2},                     // GPIO4, ADC1 channel 4
+}};
+
+#if defined(BOARD_XIAO_C3_4X4_MATRIX)
+constexpr const auto& BOARD = XIAO_C3_4X4_MATRIX;
+constexpr const auto& BOARD_ANALOG = NO_ANALOG_PINS;
+#define BOARD_MATRIX 1
+#elif defined(BOARD_XIAO_C3_6_BUTTONS)
+constexpr const auto& BOARD = XIAO_C3_6_BUTTONS;
+constexpr const auto& BOARD_ANALOG = NO_ANALOG_PINS;
+#define BOARD_MATRIX 0
+#elif defined(BOARD_XIAO_C3_2_BUTTONS_2_FADERS)
+constexpr const auto& BOARD = XIAO_C3_2_BUTTONS_2_FADERS;
+constexpr const auto& BOARD_ANALOG = XIAO_C3_FADERS;
+#define BOARD_MATRIX 0
+#else
+constexpr const auto& BOARD = XIAO_C3_2_BUTTONS;
+constexpr const auto& BOARD_ANALOG = NO_ANALOG_PINS;
+#define BOARD_MATRIX 0
+#endif
+
+constexpr int BOARD_BUTTONS = BOARD.buttonCount;
+constexpr int BOARD_ANALOG_INPUTS = BOARD_ANALOG.size();
+
+// Analog inputs on ADC1, clear of the battery input and the buttons
+template <size_t N>
+constexpr bool analogPinsValid(const std::array<AnalogPin, N>& pins) {
+    for (size_t i = 0; i < N; i++) {
+        if (pins[i].pin > 4 || pins[i].pin == A0 || BOARD.uses(pins[i].pin)) return false;
+    }
+    return true;
+}
+
+static_assert(BOARD_BUTTONS >= 2, "The both-buttons gestures need buttons 1 and 2");
+static_assert(BOARD_BUTTONS <= 32, "Button state is kept in 32-bit bitmaps");
+static_assert(BOARD.wakePinsValid(), "Wake buttons must be on GPIO0-5, and at least one is needed");
+static_assert(!BOARD.uses(A0), "A0 is the battery divider input");
+static_assert(analogPinsValid(BOARD_ANALOG), "Analog inputs must be on GPIO0-4 (ADC1), not A0 and not a button");
+
+// NVS key of a button's channel: "btn1ch", "btn2ch", ... "btn32ch" (the
+// keys the two-button firmware used, so saved channels carry over)
+struct SettingKey {
+    char text[8];
+};
+
+constexpr SettingKey channelKey(size_t index) {
+    return index < 9
+        ? SettingKey{{'b', 't', 'n', char('1' + index), 'c', 'h', '\0', '\0'}}
+        : SettingKey{{'b', 't', 'n', char('0' + (index + 1) / 10), char('0' + (index + 1) % 10), 'c', 'h', '\0'}};
+}
+
+template <size_t... I>
+constexpr std::array<SettingKey, sizeof...(I)> makeChannelKeys(std::index_sequence<I...>) {
+    return {{channelKey(I)...}};
+}
+
+constexpr auto BOARD_CHANNEL_KEYS = makeChannelKeys(std::make_index_sequence<BOARD_BUTTONS>());
+
+#endif
@@ -0,0 +1,98 @@
+// OSC-Muis - Niels van der Hulst 2026
+
+#include "button_inputs.h"
+#include "esp_sleep.h"
+#include "driver/gpio.h"
+
+#if BOARD_MATRIX
+
+void ButtonInputs::configurePins() {
+    _matrix.configurePins();
+}
+
+void ButtonInputs::begin(unsigned long debounceMs) {
+    _matrix.begin(debounceMs);
+}
+
+bool ButtonInputs::takePress(int index) {
+    return _matrix.takePresses(1u << index) != 0;
+}
+
+bool ButtonInputs::isDown(int index) const {
+    return _matrix.getState() & (1u << index);
+}
+
+void ButtonInputs::enableWake() {
+    _matrix.enableWake();
+    esp_deep_sleep_enable_gpio_wakeup(BOARD.wakeMask(LOW), ESP_GPIO_WAKEUP_GPIO_LOW);
+}
+
+#else
+
+volatile bool ButtonInputs::_pressed[BOARD_BUTTONS];
+volatile unsigned long ButtonInputs::_lastInterrupt[BOARD_BUTTONS];
+unsigned long ButtonInputs::_debounceMs = 0;
+
+// One instance per button: the index is a constant, so the handler is as
+// short as a hand-written one
+template <int I>
+void IRAM_ATTR ButtonInputs::onPress() {
+    unsigned long now = millis();
+    if (now - _lastInterrupt[I] > _debounceMs) {
+        _pressed[I] = true;
+        _lastInterrupt[I] = now;
+    }
+}
+
+template <size_t... I>
+void ButtonInputs::attachAll(std::index_sequence<I...>) {
+    // Press edge: falling for active-low buttons, rising for active-high
+    int dummy[] = {(attachInterrupt(digitalPinToInterrupt(BOARD.buttons[I].pin), onPress<I>,
+                                    BOARD.buttons[I].activeLevel == LOW ? FALLING : RISING), 0)...};
+    (void)dummy;
+}
+
+void ButtonInputs::configurePins() {
+    for (int i = 0; i < BOARD_BUTTONS; i++) {
+        const ButtonPin& b = BOARD.buttons[i];
+        pinMode(b.pin, b.activeLevel == LOW ? INPUT_PULLUP : INPUT_PULLDOWN);
+    }
+    delayMicroseconds(100);  // Let pulls settle before anything reads them
+
+    // Latch the button pads so their pulls survive deep sleep: the wake
+    // buttons need them, the others would otherwise float (a tiny bit of
+    // leakage current)
+    for (int i = 0; i < BOARD_BUTTONS; i++) {
+        gpio_hold_en((gpio_num_t)BOARD.buttons[i].pin);
+    }
+    gpio_deep_sleep_hold_en();
+}
+
+void ButtonInputs::begin(unsigned long debounceMs) {
+    _debounceMs = debounceMs;
+    for (int i = 0; i < BOARD_BUTTONS; i++) {
+        _pressed[i] = false;
+        _lastInterrupt[i] = 0;
+    }
+    attachAll(std::make_index_sequence<BOARD_BUTTONS>());
+}
+
+bool ButtonInputs::takePress(int index) {
+    if (!_pressed[index]) return false;
+    _pressed[index] = false;
+    return isDown(index);
+}
+
+bool ButtonInputs::isDown(int index) const {
+    const ButtonPin& b = BOARD.buttons[index];
+    return digitalRead(b.pin) == b.activeLevel;
+}
+
+void ButtonInputs::enableWake() {
+    constexpr uint64_t lowMask = BOARD.wakeMask(LOW);
+    constexpr uint64_t highMask = BOARD.wakeMask(HIGH);
+    if (lowMask) esp_deep_sleep_enable_gpio_wakeup(lowMask, ESP_GPIO_WAKEUP_GPIO_LOW);
+    if (highMask) esp_deep_sleep_enable_gpio_wakeup(highMask, ESP_GPIO_WAKEUP_GPIO_HIGH);
+}
+
+#endif
@@ -0,0 +1,57 @@
+// OSC-Muis - Niels van der Hulst 2026
+
+#ifndef BUTTON_INPUTS_H
+#define BUTTON_INPUTS_H
+
+#include <Arduino.h>
+#include "board_profile.h"
+#include "matrix_scanner.h"
+
+// The board profile's buttons: one interrupt handler per button, generated at
+// compile time, so a press costs the same as with hand-written ISRs.
+//
+// Each ISR fires on the leading edge (no lag), then ignores all edges
+// (including release bounce) for the debounce cooldown. loop() collects
+// presses with takePress().
+//
+// Matrix profiles have no per-key interrupts: the keys come from a
+// MatrixScanner instead, behind the same calls.
+//
+// Buttons are indexed 0..BOARD_BUTTONS-1 here; OSC and the portal number
+// them from 1.
+class ButtonInputs {
+public:
+    // Pull-ups/pull-downs, latched so they survive deep sleep. Safe to call
+    // before Serial and WiFi (the early dock check uses it).
+    void configurePins();
+
+    // Attach the interrupt handlers
+    void begin(unsigned long debounceMs);
+
+    // True once per debounced press, if the button is still held (filters
+    // glitches shorter than the loop; matrix keys are debounced by the scan)
+    bool takePress(int index);
+
+    // Live level
+    bool isDown(int index) const;
+
+    // Arm the wake buttons as deep-sleep wake sources
+    void enableWake();
+
+private:
+#if BOARD_MATRIX
+    MatrixScanner _matrix;
+#else
+    template <int I>
+    static void onPress();
+
+    template <size_t... I>
+    static void attachAll(std::index_sequence<I...>);
+
+    static volatile bool _pressed[BOARD_BUTTONS];
+    static volatile unsigned long _lastInterrupt[BOARD_BUTTONS];
+    static unsigned long _debounceMs;
+#endif
+};
+
+#endif
@@ -0,0 +1,144 @@
+// OSC-Muis - Niels van der Hulst 2026
+
+#include "captive_dns.h"
+
+#define DNS_HEADER_SIZE 12
+#define DNS_TYPE_A 1
+#define DNS_CLASS_IN 1
+
+CaptiveDNS::CaptiveDNS() {
+    _running = false;
+    _answered = 0;
+    _rateLimited = 0;
+    _malformed = 0;
+    memset(_answer, 0, sizeof(_answer));
+    memset(_buckets, 0, sizeof(_buckets));
+}
+
+bool CaptiveDNS::start(const IPAddress& ip) {
+    if (_running) stop();
+
+    setAnswerIP(ip);
+    memset(_buckets, 0, sizeof(_buckets));
+
+    if (!_udp.listen(CAPTIVE_DNS_PORT)) {
+        Serial.println("Captive DNS: listen failed");
+        return false;
+    }
+    _udp.onPacket([this](AsyncUDPPacket& packet) { handlePacket(packet); });
+    _running = true;
+    return true;
+}
+
+void CaptiveDNS::setAnswerIP(const IPAddress& ip) {
+    // Answer record template — only the IP ever changes, so build it once
+    uint8_t* a = _answer;
+    *a++ = 0xC0; *a++ = DNS_HEADER_SIZE;          // name: pointer to the question
+    *a++ = 0x00; *a++ = DNS_TYPE_A;
+    *a++ = 0x00; *a++ = DNS_CLASS_IN;
+    *a++ = 0x00; *a++ = 0x00;                     // TTL (32-bit, big endian)
+    *a++ = (CAPTIVE_DNS_TTL >> 8) & 0xFF; *a++ = CAPTIVE_DNS_TTL & 0xFF;
+    *a++ = 0x00; *a++ = 0x04;                     // RDLENGTH
+    *a++ = ip[0]; *a++ = ip[1]; *a++ = ip[2]; *a++ = ip[3];
+}
+
+void CaptiveDNS::stop() {
+    if (!_running) return;
+    _udp.close();
+    _running = false;
+}
+
+uint32_t CaptiveDNS::getAnsweredCount() const {
+    return _answered;
+}
+
+uint32_t CaptiveDNS::getRateLimitedCount() const {
+    return _rateLimited;
+}
+
+uint32_t CaptiveDNS::getMalformedCount() const {
+    return _malformed;
+}
+
+bool CaptiveDNS::admit(uint32_t ip) {
+    uint32_t now = millis();
+
+    // Find this client's bucket, or recycle the least recently refilled one
+    Bucket* b = nullptr;
+    Bucket* oldest = &_buckets[0];
+    for (int i = 0; i < CAPTIVE_DNS_MAX_CLIENTS; i++) {
+        if (_buckets[i].ip == ip) {
+            b = &_buckets[i];
+            break;
+        }
+        if ((int32_t)(_buckets[i].lastRefill - oldest->lastRefill) < 0) oldest = &_buckets[i];
+    }
+    if (!b) {
+        b = oldest;
+        b->ip = ip;
+        b->tokens = CAPTIVE_DNS_BURST;
+        b->lastRefill = now;
+    }
+
+    uint32_t refill = (now - b->lastRefill) * CAPTIVE_DNS_RATE_PER_S / 1000;
+    if (refill > 0) {
+        uint32_t tokens = b->tokens + refill;
+        b->tokens = tokens > CAPTIVE_DNS_BURST ? CAPTIVE_DNS_BURST : tokens;
+        b->lastRefill = now;
+    }
+    if (b->tokens == 0) return false;
+    b->tokens--;
+    return true;
+}
+
+void CaptiveDNS::handlePacket(AsyncUDPPacket& packet) {
+    uint8_t resp[CAPTIVE_DNS_MAX_PACKET];
+    size_t respLen = respond(packet.data(), packet.length(), (uint32_t)packet.remoteIP(), resp);
+    if (respLen > 0) packet.write(resp, respLen);
+}
+
+size_t CaptiveDNS::respond(const uint8_t* q, size_t len, uint32_t ip, uint8_t* resp) {
+    // Standard query (QR=0, OPCODE=0) with exactly one question
+    if (len < DNS_HEADER_SIZE + 5 || (q[2] & 0xF8) != 0 || q[4] != 0 || q[5] != 1) {
+        _malformed++;
+        return 0;
+    }
+
+    // Walk the QNAME labels to find the end of the question
+    size_t pos = DNS_HEADER_SIZE;
+    while (pos < len && q[pos] != 0) {
+        if (q[pos] & 0xC0) { _malformed++; return 0; }  // no compression in a question
+        pos += q[pos] + 1;
+    }
+    pos++;  // root label
+    if (pos + 4 > len || pos - DNS_HEADER_SIZE > CAPTIVE_DNS_MAX_NAME) {
+        _malformed++;
+        return 0;
+    }
+    uint16_t qtype = (q[pos] << 8) | q[pos + 1];
+    uint16_t qclass = (q[pos + 2] << 8) | q[pos + 3];
+    size_t questionEnd = pos + 4;
+
+    if (!admit(ip)) {
+        _rateLimited++;
+        return 0;
+    }
+
+    bool answerA = (qtype == DNS_TYPE_A && qclass == DNS_CLASS_IN);
+    size_t respLen = questionEnd + (answerA ? sizeof(_answer) : 0);
+    if (respLen > CAPTIVE_DNS_MAX_PACKET) {
+        _malformed++;
+        return 0;
+    }
+
+    memcpy(resp, q, questionEnd);                 // ID, flags, counts + question
+    resp[2] = 0x84 | (q[2] & 0x01);               // QR=1, AA=1, keep RD
+    resp[3] = 0x00;                               // RA=0, RCODE=NOERROR
+    resp[6] = 0x00; resp[7] = answerA ? 1 : 0;    // ANCOUNT
+    resp[8] = 0x00; resp[9] = 0x00;               // NSCOUNT
+    resp[10] = 0x00; resp[11] = 0x00;             // ARCOUNT (EDNS OPT dropped)
+    if (answerA) memcpy(resp + questionEnd, _answer, sizeof(_answer));
+
+    _answered++;
+    return respLen;
+}
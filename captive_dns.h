@@ -0,0 +1,71 @@
+// OSC-Muis - Niels van der Hulst 2026
+
+#ifndef CAPTIVE_DNS_H
+#define CAPTIVE_DNS_H
+
+#include <Arduino.h>
+#include <AsyncUDP.h>
+
+#define CAPTIVE_DNS_PORT 53
+#define CAPTIVE_DNS_TTL 60              // Seconds; same as the stock DNSServer
+#define CAPTIVE_DNS_MAX_CLIENTS 8       // Rate-limit buckets (AP allows 4 stations + slack)
+#define CAPTIVE_DNS_BURST 32            // Queries a client may send back-to-back
+#define CAPTIVE_DNS_RATE_PER_S 16       // Sustained queries per second per client
+#define CAPTIVE_DNS_MAX_PACKET 512      // Classic DNS-over-UDP limit
+#define CAPTIVE_DNS_MAX_NAME 255        // Encoded QNAME, root label included (RFC 1035)
+
+// Captive-portal DNS responder: every A query is answered with the AP's IP.
+//
+// Replaces DNSServer::processNextRequest(), which answered at most one query
+// per loop() pass. Here every query is answered as it arrives, from the
+// AsyncUDP task, so the burst of connectivity checks a phone fires on joining
+// is drained at once instead of trickling out over several seconds.
+//
+// - Responses are built by echoing the question and appending a prebuilt
+//   answer record, so there's no name parsing beyond finding its end.
+// - Non-A queries (AAAA, HTTPS, ...) get an empty NOERROR answer, which makes
+//   clients fall back to A immediately instead of retrying.
+// - Each client has a token bucket; a probe loop gets dropped, not answered.
+class CaptiveDNS {
+public:
+    CaptiveDNS();
+
+    bool start(const IPAddress& ip);
+    void stop();
+
+    // Build the answer record for this AP address (start() does this)
+    void setAnswerIP(const IPAddress& ip);
+
+    // Answer one query from ip into resp (CAPTIVE_DNS_MAX_PACKET bytes):
+    // the response length, or 0 when it's malformed or rate limited. The
+    // AsyncUDP callback; separate so the host tests can replay queries.
+    size_t respond(const uint8_t* query, size_t len, uint32_t ip, uint8_t* resp);
+
+    uint32_t getAnsweredCount() const;
+    uint32_t getRateLimitedCount() const;
+    uint32_t getMalformedCount() const;
+
+private:
+    AsyncUDP _udp;
+    bool _running;
+
+    // Prebuilt answer RR: name pointer to the question, type A, class IN, TTL, RDATA
+    uint8_t _answer[16];
+
+    struct Bucket {
+        uint32_t ip;
+        uint32_t lastRefill;   // millis()
+        uint16_t tokens;
+    };
+    Bucket _buckets[CAPTIVE_DNS_MAX_CLIENTS];
+
+    // Only touched from the AsyncUDP task, read from loop() for stats
+    volatile uint32_t _answered;
+    volatile uint32_t _rateLimited;
+    volatile uint32_t _malformed;
+
+    void handlePacket(AsyncUDPPacket& packet);
+    bool admit(uint32_t ip);
+};
+
+#endif
@@ -0,0 +1,85 @@
+// OSC-Muis - Niels van der Hulst 2026
+
+#ifndef CONFIG_SNAPSHOT_H
+#define CONFIG_SNAPSHOT_H
+
+#include <Arduino.h>
+#include <atomic>
+
+// Configuration shared between writers on other tasks (async web handlers)
+// and a hot-path reader in loop(), published as whole versioned snapshots.
+//
+// Sequence lock: the counter is odd while a write is in progress. A reader
+// copies the config and retries if the counter was odd or changed during the
+// copy, so it never takes a lock and never sees half of an update. Writers
+// are serialized by a mutex (they're rare and never on the hot path).
+//
+// T must be trivially copyable (fixed-size fields only — no String).
+//
+// The counter is only odd with the scheduler suspended: on the single-core
+// C3 a reader that preempted a writer mid-publish (an AsyncTCP handler
+// reading while loop() saves) would otherwise spin forever, since the writer
+// can't run again until the reader gives up the CPU. Interrupts stay
+// enabled; readers must not run in an ISR.
+template <typename T>
+class ConfigSnapshot {
+public:
+    ConfigSnapshot() : _seq(0), _writeLock(nullptr) {}
+
+    // Publish the initial config (call once in setup(), before any reader/writer)
+    void begin(const T& initial) {
+        if (!_writeLock) _writeLock = xSemaphoreCreateMutex();
+        _value = initial;
+        _seq.store(2, std::memory_order_release);
+    }
+
+    // Lock-free consistent copy of the current config
+    void read(T& out) const {
+        uint32_t before, after;
+        do {
+            before = _seq.load(std::memory_order_acquire);
+            out = _value;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = _seq.load(std::memory_order_relaxed);
+        } while ((before & 1) || before != after);
+    }
+
+    T read() const {
+        T out;
+        read(out);
+        return out;
+    }
+
+    // Changes with every publish (0 = not yet published)
+    uint32_t version() const {
+        return _seq.load(std::memory_order_acquire) / 2;
+    }
+
+    // Read-modify-publish under the writer lock. fn edits a private copy and
+    // returns whether to publish it; returns that result.
+    template <typename F>
+    bool update(F fn) {
+        xSemaphoreTake(_writeLock, portMAX_DELAY);
+        T next = _value;  // writers are serialized, so no torn read here
+        bool changed = fn(next);
+        if (changed) {
+            // No task switch while the counter is odd (see above)
+            vTaskSuspendAll();
+            uint32_t seq = _seq.load(std::memory_order_relaxed);
+            _seq.store(seq + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            _value = next;
+            _seq.store(seq + 2, std::memory_order_release);
+            xTaskResumeAll();
+        }
+        xSemaphoreGive(_writeLock);
+        return changed;
+    }
+
+private:
+    T _value;
+    std::atomic<uint32_t> _seq;
+    SemaphoreHandle_t _writeLock;
+};
+
+#endif
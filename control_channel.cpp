@@ -0,0 +1,186 @@
+// OSC-Muis - Niels van der Hulst 2026
+
+#include "control_channel.h"
+#include "admission_control.h"
+
+// Request that came in as an HTTP route: body params for POST, query for GET
+class HttpControlRequest : public ControlRequest {
+public:
+    HttpControlRequest(AsyncWebServerRequest* request, bool post)
+        : _request(request), _post(post) {}
+
+    bool hasParam(const char* name) const override {
+        return _request->hasParam(name, _post);
+    }
+    String getParam(const char* name) const override {
+        const AsyncWebParameter* p = _request->getParam(name, _post);
+        return p ? p->value() : String();
+    }
+    IPAddress remoteIP() const override {
+        return _request->client()->remoteIP();
+    }
+
+private:
+    AsyncWebServerRequest* _request;
+    bool _post;
+};
+
+// Request that came in over the socket: params are a urlencoded string
+class SocketControlRequest : public ControlRequest {
+public:
+    SocketControlRequest(const char* params, IPAddress remote)
+        : _params(params), _remote(remote) {}
+
+    bool hasParam(const char* name) const override {
+        return find(name, nullptr);
+    }
+    String getParam(const char* name) const override {
+        String value;
+        find(name, &value);
+        return value;
+    }
+    IPAddress remoteIP() const override {
+        return _remote;
+    }
+
+private:
+    const char* _params;
+    IPAddress _remote;
+
+    static int hexValue(char c) {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    }
+
+    // Scan "k=v&k=v" for name; URL-decode its value into *out if given
+    bool find(const char* name, String* out) const {
+        size_t nameLen = strlen(name);
+        const char* p = _params;
+        while (*p) {
+            const char* end = strchr(p, '&');
+            if (!end) end = p + strlen(p);
+            if ((size_t)(end - p) > nameLen && strncmp(p, name, nameLen) == 0 && p[nameLen] == '=') {
+                if (out) {
+                    for (const char* v = p + nameLen + 1; v < end; v++) {
+                        if (*v == '+') {
+                            *out += ' ';
+                        } else if (*v == '%' && end - v > 2 && hexValue(v[1]) >= 0 && hexValue(v[2]) >= 0) {
+                            *out += (char)(hexValue(v[1]) * 16 + hexValue(v[2]));
+                            v += 2;
+                        } else {
+                            *out += *v;
+                        }
+                    }
+                }
+                return true;
+            }
+            p = *end ? end + 1 : end;
+        }
+        return false;
+    }
+};
+
+ControlChannel::ControlChannel() : _ws("/ws") {
+    _webServer = nullptr;
+    _admission = nullptr;
+    _actionCount = 0;
+}
+
+void ControlChannel::begin(AsyncWebServer& webServer) {
+    _webServer = &webServer;
+
+    _ws.onEvent([this](AsyncWebSocket* server, AsyncWebSocketClient* client,
+                       AwsEventType type, void* arg, uint8_t* data, size_t len) {
+        if (type != WS_EVT_DATA) return;
+        AwsFrameInfo* info = (AwsFrameInfo*)arg;
+        // Requests are tiny: accept only complete, unfragmented text frames
+        if (!info->final || info->index != 0 || info->len != len || info->opcode != WS_TEXT) return;
+        if (len >= CONTROL_MAX_MESSAGE) return;
+
+        char msg[CONTROL_MAX_MESSAGE];
+        memcpy(msg, data, len);
+        msg[len] = '\0';
+        handleMessage(client, msg, len);
+    });
+    webServer.addHandler(&_ws);
+}
+
+void ControlChannel::registerAction(const char* name, const char* httpPath, WebRequestMethod method, ControlHandler handler) {
+    if (_actionCount >= CONTROL_MAX_ACTIONS) {
+        Serial.printf("WARNING: no room for control action %s\n", name);
+        return;
+    }
+    _actions[_actionCount].name = name;
+    _actions[_actionCount].handler = handler;
+    _actionCount++;
+
+    if (httpPath && _webServer) {
+        bool post = (method == HTTP_POST);
+        _webServer->on(httpPath, method, [handler, post](AsyncWebServerRequest *request) {
+            HttpControlRequest req(request, post);
+            request->send(200, "application/json", handler(req));
+        });
+    }
+}
+
+void ControlChannel::handleMessage(AsyncWebSocketClient* client, const char* msg, size_t len) {
+    // "<id> <action>[ <params>]"
+    char* rest;
+    long id = strtol(msg, &rest, 10);
+    if (rest == msg || *rest != ' ') return;
+    rest++;
+
+    const char* params = strchr(rest, ' ');
+    size_t nameLen = params ? (size_t)(params - rest) : strlen(rest);
+    params = params ? params + 1 : "";
+
+    String reply = "{\"id\":" + String(id) + ",\"r\":";
+    if (_admission && !_admission->admitMessage(client->remoteIP())) {
+        reply += _admission->isLocked() ? "{\"success\":false,\"message\":\"Show lock active\"}}"
+                                        : "{\"success\":false,\"message\":\"Too many requests\"}}";
+        client->text(reply);
+        return;
+    }
+
+    bool found = false;
+    for (int i = 0; i < _actionCount; i++) {
+        if (strlen(_actions[i].name) == nameLen && strncmp(_actions[i].name, rest, nameLen) == 0) {
+            SocketControlRequest req(params, client->remoteIP());
+            reply += _actions[i].handler(req);
+            found = true;
+            break;
+        }
+    }
+    if (!found) reply += "{\"success\":false,\"message\":\"Unknown action\"}";
+    reply += "}";
+    client->text(reply);
+}
+
+void ControlChannel::setAdmission(AdmissionControl* admission) {
+    _admission = admission;
+}
+
+void ControlChannel::push(const char* event, const String& json) {
+    if (_ws.count() == 0) return;
+    String msg = "{\"ev\":\"";
+    msg += event;
+    msg += "\",\"d\":";
+    msg += json;
+    msg += "}";
+    _ws.textAll(msg);
+}
+
+void ControlChannel::loop() {
+    // Drop clients that went away without a close frame (phone locked, left AP)
+    static unsigned long lastCleanup = 0;
+    if (millis() - lastCleanup > 1000) {
+        _ws.cleanupClients();
+        lastCleanup = millis();
+    }
+}
+
+size_t ControlChannel::clientCount() const {
+    return _ws.count();
+}
@@ -0,0 +1,76 @@
+// OSC-Muis - Niels van der Hulst 2026
+
+#ifndef CONTROL_CHANNEL_H
+#define CONTROL_CHANNEL_H
+
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+#include <functional>
+
+#define CONTROL_MAX_ACTIONS 32
+#define CONTROL_MAX_MESSAGE 384    // Largest request frame accepted over the socket
+
+class AdmissionControl;
+
+// Parameters of one control action, independent of how it arrived
+class ControlRequest {
+public:
+    virtual ~ControlRequest() {}
+    virtual bool hasParam(const char* name) const = 0;
+    virtual String getParam(const char* name) const = 0;
+    virtual IPAddress remoteIP() const = 0;
+};
+
+// Action handler: validates/applies the request and returns the JSON reply body
+typedef std::function<String(const ControlRequest& request)> ControlHandler;
+
+// One control surface for the portal: every action is reachable both over a
+// single WebSocket (/ws) and as its classic HTTP route (kept for scripting).
+//
+// Each HTTP action used to cost the portal a fresh AsyncTCP connection (plus
+// /constatus polling every 500 ms while connecting). Over the socket it's one
+// frame each way, and the device pushes connect progress, test results and
+// settings changes instead of being polled.
+//
+// Wire protocol (text frames):
+//   client -> device   "<id> <action>[ <urlencoded params>]"   e.g. "3 connect ssid=Foo&password=bar"
+//   device -> client   {"id":<id>,"r":<reply JSON>}
+//   device -> all      {"ev":"<event>","d":<event JSON>}
+class ControlChannel {
+public:
+    ControlChannel();
+
+    // Attach the socket to the web server (call before the server starts)
+    void begin(AsyncWebServer& webServer);
+
+    // Register an action under a socket name and, if httpPath is set, as an
+    // HTTP route with the given method. Call before the server starts.
+    void registerAction(const char* name, const char* httpPath, WebRequestMethod method, ControlHandler handler);
+
+    // Rate limit / show lock applied to every socket message (optional)
+    void setAdmission(AdmissionControl* admission);
+
+    // Push an event to every connected socket client
+    void push(const char* event, const String& json);
+
+    // Housekeeping (drops stale socket clients) — call from loop()
+    void loop();
+
+    size_t clientCount() const;
+
+private:
+    AsyncWebServer* _webServer;
+    AsyncWebSocket _ws;
+    AdmissionControl* _admission;
+
+    struct Action {
+        const char* name;
+        ControlHandler handler;
+    };
+    Action _actions[CONTROL_MAX_ACTIONS];
+    int _actionCount;
+
+    void handleMessage(AsyncWebSocketClient* client, const char* msg, size_t len);
+};
+
+#endif
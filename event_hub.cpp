@@ -0,0 +1,125 @@
+// OSC-Muis - Niels van der Hulst 2026
+
+#include "event_hub.h"
+#include "log_ring.h"
+
+// Single instance pointer for the library's static-style callbacks
+static EventHub* _hubInstance = nullptr;
+
+EventHub::EventHub(const char* url) : _source(url) {
+    _slotCount = 0;
+    for (int i = 0; i < EVENT_HUB_MAX_CLIENTS; i++) _clients[i] = nullptr;
+    _lock = nullptr;
+    _resyncPending = false;
+    _lastFrame = 0;
+    _lastId = 0;
+    _sent = 0;
+    _coalesced = 0;
+    _shed = 0;
+}
+
+void EventHub::begin(AsyncWebServer& webServer) {
+    _hubInstance = this;
+    _lock = xSemaphoreCreateRecursiveMutex();
+
+    // New client: remember it for backpressure and resend the full state on
+    // the next frame (to everyone — the values are idempotent for the UI).
+    _source.onConnect([](AsyncEventSourceClient* client) {
+        bool tracked = false;
+        for (int i = 0; i < EVENT_HUB_MAX_CLIENTS && !tracked; i++) {
+            AsyncEventSourceClient* empty = nullptr;
+            tracked = _hubInstance->_clients[i].compare_exchange_strong(empty, client);
+        }
+        if (!tracked) Serial.println("Events: client table full, no backpressure for this client");
+        _hubInstance->_resyncPending = true;
+    });
+
+    // Runs before the library frees the client; waits if loop() is using it
+    _source.onDisconnect([](AsyncEventSourceClient* client) {
+        xSemaphoreTakeRecursive(_hubInstance->_lock, portMAX_DELAY);
+        for (int i = 0; i < EVENT_HUB_MAX_CLIENTS; i++) {
+            if (_hubInstance->_clients[i] == client) _hubInstance->_clients[i] = nullptr;
+        }
+        xSemaphoreGiveRecursive(_hubInstance->_lock);
+    });
+
+    webServer.addHandler(&_source);
+}
+
+void EventHub::publish(const char* event, const char* data) {
+    Slot* slot = nullptr;
+    for (int i = 0; i < _slotCount; i++) {
+        if (_slots[i].event == event || strcmp(_slots[i].event, event) == 0) {
+            slot = &_slots[i];
+            break;
+        }
+    }
+    if (!slot) {
+        if (_slotCount >= EVENT_HUB_MAX_EVENTS) {
+            Serial.printf("Events: no slot for '%s' (max %d)\n", event, EVENT_HUB_MAX_EVENTS);
+            return;
+        }
+        slot = &_slots[_slotCount++];
+        slot->event = event;
+        slot->data[0] = '\0';
+        slot->dirty = false;
+    } else if (strcmp(slot->data, data) == 0) {
+        return;
+    }
+
+    if (slot->dirty) _coalesced++;
+    strncpy(slot->data, data, sizeof(slot->data) - 1);
+    slot->data[sizeof(slot->data) - 1] = '\0';
+    slot->dirty = true;
+}
+
+void EventHub::shedSlowClients() {
+    xSemaphoreTakeRecursive(_lock, portMAX_DELAY);
+    for (int i = 0; i < EVENT_HUB_MAX_CLIENTS; i++) {
+        AsyncEventSourceClient* client = _clients[i];
+        if (!client || client->packetsWaiting() <= EVENT_HUB_CLIENT_QUEUE_MAX) continue;
+
+        LOG_WARN("Events: shedding slow client (%u queued)", (unsigned)client->packetsWaiting());
+        _clients[i] = nullptr;
+        _shed++;
+        // May run onDisconnect synchronously on this task — the lock is recursive
+        client->close();
+    }
+    xSemaphoreGiveRecursive(_lock);
+}
+
+void EventHub::loop() {
+    if (!_lock) return;
+
+    unsigned long now = millis();
+    if (now - _lastFrame < EVENT_HUB_FRAME_MS) return;
+    _lastFrame = now;
+
+    shedSlowClients();
+    if (_source.count() == 0) {
+        // Nobody listening: keep the latest values, a new client resyncs anyway
+        for (int i = 0; i < _slotCount; i++) _slots[i].dirty = false;
+        return;
+    }
+
+    bool resync = _resyncPending.exchange(false);
+    for (int i = 0; i < _slotCount; i++) {
+        Slot& slot = _slots[i];
+        if (!slot.dirty && !(resync && slot.data[0])) continue;
+        _source.send(slot.data, slot.event, ++_lastId);
+        slot.dirty = false;
+        _sent++;
+    }
+}
+
+uint32_t EventHub::getSentCount() const {
+    return _sent;
+}
+
+uint32_t EventHub::getCoalescedCount() const {
+    return _coalesced;
+}
+
+uint32_t EventHub::getShedCount() const {
+    return _shed;
+}
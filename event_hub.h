@@ -0,0 +1,75 @@
+// OSC-Muis - Niels van der Hulst 2026
+
+#ifndef EVENT_HUB_H
+#define EVENT_HUB_H
+
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+#include <atomic>
+
+#define EVENT_HUB_MAX_EVENTS 4         // Distinct event names ("buttons", "battery", ...)
+#define EVENT_HUB_MAX_DATA 288         // Largest event payload, including terminator ("buttons" on 16-key boards)
+#define EVENT_HUB_MAX_CLIENTS 4        // Tracked for backpressure; matches the AP's client cap
+#define EVENT_HUB_FRAME_MS 100         // Coalescing interval
+#define EVENT_HUB_CLIENT_QUEUE_MAX 8   // Queued messages before a client is shed
+
+// Server-Sent Events publisher for the portal's live status (/events).
+//
+// - Coalesced: publish() only stores the latest value per event name; loop()
+//   sends whatever changed once per frame interval, so a burst of button edges
+//   costs one message per client, not one per edge.
+// - Serialized once: payloads live in fixed per-event buffers and go out with a
+//   single broadcast, which the library frames once and shares between all
+//   clients. No String is built on the steady-state path.
+// - Backpressure: a client whose queue holds more than
+//   EVENT_HUB_CLIENT_QUEUE_MAX messages (a phone that went to sleep with the
+//   portal open) is closed instead of growing its queue without bound. The
+//   browser's EventSource reconnects by itself and is resynced with the full
+//   current state on the next frame.
+class EventHub {
+public:
+    explicit EventHub(const char* url);
+
+    // Attach /events to the web server (call before the server starts)
+    void begin(AsyncWebServer& webServer);
+
+    // Store the latest value for an event. event must be a string literal
+    // (the pointer is kept). Unchanged values are ignored.
+    void publish(const char* event, const char* data);
+
+    // Flush changed events once per frame interval — call from loop()
+    void loop();
+
+    // Diagnostics
+    uint32_t getSentCount() const;
+    uint32_t getCoalescedCount() const;   // Values overwritten before they were sent
+    uint32_t getShedCount() const;        // Clients closed for falling behind
+
+private:
+    AsyncEventSource _source;
+
+    struct Slot {
+        const char* event;
+        char data[EVENT_HUB_MAX_DATA];
+        bool dirty;
+    };
+    Slot _slots[EVENT_HUB_MAX_EVENTS];
+    int _slotCount;
+
+    // Clients are added on the AsyncTCP task (onConnect runs with the library's
+    // client lock held, so insertion is lock-free) and removed under _lock,
+    // which loop() holds while it inspects or closes them.
+    std::atomic<AsyncEventSourceClient*> _clients[EVENT_HUB_MAX_CLIENTS];
+    SemaphoreHandle_t _lock;
+    std::atomic<bool> _resyncPending;
+
+    unsigned long _lastFrame;
+    uint32_t _lastId;
+    uint32_t _sent;
+    uint32_t _coalesced;
+    uint32_t _shed;
+
+    void shedSlowClients();
+};
+
+#endif
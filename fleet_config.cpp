@@ -0,0 +1,726 @@
+// OSC-Muis - Niels van der Hulst 2026
+
+#include "fleet_config.h"
+#include "osc_manager.h"
+#include "osc_wire.h"
+#include <esp_netif.h>
+#include <mbedtls/md.h>
+#include <stdarg.h>
+
+#define FLEET_LINE_MAX 256            // One "key=value" line of a bundle, including terminator
+#define FLEET_ACK_MAX 64              // Largest /muis/fleet/ack
+
+// Static instance pointer for web callbacks
+static FleetConfig* _fleetConfigInstance = nullptr;
+
+static uint32_t fullMask(uint32_t count) {
+    return count >= 32 ? 0xFFFFFFFF : (1u << count) - 1;
+}
+
+// The unit's device id as WiFiManager::initIdentity() makes it: 6 lowercase
+// hex digits. Acks are unsigned and the id ends up in the portal's JSON and
+// page, so anything else is dropped
+static bool isDeviceId(const char* id) {
+    if (strlen(id) != WIFI_DEVICE_ID_MAX - 1) return false;
+    for (const char* c = id; *c; c++) {
+        if (!((*c >= '0' && *c <= '9') || (*c >= 'a' && *c <= 'f'))) return false;
+    }
+    return true;
+}
+
+// snprintf onto the end of buf; false (and n unchanged) if it doesn't fit
+static bool appendf(char* buf, size_t size, size_t& n, const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    int written = vsnprintf(buf + n, size - n, fmt, args);
+    va_end(args);
+    if (written < 0 || (size_t)written >= size - n) return false;
+    n += written;
+    return true;
+}
+
+// "1,2,3" into out[BOARD_BUTTONS]; buttons past the list keep their value,
+// values past BOARD_BUTTONS (a unit with more buttons) are ignored
+static bool parseChannels(const char* list, int* out) {
+    for (int i = 0; *list; i++) {
+        char* end;
+        long channel = strtol(list, &end, 10);
+        if (end == list || channel < 1 || channel > 99) return false;
+        if (i < BOARD_BUTTONS) out[i] = channel;
+        if (*end == ',') end++;
+        else if (*end) return false;
+        list = end;
+    }
+    return true;
+}
+
+FleetConfig::FleetConfig() {
+    _oscManager = nullptr;
+    _presetBank = nullptr;
+    _wifiManager = nullptr;
+    _key[0] = '\0';
+    _lastApplied = 0;
+    _rx.id = 0;
+    _rx.count = 0;
+    _rx.received = 0;
+    _rx.length = 0;
+    _rx.status = STATUS_NONE;
+    _rx.replyPort = 0;
+    _rx.replyDue = false;
+    _rx.replyAt = 0;
+    memset(&_push, 0, sizeof(_push));
+    _push.state = PUSH_IDLE;
+    _requestedPush = false;
+    _requestedKey = false;
+    _requestedKeyValue[0] = '\0';
+}
+
+void FleetConfig::begin(OSCManager& oscManager, PresetBank& presetBank, WiFiManager& wifiManager) {
+    _oscManager = &oscManager;
+    _presetBank = &presetBank;
+    _wifiManager = &wifiManager;
+    _fleetConfigInstance = this;
+    _json.begin();
+
+    _preferences.begin("fleet", true);
+    _preferences.getString("key", _key, sizeof(_key));
+    _lastApplied = _preferences.getUInt("last", 0);
+    _preferences.end();
+
+    resumeJournal();
+    publish();
+
+    if (!wifiManager.isHeadless()) {
+        registerActions();
+    }
+    Serial.printf("Fleet config: key %s, last bundle %u\n", _key[0] ? "set" : "not set", _lastApplied);
+}
+
+bool FleetConfig::isPushing() const {
+    return _push.state == PUSH_SENDING || _push.state == PUSH_WAITING;
+}
+
+void FleetConfig::loop() {
+    if (_requestedKey) {
+        setKey(_requestedKeyValue);
+        _requestedKey = false;
+        publish();
+    }
+    if (_json.refreshRequested()) publish();
+
+    // STA network only: the access point's clients are phones, not units
+    if (!_wifiManager->getState().staConnected) {
+        if (_socket.isOpen()) _socket.end();
+        _joinedIP = IPAddress(0, 0, 0, 0);
+        if (isPushing()) {
+            _push.state = PUSH_DONE;
+            publish();
+        }
+        _requestedPush = false;
+        return;
+    }
+    if (WiFi.localIP() != _joinedIP) openSocket();
+
+    poll();
+    if (_requestedPush) {
+        _requestedPush = false;
+        _push.newestSeen = 0;
+        _push.restarted = false;
+        startPush();
+    }
+    runPush();
+    sendReply();
+}
+
+void FleetConfig::openSocket() {
+    _joinedIP = WiFi.localIP();
+    char ifname[8] = {0};
+    esp_netif_t* netif = esp_netif_get_handle_from_ifkey("WIFI_STA_DEF");
+    if (netif) esp_netif_get_netif_impl_name(netif, ifname);
+
+    // Best effort: a push must never compete with presses for the EF queue
+    _socket.end();
+    if (_socket.begin(0, FLEET_CONFIG_PORT, ifname[0] ? ifname : nullptr)) {
+        _socket.joinGroup(IPAddress(FLEET_CONFIG_GROUP), _joinedIP);
+    }
+}
+
+void FleetConfig::poll() {
+    // Bounded, like the OSC command input
+    const int MAX_PACKETS_PER_POLL = 4;
+    IPAddress self = WiFi.localIP();
+
+    for (int n = 0; n < MAX_PACKETS_PER_POLL; n++) {
+        IPAddress from;
+        uint16_t port;
+        int size = _socket.receive(_packet, sizeof(_packet), from, port);
+        if (size <= 0) break;
+        if (from == self) continue;  // Our own multicast, looped back
+
+        const char* address;
+        const char* tags;
+        size_t pos = oscGetString(_packet, size, 0, &address);
+        if (pos) pos = oscGetString(_packet, size, pos, &tags);
+        if (!pos) continue;
+
+        if (strcmp(address, "/muis/fleet/chunk") == 0 && strcmp(tags, ",iiib") == 0) {
+            onChunk(_packet, size, pos, from, port);
+        } else if (strcmp(address, "/muis/fleet/commit") == 0 && strcmp(tags, ",ii") == 0) {
+            onCommit(_packet, size, pos, from, port);
+        } else if (strcmp(address, "/muis/fleet/ack") == 0 && strcmp(tags, ",siiii") == 0) {
+            onAck(_packet, size, pos, from);
+        }
+    }
+}
+
+// --- Receiving ---------------------------------------------------------------
+
+void FleetConfig::resetReceive(uint32_t id, uint32_t count) {
+    _rx.id = id;
+    _rx.count = count;
+    _rx.received = 0;
+    _rx.length = 0;
+    // Applied before: the sender lost our answer, nothing to receive
+    _rx.status = id == _lastApplied ? STATUS_APPLIED : STATUS_INCOMPLETE;
+}
+
+// /muis/fleet/chunk id index count data
+void FleetConfig::onChunk(const uint8_t* packet, size_t len, size_t pos, const IPAddress& from, uint16_t port) {
+    if (isPushing()) return;
+
+    int32_t id, index, count;
+    const uint8_t* data;
+    size_t size;
+    pos = oscGetInt(packet, len, pos, &id);
+    if (pos) pos = oscGetInt(packet, len, pos, &index);
+    if (pos) pos = oscGetInt(packet, len, pos, &count);
+    if (pos) pos = oscGetBlob(packet, len, pos, &data, &size);
+    if (!pos || id <= 0 || count < 1 || count > FLEET_MAX_CHUNKS || index < 0 || index >= count) return;
+
+    bool last = index == count - 1;
+    if (size == 0 || size > FLEET_CHUNK_DATA || (!last && size != FLEET_CHUNK_DATA)) return;
+    // The last of FLEET_MAX_CHUNKS chunks only has room for the remainder
+    if ((size_t)index * FLEET_CHUNK_DATA + size > FLEET_BUNDLE_MAX) return;
+
+    if ((uint32_t)id != _rx.id || (uint32_t)count != _rx.count) resetReceive(id, count);
+    if (_rx.status != STATUS_INCOMPLETE) return;
+
+    memcpy(_bundle + index * FLEET_CHUNK_DATA, data, size);
+    _rx.received |= 1u << index;
+    if (last) _rx.length = index * FLEET_CHUNK_DATA + size;
+
+    if (_rx.received == fullMask(_rx.count)) {
+        finishReceive();
+        scheduleReply(from, port);
+    }
+}
+
+// /muis/fleet/commit id count  -> answer with how far we got
+void FleetConfig::onCommit(const uint8_t* packet, size_t len, size_t pos, const IPAddress& from, uint16_t port) {
+    if (isPushing()) return;
+
+    int32_t id, count;
+    pos = oscGetInt(packet, len, pos, &id);
+    if (pos) pos = oscGetInt(packet, len, pos, &count);
+    if (!pos || id <= 0 || count < 1 || count > FLEET_MAX_CHUNKS) return;
+
+    if ((uint32_t)id != _rx.id || (uint32_t)count != _rx.count) {
+        // Missed every chunk of it: the answer asks for all of them
+        resetReceive(id, count);
+    } else if (_rx.status == STATUS_LOCKED) {
+        finishReceive();
+    }
+    scheduleReply(from, port);
+}
+
+void FleetConfig::finishReceive() {
+    // onChunk() keeps every chunk inside _bundle; refuse anything else
+    if (_rx.length > FLEET_BUNDLE_MAX) {
+        _rx.status = STATUS_INVALID;
+        Serial.printf("Fleet bundle %u refused: %u bytes, more than %u\n",
+                      _rx.id, (unsigned)_rx.length, (unsigned)FLEET_BUNDLE_MAX);
+        return;
+    }
+    if (_rx.length <= FLEET_SIGNATURE_SIZE ||
+        !verify(_rx.id, _bundle, _rx.length - FLEET_SIGNATURE_SIZE, _bundle + _rx.length - FLEET_SIGNATURE_SIZE)) {
+        _rx.status = STATUS_SIGNATURE;
+        Serial.printf("Fleet bundle %u refused: not signed with our key\n", _rx.id);
+        return;
+    }
+    if (_rx.id <= _lastApplied) {
+        _rx.status = STATUS_STALE;
+        Serial.printf("Fleet bundle %u refused: not newer than %u\n", _rx.id, _lastApplied);
+        return;
+    }
+    if (_wifiManager->getAdmission().isLocked()) {
+        _rx.status = STATUS_LOCKED;
+        Serial.printf("Fleet bundle %u held: show lock\n", _rx.id);
+        return;
+    }
+
+    // Verified: the signature bytes are no longer needed, terminate the text
+    size_t textLength = _rx.length - FLEET_SIGNATURE_SIZE;
+    _bundle[textLength] = '\0';
+    const char* error = stage((const char*)_bundle);
+    if (error) {
+        _rx.status = STATUS_INVALID;
+        Serial.printf("Fleet bundle %u refused: %s\n", _rx.id, error);
+        return;
+    }
+
+    // Journal first: from here on the bundle is applied, reboot or not
+    _preferences.begin("fleet", false);
+    _preferences.putBytes("journal", _bundle, textLength + 1);
+    _preferences.putUInt("jid", _rx.id);
+    _preferences.end();
+
+    applyStaged(_rx.id);
+    _rx.status = STATUS_APPLIED;
+}
+
+void FleetConfig::resumeJournal() {
+    _preferences.begin("fleet", true);
+    size_t length = _preferences.getBytesLength("journal");
+    uint32_t id = _preferences.getUInt("jid", 0);
+    if (length > 0 && length <= FLEET_BUNDLE_MAX) {
+        _preferences.getBytes("journal", _bundle, length);
+    } else {
+        length = 0;
+    }
+    _preferences.end();
+    if (length == 0) return;
+
+    _bundle[length - 1] = '\0';
+    const char* error = stage((const char*)_bundle);
+    if (error) {
+        // Validated before it was journalled: only a firmware change gets here
+        Serial.printf("Fleet bundle %u dropped after reboot: %s\n", id, error);
+        _preferences.begin("fleet", false);
+        _preferences.remove("journal");
+        _preferences.end();
+        return;
+    }
+    Serial.printf("Fleet bundle %u was interrupted by a reboot, applying it again\n", id);
+    applyStaged(id);
+}
+
+void FleetConfig::applyStaged(uint32_t id) {
+    _oscManager->applySettings(_staged.config, " via fleet");
+    if (_staged.hasPresets) _presetBank->replaceAll(_staged.presets);
+
+    _lastApplied = id;
+    _preferences.begin("fleet", false);
+    _preferences.putUInt("last", id);
+    _preferences.remove("journal");
+    _preferences.end();
+
+    Serial.printf("Fleet bundle %u applied\n", id);
+    publish();
+}
+
+void FleetConfig::scheduleReply(const IPAddress& ip, uint16_t port) {
+    _rx.replyIP = ip;
+    _rx.replyPort = port;
+    // Spread out, so fifty answers don't arrive at the sender together
+    if (!_rx.replyDue) _rx.replyAt = millis() + random(FLEET_ACK_WINDOW_MS);
+    _rx.replyDue = true;
+}
+
+// /muis/fleet/ack unit id status chunks last
+void FleetConfig::sendReply() {
+    if (!_rx.replyDue || (long)(millis() - _rx.replyAt) < 0) return;
+    _rx.replyDue = false;
+
+    uint8_t out[FLEET_ACK_MAX];
+    size_t n = oscPutString(out, 0, "/muis/fleet/ack");
+    n = oscPutString(out, n, ",siiii");
+    n = oscPutString(out, n, _wifiManager->getDeviceId());
+    n = oscPutInt(out, n, _rx.id);
+    n = oscPutInt(out, n, _rx.status);
+    n = oscPutInt(out, n, _rx.received);
+    n = oscPutInt(out, n, _lastApplied);
+    _socket.beginPacket();
+    _socket.write(out, n);
+    _socket.endPacket(_rx.replyIP, _rx.replyPort);
+}
+
+// --- Signing -----------------------------------------------------------------
+
+// HMAC-SHA256(key, id as big-endian int32 + text) into out[FLEET_SIGNATURE_SIZE]
+void FleetConfig::sign(uint32_t id, const uint8_t* text, size_t length, uint8_t* out) const {
+    uint8_t idBytes[4];
+    oscPutInt(idBytes, 0, id);
+
+    mbedtls_md_context_t ctx;
+    mbedtls_md_init(&ctx);
+    mbedtls_md_setup(&ctx, mbedtls_md_info_from_type(MBEDTLS_MD_SHA256), 1);
+    mbedtls_md_hmac_starts(&ctx, (const unsigned char*)_key, strlen(_key));
+    mbedtls_md_hmac_update(&ctx, idBytes, sizeof(idBytes));
+    mbedtls_md_hmac_update(&ctx, text, length);
+    mbedtls_md_hmac_finish(&ctx, out);
+    mbedtls_md_free(&ctx);
+}
+
+bool FleetConfig::verify(uint32_t id, const uint8_t* text, size_t length, const uint8_t* signature) const {
+    if (!_key[0]) return false;
+
+    uint8_t expected[FLEET_SIGNATURE_SIZE];
+    sign(id, text, length, expected);
+    // Constant time: how far a guess matched must not show in the timing
+    uint8_t diff = 0;
+    for (int i = 0; i < FLEET_SIGNATURE_SIZE; i++) diff |= expected[i] ^ signature[i];
+    return diff == 0;
+}
+
+// --- Bundle text -------------------------------------------------------------
+
+// Parse and validate every line into _staged; nothing is applied. Returns
+// nullptr or a message.
+const char* FleetConfig::stage(const char* text) {
+    _oscManager->getConfig(_staged.config);
+    _staged.hasPresets = false;
+    memset(_staged.presets, 0, sizeof(_staged.presets));
+    bool versioned = false;
+
+    while (*text) {
+        const char* end = strchr(text, '\n');
+        if (!end) end = text + strlen(text);
+        char line[FLEET_LINE_MAX];
+        size_t length = end - text;
+        if (length >= sizeof(line)) return "Line too long";
+        memcpy(line, text, length);
+        line[length] = '\0';
+        if (length > 0 && line[length - 1] == '\r') line[length - 1] = '\0';
+        text = *end ? end + 1 : end;
+        if (!line[0]) continue;
+
+        char* value = strchr(line, '=');
+        if (!value) return "Not a key=value line";
+        *value++ = '\0';
+        OSCConfig& config = _staged.config;
+
+        if (strcmp(line, "v") == 0) {
+            if (strcmp(value, "1") != 0) return "Unknown bundle version";
+            versioned = true;
+        } else if (strcmp(line, "port") == 0) {
+            long port = atol(value);
+            if (port < 1 || port > 65535) return "Invalid port";
+            config.port = port;
+        } else if (strcmp(line, "target") == 0) {
+            IPAddress test;
+            if (strlen(value) >= OSC_TARGET_IP_MAX || (value[0] && !test.fromString(value))) return "Invalid target IP";
+            config.setTargetIP(value);
+        } else if (strcmp(line, "format") == 0) {
+            if (strlen(value) >= OSC_ADDRESS_FORMAT_MAX) return "Address format too long";
+            const char* error = config.program.compile(value);
+            if (error) return error;
+            strlcpy(config.addressFormat, value, sizeof(config.addressFormat));
+        } else if (strcmp(line, "channels") == 0) {
+            if (!parseChannels(value, config.channels)) return "Invalid channels";
+        } else if (strcmp(line, "prefix") == 0) {
+            config.addressPrefix = strcmp(value, "1") == 0;
+        } else if (strcmp(line, "presets") == 0) {
+            // The bank is replaced by the preset lines (none = cleared)
+            _staged.hasPresets = true;
+        } else if (strcmp(line, "preset") == 0) {
+            const char* error = stagePreset(value);
+            if (error) return error;
+        }
+        // Anything else is from a newer sender: skipped
+    }
+    return versioned ? nullptr : "Missing v=1";
+}
+
+// "slot|name|target|channels|format" (the format goes last: it may contain |)
+const char* FleetConfig::stagePreset(char* value) {
+    char* fields[4];
+    char* p = value;
+    for (int i = 0; i < 4; i++) {
+        fields[i] = p;
+        p = strchr(p, '|');
+        if (!p) return "Preset needs slot|name|target|channels|format";
+        *p++ = '\0';
+    }
+    int slot = atoi(fields[0]);
+    if (slot < 1 || slot > PRESET_MAX) return "Invalid preset slot";
+    if (strlen(fields[1]) >= PRESET_NAME_MAX || strlen(fields[2]) >= OSC_TARGET_IP_MAX ||
+        strlen(p) >= OSC_ADDRESS_FORMAT_MAX) {
+        return "Preset field too long";
+    }
+
+    int channels[BOARD_BUTTONS];
+    for (int i = 0; i < BOARD_BUTTONS; i++) channels[i] = i + 1;
+    if (!parseChannels(fields[3], channels)) return "Invalid preset channels";
+
+    PresetBank::StoredPreset& stored = _staged.presets[slot - 1];
+    memset(&stored, 0, sizeof(stored));
+    strlcpy(stored.name, fields[1], sizeof(stored.name));
+    strlcpy(stored.targetIP, fields[2], sizeof(stored.targetIP));
+    strlcpy(stored.addressFormat, p, sizeof(stored.addressFormat));
+    for (int i = 0; i < BOARD_BUTTONS; i++) stored.channels[i] = channels[i];
+    _staged.hasPresets = true;
+    return PresetBank::check(stored);
+}
+
+// This unit's settings and presets as a signed bundle in _bundle. Returns its
+// length, 0 if it doesn't fit.
+size_t FleetConfig::buildBundle(uint32_t id) {
+    OSCConfig config;
+    _oscManager->getConfig(config);
+    char* text = (char*)_bundle;
+    const size_t size = FLEET_BUNDLE_MAX - FLEET_SIGNATURE_SIZE;
+    size_t n = 0;
+
+    bool ok = appendf(text, size, n, "v=1\nport=%d\ntarget=%s\nformat=%s\nprefix=%d\nchannels=",
+                      config.port, config.targetIP, config.addressFormat, config.addressPrefix ? 1 : 0);
+    for (int i = 0; ok && i < BOARD_BUTTONS; i++) {
+        ok = appendf(text, size, n, i ? ",%d" : "%d", config.channels[i]);
+    }
+    ok = ok && appendf(text, size, n, "\npresets=\n");
+
+    for (int slot = 0; ok && slot < PRESET_MAX; slot++) {
+        PresetBank::StoredPreset stored;
+        if (!_presetBank->getStored(slot, stored)) continue;
+        ok = appendf(text, size, n, "preset=%d|%s|%s|", slot + 1, stored.name, stored.targetIP);
+        for (int i = 0; ok && i < BOARD_BUTTONS; i++) {
+            ok = appendf(text, size, n, i ? ",%d" : "%d", stored.channels[i]);
+        }
+        ok = ok && appendf(text, size, n, "|%s\n", stored.addressFormat);
+    }
+    if (!ok) return 0;
+
+    sign(id, _bundle, n, _bundle + n);
+    return n + FLEET_SIGNATURE_SIZE;
+}
+
+// --- Pushing -----------------------------------------------------------------
+
+void FleetConfig::startPush() {
+    if (!_key[0] || !_socket.isOpen()) return;
+
+    // Newer than anything this unit applied, or any unit said it has
+    uint32_t id = max(_lastApplied, _push.newestSeen) + 1;
+    size_t length = buildBundle(id);
+    if (length == 0) {
+        Serial.println("Fleet push: settings don't fit in a bundle");
+        return;
+    }
+
+    _push.id = id;
+    _push.length = length;
+    _push.count = (length + FLEET_CHUNK_DATA - 1) / FLEET_CHUNK_DATA;
+    _push.pending = fullMask(_push.count);
+    _push.round = 0;
+    _push.roundEnd = millis() + FLEET_ROUND_MS;
+    _push.unitCount = 0;
+    _push.state = PUSH_SENDING;
+
+    // What we send is what we run: a replay of it is stale here too
+    _lastApplied = id;
+    _preferences.begin("fleet", false);
+    _preferences.putUInt("last", id);
+    _preferences.end();
+
+    Serial.printf("Fleet push: bundle %u, %u bytes in %u chunks\n", id, (unsigned)length, _push.count);
+    publish();
+}
+
+void FleetConfig::runPush() {
+    if (_push.state == PUSH_SENDING) {
+        if (_push.pending) {
+            // One chunk per pass: the button path never waits for a whole round
+            int index = __builtin_ctz(_push.pending);
+            if (sendChunk(index)) {
+                _push.pending &= ~(1u << index);
+            } else if ((long)(millis() - _push.roundEnd) >= 0) {
+                _push.pending = 0;  // TX queue stuck; the answers will ask again
+            }
+            return;
+        }
+        sendCommit();
+        _push.state = PUSH_WAITING;
+        _push.roundEnd = millis() + FLEET_ROUND_MS;
+    } else if (_push.state == PUSH_WAITING && (long)(millis() - _push.roundEnd) >= 0) {
+        endRound();
+    }
+}
+
+bool FleetConfig::sendChunk(int index) {
+    size_t offset = index * FLEET_CHUNK_DATA;
+    size_t size = min((size_t)FLEET_CHUNK_DATA, _push.length - offset);
+
+    size_t n = oscPutString(_packet, 0, "/muis/fleet/chunk");
+    n = oscPutString(_packet, n, ",iiib");
+    n = oscPutInt(_packet, n, _push.id);
+    n = oscPutInt(_packet, n, index);
+    n = oscPutInt(_packet, n, _push.count);
+    n = oscPutBlob(_packet, n, _bundle + offset, size);
+    _socket.beginPacket();
+    _socket.write(_packet, n);
+    return _socket.endPacket(IPAddress(FLEET_CONFIG_GROUP), FLEET_CONFIG_PORT);
+}
+
+void FleetConfig::sendCommit() {
+    uint8_t out[32];
+    size_t n = oscPutString(out, 0, "/muis/fleet/commit");
+    n = oscPutString(out, n, ",ii");
+    n = oscPutInt(out, n, _push.id);
+    n = oscPutInt(out, n, _push.count);
+    _socket.beginPacket();
+    _socket.write(out, n);
+    _socket.endPacket(IPAddress(FLEET_CONFIG_GROUP), FLEET_CONFIG_PORT);
+}
+
+// /muis/fleet/ack unit id status chunks last
+void FleetConfig::onAck(const uint8_t* packet, size_t len, size_t pos, const IPAddress& from) {
+    if (!isPushing()) return;
+
+    const char* unitId;
+    int32_t id, status, received, last;
+    pos = oscGetString(packet, len, pos, &unitId);
+    if (pos) pos = oscGetInt(packet, len, pos, &id);
+    if (pos) pos = oscGetInt(packet, len, pos, &status);
+    if (pos) pos = oscGetInt(packet, len, pos, &received);
+    if (pos) pos = oscGetInt(packet, len, pos, &last);
+    if (!pos || (uint32_t)id != _push.id || status < 0 || status >= STATUS_NONE) return;
+    if (!isDeviceId(unitId)) return;
+
+    Unit* unit = nullptr;
+    for (int i = 0; i < _push.unitCount && !unit; i++) {
+        if (strcmp(_push.units[i].id, unitId) == 0) unit = &_push.units[i];
+    }
+    if (!unit) {
+        if (_push.unitCount >= FLEET_PUSH_MAX_UNITS) return;
+        unit = &_push.units[_push.unitCount++];
+        strlcpy(unit->id, unitId, sizeof(unit->id));
+    }
+    unit->ip = (uint32_t)from;
+    unit->status = (Status)status;
+    unit->received = received;
+    if (status == STATUS_STALE && (uint32_t)last > _push.newestSeen) _push.newestSeen = last;
+}
+
+void FleetConfig::endRound() {
+    _push.round++;
+    uint32_t missing = 0;
+    bool waiting = false;
+    bool stale = false;
+    for (int i = 0; i < _push.unitCount; i++) {
+        const Unit& unit = _push.units[i];
+        if (unit.status == STATUS_INCOMPLETE) missing |= fullMask(_push.count) & ~unit.received;
+        if (unit.status == STATUS_INCOMPLETE || unit.status == STATUS_LOCKED) waiting = true;
+        if (unit.status == STATUS_STALE) stale = true;
+    }
+
+    // Some unit already has a newer bundle (another portal, the host tool):
+    // start over once with an id above it
+    if (stale && !_push.restarted) {
+        _push.restarted = true;
+        Serial.printf("Fleet push: units ahead of bundle %u, sending again as %u\n",
+                      _push.id, _push.newestSeen + 1);
+        startPush();
+        return;
+    }
+
+    if ((_push.round >= FLEET_PUSH_MIN_ROUNDS && !waiting) || _push.round >= FLEET_PUSH_MAX_ROUNDS) {
+        int applied = 0;
+        for (int i = 0; i < _push.unitCount; i++) {
+            if (_push.units[i].status == STATUS_APPLIED) applied++;
+        }
+        _push.state = PUSH_DONE;
+        Serial.printf("Fleet push: bundle %u applied by %d of %d units that answered (%d rounds)\n",
+                      _push.id, applied, _push.unitCount, _push.round);
+    } else {
+        _push.pending = missing;
+        _push.state = PUSH_SENDING;
+        _push.roundEnd = millis() + FLEET_ROUND_MS;
+    }
+    publish();
+}
+
+// --- Portal ------------------------------------------------------------------
+
+const char* FleetConfig::statusName(Status status) {
+    switch (status) {
+        case STATUS_APPLIED:    return "applied";
+        case STATUS_INCOMPLETE: return "incomplete";
+        case STATUS_SIGNATURE:  return "wrong key";
+        case STATUS_INVALID:    return "invalid";
+        case STATUS_STALE:      return "stale";
+        case STATUS_LOCKED:     return "show lock";
+        default:                return "no answer";
+    }
+}
+
+String FleetConfig::getJson() const {
+    const char* state = isPushing() ? "sending" : (_push.state == PUSH_DONE ? "done" : "idle");
+    String json = "{\"keySet\":";
+    json += _key[0] ? "true" : "false";
+    json += ",\"lastBundle\":" + String(_lastApplied);
+    json += ",\"push\":{\"state\":\"" + String(state) + "\"";
+    json += ",\"bundle\":" + String(_push.id);
+    json += ",\"round\":" + String(_push.round);
+    json += ",\"units\":[";
+    for (int i = 0; i < _push.unitCount; i++) {
+        const Unit& unit = _push.units[i];
+        if (i > 0) json += ",";
+        json += "{\"id\":\"" + String(unit.id) + "\"";
+        json += ",\"ip\":\"" + IPAddress(unit.ip).toString() + "\"";
+        json += ",\"status\":\"" + String(statusName(unit.status)) + "\"}";
+    }
+    json += "]}}";
+    return json;
+}
+
+void FleetConfig::publish() {
+    String json = getJson();
+    if (_wifiManager) _wifiManager->getControlChannel().push("fleet", json);
+    _json.set(std::move(json));
+}
+
+void FleetConfig::setKey(const char* key) {
+    strlcpy(_key, key, sizeof(_key));
+    _preferences.begin("fleet", false);
+    _preferences.putString("key", _key);
+    _preferences.end();
+    Serial.println("Fleet key changed");
+}
+
+void FleetConfig::registerActions() {
+    ControlChannel& control = _wifiManager->getControlChannel();
+
+    control.registerAction("fleet.get", "/fleet", HTTP_GET, [](const ControlRequest&) -> String {
+        return _fleetConfigInstance->_json.get();
+    });
+
+    // Shared secret of the fleet; never sent back. Applied by loop().
+    control.registerAction("fleet.key", "/fleet/key", HTTP_POST, [](const ControlRequest& req) -> String {
+        String key = req.hasParam("key") ? req.getParam("key") : String();
+        if (key.length() < FLEET_KEY_MIN || key.length() >= FLEET_KEY_MAX) {
+            return "{\"success\":false,\"message\":\"Key must be 8-63 characters\"}";
+        }
+        if (_fleetConfigInstance->_requestedKey) {
+            return "{\"success\":false,\"message\":\"Previous change still pending, try again\"}";
+        }
+        strlcpy(_fleetConfigInstance->_requestedKeyValue, key.c_str(), FLEET_KEY_MAX);
+        _fleetConfigInstance->_requestedKey = true;
+        return "{\"success\":true}";
+    });
+
+    // Send this unit's OSC settings and presets to the fleet; progress
+    // follows as "fleet" events
+    control.registerAction("fleet.push", "/fleet/push", HTTP_POST, [](const ControlRequest&) -> String {
+        FleetConfig* self = _fleetConfigInstance;
+        if (!self->_key[0]) {
+            return "{\"success\":false,\"message\":\"Set the fleet key first\"}";
+        }
+        if (!self->_wifiManager->getState().staConnected) {
+            return "{\"success\":false,\"message\":\"Not connected to a network\"}";
+        }
+        if (self->isPushing() || self->_requestedPush) {
+            return "{\"success\":false,\"message\":\"A push is already running\"}";
+        }
+        self->_requestedPush = true;
+        return "{\"success\":true}";
+    });
+}
@@ -0,0 +1,188 @@
+// OSC-Muis - Niels van der Hulst 2026
+
+#ifndef FLEET_CONFIG_H
+#define FLEET_CONFIG_H
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include "osc_socket.h"
+#include "preset_bank.h"
+#include "wifi_manager.h"
+#include "json_cache.h"
+
+class OSCManager;
+
+#define FLEET_CONFIG_PORT 9002         // Bundles, round ends and acknowledgements
+#define FLEET_CONFIG_GROUP 239, 255, 77, 1  // Multicast group the units listen on (STA side)
+#define FLEET_KEY_MIN 8
+#define FLEET_KEY_MAX 64               // Including terminator
+#define FLEET_SIGNATURE_SIZE 32        // HMAC-SHA256
+#define FLEET_BUNDLE_MAX 2048          // Settings, every preset slot and the signature
+#define FLEET_CHUNK_DATA 192           // Bundle bytes per chunk (fits the socket buffer)
+#define FLEET_MAX_CHUNKS ((FLEET_BUNDLE_MAX + FLEET_CHUNK_DATA - 1) / FLEET_CHUNK_DATA)
+#define FLEET_ACK_WINDOW_MS 300        // A round end is answered at a random moment within this
+#define FLEET_ROUND_MS 600             // Sender: wait for answers after each round
+#define FLEET_PUSH_MIN_ROUNDS 2        // Sender: rounds even when everyone answered
+#define FLEET_PUSH_MAX_ROUNDS 6
+#define FLEET_PUSH_MAX_UNITS 64        // Units tracked per push
+
+static_assert(FLEET_MAX_CHUNKS <= 32, "Received chunks are tracked in a 32-bit mask");
+
+// Fleet-wide configuration push: one unit's portal (or tools/fleet_push.py)
+// sends OSC settings and presets to every unit on the venue network at once.
+//
+// Bundle: "key=value" lines (see README, Fleets), followed by an
+// HMAC-SHA256 over the bundle id and the text, keyed with the fleet key.
+// Units without the key, or with a different one, ignore it. The id only goes
+// up: a replayed or older bundle is refused ("stale").
+//
+// Wire (UDP, FLEET_CONFIG_PORT, multicast to FLEET_CONFIG_GROUP on the STA
+// network only):
+//
+//   /muis/fleet/chunk  id index count data    FLEET_CHUNK_DATA bytes each, last one shorter
+//   /muis/fleet/commit id count                end of a round
+//   /muis/fleet/ack    unit id status chunks last
+//                                              unicast back to the sender
+//
+// Every unit answers a round end at a random moment within
+// FLEET_ACK_WINDOW_MS: "applied", or "incomplete" with the mask of chunks it
+// has, or why it refused. The sender's next round repeats only the chunks
+// someone is missing, until every unit that answered is done or
+// FLEET_PUSH_MAX_ROUNDS have passed. A unit that never answers is not
+// known to the sender; the host tool checks the answers against the presence
+// list (fleet_presence.h).
+//
+// Applied atomically: the whole bundle is parsed and validated first (a bad
+// line changes nothing), written to flash as a journal, then published as one
+// OSC settings snapshot plus the new preset bank. A reboot halfway through
+// applies the journal again at the next boot. A new port applies after
+// reboot, as with /muis/config/port. Refused while the show lock holds.
+//
+// Receiving works headless too; the key is set in the portal. Runs on the
+// loop task; portal requests are queued for loop().
+class FleetConfig {
+public:
+    // Answers to a round end ("status" in /muis/fleet/ack)
+    enum Status : uint8_t {
+        STATUS_APPLIED,
+        STATUS_INCOMPLETE,
+        STATUS_SIGNATURE,          // No key here, or a different one
+        STATUS_INVALID,            // Signed, but a line didn't validate
+        STATUS_STALE,              // Id not newer than the last applied bundle
+        STATUS_LOCKED,             // Show lock: retried at the next round end
+        STATUS_NONE                // Sender: no answer yet
+    };
+
+    FleetConfig();
+
+    // Load the key, finish a journalled bundle, register the portal actions
+    // (unless headless). Call after presets.begin().
+    void begin(OSCManager& oscManager, PresetBank& presetBank, WiFiManager& wifiManager);
+
+    // Open the socket once the STA link is up, receive, push (call from loop())
+    void loop();
+
+    bool isPushing() const;
+
+    // Key, last bundle and the last push as JSON ("fleet" event; loop task
+    // only, GET /fleet serves the published copy)
+    String getJson() const;
+
+private:
+    OSCManager* _oscManager;
+    PresetBank* _presetBank;
+    WiFiManager* _wifiManager;
+    Preferences _preferences;
+    OSCSocket _socket;
+    IPAddress _joinedIP;              // STA address the group was joined on
+
+    char _key[FLEET_KEY_MAX];
+    uint32_t _lastApplied;            // Highest bundle id applied (or sent) here
+
+    // One bundle buffer: reassembly when receiving, the outgoing bundle when
+    // pushing (incoming chunks are ignored meanwhile)
+    uint8_t _bundle[FLEET_BUNDLE_MAX];
+    uint8_t _packet[OSC_SOCKET_BUFFER_SIZE];
+
+    struct {
+        uint32_t id;
+        uint32_t count;
+        uint32_t received;            // Chunk mask
+        size_t length;                // Known once the last chunk is in
+        Status status;
+        IPAddress replyIP;
+        uint16_t replyPort;
+        bool replyDue;
+        unsigned long replyAt;
+    } _rx;
+
+    // Validated bundle, built off to the side (too big for the loop stack)
+    struct {
+        OSCConfig config;
+        bool hasPresets;
+        PresetBank::StoredPreset presets[PRESET_MAX];
+    } _staged;
+
+    struct Unit {
+        char id[WIFI_DEVICE_ID_MAX];
+        uint32_t ip;
+        Status status;
+        uint32_t received;
+    };
+    enum PushState : uint8_t {
+        PUSH_IDLE,
+        PUSH_SENDING,
+        PUSH_WAITING,
+        PUSH_DONE
+    };
+    struct {
+        PushState state;
+        uint32_t id;
+        uint32_t count;
+        size_t length;
+        uint32_t pending;             // Chunks still to send this round
+        int round;
+        unsigned long roundEnd;
+        uint32_t newestSeen;          // Highest "last" in a stale answer
+        bool restarted;
+        Unit units[FLEET_PUSH_MAX_UNITS];
+        int unitCount;
+    } _push;
+
+    // Portal requests, applied by loop()
+    volatile bool _requestedPush;
+    volatile bool _requestedKey;
+    char _requestedKeyValue[FLEET_KEY_MAX];
+    JsonCache _json;                  // getJson() as last published
+
+    void openSocket();
+    void poll();
+    void onChunk(const uint8_t* packet, size_t len, size_t pos, const IPAddress& from, uint16_t port);
+    void onCommit(const uint8_t* packet, size_t len, size_t pos, const IPAddress& from, uint16_t port);
+    void onAck(const uint8_t* packet, size_t len, size_t pos, const IPAddress& from);
+    void resetReceive(uint32_t id, uint32_t count);
+    void finishReceive();
+    void scheduleReply(const IPAddress& ip, uint16_t port);
+    void sendReply();
+
+    void sign(uint32_t id, const uint8_t* text, size_t length, uint8_t* out) const;
+    bool verify(uint32_t id, const uint8_t* text, size_t length, const uint8_t* signature) const;
+    const char* stage(const char* text);
+    const char* stagePreset(char* value);
+    void applyStaged(uint32_t id);
+    void resumeJournal();
+
+    void startPush();
+    void runPush();
+    size_t buildBundle(uint32_t id);
+    bool sendChunk(int index);
+    void sendCommit();
+    void endRound();
+    void publish();
+
+    void setKey(const char* key);
+    void registerActions();
+    static const char* statusName(Status status);
+};
+
+#endif
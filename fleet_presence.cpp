@@ -0,0 +1,72 @@
+// OSC-Muis - Niels van der Hulst 2026
+
+#include "fleet_presence.h"
+#include "osc_manager.h"
+#include "wifi_manager.h"
+#include "osc_wire.h"
+
+// Static instance pointer for the OSC command callback
+static FleetPresence* _fleetInstance = nullptr;
+
+FleetPresence::FleetPresence() {
+    _oscManager = nullptr;
+    _wifiManager = nullptr;
+    _nextAt = 0;
+    _announced = 0;
+}
+
+void FleetPresence::begin(OSCManager& oscManager, WiFiManager& wifiManager) {
+    _oscManager = &oscManager;
+    _wifiManager = &wifiManager;
+    _fleetInstance = this;
+    oscManager.registerCommand("/muis/fleet", onFleetCommand);
+
+    // Anywhere within the first interval: a fleet booted by one switch
+    // starts out spread
+    scheduleIn(random(FLEET_ANNOUNCE_MS));
+}
+
+void FleetPresence::scheduleIn(unsigned long delayMs) {
+    _nextAt = millis() + delayMs;
+}
+
+size_t FleetPresence::encode(uint8_t* out) const {
+    const WiFiManagerState& state = _wifiManager->getState();
+    bool linked = state.staConnected;
+    IPAddress addr = linked ? WiFi.localIP() : WiFi.softAPIP();
+    char ip[16];
+    snprintf(ip, sizeof(ip), "%u.%u.%u.%u", addr[0], addr[1], addr[2], addr[3]);
+
+    size_t n = oscPutString(out, 0, "/muis/presence");
+    n = oscPutString(out, n, ",ssssiiiiis");
+    n = oscPutString(out, n, _wifiManager->getDeviceId());
+    n = oscPutString(out, n, _wifiManager->getHostname());
+    n = oscPutString(out, n, ip);
+    n = oscPutString(out, n, _oscManager->getAddressPrefix());
+    n = oscPutInt(out, n, _wifiManager->getBatteryPercent());
+    n = oscPutInt(out, n, linked ? WiFi.RSSI() : 0);
+    n = oscPutInt(out, n, WiFi.channel());
+    n = oscPutInt(out, n, state.roamCount);
+    n = oscPutInt(out, n, millis() / 1000);
+    n = oscPutString(out, n, state.headless ? "headless" : "portal");
+    return n;
+}
+
+void FleetPresence::loop() {
+    if (!_wifiManager || (long)(millis() - _nextAt) < 0) return;
+    scheduleIn(FLEET_ANNOUNCE_MS - FLEET_JITTER_MS + random(2 * FLEET_JITTER_MS + 1));
+
+    uint8_t packet[FLEET_PACKET_MAX];
+    if (_oscManager->broadcastPacket(packet, encode(packet), FLEET_PORT)) _announced++;
+}
+
+uint32_t FleetPresence::getAnnounceCount() const {
+    return _announced;
+}
+
+// /muis/fleet  -> announce within FLEET_REPLY_WINDOW_MS (never later than planned)
+void FleetPresence::onFleetCommand(OSCMessage& msg) {
+    FleetPresence* self = _fleetInstance;
+    unsigned long delayMs = random(FLEET_REPLY_WINDOW_MS);
+    if ((long)(self->_nextAt - millis()) > (long)delayMs) self->scheduleIn(delayMs);
+}
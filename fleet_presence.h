@@ -0,0 +1,57 @@
+// OSC-Muis - Niels van der Hulst 2026
+
+#ifndef FLEET_PRESENCE_H
+#define FLEET_PRESENCE_H
+
+#include <Arduino.h>
+
+class OSCManager;
+class WiFiManager;
+class OSCMessage;
+
+#define FLEET_PORT 9001                // Announcements go here (tools/fleet.py listens on it)
+#define FLEET_ANNOUNCE_MS 10000        // Mean time between announcements
+#define FLEET_JITTER_MS 3000           // Each interval is FLEET_ANNOUNCE_MS +/- this
+#define FLEET_REPLY_WINDOW_MS 1000     // A /muis/fleet query is answered at a random moment within this
+#define FLEET_PACKET_MAX 160           // Largest announcement (long host name, all fields)
+
+// Low-rate presence announcements, so a host can list every unit on the
+// network with its battery and link state:
+//
+//   /muis/presence id host ip prefix battery rssi channel roams uptime mode
+//   e.g. "a1b2c3" "osc-muis-a1b2c3" "192.168.1.40" "" 87 -61 6 2 3600 "portal"
+//
+// - Broadcast on every live interface to FLEET_PORT, not to the OSC target,
+//   so the show receiver never sees them.
+// - Jittered: every interval is drawn at random from FLEET_ANNOUNCE_MS +/-
+//   FLEET_JITTER_MS, and the first one falls anywhere within an interval, so
+//   units powered up together (one breaker for the whole cast) drift apart
+//   instead of announcing in the same millisecond.
+// - /muis/fleet (usually broadcast by the host tool) brings the next
+//   announcement forward to a random moment within FLEET_REPLY_WINDOW_MS;
+//   a whole fleet answers spread out rather than in one burst.
+// - Encoded into a stack buffer: an announcement costs no heap allocation.
+class FleetPresence {
+public:
+    FleetPresence();
+
+    // Register /muis/fleet and schedule the first announcement
+    void begin(OSCManager& oscManager, WiFiManager& wifiManager);
+
+    // Announce when due (call from loop())
+    void loop();
+
+    uint32_t getAnnounceCount() const;
+
+private:
+    OSCManager* _oscManager;
+    WiFiManager* _wifiManager;
+    unsigned long _nextAt;         // millis() of the next announcement
+    uint32_t _announced;
+
+    void scheduleIn(unsigned long delayMs);
+    size_t encode(uint8_t* out) const;
+    static void onFleetCommand(OSCMessage& msg);
+};
+
+#endif
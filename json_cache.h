@@ -0,0 +1,51 @@
+// OSC-Muis - Niels van der Hulst 2026
+
+#ifndef JSON_CACHE_H
+#define JSON_CACHE_H
+
+#include <Arduino.h>
+#include <atomic>
+#include <utility>
+
+// A module's state as JSON, built on the loop task and served by portal
+// handlers, which run on the AsyncTCP task and preempt loop(): a handler
+// copies the last published text instead of reading arrays that loop() may
+// be rewriting. get() also asks for a refresh, which the module's loop()
+// publishes (cached here and pushed as its control event) on its next pass.
+class JsonCache {
+public:
+    JsonCache() : _lock(nullptr), _refresh(false) {}
+
+    // Create the lock (call in the module's begin(), before the server starts)
+    void begin() {
+        if (!_lock) _lock = xSemaphoreCreateMutex();
+    }
+
+    // Replace the cached JSON (loop task)
+    void set(String json) {
+        xSemaphoreTake(_lock, portMAX_DELAY);
+        _json = std::move(json);
+        xSemaphoreGive(_lock);
+    }
+
+    // Copy of the cached JSON, and a refresh request (any task)
+    String get() {
+        _refresh = true;
+        xSemaphoreTake(_lock, portMAX_DELAY);
+        String json = _json;
+        xSemaphoreGive(_lock);
+        return json;
+    }
+
+    // True once after get() was called (loop task)
+    bool refreshRequested() {
+        return _refresh.exchange(false);
+    }
+
+private:
+    SemaphoreHandle_t _lock;
+    String _json;
+    std::atomic<bool> _refresh;
+};
+
+#endif
@@ -0,0 +1,121 @@
+// OSC-Muis - Niels van der Hulst 2026
+
+#include "log_ring.h"
+
+LogRing logRing;
+
+static const char* const LEVEL_TAGS[] = { "", "E ", "W ", "", "D " };
+
+LogRing::LogRing() : _stream("/log") {
+    _head = 0;
+    _tail = 0;
+    _mux = portMUX_INITIALIZER_UNLOCKED;
+    _dropped = 0;
+    _droppedReported = 0;
+    _skipped = 0;
+    _streamId = 0;
+}
+
+void LogRing::begin(AsyncWebServer& webServer) {
+    webServer.addHandler(&_stream);
+}
+
+void LogRing::push(uint8_t level, const char* text, const char* format, const uintptr_t* args, int argCount) {
+    uint32_t timeMs = millis();
+
+    portENTER_CRITICAL(&_mux);
+    if (_head - _tail >= LOG_RING_ENTRIES) {
+        _dropped++;
+        portEXIT_CRITICAL(&_mux);
+        return;
+    }
+    Entry& entry = _entries[_head % LOG_RING_ENTRIES];
+    entry.timeMs = timeMs;
+    entry.format = format;
+    entry.level = level;
+    entry.hasText = text != nullptr;
+    for (int i = 0; i < argCount; i++) entry.args[i] = args[i];
+    if (text) strlcpy(entry.text, text, sizeof(entry.text));
+    _head++;
+    portEXIT_CRITICAL(&_mux);
+}
+
+bool LogRing::pop(Entry& out) {
+    portENTER_CRITICAL(&_mux);
+    bool available = _tail != _head;
+    if (available) {
+        out = _entries[_tail % LOG_RING_ENTRIES];
+        _tail++;
+    }
+    portEXIT_CRITICAL(&_mux);
+    return available;
+}
+
+size_t LogRing::formatLine(const Entry& entry, char* line) const {
+    // The copied text goes to the first conversion, the arguments after it
+    uintptr_t v[LOG_MAX_ARGS + 1];
+    int n = 0;
+    if (entry.hasText) v[n++] = (uintptr_t)entry.text;
+    for (int i = 0; n <= LOG_MAX_ARGS; i++) v[n++] = i < LOG_MAX_ARGS ? entry.args[i] : 0;
+
+    int length = snprintf(line, LOG_LINE_MAX, "%lu.%03lu %s",
+                          (unsigned long)(entry.timeMs / 1000), (unsigned long)(entry.timeMs % 1000),
+                          LEVEL_TAGS[entry.level < 5 ? entry.level : 0]);
+    // Unused arguments are ignored by the format
+    length += snprintf(line + length, LOG_LINE_MAX - length, entry.format,
+                       v[0], v[1], v[2], v[3], v[4], v[5], v[6], v[7], v[8]);
+    if (length > LOG_LINE_MAX - 2) length = LOG_LINE_MAX - 2;
+    line[length++] = '\n';
+    line[length] = '\0';
+    return length;
+}
+
+void LogRing::emit(const char* line, size_t length, bool wait) {
+    if (wait || Serial.availableForWrite() >= (int)length) {
+        Serial.write((const uint8_t*)line, length);
+    } else {
+        _skipped++;
+    }
+
+    // Only costs anything (the library allocates per message) while a
+    // client is attached; a client that falls behind misses lines
+    if (_stream.count() > 0 && _stream.avgPacketsWaiting() < LOG_STREAM_QUEUE_MAX) {
+        char data[LOG_LINE_MAX];
+        memcpy(data, line, length - 1);
+        data[length - 1] = '\0';
+        _stream.send(data, "log", ++_streamId);
+    }
+}
+
+void LogRing::drain(int maxLines, bool wait) {
+    char line[LOG_LINE_MAX];
+    uint32_t dropped = _dropped;
+    if (dropped != _droppedReported) {
+        int length = snprintf(line, sizeof(line), "(log ring full: %lu lines dropped)\n",
+                              (unsigned long)(dropped - _droppedReported));
+        _droppedReported = dropped;
+        emit(line, length, wait);
+    }
+
+    Entry entry;
+    for (int n = 0; n < maxLines && pop(entry); n++) {
+        emit(line, formatLine(entry, line), wait);
+    }
+}
+
+void LogRing::loop() {
+    drain(LOG_DRAIN_PER_PASS, false);
+}
+
+void LogRing::flush() {
+    drain(LOG_RING_ENTRIES, true);
+    Serial.flush();
+}
+
+uint32_t LogRing::getDroppedCount() const {
+    return _dropped;
+}
+
+uint32_t LogRing::getSkippedCount() const {
+    return _skipped;
+}
@@ -0,0 +1,142 @@
+// OSC-Muis - Niels van der Hulst 2026
+
+#ifndef LOG_RING_H
+#define LOG_RING_H
+
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+#include <type_traits>
+
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_INFO 3
+#define LOG_LEVEL_DEBUG 4
+
+// Levels above this are compiled out, format strings and arguments included
+// (the calls stay behind "if (0)", so arguments still count as used).
+// Override with a build flag, e.g.
+//   --build-property "build.extra_flags=-DOSC_MUIS_LOG_LEVEL=2"
+#ifndef OSC_MUIS_LOG_LEVEL
+#define OSC_MUIS_LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+#define LOG_RING_ENTRIES 64           // Lines waiting to be printed
+#define LOG_MAX_ARGS 8                // Integer/static string arguments per line
+#define LOG_TEXT_MAX 40               // Copied string per line (an address built on the stack)
+#define LOG_LINE_MAX 192              // Formatted line, including terminator
+#define LOG_DRAIN_PER_PASS 4          // Lines formatted per loop() pass
+#define LOG_STREAM_QUEUE_MAX 8        // /log client: queued lines before it gets none
+
+// Deferred log for the loop task's hot paths (presses, macros, route and
+// power profile changes, WiFi events).
+//
+// Serial.printf() formats on the spot and writes to the USB-CDC port, which
+// blocks once its buffer is full — with a host attached that isn't reading,
+// a press waited for the log line. LOG_*() only stores the format pointer
+// (the format id), the arguments and a timestamp in a fixed ring: a copy of
+// under 100 bytes, no formatting, no I/O, no allocation.
+//
+// loop() formats at most LOG_DRAIN_PER_PASS lines per pass, after the
+// button path, and writes a line to Serial only if the port has room for
+// all of it; otherwise the line is skipped and counted, never waited for.
+// The same lines go to the /log event stream (portal mode) while a client
+// is attached.
+//
+// Arguments: up to LOG_MAX_ARGS integers of at most 32 bits, or pointers to
+// strings that outlive the ring (literals, route names). Floats don't
+// compile. The _TEXT variants copy one string (up to LOG_TEXT_MAX - 1
+// characters) into the entry; it goes to the format's first conversion.
+//
+// A full ring drops new lines and counts them. Safe from any task (a short
+// critical section around the copy); other tasks still use Serial directly,
+// since they never hold up a press.
+class LogRing {
+public:
+    LogRing();
+
+    // Attach the /log event stream (portal mode only; call before the server
+    // starts)
+    void begin(AsyncWebServer& webServer);
+
+    // Queue a line (use the LOG_* macros)
+    template <typename... Args>
+    void write(uint8_t level, const char* text, const char* format, Args... args) {
+        static_assert(sizeof...(Args) <= LOG_MAX_ARGS, "Too many log arguments");
+        // Each argument is stored as a uintptr_t: a float would be truncated to
+        // an integer and printed through its %f as garbage
+        static_assert(((std::is_integral<Args>::value || std::is_pointer<Args>::value ||
+                        std::is_enum<Args>::value) && ...),
+                      "Log arguments must be integers, enums or string pointers");
+        uintptr_t values[LOG_MAX_ARGS + 1] = { (uintptr_t)args..., 0 };
+        push(level, text, format, values, sizeof...(Args));
+    }
+
+    // Print waiting lines (call from loop(), after the button path)
+    void loop();
+
+    // Print everything still waiting, blocking if need be (before a reboot
+    // or deep sleep)
+    void flush();
+
+    // Diagnostics
+    uint32_t getDroppedCount() const;     // Ring full
+    uint32_t getSkippedCount() const;     // Serial had no room
+
+private:
+    struct Entry {
+        uint32_t timeMs;
+        const char* format;           // Format id: the literal's address
+        uint8_t level;
+        bool hasText;
+        uintptr_t args[LOG_MAX_ARGS];
+        char text[LOG_TEXT_MAX];
+    };
+    Entry _entries[LOG_RING_ENTRIES];
+    uint32_t _head;                   // Next write (producers, under _mux)
+    uint32_t _tail;                   // Next read (loop task)
+    portMUX_TYPE _mux;
+
+    uint32_t _dropped;
+    uint32_t _droppedReported;
+    uint32_t _skipped;
+    uint32_t _streamId;
+    AsyncEventSource _stream;
+
+    void push(uint8_t level, const char* text, const char* format, const uintptr_t* args, int argCount);
+    bool pop(Entry& out);
+    size_t formatLine(const Entry& entry, char* line) const;
+    void emit(const char* line, size_t length, bool wait);
+    void drain(int maxLines, bool wait);
+};
+
+extern LogRing logRing;
+
+#if OSC_MUIS_LOG_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_ERROR(...) logRing.write(LOG_LEVEL_ERROR, nullptr, __VA_ARGS__)
+#else
+#define LOG_ERROR(...) do { if (0) logRing.write(LOG_LEVEL_ERROR, nullptr, __VA_ARGS__); } while (0)
+#endif
+
+#if OSC_MUIS_LOG_LEVEL >= LOG_LEVEL_WARN
+#define LOG_WARN(...) logRing.write(LOG_LEVEL_WARN, nullptr, __VA_ARGS__)
+#define LOG_WARN_TEXT(text, ...) logRing.write(LOG_LEVEL_WARN, text, __VA_ARGS__)
+#else
+#define LOG_WARN(...) do { if (0) logRing.write(LOG_LEVEL_WARN, nullptr, __VA_ARGS__); } while (0)
+#define LOG_WARN_TEXT(text, ...) do { if (0) logRing.write(LOG_LEVEL_WARN, text, __VA_ARGS__); } while (0)
+#endif
+
+#if OSC_MUIS_LOG_LEVEL >= LOG_LEVEL_INFO
+#define LOG_INFO(...) logRing.write(LOG_LEVEL_INFO, nullptr, __VA_ARGS__)
+#define LOG_INFO_TEXT(text, ...) logRing.write(LOG_LEVEL_INFO, text, __VA_ARGS__)
+#else
+#define LOG_INFO(...) do { if (0) logRing.write(LOG_LEVEL_INFO, nullptr, __VA_ARGS__); } while (0)
+#define LOG_INFO_TEXT(text, ...) do { if (0) logRing.write(LOG_LEVEL_INFO, text, __VA_ARGS__); } while (0)
+#endif
+
+#if OSC_MUIS_LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(...) logRing.write(LOG_LEVEL_DEBUG, nullptr, __VA_ARGS__)
+#else
+#define LOG_DEBUG(...) do { if (0) logRing.write(LOG_LEVEL_DEBUG, nullptr, __VA_ARGS__); } while (0)
+#endif
+
+#endif
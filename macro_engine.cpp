@@ -0,0 +1,303 @@
+// OSC-Muis - Niels van der Hulst 2026
+
+#include "macro_engine.h"
+#include "osc_manager.h"
+#include "wifi_manager.h"
+#include "log_ring.h"
+#include <OSCMessage.h>
+
+// Static instance pointer for web/OSC callbacks
+static MacroEngine* _macroInstance = nullptr;
+
+// Print into a fixed buffer: encodes a step once, when the macro is saved
+class StepWriter : public Print {
+public:
+    StepWriter(uint8_t* buffer, size_t capacity) : _buffer(buffer), _capacity(capacity), length(0), overflow(false) {}
+
+    size_t write(uint8_t b) override {
+        return write(&b, 1);
+    }
+
+    size_t write(const uint8_t* data, size_t len) override {
+        if (length + len > _capacity) {
+            overflow = true;
+            return 0;
+        }
+        memcpy(_buffer + length, data, len);
+        length += len;
+        return len;
+    }
+
+private:
+    uint8_t* _buffer;
+    size_t _capacity;
+
+public:
+    size_t length;
+    bool overflow;
+};
+
+MacroEngine::MacroEngine() {
+    memset(_macros, 0, sizeof(_macros));
+    _encodedVersion = 0;
+    memset(_requestedSource, 0, sizeof(_requestedSource));
+    for (int b = 0; b < MACRO_BUTTONS; b++) _requested[b] = false;
+    _oscManager = nullptr;
+    _wifiManager = nullptr;
+}
+
+void MacroEngine::begin(OSCManager& oscManager, WiFiManager& wifiManager) {
+    _oscManager = &oscManager;
+    _wifiManager = &wifiManager;
+    _macroInstance = this;
+    _json.begin();
+
+    _preferences.begin("macro", true);
+    char key[4] = "b1";
+    for (int b = 0; b < MACRO_BUTTONS; b++) {
+        key[1] = '1' + b;
+        _preferences.getString(key, _macros[b].source, sizeof(_macros[b].source));
+    }
+    _preferences.end();
+    encodeAll();
+    publish();
+
+    oscManager.registerCommand("/muis/macro", onMacroCommand);
+    if (!wifiManager.isHeadless()) {
+        registerActions();
+    }
+
+    for (int b = 0; b < MACRO_BUTTONS; b++) {
+        if (_macros[b].stepCount) {
+            Serial.printf("Macro button %d: %d steps\n", b + 1, _macros[b].stepCount);
+        }
+    }
+}
+
+// Parse a macro into out (encoded for buttonNumber), or only validate it
+// when out is null
+const char* MacroEngine::compile(const char* source, int buttonNumber, OSCManager* osc, Macro* out) {
+    if (strlen(source) >= MACRO_SOURCE_MAX) return "Macro too long";
+
+    OSCTemplateContext ctx;
+    if (osc) osc->makeContext(buttonNumber, ctx);
+
+    int count = 0;
+    uint32_t offset = 0;
+    const char* p = source;
+    while (*p) {
+        // One step: [+<ms>] <template> up to the next ';'
+        while (*p == ' ') p++;
+        const char* end = strchr(p, ';');
+        if (!end) end = p + strlen(p);
+
+        if (end > p) {
+            if (count >= MACRO_MAX_STEPS) return "Too many steps (max 8)";
+
+            if (*p == '+') {
+                p++;
+                uint32_t delayMs = 0;
+                if (*p < '0' || *p > '9') return "Expected milliseconds after '+'";
+                while (*p >= '0' && *p <= '9') {
+                    delayMs = delayMs * 10 + (*p++ - '0');
+                    if (delayMs > MACRO_MAX_DELAY_MS) return "Step delay too long (max 60000 ms)";
+                }
+                if (*p != ' ') return "Expected a space after the delay";
+                while (*p == ' ') p++;
+                offset += delayMs;
+            }
+
+            // Copy the template out so it ends at the ';' (trailing spaces dropped)
+            char text[MACRO_SOURCE_MAX];
+            size_t len = end - p;
+            while (len > 0 && p[len - 1] == ' ') len--;
+            memcpy(text, p, len);
+            text[len] = '\0';
+
+            OSCTemplate program;
+            const char* error = program.compile(text, false);
+            if (error) return error;
+            if (program.maxEncodedSize > MACRO_STEP_MAX_BYTES) return "Step message too long";
+
+            if (out) {
+                Step& step = out->steps[count];
+                StepWriter writer(step.data, sizeof(step.data));
+                program.encode(writer, ctx);
+                if (writer.overflow) return "Step message too long";
+                step.length = writer.length;
+                step.offsetMs = offset;
+            }
+            count++;
+        }
+        p = *end ? end + 1 : end;
+    }
+
+    if (out) {
+        strlcpy(out->source, source, sizeof(out->source));
+        out->stepCount = count;
+    }
+    return nullptr;
+}
+
+const char* MacroEngine::validate(const char* source) {
+    return compile(source, 1, nullptr, nullptr);
+}
+
+void MacroEngine::encodeAll() {
+    // Steps carry the channel and device name baked in: redo them whenever
+    // the OSC settings change. Pending steps keep their indices.
+    static Macro scratch;  // static: too big for the loop task stack
+    for (int b = 0; b < MACRO_BUTTONS; b++) {
+        if (!_macros[b].source[0]) continue;
+        const char* error = compile(_macros[b].source, b + 1, _oscManager, &scratch);
+        if (error) {
+            Serial.printf("Macro button %d disabled: %s\n", b + 1, error);
+            _wheel.cancel(b + 1);
+            _macros[b].stepCount = 0;
+            continue;
+        }
+        _macros[b] = scratch;
+    }
+    _encodedVersion = _oscManager->getConfigVersion();
+}
+
+const char* MacroEngine::setMacro(int buttonNumber, const char* source) {
+    if (buttonNumber < 1 || buttonNumber > MACRO_BUTTONS) return "No such button";
+    Macro& macro = _macros[buttonNumber - 1];
+
+    static Macro scratch;
+    const char* error = compile(source, buttonNumber, _oscManager, &scratch);
+    if (error) return error;
+
+    _wheel.cancel(buttonNumber);
+    macro = scratch;
+
+    char key[4] = "b1";
+    key[1] = '0' + buttonNumber;
+    _preferences.begin("macro", false);
+    if (source[0]) _preferences.putString(key, source);
+    else _preferences.remove(key);
+    _preferences.end();
+
+    Serial.printf("Macro button %d: %s\n", buttonNumber, source[0] ? source : "(none)");
+    publish();
+    return nullptr;
+}
+
+bool MacroEngine::press(int buttonNumber) {
+    if (buttonNumber < 1 || buttonNumber > MACRO_BUTTONS) return false;
+    const Macro& macro = _macros[buttonNumber - 1];
+    if (macro.stepCount == 0) return false;
+
+    // Second press while running: stop the rest of the sequence
+    if (isRunning(buttonNumber)) {
+        _wheel.cancel(buttonNumber);
+        LOG_INFO("Macro button %d cancelled", buttonNumber);
+        return true;
+    }
+
+    // Steps due now go out from the press itself; the rest wait on the wheel
+    for (int i = 0; i < macro.stepCount; i++) {
+        if (macro.steps[i].offsetMs == 0) fire(buttonNumber, i);
+        else _wheel.schedule(buttonNumber, i, macro.steps[i].offsetMs);  // one entry per step: always room
+    }
+    return true;
+}
+
+bool MacroEngine::isRunning(int buttonNumber) const {
+    return _wheel.isPending(buttonNumber);
+}
+
+void MacroEngine::fire(int button, int step) {
+    const Step& s = _macros[button - 1].steps[step];
+    _oscManager->sendPacket(s.data, s.length, button);
+}
+
+void MacroEngine::loop() {
+    _wheel.advance([this](int button, int step) { fire(button, step); });
+
+    // Saved from the portal (validated there)
+    for (int b = 0; b < MACRO_BUTTONS; b++) {
+        if (!_requested[b]) continue;
+        char source[MACRO_SOURCE_MAX];
+        strlcpy(source, _requestedSource[b], sizeof(source));
+        _requested[b] = false;
+        const char* error = setMacro(b + 1, source);
+        if (error) Serial.printf("Macro button %d not saved: %s\n", b + 1, error);
+    }
+
+    if (_oscManager->getConfigVersion() != _encodedVersion) {
+        encodeAll();
+    }
+    if (_json.refreshRequested()) publish();
+}
+
+void MacroEngine::publish() {
+    String json = getJson();
+    if (_wifiManager) _wifiManager->getControlChannel().push("macro", json);
+    _json.set(std::move(json));
+}
+
+String MacroEngine::getJson() const {
+    String json = "{\"buttons\":[";
+    for (int b = 0; b < MACRO_BUTTONS; b++) {
+        if (b > 0) json += ",";
+        json += "{\"button\":" + String(b + 1);
+        json += ",\"steps\":\"" + String(_macros[b].source) + "\"";
+        json += ",\"count\":" + String(_macros[b].stepCount);
+        json += ",\"running\":";
+        json += isRunning(b + 1) ? "true" : "false";
+        json += "}";
+    }
+    json += "]}";
+    return json;
+}
+
+void MacroEngine::registerActions() {
+    ControlChannel& control = _wifiManager->getControlChannel();
+
+    control.registerAction("macro.get", "/macro", HTTP_GET, [](const ControlRequest&) -> String {
+        return _macroInstance->_json.get();
+    });
+
+    // Validated here so the portal gets the error; stored from loop(), which
+    // is the only task that touches the steps
+    control.registerAction("macro.set", "/macro", HTTP_POST, [](const ControlRequest& req) -> String {
+        int button = req.hasParam("button") ? req.getParam("button").toInt() : 0;
+        if (button < 1 || button > MACRO_BUTTONS) {
+            return "{\"success\":false,\"message\":\"No such button\"}";
+        }
+        String steps = req.hasParam("steps") ? req.getParam("steps") : String();
+        const char* error = validate(steps.c_str());
+        if (error) {
+            return String("{\"success\":false,\"message\":\"") + error + "\"}";
+        }
+        if (_macroInstance->_requested[button - 1]) {
+            return "{\"success\":false,\"message\":\"Previous save still pending, try again\"}";
+        }
+        strlcpy(_macroInstance->_requestedSource[button - 1], steps.c_str(), MACRO_SOURCE_MAX);
+        _macroInstance->_requested[button - 1] = true;
+        return "{\"success\":true}";
+    });
+}
+
+// /muis/macro i      -> reply "/muis/macro button steps"
+// /muis/macro i s    -> set the button's macro ("" clears it), then reply
+void MacroEngine::onMacroCommand(OSCMessage& msg) {
+    MacroEngine* self = _macroInstance;
+    if (!msg.isInt(0)) return;
+    int button = msg.getInt(0);
+    if (button < 1 || button > MACRO_BUTTONS) return;
+
+    if (msg.isString(1)) {
+        char source[MACRO_SOURCE_MAX + 1];  // one over, so a too-long macro is caught
+        msg.getString(1, source, sizeof(source));
+        const char* error = self->setMacro(button, source);
+        if (error) Serial.printf("Macro button %d rejected via OSC: %s\n", button, error);
+    }
+
+    OSCMessage out("/muis/macro");
+    out.add((int32_t)button);
+    out.add(self->_macros[button - 1].source);
+    self->_oscManager->reply(out);
+}
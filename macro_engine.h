@@ -0,0 +1,99 @@
+// OSC-Muis - Niels van der Hulst 2026
+
+#ifndef MACRO_ENGINE_H
+#define MACRO_ENGINE_H
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include "board_profile.h"
+#include "macro_wheel.h"
+#include "json_cache.h"
+
+class OSCManager;
+class WiFiManager;
+class OSCMessage;
+
+#define MACRO_BUTTONS BOARD_BUTTONS
+#define MACRO_MAX_STEPS 8             // Steps per button
+#define MACRO_SOURCE_MAX 200          // Macro text as stored in NVS
+#define MACRO_STEP_MAX_BYTES 72       // One pre-encoded OSC message (64 + the fleet address prefix)
+#define MACRO_MAX_DELAY_MS 60000      // Per step, after the previous one
+
+#define MACRO_MAX_PENDING (MACRO_BUTTONS * MACRO_MAX_STEPS)
+
+// Per-button macros: one press fires a timed sequence of OSC messages.
+//
+//   /fade/3 ,f1.0; +250 /kmpush5; +2000 /stop/3
+//
+// Steps are separated by ';'. "+<ms>" delays a step after the previous one;
+// the rest is an address template (see osc_template.h) whose address is used
+// as written ({ch} and {btn} refer to the pressed button). A button without
+// a macro sends its normal message.
+//
+// Steps are compiled and encoded into ready-to-send packets when the macro is
+// saved (and again when the OSC settings change), so firing a step is a
+// single socket write. The first step goes out from the press itself; later
+// steps wait on a hashed timer wheel serviced from loop() — never delay().
+// Pressing the button again while its macro is running cancels the rest.
+class MacroEngine {
+public:
+    MacroEngine();
+
+    // Load macros from flash, register OSC commands (and portal actions
+    // unless headless)
+    void begin(OSCManager& oscManager, WiFiManager& wifiManager);
+
+    // Button press: starts the button's macro, or cancels it if it's still
+    // running. Returns false if the button has no macro (send normally).
+    bool press(int buttonNumber);
+
+    // Fire due steps; apply macros saved from the portal; re-encode after OSC
+    // settings changes (call from loop(), right after the buttons)
+    void loop();
+
+    // Validate a macro without storing it. Returns nullptr or a message.
+    static const char* validate(const char* source);
+
+    // Store and persist a macro ("" clears it). Loop task only.
+    const char* setMacro(int buttonNumber, const char* source);
+
+    bool isRunning(int buttonNumber) const;
+
+    // Macro texts, step counts and running state as JSON ("macro" event;
+    // loop task only, GET /macro serves the published copy)
+    String getJson() const;
+
+private:
+    struct Step {
+        uint32_t offsetMs;        // From the press
+        uint8_t length;
+        uint8_t data[MACRO_STEP_MAX_BYTES];
+    };
+    struct Macro {
+        char source[MACRO_SOURCE_MAX];
+        Step steps[MACRO_MAX_STEPS];
+        uint8_t stepCount;
+    };
+    Macro _macros[MACRO_BUTTONS];
+
+    MacroWheel<MACRO_MAX_PENDING> _wheel;  // Pending steps
+    uint32_t _encodedVersion;     // OSC config version the steps were encoded with
+
+    // Portal saves arrive on the AsyncTCP task; loop() applies them
+    char _requestedSource[MACRO_BUTTONS][MACRO_SOURCE_MAX];
+    volatile bool _requested[MACRO_BUTTONS];
+    JsonCache _json;              // getJson() as last published
+
+    OSCManager* _oscManager;
+    WiFiManager* _wifiManager;
+    Preferences _preferences;
+
+    static const char* compile(const char* source, int buttonNumber, OSCManager* osc, Macro* out);
+    void encodeAll();
+    void fire(int button, int step);
+    void publish();
+    void registerActions();
+    static void onMacroCommand(OSCMessage& msg);
+};
+
+#endif
@@ -0,0 +1,135 @@
+// OSC-Muis - Niels van der Hulst 2026
+
+#ifndef MACRO_WHEEL_H
+#define MACRO_WHEEL_H
+
+#include <Arduino.h>
+
+// Timer wheel: 64 slots of 5 ms = one revolution every 320 ms; longer delays
+// go round several times
+#define MACRO_WHEEL_SLOTS 64
+#define MACRO_WHEEL_TICK_MS 5
+
+// Hashed timer wheel for the macro steps waiting to fire, N entries at most.
+// An entry is a (button, step) pair: the step's packet is looked up when it
+// fires, so steps re-encoded meanwhile go out in their new form.
+//
+// Each slot is a singly linked list through the entries; rounds counts the
+// remaining revolutions before an entry is due. Scheduling and cancelling
+// touch no heap and no clock but millis(). Loop task only.
+template <int N>
+class MacroWheel {
+public:
+    static_assert(N <= 128, "Pending steps are linked by int8_t index");
+
+    MacroWheel() {
+        memset(_timers, 0, sizeof(_timers));
+        for (int i = 0; i < MACRO_WHEEL_SLOTS; i++) _slots[i] = -1;
+        _tick = 0;
+        _lastTickMs = 0;
+        _pending = 0;
+    }
+
+    // Fire (button, step) offsetMs from now: never early, at most one tick
+    // late if advance() runs every tick. False if all N entries are taken.
+    bool schedule(uint8_t button, uint8_t step, uint32_t offsetMs) {
+        int index = -1;
+        for (int i = 0; i < N; i++) {
+            if (!_timers[i].active) {
+                index = i;
+                break;
+            }
+        }
+        if (index < 0) return false;
+
+        // Idle wheel: restart the tick clock so it doesn't catch up on old ticks
+        unsigned long now = millis();
+        if (_pending == 0) _lastTickMs = now;
+
+        // Round up from the last tick boundary: a step may fire up to one tick
+        // late, never early
+        uint32_t ticks = (now - _lastTickMs + offsetMs + MACRO_WHEEL_TICK_MS - 1) / MACRO_WHEEL_TICK_MS;
+        if (ticks == 0) ticks = 1;
+        int slot = (_tick + ticks) % MACRO_WHEEL_SLOTS;
+
+        Timer& timer = _timers[index];
+        timer.button = button;
+        timer.step = step;
+        timer.rounds = (ticks - 1) / MACRO_WHEEL_SLOTS;
+        timer.next = _slots[slot];
+        timer.active = true;
+        _slots[slot] = index;
+        _pending++;
+        return true;
+    }
+
+    // Drop every pending entry of button
+    void cancel(uint8_t button) {
+        for (int slot = 0; slot < MACRO_WHEEL_SLOTS; slot++) {
+            int8_t* link = &_slots[slot];
+            while (*link >= 0) {
+                Timer& timer = _timers[*link];
+                if (timer.button == button) {
+                    timer.active = false;
+                    *link = timer.next;
+                    _pending--;
+                } else {
+                    link = &timer.next;
+                }
+            }
+        }
+    }
+
+    // Call fire(button, step) for every entry that has come due, catching up
+    // on ticks missed since the last call
+    template <typename F>
+    void advance(F fire) {
+        if (_pending == 0) return;
+
+        while (millis() - _lastTickMs >= MACRO_WHEEL_TICK_MS) {
+            _lastTickMs += MACRO_WHEEL_TICK_MS;
+            _tick++;
+
+            int8_t* link = &_slots[_tick % MACRO_WHEEL_SLOTS];
+            while (*link >= 0) {
+                Timer& timer = _timers[*link];
+                if (timer.rounds > 0) {
+                    timer.rounds--;
+                    link = &timer.next;
+                    continue;
+                }
+                *link = timer.next;
+                timer.active = false;
+                _pending--;
+                fire(timer.button, timer.step);
+            }
+        }
+    }
+
+    bool isPending(uint8_t button) const {
+        for (int i = 0; i < N; i++) {
+            if (_timers[i].active && _timers[i].button == button) return true;
+        }
+        return false;
+    }
+
+    int getPendingCount() const {
+        return _pending;
+    }
+
+private:
+    struct Timer {
+        uint8_t button;
+        uint8_t step;
+        uint16_t rounds;
+        int8_t next;
+        bool active;
+    };
+    Timer _timers[N];
+    int8_t _slots[MACRO_WHEEL_SLOTS];
+    uint32_t _tick;
+    unsigned long _lastTickMs;
+    int _pending;
+};
+
+#endif
@@ -0,0 +1,175 @@
+// OSC-Muis - Niels van der Hulst 2026
+
+#include "matrix_scanner.h"
+
+#if BOARD_MATRIX
+
+#include "driver/gpio.h"
+
+// Static instance pointer for the timer callback and column ISR
+static MatrixScanner* _scannerInstance = nullptr;
+
+MatrixScanner::MatrixScanner() : _pending(0), _state(0) {
+    _timer = nullptr;
+    memset(&_debouncer, 0, sizeof(_debouncer));
+    _scanning = false;
+    _idleScans = 0;
+    _lockoutMs = 0;
+    memset(_lastPress, 0, sizeof(_lastPress));
+}
+
+void MatrixScanner::configurePins() {
+    // Rows come out of deep sleep still held LOW (see enableWake())
+    for (size_t r = 0; r < BOARD.rowCount; r++) {
+        gpio_hold_dis((gpio_num_t)BOARD.rows[r]);
+        pinMode(BOARD.rows[r], OUTPUT_OPEN_DRAIN);
+        digitalWrite(BOARD.rows[r], HIGH);  // Released
+    }
+    for (size_t c = 0; c < BOARD.colCount; c++) {
+        pinMode(BOARD.cols[c], INPUT_PULLUP);
+    }
+    delayMicroseconds(100);  // Let pull-ups settle before anything reads them
+
+    // Column pull-ups survive deep sleep (the wake columns need them). Rows
+    // are only latched when going to sleep: held pads can't be scanned.
+    for (size_t c = 0; c < BOARD.colCount; c++) {
+        gpio_hold_en((gpio_num_t)BOARD.cols[c]);
+    }
+    gpio_deep_sleep_hold_en();
+}
+
+void MatrixScanner::begin(unsigned long lockoutMs) {
+    _scannerInstance = this;
+    _lockoutMs = lockoutMs;
+
+    // Column interrupts only wake an idle scanner; masked while it runs
+    for (size_t c = 0; c < BOARD.colCount; c++) {
+        attachInterrupt(digitalPinToInterrupt(BOARD.cols[c]), onColumn, FALLING);
+    }
+    setColumnInterrupts(false);
+
+    esp_timer_create_args_t args = {};
+    args.callback = onTimer;
+    args.arg = this;
+    args.dispatch_method = ESP_TIMER_TASK;
+    args.name = "matrix";
+    esp_timer_create(&args, &_timer);
+
+    // Keys may already be held: start scanning, go idle from there
+    _scanning = true;
+    esp_timer_start_periodic(_timer, MATRIX_SCAN_PERIOD_US);
+    Serial.printf("Key matrix: %dx%d, scanning every %d us\n",
+                  (int)BOARD.rowCount, (int)BOARD.colCount, MATRIX_SCAN_PERIOD_US);
+}
+
+void IRAM_ATTR MatrixScanner::setColumnInterrupts(bool enabled) {
+    for (size_t c = 0; c < BOARD.colCount; c++) {
+        if (enabled) gpio_intr_enable((gpio_num_t)BOARD.cols[c]);
+        else gpio_intr_disable((gpio_num_t)BOARD.cols[c]);
+    }
+}
+
+void MatrixScanner::onTimer(void* arg) {
+    static_cast<MatrixScanner*>(arg)->scan();
+}
+
+// First key down on an idle pad. esp_timer_start_periodic() takes the timer
+// list spinlock and is safe from an ISR.
+void IRAM_ATTR MatrixScanner::onColumn() {
+    MatrixScanner* self = _scannerInstance;
+    if (self->_scanning) return;
+    self->_scanning = true;
+    self->setColumnInterrupts(false);
+    esp_timer_start_periodic(self->_timer, MATRIX_SCAN_PERIOD_US);
+}
+
+void MatrixScanner::scan() {
+    // Sample every key: pull one row LOW, read which columns follow it
+    uint32_t sample = 0;
+    for (size_t r = 0; r < BOARD.rowCount; r++) {
+        digitalWrite(BOARD.rows[r], HIGH);
+    }
+    for (size_t r = 0; r < BOARD.rowCount; r++) {
+        digitalWrite(BOARD.rows[r], LOW);
+        delayMicroseconds(MATRIX_SETTLE_US);
+        for (size_t c = 0; c < BOARD.colCount; c++) {
+            if (digitalRead(BOARD.cols[c]) == LOW) sample |= 1u << (r * BOARD.colCount + c);
+        }
+        digitalWrite(BOARD.rows[r], HIGH);
+    }
+
+    uint32_t pressed = _debouncer.update(sample);
+    _state.store(_debouncer.state, std::memory_order_relaxed);
+
+    if (pressed) {
+        // Same cooldown as the direct buttons' ISRs: a key ignores repeat
+        // presses for the lockout time
+        unsigned long now = millis();
+        for (int i = 0; i < BOARD_BUTTONS; i++) {
+            uint32_t bit = 1u << i;
+            if (!(pressed & bit)) continue;
+            if (now - _lastPress[i] > _lockoutMs) _lastPress[i] = now;
+            else pressed &= ~bit;
+        }
+        _pending.fetch_or(pressed, std::memory_order_release);
+    }
+
+    if (sample == 0 && _debouncer.state == 0) {
+        if (++_idleScans >= MATRIX_IDLE_SCANS) sleep();
+    } else {
+        _idleScans = 0;
+    }
+}
+
+void MatrixScanner::sleep() {
+    // Stop first: once the column interrupts are on, their ISR may restart
+    // the timer at any moment
+    esp_timer_stop(_timer);
+    _idleScans = 0;
+    memset(&_debouncer, 0, sizeof(_debouncer));
+
+    // Every row LOW: any key pulls its column LOW and raises an edge
+    for (size_t r = 0; r < BOARD.rowCount; r++) {
+        digitalWrite(BOARD.rows[r], LOW);
+    }
+    delayMicroseconds(MATRIX_SETTLE_US);
+    _scanning = false;
+    setColumnInterrupts(true);
+
+    // A key that went down just before the interrupts were enabled raised
+    // no edge. With the interrupts masked the ISR can't race this.
+    for (size_t c = 0; c < BOARD.colCount; c++) {
+        if (digitalRead(BOARD.cols[c]) == LOW) {
+            setColumnInterrupts(false);
+            if (!_scanning) {
+                _scanning = true;
+                esp_timer_start_periodic(_timer, MATRIX_SCAN_PERIOD_US);
+            }
+            break;
+        }
+    }
+}
+
+uint32_t MatrixScanner::takePresses(uint32_t mask) {
+    return _pending.fetch_and(~mask, std::memory_order_acquire) & mask;
+}
+
+uint32_t MatrixScanner::getState() const {
+    return _state.load(std::memory_order_relaxed);
+}
+
+bool MatrixScanner::isScanning() const {
+    return _scanning;
+}
+
+void MatrixScanner::enableWake() {
+    if (_timer) esp_timer_stop(_timer);
+    setColumnInterrupts(false);
+    for (size_t r = 0; r < BOARD.rowCount; r++) {
+        digitalWrite(BOARD.rows[r], LOW);
+        gpio_hold_en((gpio_num_t)BOARD.rows[r]);
+    }
+    gpio_deep_sleep_hold_en();
+}
+
+#endif
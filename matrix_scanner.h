@@ -0,0 +1,96 @@
+// OSC-Muis - Niels van der Hulst 2026
+
+#ifndef MATRIX_SCANNER_H
+#define MATRIX_SCANNER_H
+
+#include <Arduino.h>
+#include <atomic>
+#include "board_profile.h"
+
+#if BOARD_MATRIX
+
+#include "esp_timer.h"
+
+#define MATRIX_SCAN_PERIOD_US 1000    // One full scan per ms
+#define MATRIX_SETTLE_US 5            // Column settle time after pulling a row LOW
+#define MATRIX_IDLE_SCANS 100         // All keys up this long: stop scanning, wait for a key interrupt
+
+// Per-key debounce on bitmaps (bit = key): vertical 2-bit counters, so all
+// keys are debounced with a handful of bitwise operations per scan. A key
+// changes state after 4 consecutive samples that disagree with its current
+// state; any agreeing sample in between starts the count over. At 1 ms per
+// scan a press is reported 3-4 ms after the contact settles.
+//
+// Plain data with no hardware access, so it can be fed simulated samples.
+struct MatrixDebouncer {
+    uint32_t state;           // Debounced: bit set = key down
+    uint32_t count0;          // Low bit of each key's counter
+    uint32_t count1;          // High bit
+
+    // Feed one scan; returns the keys that went down with it
+    uint32_t update(uint32_t sample) {
+        uint32_t delta = sample ^ state;
+        count1 = (count1 ^ count0) & delta;
+        count0 = ~count0 & delta;
+        uint32_t toggle = delta & ~(count0 | count1);
+        state ^= toggle;
+        return toggle & state;
+    }
+};
+
+// Scans the board profile's key matrix on a periodic esp_timer (hardware
+// timer backed, callbacks on the high-priority esp_timer task) and turns
+// debounced press edges into the same press flags the direct-wired buttons
+// raise from their ISRs, so loop() handles both the same way.
+//
+// Any number of keys can be held at once (n-key rollover, given the
+// diodes). Like the direct buttons, a key that was pressed ignores new
+// presses for the lockout time.
+//
+// Idle: once every key has been up for MATRIX_IDLE_SCANS scans, the timer
+// stops, all rows are pulled LOW and the columns' edge interrupts are
+// enabled; the first key down restarts the scan from its ISR. A quiet pad
+// costs no CPU time at all.
+class MatrixScanner {
+public:
+    MatrixScanner();
+
+    // Rows released, columns pulled up and latched across deep sleep
+    void configurePins();
+
+    // Start scanning (and the column interrupts for idle wake)
+    void begin(unsigned long lockoutMs);
+
+    // Press edges since the last call for the keys in mask; clears them
+    uint32_t takePresses(uint32_t mask);
+
+    // Debounced key state (bit = key down)
+    uint32_t getState() const;
+
+    // Pull all rows LOW and hold them across deep sleep, so a key in a wake
+    // column pulls its column LOW
+    void enableWake();
+
+    bool isScanning() const;
+
+private:
+    static void onTimer(void* arg);
+    static void onColumn();
+
+    void scan();
+    void sleep();
+    void setColumnInterrupts(bool enabled);
+
+    esp_timer_handle_t _timer;
+    MatrixDebouncer _debouncer;
+    std::atomic<uint32_t> _pending;   // Press edges not yet taken by loop()
+    std::atomic<uint32_t> _state;     // Copy of the debounced state for loop()
+    volatile bool _scanning;
+    uint16_t _idleScans;
+    unsigned long _lockoutMs;
+    unsigned long _lastPress[BOARD_BUTTONS];
+};
+
+#endif
+
+#endif
@@ -0,0 +1,24 @@
+// OSC-Muis - Niels van der Hulst 2026
+
+#ifndef OSC_HEARD_H
+#define OSC_HEARD_H
+
+#include <Arduino.h>
+
+// Does an incoming packet prove that the receiver of our presses lives on
+// the interface it arrived on (OSCRouter::noteHeard)?
+//
+// Yes if the configured unicast target sent it, or it is one of the /muis/
+// commands registered as show control (heardCommand: preset changes, power
+// mode), which come from the show machine. Configuration and diagnostics
+// (/muis/config*, /muis/status, /muis/fleet*, ...) come from whatever laptop
+// is at hand, and other OSC on the port may be a neighbouring unit's
+// broadcast presses: neither may cut broadcasts to the other interface.
+// Our own broadcasts looping back never count.
+inline bool oscProvesReceiver(uint32_t from, uint32_t localIP, uint32_t target, bool heardCommand) {
+    if (from == localIP) return false;
+    if (target != 0 && from == target) return true;
+    return heardCommand;
+}
+
+#endif
@@ -2,6 +2,9 @@
 
 #include "osc_manager.h"
 #include "wifi_manager.h"
+#include "osc_heard.h"
+#include "log_ring.h"
+#include "telemetry.h"
 #include <OSCMessage.h>
 
 // Static instance pointer for web callbacks
@@ -11,280 +14,794 @@ static OSCManager* _oscInstance = nullptr;
 static String oscTemplateProcessor(const String& var) {
     if (!_oscInstance) return String();
 
-    if (var == "OSC_PORT") return String(_oscInstance->getPort());
-    if (var == "OSC_TARGET_IP") {
-        String target = _oscInstance->getTargetIP();
-        return target.length() > 0 ? target : "broadcast";
+    OSCConfig config;
+    _oscInstance->getConfig(config);
+    if (var == "OSC_PORT") return String(config.port);
+    if (var == "OSC_TARGET_IP") return String(config.targetIP[0] ? config.targetIP : "broadcast");
+    if (var == "OSC_ADDRESS_FORMAT") return String(config.addressFormat);
+    if (var == "OSC_PREFIX_CHECKED") return config.addressPrefix ? "checked" : "";
+    if (var == "OSC_CHANNELS") {
+        // JS array literal; the portal builds one channel field per button from it
+        String list = "[";
+        for (int i = 0; i < BOARD_BUTTONS; i++) {
+            if (i > 0) list += ",";
+            list += String(config.channels[i]);
+        }
+        return list + "]";
     }
-    if (var == "OSC_ADDRESS_FORMAT") return _oscInstance->getAddressFormat();
-    if (var == "OSC_BUTTON1_CHANNEL") return String(_oscInstance->getButton1Channel());
-    if (var == "OSC_BUTTON2_CHANNEL") return String(_oscInstance->getButton2Channel());
 
     return String();  // Variable not handled
 }
 
+void OSCConfig::setTargetIP(const char* ip) {
+    strlcpy(targetIP, ip, sizeof(targetIP));
+    IPAddress addr(0, 0, 0, 0);
+    if (targetIP[0]) {
+        addr.fromString(targetIP);
+    }
+    targetAddr = (uint32_t)addr;
+}
+
 OSCManager::OSCManager() {
     _wifiManager = nullptr;
-    _state.port = 8001;  // LuPlayer default incoming port
-    _state.targetIP = "";  // Empty = broadcast
-    _state.addressFormat = "/kmpush";  // Default format for Keyboard Mapped mode
-    _state.button1Channel = 1;  // Default channel for button 1
-    _state.button2Channel = 2;  // Default channel for button 2
+    strlcpy(_deviceName, "OSC-MUIS", sizeof(_deviceName));
+    _addressPrefix[0] = '\0';
     _state.testRequested = false;
+    _state.benchRequested = false;
+    _bench.valid = false;
+    _commandCount = 0;
+    _replySocket = nullptr;
+    _replyPort = 0;
 }
 
 void OSCManager::begin(AsyncWebServer& webServer, WiFiManager& wifiManager) {
     _wifiManager = &wifiManager;
     _oscInstance = this;
+    strlcpy(_deviceName, wifiManager.getDeviceName(), sizeof(_deviceName));
+    snprintf(_addressPrefix, sizeof(_addressPrefix), "/%s", wifiManager.getDeviceId());
 
-    // Load saved settings
+    // Load saved settings (publishes the first snapshot)
     loadSettings();
 
-    // Register web endpoints
-    registerWebEndpoints(webServer);
-
-    // Register template processor callback with WiFiManager
-    wifiManager.registerTemplateCallback(oscTemplateProcessor);
+    // Settings over OSC work in both modes; the portal side only exists
+    // when the portal stack is up
+    registerConfigCommands();
+    if (!wifiManager.isHeadless()) {
+        registerWebEndpoints(webServer);
+        wifiManager.registerTemplateCallback(oscTemplateProcessor);
+    }
 
+    OSCConfig config;
+    getConfig(config);
     Serial.printf("OSC configured: port=%d, target=%s, format=%s\n",
-        _state.port,
-        _state.targetIP.length() > 0 ? _state.targetIP.c_str() : "broadcast",
-        _state.addressFormat.c_str());
+        config.port,
+        config.targetIP[0] ? config.targetIP : "broadcast",
+        config.addressFormat);
 }
 
 void OSCManager::loadSettings() {
+    OSCConfig config;
     _preferences.begin("osc", true);
-    _state.port = _preferences.getInt("port", 8001);
-    _state.targetIP = _preferences.getString("targetip", "");
-    _state.addressFormat = _preferences.getString("addrfmt", "/kmpush");
-    _state.button1Channel = _preferences.getInt("btn1ch", 1);
-    _state.button2Channel = _preferences.getInt("btn2ch", 2);
+    config.port = _preferences.getInt("port", 8001);  // LuPlayer default incoming port
+    // getString() leaves the buffer alone when the key is missing: defaults first
+    config.targetIP[0] = '\0';  // Empty = broadcast
+    strlcpy(config.addressFormat, "/kmpush", sizeof(config.addressFormat));  // Default format for Keyboard Mapped mode
+    _preferences.getString("targetip", config.targetIP, sizeof(config.targetIP));
+    _preferences.getString("addrfmt", config.addressFormat, sizeof(config.addressFormat));
+    for (int i = 0; i < BOARD_BUTTONS; i++) {
+        config.channels[i] = _preferences.getInt(BOARD_CHANNEL_KEYS[i].text, i + 1);
+    }
+    config.addressPrefix = _preferences.getBool("prefix", false);
     _preferences.end();
+    config.setTargetIP(config.targetIP);
+
+    const char* error = config.program.compile(config.addressFormat);
+    if (error) {
+        Serial.printf("OSC template \"%s\" invalid (%s), using /kmpush\n", config.addressFormat, error);
+        strlcpy(config.addressFormat, "/kmpush", sizeof(config.addressFormat));
+        config.program.compile(config.addressFormat);
+    }
+    _config.begin(config);
 }
 
-void OSCManager::saveSettings() {
+// Called from inside a ConfigSnapshot update, so saves are serialized too
+void OSCManager::saveSettings(const OSCConfig& config) {
     _preferences.begin("osc", false);
-    _preferences.putInt("port", _state.port);
-    _preferences.putString("targetip", _state.targetIP);
-    _preferences.putString("addrfmt", _state.addressFormat);
-    _preferences.putInt("btn1ch", _state.button1Channel);
-    _preferences.putInt("btn2ch", _state.button2Channel);
+    _preferences.putInt("port", config.port);
+    _preferences.putString("targetip", config.targetIP);
+    _preferences.putString("addrfmt", config.addressFormat);
+    for (int i = 0; i < BOARD_BUTTONS; i++) {
+        _preferences.putInt(BOARD_CHANNEL_KEYS[i].text, config.channels[i]);
+    }
+    _preferences.putBool("prefix", config.addressPrefix);
     _preferences.end();
 }
 
+void OSCManager::logSettings(const char* how, const OSCConfig& config) {
+    char channels[4 * BOARD_BUTTONS + 1];
+    size_t n = 0;
+    for (int i = 0; i < BOARD_BUTTONS; i++) {
+        n += snprintf(channels + n, sizeof(channels) - n, "%s%d", i ? "," : "", config.channels[i]);
+    }
+    Serial.printf("OSC settings saved%s: port=%d, target=%s, format=%s, channels=%s, prefix=%s\n",
+        how,
+        config.port,
+        config.targetIP[0] ? config.targetIP : "broadcast",
+        config.addressFormat,
+        channels,
+        config.addressPrefix ? "on" : "off");
+}
+
+String OSCManager::getSettingsJson() const {
+    OSCConfig config;
+    getConfig(config);
+    return settingsJson(config);
+}
+
+String OSCManager::settingsJson(const OSCConfig& config) {
+    String json = "{";
+    json += "\"port\":" + String(config.port) + ",";
+    json += "\"targetip\":\"" + String(config.targetIP) + "\",";
+    json += "\"addressFormat\":\"" + String(config.addressFormat) + "\",";
+    json += "\"addressPrefix\":" + String(config.addressPrefix ? "true" : "false") + ",";
+    json += "\"channels\":[";
+    for (int i = 0; i < BOARD_BUTTONS; i++) {
+        if (i > 0) json += ",";
+        json += String(config.channels[i]);
+    }
+    json += "]";
+    // Per-button fields as before, for existing scripts
+    for (int i = 0; i < BOARD_BUTTONS; i++) {
+        json += ",\"button" + String(i + 1) + "Channel\":" + String(config.channels[i]);
+    }
+    json += "}";
+    return json;
+}
+
+String OSCManager::getTestJson() const {
+    OSCConfig config;
+    getConfig(config);
+    OSCTemplateContext ctx;
+    makeContext(config, 1, ctx);
+    char address[OSC_ADDRESS_MAX];
+    config.program.formatAddress(ctx, address, sizeof(address));
+    IPAddress targets[OSC_MAX_ROUTES];
+    int routes[OSC_MAX_ROUTES];
+    int count = getTargets(config, targets, routes);
+
+    String json = "{\"address\":\"" + String(address) + "\",\"targets\":[";
+    for (int i = 0; i < count; i++) {
+        if (i > 0) json += ",";
+        json += "\"" + targets[i].toString() + ":" + String(config.port) + "\"";
+    }
+    json += "]}";
+    return json;
+}
+
 void OSCManager::registerWebEndpoints(AsyncWebServer& webServer) {
+    ControlChannel& control = _wifiManager->getControlChannel();
+
     // Get OSC settings
-    webServer.on("/osc", HTTP_GET, [](AsyncWebServerRequest *request) {
-        if (!_oscInstance) {
-            request->send(500, "application/json", "{\"error\":\"OSC not initialized\"}");
-            return;
-        }
-        String json = "{";
-        json += "\"port\":" + String(_oscInstance->_state.port) + ",";
-        json += "\"targetip\":\"" + _oscInstance->_state.targetIP + "\",";
-        json += "\"addressFormat\":\"" + _oscInstance->_state.addressFormat + "\",";
-        json += "\"button1Channel\":" + String(_oscInstance->_state.button1Channel) + ",";
-        json += "\"button2Channel\":" + String(_oscInstance->_state.button2Channel);
-        json += "}";
-        request->send(200, "application/json", json);
+    control.registerAction("osc.get", "/osc", HTTP_GET, [](const ControlRequest&) -> String {
+        return _oscInstance->getSettingsJson();
     });
 
     // Save OSC settings
-    webServer.on("/osc", HTTP_POST, [](AsyncWebServerRequest *request) {
-        if (!_oscInstance) {
-            request->send(500, "application/json", "{\"error\":\"OSC not initialized\"}");
-            return;
-        }
-
-        bool changed = false;
-
-        if (request->hasParam("port", true)) {
-            int port = request->getParam("port", true)->value().toInt();
-            if (port > 0 && port < 65536) {
-                _oscInstance->_state.port = port;
-                changed = true;
-            }
+    control.registerAction("osc.set", "/osc", HTTP_POST, [](const ControlRequest& req) -> String {
+        // Validate everything first: a rejected request changes nothing
+        int port = req.hasParam("port") ? req.getParam("port").toInt() : 0;
+        int channels[BOARD_BUTTONS];
+        for (int i = 0; i < BOARD_BUTTONS; i++) {
+            char name[20];
+            snprintf(name, sizeof(name), "button%dChannel", i + 1);
+            channels[i] = req.hasParam(name) ? req.getParam(name).toInt() : 0;
         }
 
-        if (request->hasParam("targetip", true)) {
-            String newTargetIP = request->getParam("targetip", true)->value();
-            // Validate: empty is OK (means broadcast), otherwise must parse as a valid IPv4 address
-            if (newTargetIP.length() > 0) {
-                IPAddress test;
-                if (!test.fromString(newTargetIP)) {
-                    request->send(200, "application/json",
-                        "{\"success\":false,\"message\":\"Invalid target IP — must be a valid IPv4 address (e.g. 192.168.1.10) or empty for broadcast\"}");
-                    return;
-                }
+        bool hasTargetIP = req.hasParam("targetip");
+        String newTargetIP = hasTargetIP ? req.getParam("targetip") : String();
+        // Validate: empty is OK (means broadcast), otherwise must parse as a valid IPv4 address
+        if (newTargetIP.length() > 0) {
+            IPAddress test;
+            if (newTargetIP.length() >= OSC_TARGET_IP_MAX || !test.fromString(newTargetIP)) {
+                return "{\"success\":false,\"message\":\"Invalid target IP — must be a valid IPv4 address (e.g. 192.168.1.10) or empty for broadcast\"}";
             }
-            _oscInstance->_state.targetIP = newTargetIP;
-            changed = true;
         }
 
-        if (request->hasParam("addressFormat", true)) {
-            _oscInstance->_state.addressFormat = request->getParam("addressFormat", true)->value();
-            changed = true;
-        }
+        bool hasPrefix = req.hasParam("addressPrefix");
+        bool prefix = hasPrefix && req.getParam("addressPrefix") == "1";
 
-        if (request->hasParam("button1Channel", true)) {
-            int ch = request->getParam("button1Channel", true)->value().toInt();
-            if (ch > 0 && ch < 100) {
-                _oscInstance->_state.button1Channel = ch;
-                changed = true;
+        // Templates are compiled here, once; a press only runs the result
+        bool hasFormat = req.hasParam("addressFormat");
+        String format = hasFormat ? req.getParam("addressFormat") : String();
+        OSCTemplate program;
+        if (hasFormat) {
+            if (format.length() >= OSC_ADDRESS_FORMAT_MAX) {
+                return "{\"success\":false,\"message\":\"Address format too long\"}";
+            }
+            const char* error = program.compile(format.c_str());
+            if (error) {
+                return String("{\"success\":false,\"message\":\"Address template: ") + error + "\"}";
             }
         }
 
-        if (request->hasParam("button2Channel", true)) {
-            int ch = request->getParam("button2Channel", true)->value().toInt();
-            if (ch > 0 && ch < 100) {
-                _oscInstance->_state.button2Channel = ch;
-                changed = true;
+        // Build the next version off to the side and publish it in one go;
+        // the button path keeps sending with the previous version until then
+        OSCConfig saved;
+        bool changed = _oscInstance->_config.update([&](OSCConfig& next) {
+            bool dirty = false;
+            if (port > 0 && port < 65536) { next.port = port; dirty = true; }
+            if (hasTargetIP) { next.setTargetIP(newTargetIP.c_str()); dirty = true; }
+            if (hasFormat) {
+                strlcpy(next.addressFormat, format.c_str(), sizeof(next.addressFormat));
+                next.program = program;
+                dirty = true;
             }
-        }
+            for (int i = 0; i < BOARD_BUTTONS; i++) {
+                if (channels[i] > 0 && channels[i] < 100) { next.channels[i] = channels[i]; dirty = true; }
+            }
+            if (hasPrefix) { next.addressPrefix = prefix; dirty = true; }
+            if (dirty) {
+                _oscInstance->saveSettings(next);
+                saved = next;
+            }
+            return dirty;
+        });
 
         if (changed) {
-            _oscInstance->saveSettings();
-
-            Serial.printf("OSC settings saved: port=%d, target=%s, format=%s, btn1=%d, btn2=%d\n",
-                _oscInstance->_state.port,
-                _oscInstance->_state.targetIP.length() > 0 ? _oscInstance->_state.targetIP.c_str() : "broadcast",
-                _oscInstance->_state.addressFormat.c_str(),
-                _oscInstance->_state.button1Channel,
-                _oscInstance->_state.button2Channel);
+            logSettings("", saved);
+
+            // Let every open portal pick up the new settings
+            _oscInstance->_wifiManager->getControlChannel().push("osc", settingsJson(saved));
         }
 
-        request->send(200, "application/json", "{\"success\":true}");
+        return "{\"success\":true}";
+    });
+
+    // Test OSC - sets a flag that the main sketch checks. The reply lists
+    // where the message will go; socket clients get a "testosc" event once
+    // it has actually been sent.
+    control.registerAction("testosc", "/testosc", HTTP_POST, [](const ControlRequest&) -> String {
+        // Set flag for main loop to send test message
+        _oscInstance->_state.testRequested = true;
+        Serial.println("OSC test requested via web UI");
+        return _oscInstance->getTestJson();
+    });
+
+    // Routing table: interfaces, whether a receiver was heard, suppressed sends
+    control.registerAction("routes", "/routes", HTTP_GET, [](const ControlRequest&) -> String {
+        return _oscInstance->_router.getStatusJson();
     });
 
-    // Test OSC - sets a flag that the main sketch checks
-    webServer.on("/testosc", HTTP_POST, [](AsyncWebServerRequest *request) {
-        if (!_oscInstance || !_oscInstance->_wifiManager) {
+    // Latency bench — POST starts a run in loop(), GET returns the last result
+    webServer.on("/oscbench", HTTP_POST, [](AsyncWebServerRequest *request) {
+        if (!_oscInstance) {
             request->send(500, "application/json", "{\"error\":\"OSC not initialized\"}");
             return;
         }
+        _oscInstance->_state.benchRequested = true;
+        request->send(200, "application/json", "{\"success\":true,\"status\":\"running\"}");
+    });
 
-        String address = _oscInstance->formatAddress(1);
-        std::vector<IPAddress> targets = _oscInstance->getTargetIPAddresses();
-
-        // Build response with all targets
-        String json = "{\"address\":\"" + address + "\",\"targets\":[";
-        for (size_t i = 0; i < targets.size(); i++) {
-            if (i > 0) json += ",";
-            json += "\"" + targets[i].toString() + ":" + String(_oscInstance->_state.port) + "\"";
+    webServer.on("/oscbench", HTTP_GET, [](AsyncWebServerRequest *request) {
+        if (!_oscInstance || !_oscInstance->_bench.valid) {
+            request->send(200, "application/json", "{\"status\":\"none\"}");
+            return;
         }
-        json += "]}";
-
+        auto pathJson = [](const BenchPathResult& r) {
+            return "{\"sent\":" + String(r.sent) +
+                   ",\"dropped\":" + String(r.dropped) +
+                   ",\"sendAvgUs\":" + String(r.avgUs) +
+                   ",\"sendMaxUs\":" + String(r.maxUs) + "}";
+        };
+        String json = "{\"target\":\"" + _oscInstance->_bench.target.toString() + "\",";
+        json += "\"wifiudp\":" + pathJson(_oscInstance->_bench.wifiUdp) + ",";
+        json += "\"socket\":" + pathJson(_oscInstance->_bench.socket) + "}";
         request->send(200, "application/json", json);
-
-        // Set flag for main loop to send test message
-        _oscInstance->_state.testRequested = true;
-        Serial.println("OSC test requested via web UI");
     });
 }
 
 void OSCManager::setPort(int port) {
-    _state.port = port;
+    _config.update([port](OSCConfig& next) { next.port = port; return true; });
 }
 
 int OSCManager::getPort() const {
-    return _state.port;
+    return _config.read().port;
+}
+
+void OSCManager::setTargetIP(const char* ip) {
+    _config.update([ip](OSCConfig& next) { next.setTargetIP(ip); return true; });
+}
+
+IPAddress OSCManager::getUnicastTarget() const {
+    return IPAddress(_config.read().targetAddr);
 }
 
-void OSCManager::setTargetIP(const String& ip) {
-    _state.targetIP = ip;
+bool OSCManager::setAddressFormat(const char* format) {
+    OSCTemplate program;
+    if (strlen(format) >= OSC_ADDRESS_FORMAT_MAX || program.compile(format)) return false;
+    _config.update([format, &program](OSCConfig& next) {
+        strlcpy(next.addressFormat, format, sizeof(next.addressFormat));
+        next.program = program;
+        return true;
+    });
+    return true;
 }
 
-String OSCManager::getTargetIP() const {
-    return _state.targetIP;
+void OSCManager::setButtonChannel(int buttonNumber, int channel) {
+    if (buttonNumber < 1 || buttonNumber > BOARD_BUTTONS) return;
+    _config.update([buttonNumber, channel](OSCConfig& next) { next.channels[buttonNumber - 1] = channel; return true; });
 }
 
-void OSCManager::setAddressFormat(const String& format) {
-    _state.addressFormat = format;
+int OSCManager::getButtonChannel(int buttonNumber) const {
+    if (buttonNumber < 1 || buttonNumber > BOARD_BUTTONS) return 0;
+    return _config.read().channels[buttonNumber - 1];
 }
 
-String OSCManager::getAddressFormat() const {
-    return _state.addressFormat;
+void OSCManager::getConfig(OSCConfig& out) const {
+    _config.read(out);
 }
 
-void OSCManager::setButton1Channel(int channel) {
-    _state.button1Channel = channel;
+uint32_t OSCManager::getConfigVersion() const {
+    return _config.version();
 }
 
-int OSCManager::getButton1Channel() const {
-    return _state.button1Channel;
+void OSCManager::applyPreset(const OSCConfig& preset) {
+    OSCConfig applied;
+    _config.update([&](OSCConfig& next) {
+        int port = next.port;
+        bool prefix = next.addressPrefix;
+        next = preset;
+        next.port = port;
+        next.addressPrefix = prefix;
+        applied = next;
+        return true;
+    });
+    _wifiManager->getControlChannel().push("osc", settingsJson(applied));
 }
 
-void OSCManager::setButton2Channel(int channel) {
-    _state.button2Channel = channel;
+void OSCManager::applySettings(const OSCConfig& config, const char* how) {
+    _config.update([&](OSCConfig& next) {
+        next = config;
+        saveSettings(next);
+        return true;
+    });
+    logSettings(how, config);
+    _wifiManager->getControlChannel().push("osc", settingsJson(config));
 }
 
-int OSCManager::getButton2Channel() const {
-    return _state.button2Channel;
+int OSCManager::getTargetIPAddresses(IPAddress* out) const {
+    OSCConfig config;
+    getConfig(config);
+    int routes[OSC_MAX_ROUTES];
+    return getTargets(config, out, routes);
 }
 
-std::vector<IPAddress> OSCManager::getTargetIPAddresses() const {
-    std::vector<IPAddress> targets;
+int OSCManager::getTargets(const OSCConfig& config, IPAddress* out, int* routes) const {
+    // If custom target IP is specified, use only that, through the interface
+    // that reaches it
+    if (config.targetAddr != 0) {
+        int route = _router.routeFor(IPAddress(config.targetAddr));
+        if (route < 0) return 0;
+        out[0] = IPAddress(config.targetAddr);
+        routes[0] = route;
+        return 1;
+    }
 
-    // If custom target IP is specified, use only that
-    if (_state.targetIP.length() > 0) {
-        IPAddress ip;
-        if (ip.fromString(_state.targetIP)) {
-            targets.push_back(ip);
-            return targets;
+    // Broadcasting mode - every interface the router sends on (the table is
+    // only rebuilt on WiFi events, so this is a short array walk)
+    int count = 0;
+    for (int i = 0; i < _router.getRouteCount(); i++) {
+        if (_router.shouldBroadcast(i)) {
+            out[count] = _router.getRoute(i).broadcast;
+            routes[count] = i;
+            count++;
         }
     }
+    return count;
+}
 
-    // Broadcasting mode - get all broadcast IPs from WiFi manager
-    if (_wifiManager) {
-        return _wifiManager->getBroadcastIPAddresses();
+void OSCManager::formatAddress(int buttonNumber, char* out) const {
+    OSCConfig config;
+    getConfig(config);
+    OSCTemplateContext ctx;
+    makeContext(config, buttonNumber, ctx);
+    config.program.formatAddress(ctx, out, OSC_ADDRESS_MAX);
+}
+
+void OSCManager::makeContext(int buttonNumber, OSCTemplateContext& ctx) const {
+    OSCConfig config;
+    getConfig(config);
+    makeContext(config, buttonNumber, ctx);
+}
+
+void OSCManager::makeContext(const OSCConfig& config, int buttonNumber, OSCTemplateContext& ctx) const {
+    // Map button number to configured channel
+    ctx.channel = (buttonNumber >= 1 && buttonNumber <= BOARD_BUTTONS) ? config.channels[buttonNumber - 1] : 0;
+    ctx.button = buttonNumber;
+    ctx.device = _deviceName;
+    ctx.value = 1.0f;
+    ctx.prefix = config.addressPrefix ? _addressPrefix : "";
+}
+
+const char* OSCManager::getAddressPrefix() const {
+    return _config.read().addressPrefix ? _addressPrefix : "";
+}
+
+void OSCManager::sendButton(int buttonNumber) {
+    // One lock-free copy of the settings for the whole send: a concurrent
+    // save from the portal lands either entirely before or entirely after
+    OSCConfig config;
+    getConfig(config);
+
+    OSCTemplateContext ctx;
+    makeContext(config, buttonNumber, ctx);
+
+    // Get all target IPs (will be multiple in AP+STA mode until a receiver
+    // has shown which network it is on)
+    IPAddress targets[OSC_MAX_ROUTES];
+    int routes[OSC_MAX_ROUTES];
+    int count = getTargets(config, targets, routes);
+    if (count == 0) {
+        LOG_WARN("OSC DROPPED: no interface up");
+        telemetry.noteSendFailure();
+        return;
+    }
+
+    // Broadcasts skipped on silent interfaces (diagnostics)
+    if (config.targetAddr == 0) {
+        for (int i = 0; i < _router.getRouteCount(); i++) {
+            if (_router.getRoute(i).up && !_router.shouldBroadcast(i)) _router.noteSuppressed(i);
+        }
+    }
+
+    // The address for the log lines, formatted at most once per press. Only
+    // used as a LOG_* argument: with that level compiled out, it never runs.
+    char address[OSC_ADDRESS_MAX];
+    address[0] = '\0';
+    auto logAddress = [&]() -> const char* {
+        if (!address[0]) config.program.formatAddress(ctx, address, sizeof(address));
+        return address;
+    };
+
+    // Send to all targets, each through its own interface's socket
+    for (int i = 0; i < count; i++) {
+        OSCSocket& socket = _router.getRoute(routes[i]).socket;
+        socket.beginPacket();
+        config.program.encode(socket, ctx);  // Compiled template: copies and small numbers only
+        bool ok = socket.endPacket(targets[i], config.port);
+
+        // Deferred: formatted and printed by the log ring after the press
+        if (ok) {
+            LOG_INFO_TEXT(logAddress(), "OSC sent: %s (btn%d->ch%d) -> %u.%u.%u.%u:%d via %s",
+                buttonNumber, ctx.channel, targets[i][0], targets[i][1], targets[i][2], targets[i][3],
+                config.port, _router.getRoute(routes[i]).name);
+        } else {
+            LOG_WARN_TEXT(logAddress(), "OSC DROPPED: %s (btn%d->ch%d) -> %u.%u.%u.%u:%d via %s",
+                buttonNumber, ctx.channel, targets[i][0], targets[i][1], targets[i][2], targets[i][3],
+                config.port, _router.getRoute(routes[i]).name);
+            telemetry.noteSendFailure();
+        }
+    }
+}
+
+void OSCManager::sendPacket(const uint8_t* data, size_t length, int buttonNumber) {
+    OSCConfig config;
+    getConfig(config);
+
+    IPAddress targets[OSC_MAX_ROUTES];
+    int routes[OSC_MAX_ROUTES];
+    int count = getTargets(config, targets, routes);
+
+    for (int i = 0; i < count; i++) {
+        OSCSocket& socket = _router.getRoute(routes[i]).socket;
+        socket.beginPacket();
+        socket.write(data, length);
+        bool ok = socket.endPacket(targets[i], config.port);
+
+        // The packet starts with the NUL-terminated address
+        if (ok) {
+            LOG_INFO_TEXT((const char*)data, "OSC sent: %s (btn%d macro) -> %u.%u.%u.%u:%d via %s",
+                buttonNumber, targets[i][0], targets[i][1], targets[i][2], targets[i][3],
+                config.port, _router.getRoute(routes[i]).name);
+        } else {
+            LOG_WARN_TEXT((const char*)data, "OSC DROPPED: %s (btn%d macro) -> %u.%u.%u.%u:%d via %s",
+                buttonNumber, targets[i][0], targets[i][1], targets[i][2], targets[i][3],
+                config.port, _router.getRoute(routes[i]).name);
+            telemetry.noteSendFailure();
+        }
     }
+}
+
+bool OSCManager::sendUpdate(const OSCTemplate& program, const OSCTemplateContext& ctx) {
+    OSCConfig config;
+    getConfig(config);
+
+    IPAddress targets[OSC_MAX_ROUTES];
+    int routes[OSC_MAX_ROUTES];
+    int count = getTargets(config, targets, routes);
 
-    // Fallback
-    targets.push_back(IPAddress(192, 168, 4, 255));
-    return targets;
+    bool ok = count > 0;
+    for (int i = 0; i < count; i++) {
+        OSCSocket& socket = _router.getRoute(routes[i]).socket;
+        socket.beginPacket();
+        program.encode(socket, ctx);
+        if (!socket.endPacket(targets[i], config.port)) ok = false;
+    }
+    return ok;
 }
 
-String OSCManager::formatAddress(int buttonNumber) const {
-    String addr = _state.addressFormat;
+bool OSCManager::broadcastPacket(const uint8_t* data, size_t length, uint16_t port) {
+    bool sent = false;
+    for (int i = 0; i < _router.getRouteCount(); i++) {
+        OSCRouter::Route& route = _router.getRoute(i);
+        if (!route.up) continue;
+        route.socket.beginPacket();
+        route.socket.write(data, length);
+        if (route.socket.endPacket(route.broadcast, port)) sent = true;
+    }
+    return sent;
+}
 
-    // If format ends with a number placeholder or nothing, append the button number
-    // Supported formats: "/kmpush", "kmpush", "/km/push/"
-    if (addr.endsWith("/")) {
-        // Format like "/km/push/" -> "/km/push/1"
-        addr += String(buttonNumber);
-    } else {
-        // Format like "/kmpush" or "kmpush" -> "/kmpush1" or "kmpush1"
-        addr += String(buttonNumber);
+bool OSCManager::registerCommand(const char* address, OSCCommandCallback callback, bool heard) {
+    if (_commandCount >= OSC_MAX_COMMANDS) {
+        Serial.printf("WARNING: no room for OSC command %s\n", address);
+        return false;
     }
+    _commands[_commandCount].address = address;
+    _commands[_commandCount].callback = callback;
+    _commands[_commandCount].heard = heard;
+    _commandCount++;
+    return true;
+}
 
-    return addr;
+int OSCManager::getCommandCount() const {
+    return _commandCount;
 }
 
-void OSCManager::sendButton(WiFiUDP& udp, int buttonNumber) {
-    // Map button number to configured channel
-    int channel = (buttonNumber == 1) ? _state.button1Channel : _state.button2Channel;
+const char* OSCManager::getCommandAddress(int index) const {
+    return _commands[index].address;
+}
 
-    // Build the OSC address using configured format and channel
-    String address = formatAddress(channel);
+void OSCManager::beginRouting() {
+    _router.begin(_config.read().port);
+}
 
-    // Get all target IPs (will be multiple when in AP+STA mode)
-    std::vector<IPAddress> targets = getTargetIPAddresses();
+void OSCManager::loop() {
+    _router.loop();
+    pollIncoming();
+}
 
-    // Send to all targets
-    for (const IPAddress& targetIP : targets) {
-        OSCMessage msg(address.c_str());
-        msg.add(1.0f);  // Send a single float value of 1.0 (common trigger format)
+void OSCManager::pollIncoming() {
+    // Bounded so a flood of incoming packets can't starve the button path
+    const int MAX_PACKETS_PER_POLL = 4;
+    static uint8_t packet[512];  // static: keep it off the loop task stack
+
+    for (int r = 0; r < _router.getRouteCount(); r++) {
+        OSCRouter::Route& route = _router.getRoute(r);
+        if (!route.up) continue;
+
+        for (int n = 0; n < MAX_PACKETS_PER_POLL; n++) {
+            // Polling costs nothing when idle; only an arriving command allocates
+            // (OSCMessage builds its argument list on the heap)
+            int size = route.socket.receive(packet, sizeof(packet), _replyIP, _replyPort);
+            if (size <= 0) break;
+
+            OSCMessage msg;
+            msg.fill(packet, size);
+            if (msg.hasError()) continue;
+
+            int command = -1;
+            for (int i = 0; i < _commandCount; i++) {
+                if (msg.fullMatch(_commands[i].address)) {
+                    command = i;
+                    break;
+                }
+            }
 
-        udp.beginPacket(targetIP, _state.port);
-        msg.send(udp);
-        udp.endPacket();
-        msg.empty();
+            bool heardCommand = command >= 0 && _commands[command].heard;
+            if (oscProvesReceiver((uint32_t)_replyIP, (uint32_t)route.localIP, (uint32_t)getUnicastTarget(), heardCommand)) {
+                _router.noteHeard(r);
+            }
 
-        Serial.printf("OSC sent: %s (btn%d->ch%d) -> %s:%d (value=1.0)\n",
-            address.c_str(), buttonNumber, channel, targetIP.toString().c_str(), _state.port);
+            if (command < 0) continue;
+            _replySocket = &route.socket;
+            _commands[command].callback(msg);
+            _replySocket = nullptr;
+        }
     }
 }
 
+void OSCManager::reply(OSCMessage& msg) {
+    if (!_replySocket) return;
+    _replySocket->beginPacket();
+    msg.send(*_replySocket);
+    _replySocket->endPacket(_replyIP, _replyPort);
+}
+
+void OSCManager::registerConfigCommands() {
+    registerCommand("/muis/config", onConfigCommand);
+    registerCommand("/muis/config/port", onConfigCommand);
+    registerCommand("/muis/config/target", onConfigCommand);
+    registerCommand("/muis/config/format", onConfigCommand);
+    registerCommand("/muis/config/channel", onConfigCommand);
+    registerCommand("/muis/config/prefix", onConfigCommand);
+}
+
+// /muis/config                      -> reply with the current settings
+// /muis/config/port i               -> listening/target port (after reboot)
+// /muis/config/target s             -> target IP, "" = broadcast
+// /muis/config/format s             -> address template or mode, e.g. "/kmpush", "8faderspush" or "/cue/{ch}/go ,i{btn}"
+// /muis/config/channel i i          -> button (1-BOARD_BUTTONS), channel (1-99)
+// /muis/config/prefix i             -> 1 = put "/<device id>" in front of every address, 0 = off
+// Every command replies "/muis/config port target format ch1 ch2 ...", one channel per button.
+void OSCManager::onConfigCommand(OSCMessage& msg) {
+    OSCManager* self = _oscInstance;
+    char address[24];
+    char text[OSC_ADDRESS_FORMAT_MAX + 1];  // one over, so a too-long template is caught
+    OSCTemplate program;
+    msg.getAddress(address, 0, sizeof(address));
+
+    OSCConfig config;
+    bool changed = self->_config.update([&](OSCConfig& next) {
+        bool dirty = false;
+        if (strcmp(address, "/muis/config/port") == 0 && msg.isInt(0)) {
+            int port = msg.getInt(0);
+            if (port > 0 && port < 65536) {
+                next.port = port;
+                dirty = true;
+            }
+        } else if (strcmp(address, "/muis/config/target") == 0 && msg.isString(0)) {
+            msg.getString(0, text, sizeof(text));
+            IPAddress test;
+            if (text[0] == '\0' || (strlen(text) < OSC_TARGET_IP_MAX && test.fromString(text))) {
+                next.setTargetIP(text);
+                dirty = true;
+            }
+        } else if (strcmp(address, "/muis/config/format") == 0 && msg.isString(0)) {
+            msg.getString(0, text, sizeof(text));
+            // Same validation as osc.set: the template compiler decides, so
+            // LuPlayer's mode keywords ("8faderspush") are accepted too
+            const char* error = strlen(text) < OSC_ADDRESS_FORMAT_MAX ? program.compile(text) : "too long";
+            if (!error) {
+                strlcpy(next.addressFormat, text, sizeof(next.addressFormat));
+                next.program = program;
+                dirty = true;
+            } else {
+                Serial.printf("OSC template rejected: %s\n", error);
+            }
+        } else if (strcmp(address, "/muis/config/channel") == 0 && msg.isInt(0) && msg.isInt(1)) {
+            int button = msg.getInt(0);
+            int ch = msg.getInt(1);
+            if (ch > 0 && ch < 100 && button >= 1 && button <= BOARD_BUTTONS) {
+                next.channels[button - 1] = ch;
+                dirty = true;
+            }
+        } else if (strcmp(address, "/muis/config/prefix") == 0 && msg.isInt(0)) {
+            next.addressPrefix = msg.getInt(0) != 0;
+            dirty = true;
+        }
+        if (dirty) self->saveSettings(next);
+        config = next;
+        return dirty;
+    });
+
+    if (changed) {
+        logSettings(" via OSC", config);
+        self->_wifiManager->getControlChannel().push("osc", settingsJson(config));
+    }
+
+    OSCMessage out("/muis/config");
+    out.add((int32_t)config.port);
+    out.add(config.targetIP);
+    out.add(config.addressFormat);
+    for (int i = 0; i < BOARD_BUTTONS; i++) {
+        out.add((int32_t)config.channels[i]);
+    }
+    self->reply(out);
+}
+
+bool OSCManager::checkAndClearBenchRequest() {
+    if (_state.benchRequested) {
+        _state.benchRequested = false;
+        return true;
+    }
+    return false;
+}
+
+void OSCManager::runLatencyBench(WiFiUDP& udp) {
+    // Each round queues a burst of best-effort filler (to the discard port)
+    // in front of one probe per path, so the probe has to compete with it
+    // the way a cue competes with venue video. The probes carry a sequence
+    // number, the path (0 = WiFiUDP, 1 = QoS socket) and the send timestamp.
+    // Only the send call is timed here: queueing happens in the driver after
+    // it returns, so arrival latency per path is measured on the target by
+    // tools/bench_receiver.py.
+    const int ROUNDS = 20;
+    const int FILLER_PER_ROUND = 4;
+    const uint16_t DISCARD_PORT = 9;
+    static uint8_t filler[512];  // static: keep the bench off the loop task stack
+
+    OSCConfig config;
+    getConfig(config);
+    IPAddress targets[OSC_MAX_ROUTES];
+    int routes[OSC_MAX_ROUTES];
+    if (getTargets(config, targets, routes) == 0) {
+        Serial.println("OSC bench: no interface up");
+        return;
+    }
+    IPAddress target = targets[0];
+    OSCSocket& socket = _router.getRoute(routes[0]).socket;
+    uint32_t totalUs[2] = {0, 0};
+    BenchPathResult results[2];
+    memset(results, 0, sizeof(results));
+
+    Serial.printf("OSC bench: %d rounds against %s:%d\n", ROUNDS, target.toString().c_str(), config.port);
+
+    for (int round = 0; round < ROUNDS; round++) {
+        for (int path = 0; path < 2; path++) {
+            for (int i = 0; i < FILLER_PER_ROUND; i++) {
+                udp.beginPacket(target, DISCARD_PORT);
+                udp.write(filler, sizeof(filler));
+                udp.endPacket();
+            }
+
+            uint32_t t0 = micros();
+            OSCMessage msg("/muis/bench");
+            msg.add((int32_t)round);
+            msg.add((int32_t)path);
+            msg.add((int32_t)t0);
+
+            bool ok;
+            if (path == 0) {
+                udp.beginPacket(target, config.port);
+                msg.send(udp);
+                ok = udp.endPacket() == 1;
+            } else {
+                socket.beginPacket();
+                msg.send(socket);
+                ok = socket.endPacket(target, config.port);
+            }
+            uint32_t dt = micros() - t0;
+            msg.empty();
+
+            BenchPathResult& r = results[path];
+            if (ok) r.sent++; else r.dropped++;
+            totalUs[path] += dt;
+            if (dt > r.maxUs) r.maxUs = dt;
+        }
+        delay(10);  // let the queue drain between rounds
+    }
+
+    for (int path = 0; path < 2; path++) {
+        results[path].avgUs = totalUs[path] / ROUNDS;
+    }
+    _bench.target = target;
+    _bench.wifiUdp = results[0];
+    _bench.socket = results[1];
+    _bench.valid = true;
+
+    Serial.printf("OSC bench (send call): WiFiUDP avg=%uus max=%uus drop=%u | socket avg=%uus max=%uus drop=%u\n",
+        results[0].avgUs, results[0].maxUs, results[0].dropped,
+        results[1].avgUs, results[1].maxUs, results[1].dropped);
+}
+
+void OSCManager::sendTest() {
+    uint32_t droppedBefore = 0;
+    for (int i = 0; i < _router.getRouteCount(); i++) {
+        droppedBefore += _router.getRoute(i).socket.getDroppedCount();
+    }
+    sendButton(1);
+    uint32_t droppedAfter = 0;
+    for (int i = 0; i < _router.getRouteCount(); i++) {
+        droppedAfter += _router.getRoute(i).socket.getDroppedCount();
+    }
+
+    String json = getTestJson();
+    json.remove(json.length() - 1);  // reopen the object to add the outcome
+    json += ",\"dropped\":" + String(droppedAfter - droppedBefore) + "}";
+    _wifiManager->getControlChannel().push("testosc", json);
+}
+
 bool OSCManager::checkAndClearTestRequest() {
     if (_state.testRequested) {
         _state.testRequested = false;
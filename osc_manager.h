@@ -7,10 +7,40 @@
 #include <Preferences.h>
 #include <ESPAsyncWebServer.h>
 #include <WiFiUdp.h>
-#include <vector>
+#include "osc_router.h"
+#include "osc_template.h"
+#include "config_snapshot.h"
+#include "board_profile.h"
 
-// Forward declaration
+// Forward declarations
 class WiFiManager;
+class OSCMessage;
+
+// Setting buffers (fixed size: runtime state stays off the heap)
+#define OSC_TARGET_IP_MAX 16          // "255.255.255.255" + terminator
+#define OSC_ADDRESS_FORMAT_MAX 96     // Address/argument template source (see osc_template.h)
+#define OSC_ADDRESS_MAX 128           // Expanded address (placeholders filled in)
+
+// Max number of incoming OSC command addresses that can be registered
+#define OSC_MAX_COMMANDS 16
+
+// OSC settings. Published as a whole through a ConfigSnapshot: web handlers
+// (AsyncTCP task) and OSC commands write, the button path reads lock-free.
+struct OSCConfig {
+    int port;                 // OSC port (default 8001 for LuPlayer)
+    char targetIP[OSC_TARGET_IP_MAX];  // Target IP for OSC (empty = broadcast)
+    uint32_t targetAddr;      // targetIP parsed once on change (0 = broadcast)
+    char addressFormat[OSC_ADDRESS_FORMAT_MAX];  // LuPlayer mode: "/kmpush" (Keyboard Mapped), "/8faderspush" (Eight Faders), or a custom template
+    OSCTemplate program;      // addressFormat compiled; what a press actually runs
+    int channels[BOARD_BUTTONS];  // Channel number per button (default: the button number)
+    bool addressPrefix;       // Fleet: put "/<device id>" in front of every address sent
+
+    // Set targetIP and parse it into targetAddr
+    void setTargetIP(const char* ip);
+};
+
+// Callback for an incoming OSC command (see registerCommand)
+typedef void (*OSCCommandCallback)(OSCMessage& msg);
 
 class OSCManager {
 public:
@@ -22,45 +52,156 @@ public:
     // Configuration
     void setPort(int port);
     int getPort() const;
-    void setTargetIP(const String& ip);
-    String getTargetIP() const;
-    void setAddressFormat(const String& format);
-    String getAddressFormat() const;
-    void setButton1Channel(int channel);
-    int getButton1Channel() const;
-    void setButton2Channel(int channel);
-    int getButton2Channel() const;
-
-    // Get target IPs for sending (uses WiFiManager's broadcast IPs)
-    std::vector<IPAddress> getTargetIPAddresses() const;
-
-    // Format OSC address for button
-    String formatAddress(int buttonNumber) const;
-
-    // Test request handling
+    void setTargetIP(const char* ip);
+    IPAddress getUnicastTarget() const;  // Parsed target IP (0.0.0.0 = broadcast)
+    bool setAddressFormat(const char* format);  // False if the template doesn't compile
+    void setButtonChannel(int buttonNumber, int channel);
+    int getButtonChannel(int buttonNumber) const;
+
+    // Consistent copy of all settings (lock-free; safe from any task)
+    void getConfig(OSCConfig& out) const;
+    uint32_t getConfigVersion() const;
+
+    // Switch to a precompiled preset (target, template, channels; the port
+    // and the address prefix stay). Publishes it as the next snapshot without touching flash.
+    void applyPreset(const OSCConfig& preset);
+
+    // Replace all settings with a complete, already validated config (fleet
+    // push), save them and tell the portal. A new port applies after reboot.
+    // how is for the log (" via fleet").
+    void applySettings(const OSCConfig& config, const char* how);
+
+    // Open the per-interface OSC sockets on the configured port (call in
+    // setup() once WiFi is up)
+    void beginRouting();
+
+    // Routing table updates after WiFi events, then incoming OSC commands
+    // (call from loop())
+    void loop();
+
+    // Get target IPs for sending (unicast target, or the broadcast address of
+    // every interface the router sends on) into out[OSC_MAX_ROUTES]; returns
+    // the count
+    int getTargetIPAddresses(IPAddress* out) const;
+
+    // Address prefix in use ("/a1b2c3", or "" when off)
+    const char* getAddressPrefix() const;
+
+    // Expanded OSC address for a button into out[OSC_ADDRESS_MAX]
+    void formatAddress(int buttonNumber, char* out) const;
+
+    // Test request handling: the sketch polls the flag and calls sendTest(),
+    // which sends button 1 and pushes the outcome to socket clients
     bool checkAndClearTestRequest();
+    void sendTest();
+
+    // Current settings as JSON (GET /osc, "osc" push event)
+    String getSettingsJson() const;
 
     // Send OSC button press message
-    // Handles formatting, broadcasting to all targets, and logging
-    void sendButton(WiFiUDP& udp, int buttonNumber);
+    // Handles formatting, sending on every route the router picks, and logging.
+    // No heap allocation: the packet is built in the route socket's buffer.
+    void sendButton(int buttonNumber);
+
+    // Send a ready-encoded OSC message (macro step) to the same targets as a
+    // press. buttonNumber is only for the log.
+    void sendPacket(const uint8_t* data, size_t length, int buttonNumber);
+
+    // Send a controller update (analog input) to the same targets as a
+    // press, encoded from the caller's compiled template. Not logged: a
+    // moving fader sends up to 50 a second. False if no interface is up or
+    // any route dropped it (the caller retries with its latest value).
+    bool sendUpdate(const OSCTemplate& program, const OSCTemplateContext& ctx);
+
+    // Send a ready-encoded message to the broadcast address of every live
+    // interface on the given port (fleet presence), whatever the OSC target
+    // and broadcast suppression say. False if no interface is up.
+    bool broadcastPacket(const uint8_t* data, size_t length, uint16_t port);
+
+    // Placeholder values for a button under the current settings
+    void makeContext(int buttonNumber, OSCTemplateContext& ctx) const;
+
+    // Incoming OSC commands on the route sockets (bound to the OSC port).
+    // Other modules register exact addresses (e.g. "/muis/power"); loop()
+    // dispatches them. heard: show control sent from the show machine, so
+    // its sender proves the receiver's interface (see osc_heard.h)
+    bool registerCommand(const char* address, OSCCommandCallback callback, bool heard = false);
+
+    // Registered command addresses (OSCQuery namespace)
+    int getCommandCount() const;
+    const char* getCommandAddress(int index) const;
+
+    // Send a message back to the sender of the command being dispatched, from
+    // the OSC port. Only valid inside a command callback.
+    void reply(OSCMessage& msg);
+
+    // Latency bench: sends probes on the QoS socket and the best-effort
+    // WiFiUDP path while best-effort filler traffic contends for the TX
+    // queue. Requested via POST /oscbench, run from loop(); GET /oscbench has
+    // the send-call times, tools/bench_receiver.py the arrival latency.
+    bool checkAndClearBenchRequest();
+    void runLatencyBench(WiFiUDP& udp);
 
 private:
     WiFiManager* _wifiManager;
+    OSCRouter _router;
+    char _deviceName[OSC_DEVICE_NAME_MAX];  // {device} in templates
+    char _addressPrefix[OSC_ADDRESS_PREFIX_MAX];  // "/<device id>", used when addressPrefix is on
+
+    // Never read field by field: take a copy with getConfig() so all values
+    // come from the same version
+    ConfigSnapshot<OSCConfig> _config;
 
     struct {
-        String targetIP;          // Target IP for OSC (empty = broadcast)
-        int port;                 // OSC port (default 8001 for LuPlayer)
-        String addressFormat;     // LuPlayer mode: "kmpush" (Keyboard Mapped), "8faderspush" (Eight Faders), or custom
-        int button1Channel;       // Channel number for button 1 (default 1)
-        int button2Channel;       // Channel number for button 2 (default 2)
         volatile bool testRequested;  // Test trigger flag (set by web UI, cleared by main loop)
+        volatile bool benchRequested; // Latency bench trigger (set by web UI, cleared by main loop)
     } _state;
 
+    // Per-path results of the last latency bench
+    struct BenchPathResult {
+        uint32_t sent;
+        uint32_t dropped;
+        uint32_t avgUs;           // Mean time spent in the send call
+        uint32_t maxUs;           // Worst send call
+    };
+    struct {
+        bool valid;
+        IPAddress target;
+        BenchPathResult wifiUdp;
+        BenchPathResult socket;
+    } _bench;
+
+    struct OSCCommand {
+        const char* address;
+        OSCCommandCallback callback;
+        bool heard;
+    };
+    OSCCommand _commands[OSC_MAX_COMMANDS];
+    int _commandCount;
+
+    // Sender of the command being dispatched (see reply())
+    OSCSocket* _replySocket;
+    IPAddress _replyIP;
+    uint16_t _replyPort;
+
     Preferences _preferences;
 
     void loadSettings();
-    void saveSettings();
+    void saveSettings(const OSCConfig& config);
+    void pollIncoming();
+    String getTestJson() const;
+    static String settingsJson(const OSCConfig& config);
+    static void logSettings(const char* how, const OSCConfig& config);
+
+    // Helpers that work on one snapshot, so a send never mixes versions
+    // out[] and routes[] hold OSC_MAX_ROUTES entries
+    int getTargets(const OSCConfig& config, IPAddress* out, int* routes) const;
+    void makeContext(const OSCConfig& config, int buttonNumber, OSCTemplateContext& ctx) const;
     void registerWebEndpoints(AsyncWebServer& webServer);
+
+    // /muis/config/* — OSC settings without the portal (headless mode)
+    void registerConfigCommands();
+    static void onConfigCommand(OSCMessage& msg);
 };
 
 #endif
@@ -0,0 +1,182 @@
+// OSC-Muis - Niels van der Hulst 2026
+
+#include "osc_router.h"
+#include "log_ring.h"
+#include "esp_netif.h"
+
+// Static instance pointer for the WiFi event callback
+static OSCRouter* _routerInstance = nullptr;
+
+OSCRouter::OSCRouter() {
+    _routes[OSC_ROUTE_STA].name = "sta";
+    _routes[OSC_ROUTE_AP].name = "ap";
+    for (int i = 0; i < OSC_MAX_ROUTES; i++) {
+        _routes[i].up = false;
+        _routes[i].lastHeard = 0;
+        _routes[i].heard = false;
+        _routes[i].suppressed = 0;
+    }
+    _port = 0;
+    _tos = OSC_SOCKET_TOS_EF;
+    _dirty = true;
+}
+
+void OSCRouter::begin(uint16_t port, uint8_t tos) {
+    _routerInstance = this;
+    _port = port;
+    _tos = tos;
+    WiFi.onEvent(onWiFiEvent);
+
+    // Events from before begin() (AP start, early STA connect) were missed
+    rebuild();
+}
+
+// Runs on the WiFi event task: only flag, the sockets are handled in loop()
+void OSCRouter::onWiFiEvent(arduino_event_id_t event) {
+    if (!_routerInstance) return;
+    switch (event) {
+        case ARDUINO_EVENT_WIFI_STA_GOT_IP:
+        case ARDUINO_EVENT_WIFI_STA_LOST_IP:
+        case ARDUINO_EVENT_WIFI_STA_DISCONNECTED:
+        case ARDUINO_EVENT_WIFI_AP_START:
+        case ARDUINO_EVENT_WIFI_AP_STOP:
+            _routerInstance->_dirty = true;
+            break;
+        default:
+            break;
+    }
+}
+
+void OSCRouter::loop() {
+    if (_dirty) {
+        rebuild();
+    }
+}
+
+void OSCRouter::rebuild() {
+    _dirty = false;
+    updateRoute(_routes[OSC_ROUTE_STA], "WIFI_STA_DEF");
+    updateRoute(_routes[OSC_ROUTE_AP], "WIFI_AP_DEF");
+
+    for (int i = 0; i < OSC_MAX_ROUTES; i++) {
+        const Route& route = _routes[i];
+        if (route.up) {
+            LOG_INFO("OSC route %s: broadcast %u.%u.%u.%u", route.name,
+                     route.broadcast[0], route.broadcast[1], route.broadcast[2], route.broadcast[3]);
+        } else {
+            LOG_INFO("OSC route %s: down", route.name);
+        }
+    }
+}
+
+void OSCRouter::updateRoute(Route& route, const char* ifkey) {
+    esp_netif_t* netif = esp_netif_get_handle_from_ifkey(ifkey);
+    esp_netif_ip_info_t info;
+    bool up = netif && esp_netif_is_netif_up(netif) &&
+              esp_netif_get_ip_info(netif, &info) == ESP_OK && info.ip.addr != 0;
+
+    if (!up) {
+        if (route.up) LOG_INFO("OSC route %s down", route.name);
+        route.socket.end();
+        route.up = false;
+        route.heard = false;
+        return;
+    }
+
+    IPAddress localIP(info.ip.addr);
+    if (route.up && localIP == route.localIP && route.socket.isOpen()) return;  // unchanged
+
+    // New interface or new address: whatever we learned about receivers on
+    // the old network no longer holds
+    route.localIP = localIP;
+    route.netmask = IPAddress(info.netmask.addr);
+    route.broadcast = IPAddress(info.ip.addr | ~info.netmask.addr);
+    route.heard = false;
+
+    char ifname[8] = {0};
+    esp_netif_get_netif_impl_name(netif, ifname);
+    route.socket.end();
+    route.up = route.socket.begin(_tos, _port, ifname);
+}
+
+int OSCRouter::getRouteCount() const {
+    return OSC_MAX_ROUTES;
+}
+
+OSCRouter::Route& OSCRouter::getRoute(int index) {
+    return _routes[index];
+}
+
+const OSCRouter::Route& OSCRouter::getRoute(int index) const {
+    return _routes[index];
+}
+
+bool OSCRouter::heardRecently(const Route& route) const {
+    return route.up && route.heard && millis() - route.lastHeard < OSC_ROUTE_HEARD_TTL_MS;
+}
+
+bool OSCRouter::shouldBroadcast(int index) const {
+    const Route& route = _routes[index];
+    if (!route.up) return false;
+    if (heardRecently(route)) return true;
+
+    // Silent interface: skip it only if a receiver has proven itself elsewhere
+    for (int i = 0; i < OSC_MAX_ROUTES; i++) {
+        if (i != index && heardRecently(_routes[i])) return false;
+    }
+    return true;
+}
+
+int OSCRouter::routeFor(const IPAddress& ip) const {
+    uint32_t addr = (uint32_t)ip;
+    for (int i = 0; i < OSC_MAX_ROUTES; i++) {
+        const Route& route = _routes[i];
+        uint32_t mask = (uint32_t)route.netmask;
+        if (route.up && (addr & mask) == ((uint32_t)route.localIP & mask)) return i;
+    }
+    // Off-subnet: through the venue network's gateway
+    return _routes[OSC_ROUTE_STA].up ? OSC_ROUTE_STA : -1;
+}
+
+int OSCRouter::primaryRoute() const {
+    for (int i = 0; i < OSC_MAX_ROUTES; i++) {
+        if (_routes[i].up) return i;
+    }
+    return -1;
+}
+
+void OSCRouter::noteHeard(int index) {
+    Route& route = _routes[index];
+    if (!heardRecently(route)) {
+        LOG_INFO("OSC route %s: receiver heard, broadcasts limited to proven interfaces", route.name);
+    }
+    route.lastHeard = millis();
+    route.heard = true;
+}
+
+void OSCRouter::noteSuppressed(int index) {
+    _routes[index].suppressed++;
+}
+
+String OSCRouter::getStatusJson() const {
+    String json = "[";
+    for (int i = 0; i < OSC_MAX_ROUTES; i++) {
+        const Route& route = _routes[i];
+        if (i > 0) json += ",";
+        json += "{\"if\":\"" + String(route.name) + "\",\"up\":";
+        json += route.up ? "true" : "false";
+        if (route.up) {
+            json += ",\"ip\":\"" + route.localIP.toString() + "\"";
+            json += ",\"broadcast\":\"" + route.broadcast.toString() + "\"";
+        }
+        json += ",\"heardAgoS\":";
+        json += heardRecently(route) ? String((millis() - route.lastHeard) / 1000) : String("null");
+        json += ",\"sending\":";
+        json += shouldBroadcast(i) ? "true" : "false";
+        json += ",\"sent\":" + String(route.socket.getSentCount());
+        json += ",\"dropped\":" + String(route.socket.getDroppedCount());
+        json += ",\"suppressed\":" + String(route.suppressed) + "}";
+    }
+    json += "]";
+    return json;
+}
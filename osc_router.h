@@ -0,0 +1,90 @@
+// OSC-Muis - Niels van der Hulst 2026
+
+#ifndef OSC_ROUTER_H
+#define OSC_ROUTER_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include "osc_socket.h"
+
+// One route per WiFi interface: STA (venue network) and AP (own network)
+#define OSC_MAX_ROUTES 2
+#define OSC_ROUTE_STA 0
+#define OSC_ROUTE_AP 1
+
+// How long a packet from a host on an interface counts as proof that the
+// receiver lives there. Without fresh proof we go back to sending everywhere.
+#define OSC_ROUTE_HEARD_TTL_MS 300000UL
+
+// Routing table for outgoing OSC, rebuilt only when WiFi reports an interface
+// change (STA got/lost IP, AP start/stop) instead of on every press.
+//
+// Each live interface gets its own socket bound to that netif (and to the OSC
+// port), so broadcasts leave through the interface they are meant for and
+// every incoming packet is attributed to the interface it arrived on.
+//
+// In AP+STA mode a broadcast press used to go out on both networks, doubling
+// airtime. Once the receiver has proven itself on one interface (see
+// osc_heard.h), the other interfaces are marked silent and broadcasts to
+// them are suppressed until that proof expires or the table changes. Unicast targets always go out on the interface that reaches them.
+class OSCRouter {
+public:
+    struct Route {
+        const char* name;         // "sta" / "ap"
+        bool up;
+        IPAddress localIP;
+        IPAddress netmask;
+        IPAddress broadcast;      // Honors the actual subnet mask
+        OSCSocket socket;         // Bound to this interface and the OSC port
+        unsigned long lastHeard;  // millis() of the last packet from a peer here
+        bool heard;               // lastHeard is valid
+        uint32_t suppressed;      // Broadcasts skipped because a receiver was proven elsewhere
+    };
+
+    OSCRouter();
+
+    // Register for WiFi events and build the initial table (call in setup()
+    // once WiFi is up)
+    void begin(uint16_t port, uint8_t tos = OSC_SOCKET_TOS_EF);
+
+    // Rebuild the table if a WiFi event flagged it (call from loop())
+    void loop();
+
+    int getRouteCount() const;
+    Route& getRoute(int index);
+    const Route& getRoute(int index) const;
+
+    // Broadcast on this route? False if it's down, or a receiver has been
+    // heard on another interface but not on this one.
+    bool shouldBroadcast(int index) const;
+
+    // Route that reaches a unicast address: the interface whose subnet holds
+    // it, otherwise STA (default gateway). -1 if none is up.
+    int routeFor(const IPAddress& ip) const;
+
+    // First live route (replies, bench); -1 if none is up
+    int primaryRoute() const;
+
+    // Record a packet on a route from a proven receiver (the configured
+    // target, or a show controller's command; see osc_heard.h)
+    void noteHeard(int index);
+
+    // Count a skipped broadcast (diagnostics)
+    void noteSuppressed(int index);
+
+    // Routes with address, liveness and counters as JSON (GET /routes)
+    String getStatusJson() const;
+
+private:
+    Route _routes[OSC_MAX_ROUTES];
+    uint16_t _port;
+    uint8_t _tos;
+    volatile bool _dirty;    // Set from the WiFi event task, consumed in loop()
+
+    void rebuild();
+    void updateRoute(Route& route, const char* ifkey);
+    bool heardRecently(const Route& route) const;
+    static void onWiFiEvent(arduino_event_id_t event);
+};
+
+#endif
@@ -0,0 +1,159 @@
+// OSC-Muis - Niels van der Hulst 2026
+
+#include "osc_socket.h"
+#include <lwip/sockets.h>
+
+OSCSocket::OSCSocket() {
+    _fd = -1;
+    _length = 0;
+    _overflow = false;
+    _sent = 0;
+    _dropped = 0;
+}
+
+bool OSCSocket::begin(uint8_t tos, uint16_t localPort, const char* ifname) {
+    if (_fd >= 0) return true;
+
+    _fd = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (_fd < 0) {
+        Serial.println("OSC socket: socket() failed");
+        return false;
+    }
+
+    // Mark outgoing packets so the driver picks a higher WMM access category
+    int tosValue = tos;
+    if (setsockopt(_fd, IPPROTO_IP, IP_TOS, &tosValue, sizeof(tosValue)) < 0) {
+        Serial.println("OSC socket: IP_TOS not accepted, sending best effort");
+    }
+
+    // Broadcast is our default target mode; lwIP refuses it without this
+    int yes = 1;
+    setsockopt(_fd, SOL_SOCKET, SO_BROADCAST, &yes, sizeof(yes));
+
+    // Never block loop() on a congested TX queue (or an empty RX queue)
+    int flags = fcntl(_fd, F_GETFL, 0);
+    fcntl(_fd, F_SETFL, flags | O_NONBLOCK);
+
+    if (ifname) {
+        // One socket per interface on the same port: each binds to its netif,
+        // so lwIP hands every incoming packet to exactly one of them
+        setsockopt(_fd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+
+        struct ifreq ifr;
+        memset(&ifr, 0, sizeof(ifr));
+        strlcpy(ifr.ifr_name, ifname, sizeof(ifr.ifr_name));
+        if (setsockopt(_fd, SOL_SOCKET, SO_BINDTODEVICE, &ifr, sizeof(ifr)) < 0) {
+            Serial.printf("OSC socket: binding to %s failed, using the routing table\n", ifname);
+        }
+    }
+
+    if (localPort) {
+        struct sockaddr_in local;
+        memset(&local, 0, sizeof(local));
+        local.sin_family = AF_INET;
+        local.sin_port = htons(localPort);
+        local.sin_addr.s_addr = INADDR_ANY;
+        if (bind(_fd, (struct sockaddr*)&local, sizeof(local)) < 0) {
+            Serial.printf("OSC socket: bind to port %u failed, send-only\n", localPort);
+        }
+    }
+
+    Serial.printf("OSC socket ready (TOS=0x%02X, non-blocking, port %u, %s)\n",
+                  tos, localPort, ifname ? ifname : "any interface");
+    return true;
+}
+
+void OSCSocket::end() {
+    if (_fd >= 0) {
+        close(_fd);
+        _fd = -1;
+    }
+}
+
+bool OSCSocket::isOpen() const {
+    return _fd >= 0;
+}
+
+bool OSCSocket::joinGroup(const IPAddress& group, const IPAddress& iface) {
+    if (_fd < 0) return false;
+
+    struct ip_mreq mreq;
+    mreq.imr_multiaddr.s_addr = (uint32_t)group;
+    mreq.imr_interface.s_addr = (uint32_t)iface;
+    if (setsockopt(_fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) < 0) {
+        Serial.println("OSC socket: joining the multicast group failed");
+        return false;
+    }
+
+    struct in_addr out;
+    out.s_addr = (uint32_t)iface;
+    setsockopt(_fd, IPPROTO_IP, IP_MULTICAST_IF, &out, sizeof(out));
+    return true;
+}
+
+void OSCSocket::beginPacket() {
+    _length = 0;
+    _overflow = false;
+}
+
+bool OSCSocket::endPacket(const IPAddress& ip, uint16_t port) {
+    if (_fd < 0 || _overflow || _length == 0) {
+        _dropped++;
+        return false;
+    }
+
+    struct sockaddr_in dest;
+    memset(&dest, 0, sizeof(dest));
+    dest.sin_family = AF_INET;
+    dest.sin_port = htons(port);
+    dest.sin_addr.s_addr = (uint32_t)ip;  // IPAddress stores network byte order
+
+    int n = sendto(_fd, _buffer, _length, 0, (struct sockaddr*)&dest, sizeof(dest));
+    if (n != (int)_length) {
+        // EAGAIN / ENOMEM: driver queue full — drop rather than wait
+        _dropped++;
+        return false;
+    }
+    _sent++;
+    return true;
+}
+
+int OSCSocket::receive(uint8_t* buf, size_t len, IPAddress& from, uint16_t& fromPort) {
+    if (_fd < 0) return 0;
+
+    struct sockaddr_in src;
+    socklen_t srcLen = sizeof(src);
+    int n = recvfrom(_fd, buf, len, MSG_DONTWAIT, (struct sockaddr*)&src, &srcLen);
+    if (n <= 0) return 0;
+
+    from = IPAddress(src.sin_addr.s_addr);
+    fromPort = ntohs(src.sin_port);
+    return n;
+}
+
+size_t OSCSocket::write(uint8_t b) {
+    if (_length >= sizeof(_buffer)) {
+        _overflow = true;
+        return 0;
+    }
+    _buffer[_length++] = b;
+    return 1;
+}
+
+size_t OSCSocket::write(const uint8_t* data, size_t len) {
+    if (_length + len > sizeof(_buffer)) {
+        _overflow = true;
+        return 0;
+    }
+    memcpy(_buffer + _length, data, len);
+    _length += len;
+    return len;
+}
+
+uint32_t OSCSocket::getSentCount() const {
+    return _sent;
+}
+
+uint32_t OSCSocket::getDroppedCount() const {
+    return _dropped;
+}
@@ -0,0 +1,75 @@
+// OSC-Muis - Niels van der Hulst 2026
+
+#ifndef OSC_SOCKET_H
+#define OSC_SOCKET_H
+
+#include <Arduino.h>
+
+// Largest OSC packet we ever build on the send path. Button triggers are
+// ~20 bytes; this leaves room for longer custom addresses and arguments.
+#define OSC_SOCKET_BUFFER_SIZE 256
+
+// DSCP EF (46) in the upper six bits of the IPv4 TOS byte. The WiFi driver
+// derives the 802.11e user priority from this, which lifts OSC out of the
+// best-effort WMM queue that venue video streams are sitting in.
+#define OSC_SOCKET_TOS_EF 0xB8
+
+// UDP sender on a raw lwIP socket, used instead of WiFiUDP on the press path.
+//
+// - Packets are tagged DSCP EF (see above), WiFiUDP always sends best effort.
+// - The socket is non-blocking: a full TX queue drops the packet and bumps a
+//   counter instead of stalling loop().
+// - The packet is assembled in a preallocated buffer, so a send costs no
+//   heap allocation (WiFiUDP allocates a pbuf per beginPacket()). The press
+//   path serializes a compiled OSCTemplate into it instead of using
+//   OSCMessage, which heap-allocates its address and argument list.
+//
+// Implements Print so OSCMessage::send() can serialize straight into it.
+class OSCSocket : public Print {
+public:
+    OSCSocket();
+
+    // Create the socket. Call after WiFi is up (lwIP must be initialized).
+    // With a localPort the socket is bound to it and also receives (incoming
+    // OSC commands, and replies go out from that port).
+    // With an lwIP interface name ("st1", "ap1") the socket only sends and
+    // receives on that interface, and several sockets can share the port.
+    bool begin(uint8_t tos = OSC_SOCKET_TOS_EF, uint16_t localPort = 0, const char* ifname = nullptr);
+    void end();
+    bool isOpen() const;
+
+    // Receive a multicast group on the interface with this address, and send
+    // multicast out of it. Memberships end with the socket: after the
+    // address changes, end() and begin() again before joining.
+    bool joinGroup(const IPAddress& group, const IPAddress& iface);
+
+    // Start a new packet in the preallocated buffer
+    void beginPacket();
+
+    // Send the buffered packet with a single non-blocking sendto().
+    // Returns false if the packet overflowed the buffer or the stack refused it.
+    bool endPacket(const IPAddress& ip, uint16_t port);
+
+    // Non-blocking receive into buf. Returns the packet length, 0 if nothing
+    // is waiting. Replaces WiFiUDP::parsePacket(), which mallocs a 1460-byte
+    // buffer on every call, even when nothing has arrived.
+    int receive(uint8_t* buf, size_t len, IPAddress& from, uint16_t& fromPort);
+
+    // Print interface (used by OSCMessage::send)
+    size_t write(uint8_t b) override;
+    size_t write(const uint8_t* data, size_t len) override;
+
+    // Counters for diagnostics
+    uint32_t getSentCount() const;
+    uint32_t getDroppedCount() const;
+
+private:
+    int _fd;
+    uint8_t _buffer[OSC_SOCKET_BUFFER_SIZE];
+    size_t _length;
+    bool _overflow;
+    uint32_t _sent;
+    uint32_t _dropped;
+};
+
+#endif
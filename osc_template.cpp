@@ -0,0 +1,322 @@
+// OSC-Muis - Niels van der Hulst 2026
+
+#include "osc_template.h"
+#include "osc_socket.h"
+
+// Widest value a placeholder can expand to (channel 1-99, button number,
+// device name)
+#define OSC_PLACEHOLDER_NUMBER_MAX 3
+
+// Bytes of an OSC string of len characters: terminator plus padding to 4
+static size_t paddedLength(size_t len) {
+    return (len & ~(size_t)3) + 4;
+}
+
+// Decimal digits of a non-negative number into buf; returns the count
+static int formatDecimal(int value, char* buf) {
+    char tmp[11];
+    int n = 0;
+    unsigned int v = value < 0 ? 0 : value;
+    do {
+        tmp[n++] = '0' + v % 10;
+        v /= 10;
+    } while (v && n < (int)sizeof(tmp));
+    for (int i = 0; i < n; i++) buf[i] = tmp[n - 1 - i];
+    return n;
+}
+
+static void writeBigEndian(Print& out, uint32_t bits) {
+    uint8_t be[4] = {(uint8_t)(bits >> 24), (uint8_t)(bits >> 16), (uint8_t)(bits >> 8), (uint8_t)bits};
+    out.write(be, sizeof(be));
+}
+
+// Characters the OSC spec reserves in address patterns, plus the separators
+// of our own syntax
+static bool isAddressChar(char c) {
+    return c > ' ' && c < 127 && !strchr("#*,?[]{}", c);
+}
+
+const char* OSCTemplate::compile(const char* source, bool appendChannel) {
+    // Templates are echoed into JSON and the portal's script unescaped
+    const char* error = strpbrk(source, "\"'\\") ? "Quotes and backslashes are not allowed"
+                                                : parse(source, appendChannel);
+    if (error) memset(this, 0, sizeof(*this));
+    return error;
+}
+
+const char* OSCTemplate::parse(const char* source, bool appendChannel) {
+    memset(this, 0, sizeof(*this));
+    const char* p = source;
+
+    const char* error = parseText(p, true);
+    if (error) return error;
+    addressPieces = pieceCount;
+    if (addressPieces == 0) return "Address is empty";
+
+    // Plain address format: the channel number goes on the end
+    bool hasPlaceholder = false;
+    for (int i = 0; i < addressPieces; i++) {
+        if (pieces[i].kind != OSC_PIECE_LITERAL) hasPlaceholder = true;
+    }
+    if (!hasPlaceholder && appendChannel) {
+        if (!addPlaceholder(OSC_PIECE_CHANNEL)) return "Template too complex";
+        addressPieces = pieceCount;
+    }
+
+    while (*p) {
+        if (*p == ' ') {
+            p++;
+            continue;
+        }
+        if (*p != ',') return "Arguments start with ',' and a type (i, f, s, T or F)";
+        p++;
+        if (argCount >= OSC_TEMPLATE_MAX_ARGS) return "Too many arguments (max 4)";
+
+        Arg& arg = args[argCount++];
+        arg.type = *p ? *p++ : '\0';
+        switch (arg.type) {
+            case 'i':
+            case 'f':
+                error = parseNumber(p, arg);
+                break;
+            case 's':
+                arg.firstPiece = pieceCount;
+                error = parseText(p, false);
+                arg.pieceCount = pieceCount - arg.firstPiece;
+                break;
+            case 'T':
+            case 'F':
+                break;
+            default:
+                return "Unknown argument type (use i, f, s, T or F)";
+        }
+        if (error) return error;
+        if (*p && *p != ' ') return "Expected a space between arguments";
+    }
+
+    // Plain address format: the common trigger value
+    if (argCount == 0) {
+        args[0].type = 'f';
+        args[0].source = OSC_PIECE_LITERAL;
+        args[0].floatValue = 1.0f;
+        argCount = 1;
+    }
+
+    typeTags[0] = ',';
+    for (int i = 0; i < argCount; i++) typeTags[i + 1] = args[i].type;
+    typeTagsLength = paddedLength(argCount + 1);
+
+    // Worst case, so the press path can never overflow the packet buffer
+    size_t size = paddedLength(OSC_ADDRESS_PREFIX_MAX - 1 + maxTextLength(0, addressPieces)) + typeTagsLength;
+    for (int i = 0; i < argCount; i++) {
+        const Arg& arg = args[i];
+        if (arg.type == 'i' || arg.type == 'f') size += 4;
+        else if (arg.type == 's') size += paddedLength(maxTextLength(arg.firstPiece, arg.pieceCount));
+    }
+    if (size > OSC_SOCKET_BUFFER_SIZE) return "Message too long";
+    maxEncodedSize = size;
+    return nullptr;
+}
+
+const char* OSCTemplate::parseText(const char*& p, bool address) {
+    uint8_t firstPiece = pieceCount;
+    while (*p && *p != ' ') {
+        if (*p == '{') {
+            const char* close = strchr(p, '}');
+            if (!close) return "Unclosed '{'";
+            size_t len = close - p - 1;
+            uint8_t kind;
+            if (len == 2 && strncmp(p + 1, "ch", 2) == 0) kind = OSC_PIECE_CHANNEL;
+            else if (len == 3 && strncmp(p + 1, "btn", 3) == 0) kind = OSC_PIECE_BUTTON;
+            else if (len == 6 && strncmp(p + 1, "device", 6) == 0) kind = OSC_PIECE_DEVICE;
+            else return "Unknown placeholder (use {ch}, {btn} or {device})";
+            if (!addPlaceholder(kind)) return "Template too complex";
+            p = close + 1;
+            continue;
+        }
+        if (*p == '}') return "Unmatched '}'";
+        if (address ? !isAddressChar(*p) : (*p < ' ' || *p >= 127)) {
+            return address ? "Character not allowed in an OSC address" : "Only printable ASCII in string arguments";
+        }
+        if (!addLiteral(*p, firstPiece)) return "Template too long";
+        p++;
+    }
+    return nullptr;
+}
+
+const char* OSCTemplate::parseNumber(const char*& p, Arg& arg) {
+    if (*p == '{') {
+        if (strncmp(p, "{ch}", 4) == 0) {
+            arg.source = OSC_PIECE_CHANNEL;
+            p += 4;
+        } else if (strncmp(p, "{btn}", 5) == 0) {
+            arg.source = OSC_PIECE_BUTTON;
+            p += 5;
+        } else if (strncmp(p, "{value}", 7) == 0) {
+            if (arg.type != 'f') return "{value} is a float: use ,f{value}";
+            arg.source = OSC_PIECE_VALUE;
+            p += 7;
+        } else {
+            return "Numeric arguments take a number, {ch}, {btn} or {value}";
+        }
+        return nullptr;
+    }
+
+    // The value runs to the next space; copy it so strtol/strtof stop there
+    char number[16];
+    size_t len = 0;
+    while (p[len] && p[len] != ' ') len++;
+    if (len == 0 || len >= sizeof(number)) return "Invalid number";
+    memcpy(number, p, len);
+    number[len] = '\0';
+
+    char* end;
+    arg.source = OSC_PIECE_LITERAL;
+    if (arg.type == 'i') {
+        long value = strtol(number, &end, 10);
+        if (*end || value < INT32_MIN || value > INT32_MAX) return "Invalid integer";
+        arg.intValue = value;
+    } else {
+        float value = strtof(number, &end);
+        if (*end || !isfinite(value)) return "Invalid float";
+        arg.floatValue = value;
+    }
+    p += len;
+    return nullptr;
+}
+
+bool OSCTemplate::addLiteral(char c, uint8_t firstPiece) {
+    if (poolLength >= OSC_TEMPLATE_POOL_SIZE) return false;
+
+    // Extend the previous literal run if it belongs to the same text (not the
+    // address or an earlier argument) and ends where the pool does
+    if (pieceCount > firstPiece) {
+        Piece& last = pieces[pieceCount - 1];
+        if (last.kind == OSC_PIECE_LITERAL && last.offset + last.length == poolLength) {
+            pool[poolLength++] = c;
+            last.length++;
+            return true;
+        }
+    }
+    if (pieceCount >= OSC_TEMPLATE_MAX_PIECES) return false;
+    pieces[pieceCount].kind = OSC_PIECE_LITERAL;
+    pieces[pieceCount].offset = poolLength;
+    pieces[pieceCount].length = 1;
+    pieceCount++;
+    pool[poolLength++] = c;
+    return true;
+}
+
+bool OSCTemplate::addPlaceholder(uint8_t kind) {
+    if (pieceCount >= OSC_TEMPLATE_MAX_PIECES) return false;
+    pieces[pieceCount].kind = kind;
+    pieces[pieceCount].offset = 0;
+    pieces[pieceCount].length = 0;
+    pieceCount++;
+    return true;
+}
+
+size_t OSCTemplate::maxTextLength(uint8_t first, uint8_t count) const {
+    size_t len = 0;
+    for (int i = first; i < first + count; i++) {
+        switch (pieces[i].kind) {
+            case OSC_PIECE_LITERAL: len += pieces[i].length; break;
+            case OSC_PIECE_DEVICE: len += OSC_DEVICE_NAME_MAX - 1; break;
+            default: len += OSC_PLACEHOLDER_NUMBER_MAX; break;
+        }
+    }
+    return len;
+}
+
+size_t OSCTemplate::textLength(uint8_t first, uint8_t count, const OSCTemplateContext& ctx) const {
+    char digits[11];
+    size_t len = 0;
+    for (int i = first; i < first + count; i++) {
+        switch (pieces[i].kind) {
+            case OSC_PIECE_LITERAL: len += pieces[i].length; break;
+            case OSC_PIECE_CHANNEL: len += formatDecimal(ctx.channel, digits); break;
+            case OSC_PIECE_BUTTON: len += formatDecimal(ctx.button, digits); break;
+            case OSC_PIECE_DEVICE: len += strnlen(ctx.device, OSC_DEVICE_NAME_MAX - 1); break;
+        }
+    }
+    return len;
+}
+
+void OSCTemplate::writeText(Print& out, uint8_t first, uint8_t count, const OSCTemplateContext& ctx,
+                            const char* prefix) const {
+    static const uint8_t zeros[4] = {0, 0, 0, 0};
+    char digits[11];
+    size_t prefixLen = strnlen(prefix, OSC_ADDRESS_PREFIX_MAX - 1);
+    out.write((const uint8_t*)prefix, prefixLen);
+    for (int i = first; i < first + count; i++) {
+        const Piece& piece = pieces[i];
+        switch (piece.kind) {
+            case OSC_PIECE_LITERAL:
+                out.write((const uint8_t*)pool + piece.offset, piece.length);
+                break;
+            case OSC_PIECE_CHANNEL:
+                out.write((const uint8_t*)digits, formatDecimal(ctx.channel, digits));
+                break;
+            case OSC_PIECE_BUTTON:
+                out.write((const uint8_t*)digits, formatDecimal(ctx.button, digits));
+                break;
+            case OSC_PIECE_DEVICE:
+                out.write((const uint8_t*)ctx.device, strnlen(ctx.device, OSC_DEVICE_NAME_MAX - 1));
+                break;
+        }
+    }
+    // OSC strings are NUL-terminated and padded to a multiple of 4 bytes
+    out.write(zeros, 4 - ((prefixLen + textLength(first, count, ctx)) & 3));
+}
+
+void OSCTemplate::encode(Print& out, const OSCTemplateContext& ctx) const {
+    writeText(out, 0, addressPieces, ctx, ctx.prefix);
+    out.write((const uint8_t*)typeTags, typeTagsLength);
+
+    for (int i = 0; i < argCount; i++) {
+        const Arg& arg = args[i];
+        int placeholder = arg.source == OSC_PIECE_CHANNEL ? ctx.channel : ctx.button;
+        switch (arg.type) {
+            case 'i':
+                writeBigEndian(out, arg.source == OSC_PIECE_LITERAL ? arg.intValue : placeholder);
+                break;
+            case 'f': {
+                float value = arg.source == OSC_PIECE_LITERAL ? arg.floatValue
+                            : arg.source == OSC_PIECE_VALUE ? ctx.value
+                            : (float)placeholder;
+                uint32_t bits;
+                memcpy(&bits, &value, sizeof(bits));
+                writeBigEndian(out, bits);
+                break;
+            }
+            case 's':
+                writeText(out, arg.firstPiece, arg.pieceCount, ctx);
+                break;
+            default:
+                break;  // T / F carry no data
+        }
+    }
+}
+
+void OSCTemplate::formatAddress(const OSCTemplateContext& ctx, char* out, size_t len) const {
+    if (len == 0) return;
+    char digits[11];
+    size_t n = strnlen(ctx.prefix, OSC_ADDRESS_PREFIX_MAX - 1);
+    if (n > len - 1) n = len - 1;
+    memcpy(out, ctx.prefix, n);
+    for (int i = 0; i < addressPieces; i++) {
+        const Piece& piece = pieces[i];
+        const char* text;
+        size_t textLen;
+        switch (piece.kind) {
+            case OSC_PIECE_LITERAL: text = pool + piece.offset; textLen = piece.length; break;
+            case OSC_PIECE_CHANNEL: text = digits; textLen = formatDecimal(ctx.channel, digits); break;
+            case OSC_PIECE_BUTTON: text = digits; textLen = formatDecimal(ctx.button, digits); break;
+            default: text = ctx.device; textLen = strnlen(ctx.device, OSC_DEVICE_NAME_MAX - 1); break;
+        }
+        if (textLen > len - 1 - n) textLen = len - 1 - n;
+        memcpy(out + n, text, textLen);
+        n += textLen;
+    }
+    out[n] = '\0';
+}
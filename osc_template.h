@@ -0,0 +1,107 @@
+// OSC-Muis - Niels van der Hulst 2026
+
+#ifndef OSC_TEMPLATE_H
+#define OSC_TEMPLATE_H
+
+#include <Arduino.h>
+
+#define OSC_TEMPLATE_MAX_PIECES 16    // Literal runs + placeholders (address and string arguments together)
+#define OSC_TEMPLATE_MAX_ARGS 4
+#define OSC_TEMPLATE_POOL_SIZE 96     // Literal text (address and string arguments together)
+#define OSC_DEVICE_NAME_MAX 32        // {device} value, including terminator
+#define OSC_ADDRESS_PREFIX_MAX 8      // Fleet address prefix ("/a1b2c3"), including terminator
+
+// Piece kinds; for numeric arguments OSC_PIECE_LITERAL means "constant"
+#define OSC_PIECE_LITERAL 0
+#define OSC_PIECE_CHANNEL 1           // {ch}: the button's configured channel
+#define OSC_PIECE_BUTTON 2            // {btn}: the button number
+#define OSC_PIECE_DEVICE 3            // {device}: the device name
+#define OSC_PIECE_VALUE 4             // {value}: controller position (float arguments only)
+
+// Values the placeholders stand for, filled in per press
+struct OSCTemplateContext {
+    int channel;
+    int button;
+    const char* device;
+    float value;              // 0.0-1.0 for analog inputs; 1.0 for a press
+    const char* prefix;       // Put in front of the address ("" = none)
+};
+
+// Address and argument template, compiled once when the settings change so a
+// press only runs the stored program — no parsing, no string handling beyond
+// copying literal bytes and printing small numbers.
+//
+// Syntax: an address, then optional space-separated arguments:
+//
+//   /cue/{ch}/go ,i{btn} ,f1.0 ,s{device}
+//
+//   ,i<int>|{ch}|{btn}       int32
+//   ,f<float>|{ch}|{btn}|{value}
+//                            float32; {value} is an analog input's
+//                            position, 0.0-1.0 (1.0 for a button press)
+//   ,s<text>                 string; may contain {ch}, {btn}, {device}
+//   ,T  ,F                   true / false (no value)
+//
+// No quotes or backslashes anywhere: templates are echoed unescaped into
+// JSON and the portal's script.
+//
+// For compatibility with plain address formats ("/kmpush"): an address
+// without any placeholder gets the channel number appended (unless
+// appendChannel is false, as for macro steps that name their address in
+// full), and a template without arguments sends the single float 1.0.
+//
+// The context's prefix (a fleet unit's "/<device id>") goes in front of the
+// address when encoding; it is not part of the template.
+//
+// Plain data (trivially copyable), so it can live in a ConfigSnapshot.
+struct OSCTemplate {
+    // Parse and validate source. Returns nullptr on success, otherwise a
+    // message for the user; the template is then left empty.
+    const char* compile(const char* source, bool appendChannel = true);
+
+    // Serialize the complete OSC message into out (the press path). Never
+    // larger than maxEncodedSize, which compile() checked against the packet
+    // buffer.
+    void encode(Print& out, const OSCTemplateContext& ctx) const;
+
+    // Expanded address into out[len] (portal, logging)
+    void formatAddress(const OSCTemplateContext& ctx, char* out, size_t len) const;
+
+    struct Piece {
+        uint8_t kind;
+        uint8_t offset;           // Literal: start in pool
+        uint8_t length;           // Literal: byte count
+    };
+    struct Arg {
+        char type;                // 'i', 'f', 's', 'T' or 'F'
+        uint8_t source;           // Numeric: OSC_PIECE_LITERAL or a placeholder
+        uint8_t firstPiece;       // String: its pieces
+        uint8_t pieceCount;
+        int32_t intValue;
+        float floatValue;
+    };
+
+    char pool[OSC_TEMPLATE_POOL_SIZE];
+    Piece pieces[OSC_TEMPLATE_MAX_PIECES];
+    uint8_t poolLength;
+    uint8_t pieceCount;
+    uint8_t addressPieces;        // pieces[0, addressPieces) form the address
+    Arg args[OSC_TEMPLATE_MAX_ARGS];
+    uint8_t argCount;
+    char typeTags[OSC_TEMPLATE_MAX_ARGS + 4];  // ",ifs" zero-padded to a multiple of 4
+    uint8_t typeTagsLength;       // Padded length
+    uint16_t maxEncodedSize;      // Worst case over all placeholder values
+
+private:
+    const char* parse(const char* source, bool appendChannel);
+    const char* parseText(const char*& p, bool address);
+    const char* parseNumber(const char*& p, Arg& arg);
+    bool addLiteral(char c, uint8_t firstPiece);
+    bool addPlaceholder(uint8_t kind);
+    size_t textLength(uint8_t first, uint8_t count, const OSCTemplateContext& ctx) const;
+    size_t maxTextLength(uint8_t first, uint8_t count) const;
+    void writeText(Print& out, uint8_t first, uint8_t count, const OSCTemplateContext& ctx,
+                   const char* prefix = "") const;
+};
+
+#endif
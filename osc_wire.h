@@ -0,0 +1,70 @@
+// OSC-Muis - Niels van der Hulst 2026
+
+#ifndef OSC_WIRE_H
+#define OSC_WIRE_H
+
+#include <Arduino.h>
+
+// Fixed-layout OSC messages (fleet presence, fleet config push) encoded and
+// decoded in place, without OSCMessage and its heap-allocated argument list.
+//
+// Writers append at n and return the new length; the caller sizes the buffer
+// for the largest message. Readers take the position of the field and return
+// the position after it, or 0 if the field runs past len.
+
+// OSC string: NUL-terminated, padded to a multiple of 4 bytes
+static inline size_t oscPutString(uint8_t* out, size_t n, const char* s) {
+    size_t len = strlen(s);
+    size_t padded = (len & ~(size_t)3) + 4;
+    memcpy(out + n, s, len);
+    memset(out + n + len, 0, padded - len);
+    return n + padded;
+}
+
+static inline size_t oscPutInt(uint8_t* out, size_t n, int32_t value) {
+    uint32_t bits = (uint32_t)value;
+    out[n] = bits >> 24;
+    out[n + 1] = bits >> 16;
+    out[n + 2] = bits >> 8;
+    out[n + 3] = bits;
+    return n + 4;
+}
+
+// OSC blob: int32 size, the bytes, padded to a multiple of 4
+static inline size_t oscPutBlob(uint8_t* out, size_t n, const uint8_t* data, size_t size) {
+    n = oscPutInt(out, n, (int32_t)size);
+    memcpy(out + n, data, size);
+    size_t padded = (size + 3) & ~(size_t)3;
+    memset(out + n + size, 0, padded - size);
+    return n + padded;
+}
+
+static inline size_t oscGetString(const uint8_t* in, size_t len, size_t pos, const char** out) {
+    for (size_t i = pos; i < len; i++) {
+        if (in[i] == 0) {
+            size_t next = (i & ~(size_t)3) + 4;
+            if (next > len) return 0;
+            *out = (const char*)in + pos;
+            return next;
+        }
+    }
+    return 0;
+}
+
+static inline size_t oscGetInt(const uint8_t* in, size_t len, size_t pos, int32_t* out) {
+    if (pos + 4 > len) return 0;
+    *out = (int32_t)(((uint32_t)in[pos] << 24) | ((uint32_t)in[pos + 1] << 16) |
+                     ((uint32_t)in[pos + 2] << 8) | in[pos + 3]);
+    return pos + 4;
+}
+
+static inline size_t oscGetBlob(const uint8_t* in, size_t len, size_t pos, const uint8_t** data, size_t* size) {
+    int32_t n;
+    pos = oscGetInt(in, len, pos, &n);
+    if (!pos || n < 0 || pos + (((size_t)n + 3) & ~(size_t)3) > len) return 0;
+    *data = in + pos;
+    *size = (size_t)n;
+    return pos + (((size_t)n + 3) & ~(size_t)3);
+}
+
+#endif
@@ -0,0 +1,415 @@
+// OSC-Muis - Niels van der Hulst 2026
+
+#include "oscquery_server.h"
+#include "wifi_manager.h"
+
+// Static instance pointer for the socket callback
+static OSCQueryServer* _queryInstance = nullptr;
+
+// Attributes a node may have; anything else in a query is a 400
+static const char* const OSCQUERY_ATTRIBUTES[] = {
+    "FULL_PATH", "CONTENTS", "TYPE", "ACCESS", "VALUE", "RANGE", "DESCRIPTION"
+};
+
+// Value of "key":"..." in a flat JSON object. False if missing or too long.
+static bool jsonString(const char* json, const char* key, char* out, size_t len) {
+    const char* p = strstr(json, key);
+    if (!p) return false;
+    p = strchr(p + strlen(key), ':');
+    if (!p) return false;
+    p = strchr(p, '"');
+    if (!p) return false;
+    p++;
+    const char* end = strchr(p, '"');
+    if (!end || (size_t)(end - p) >= len) return false;
+    memcpy(out, p, end - p);
+    out[end - p] = '\0';
+    return true;
+}
+
+OSCQueryServer::OSCQueryServer() : _ws("/") {
+    memset(_nodes, 0, sizeof(_nodes));
+    _nodeCount = 0;
+    _buttons = 0;
+    for (int i = 0; i < ANALOG_SLOTS; i++) _faders[i] = 0.0f;
+    memset(_listeners, 0, sizeof(_listeners));
+    _lock = nullptr;
+    _pending = false;
+    _oscManager = nullptr;
+    _wifiManager = nullptr;
+    _lastCleanup = 0;
+}
+
+void OSCQueryServer::begin(OSCManager& oscManager, WiFiManager& wifiManager) {
+    _oscManager = &oscManager;
+    _wifiManager = &wifiManager;
+    if (wifiManager.isHeadless()) return;
+    _queryInstance = this;
+    _lock = xSemaphoreCreateMutex();
+
+    char path[OSCQUERY_PATH_MAX];
+    for (int i = 0; i < BOARD_BUTTONS; i++) {
+        snprintf(path, sizeof(path), "/muis/button/%d", i + 1);
+        addNode(path, NODE_BUTTON, i);
+    }
+    for (int i = 0; i < BOARD_ANALOG_INPUTS; i++) {
+        snprintf(path, sizeof(path), "/muis/fader/%d", i + 1);
+        addNode(path, NODE_FADER, i);
+    }
+    for (int i = 0; i < oscManager.getCommandCount(); i++) {
+        addNode(oscManager.getCommandAddress(i), NODE_COMMAND, 0);
+    }
+
+    _ws.onEvent([](AsyncWebSocket* server, AsyncWebSocketClient* client,
+                   AwsEventType type, void* arg, uint8_t* data, size_t len) {
+        if (type == WS_EVT_DISCONNECT) {
+            _queryInstance->dropListener(client->id());
+            return;
+        }
+        if (type != WS_EVT_DATA) return;
+        AwsFrameInfo* info = (AwsFrameInfo*)arg;
+        // Commands are tiny: accept only complete, unfragmented text frames
+        if (!info->final || info->index != 0 || info->len != len || info->opcode != WS_TEXT) return;
+        if (len >= OSCQUERY_MAX_MESSAGE) return;
+
+        char msg[OSCQUERY_MAX_MESSAGE];
+        memcpy(msg, data, len);
+        msg[len] = '\0';
+        _queryInstance->handleMessage(client->id(), msg);
+    });
+
+    // Runs after admission control (added by WiFiManager::begin())
+    AsyncWebServer& webServer = wifiManager.getWebServer();
+    webServer.addMiddleware(this);
+    webServer.addHandler(&_ws);
+    wifiManager.addMDNSService("oscjson", "tcp", 80);
+    Serial.printf("OSCQuery: %d nodes\n", _nodeCount);
+}
+
+void OSCQueryServer::addNode(const char* path, NodeKind kind, int index) {
+    if (_nodeCount >= OSCQUERY_NODES || strlen(path) >= OSCQUERY_PATH_MAX) {
+        Serial.printf("WARNING: OSCQuery skips %s\n", path);
+        return;
+    }
+    Node& node = _nodes[_nodeCount++];
+    strlcpy(node.path, path, sizeof(node.path));
+    node.kind = kind;
+    node.index = index;
+}
+
+const OSCQueryServer::Node* OSCQueryServer::findNode(const char* path) const {
+    for (int i = 0; i < _nodeCount; i++) {
+        if (strcmp(_nodes[i].path, path) == 0) return &_nodes[i];
+    }
+    return nullptr;
+}
+
+// path is "" for the root
+bool OSCQueryServer::hasChildren(const char* path) const {
+    size_t len = strlen(path);
+    for (int i = 0; i < _nodeCount; i++) {
+        if (strncmp(_nodes[i].path, path, len) == 0 && _nodes[i].path[len] == '/') return true;
+    }
+    return false;
+}
+
+int OSCQueryServer::valueBit(const Node& node) {
+    if (node.kind == NODE_BUTTON) return node.index;
+    if (node.kind == NODE_FADER) return BOARD_BUTTONS + node.index;
+    return -1;
+}
+
+void OSCQueryServer::appendValue(String& json, const Node& node) const {
+    if (node.kind == NODE_BUTTON) {
+        json += (_buttons.load() >> node.index) & 1 ? "[1]" : "[0]";
+    } else {
+        json += "[" + String(_faders[node.index].load(), 3) + "]";
+    }
+}
+
+// The node's attributes, comma-separated without braces. path is "" for the
+// root; only is a single attribute, or nullptr for all of them (CONTENTS
+// then holds the whole subtree).
+void OSCQueryServer::appendNode(String& json, const char* path, const char* only) const {
+    size_t start = json.length();
+    auto field = [&](const char* name) -> bool {
+        if (only && strcmp(only, name) != 0) return false;
+        if (json.length() > start) json += ",";
+        json += "\"";
+        json += name;
+        json += "\":";
+        return true;
+    };
+
+    const Node* node = findNode(path);
+    if (field("FULL_PATH")) {
+        json += "\"";
+        json += path[0] ? path : "/";
+        json += "\"";
+    }
+
+    if (!node) {
+        // Container only
+        if (field("ACCESS")) json += "0";
+        if (!path[0] && field("DESCRIPTION")) {
+            json += "\"";
+            json += _wifiManager->getDeviceName();
+            json += "\"";
+        }
+    } else if (node->kind == NODE_COMMAND) {
+        if (field("ACCESS")) json += "2";
+        if (field("DESCRIPTION")) json += "\"Device command (OSC port)\"";
+    } else {
+        bool button = node->kind == NODE_BUTTON;
+        if (field("TYPE")) json += button ? "\"i\"" : "\"f\"";
+        if (field("ACCESS")) json += "1";
+        if (field("VALUE")) appendValue(json, *node);
+        if (field("RANGE")) json += button ? "[{\"MIN\":0,\"MAX\":1}]" : "[{\"MIN\":0.0,\"MAX\":1.0}]";
+        if (field("DESCRIPTION")) {
+            if (button) {
+                char address[OSC_ADDRESS_MAX];
+                _oscManager->formatAddress(node->index + 1, address);
+                json += "\"Button " + String(node->index + 1) + ", sends " + address + "\"";
+            } else {
+                json += "\"Fader " + String(node->index + 1) + "\"";
+            }
+        }
+    }
+
+    if (!hasChildren(path) || !field("CONTENTS")) return;
+    json += "{";
+    size_t len = strlen(path);
+    bool first = true;
+    for (int i = 0; i < _nodeCount; i++) {
+        const char* p = _nodes[i].path;
+        if (strncmp(p, path, len) != 0 || p[len] != '/') continue;
+        const char* name = p + len + 1;
+        const char* slash = strchr(name, '/');
+        size_t childLen = slash ? (size_t)(slash - p) : strlen(p);
+
+        // Each child once, however many nodes live below it
+        bool seen = false;
+        for (int j = 0; j < i && !seen; j++) {
+            const char* q = _nodes[j].path;
+            seen = strncmp(q, p, childLen) == 0 && (q[childLen] == '/' || q[childLen] == '\0');
+        }
+        if (seen) continue;
+
+        char child[OSCQUERY_PATH_MAX];
+        memcpy(child, p, childLen);
+        child[childLen] = '\0';
+        if (!first) json += ",";
+        first = false;
+        json += "\"";
+        json += child + len + 1;
+        json += "\":{";
+        appendNode(json, child, nullptr);
+        json += "}";
+    }
+    json += "}";
+}
+
+String OSCQueryServer::hostInfoJson() const {
+    String json = "{\"NAME\":\"";
+    json += _wifiManager->getDeviceName();
+    json += "\",\"OSC_PORT\":" + String(_oscManager->getPort());
+    json += ",\"OSC_TRANSPORT\":\"UDP\",\"EXTENSIONS\":{";
+    json += "\"ACCESS\":true,\"VALUE\":true,\"RANGE\":true,\"DESCRIPTION\":true,\"LISTEN\":true,";
+    json += "\"TAGS\":false,\"CLIPMODE\":false,\"UNIT\":false,\"CRITICAL\":false,";
+    json += "\"PATH_CHANGED\":false,\"PATH_RENAMED\":false,\"PATH_ADDED\":false,\"PATH_REMOVED\":false}}";
+    return json;
+}
+
+void OSCQueryServer::run(AsyncWebServerRequest* request, ArMiddlewareNext next) {
+    if (request->method() != HTTP_GET || request->requestedConnType() == RCT_WS) {
+        next();
+        return;
+    }
+
+    // "/" is the portal for browsers; only queries and non-HTML clients get
+    // the namespace
+    const String& url = request->url();
+    bool root = (url == "/");
+    if (root) {
+        if (request->params() == 0 && request->header("Accept").indexOf("text/html") >= 0) {
+            next();
+            return;
+        }
+    } else if (!url.startsWith("/muis") || (url.length() > 5 && url[5] != '/')) {
+        next();
+        return;
+    }
+
+    const char* path = root ? "" : url.c_str();
+    if (!root && !findNode(path) && !hasChildren(path)) {
+        request->send(404, "application/json", "{}");
+        return;
+    }
+
+    const char* only = nullptr;
+    if (request->params() > 0) {
+        only = request->getParam((size_t)0)->name().c_str();
+        if (strcmp(only, "HOST_INFO") == 0) {
+            request->send(200, "application/json", hostInfoJson());
+            return;
+        }
+        bool known = false;
+        for (const char* attribute : OSCQUERY_ATTRIBUTES) known = known || strcmp(only, attribute) == 0;
+        if (!known) {
+            request->send(400, "application/json", "{}");
+            return;
+        }
+    }
+
+    String json = "{";
+    appendNode(json, path, only);
+    if (json.length() == 1) {
+        // The node doesn't have this attribute
+        request->send(204);
+        return;
+    }
+    json += "}";
+    request->send(200, "application/json", json);
+}
+
+void OSCQueryServer::handleMessage(uint32_t id, const char* msg) {
+    // {"COMMAND":"LISTEN","DATA":"/muis/button/1"}
+    char command[8];
+    char path[OSCQUERY_PATH_MAX];
+    if (!jsonString(msg, "\"COMMAND\"", command, sizeof(command)) ||
+        !jsonString(msg, "\"DATA\"", path, sizeof(path))) {
+        return;
+    }
+    bool listen = strcmp(command, "LISTEN") == 0;
+    if (!listen && strcmp(command, "IGNORE") != 0) return;
+
+    const Node* node = findNode(path);
+    int bit = node ? valueBit(*node) : -1;
+    if (bit < 0) return;
+    setListening(id, 1u << bit, listen);
+}
+
+void OSCQueryServer::setListening(uint32_t id, uint32_t bits, bool listen) {
+    xSemaphoreTake(_lock, portMAX_DELAY);
+    Listener* listener = nullptr;
+    Listener* empty = nullptr;
+    for (int i = 0; i < OSCQUERY_MAX_LISTENERS; i++) {
+        if (_listeners[i].id == id) listener = &_listeners[i];
+        else if (!_listeners[i].id && !empty) empty = &_listeners[i];
+    }
+    if (!listener && listen && empty) {
+        listener = empty;
+        listener->id = id;
+        listener->listen = 0;
+        listener->dirty = 0;
+    }
+
+    if (!listener) {
+        if (listen) Serial.println("OSCQuery: listener table full");
+    } else if (listen) {
+        // Start the new subscriber off with the current value
+        listener->listen |= bits;
+        listener->dirty |= bits;
+        _pending = true;
+    } else {
+        listener->listen &= ~bits;
+        listener->dirty &= ~bits;
+        if (!listener->listen) listener->id = 0;
+    }
+    xSemaphoreGive(_lock);
+}
+
+void OSCQueryServer::dropListener(uint32_t id) {
+    xSemaphoreTake(_lock, portMAX_DELAY);
+    for (int i = 0; i < OSCQUERY_MAX_LISTENERS; i++) {
+        if (_listeners[i].id == id) memset(&_listeners[i], 0, sizeof(Listener));
+    }
+    xSemaphoreGive(_lock);
+}
+
+void OSCQueryServer::markDirty(uint32_t bits) {
+    if (!_lock || !bits) return;
+    xSemaphoreTake(_lock, portMAX_DELAY);
+    for (int i = 0; i < OSCQUERY_MAX_LISTENERS; i++) {
+        uint32_t dirty = bits & _listeners[i].listen;
+        if (!dirty) continue;
+        _listeners[i].dirty |= dirty;
+        _pending = true;
+    }
+    xSemaphoreGive(_lock);
+}
+
+void OSCQueryServer::setButtons(uint32_t state) {
+    uint32_t changed = _buttons.exchange(state) ^ state;
+    markDirty(changed);
+}
+
+void OSCQueryServer::setFader(int index, float value) {
+    if (index < 0 || index >= BOARD_ANALOG_INPUTS) return;
+    if (_faders[index].exchange(value) == value) return;
+    markDirty(1u << (BOARD_BUTTONS + index));
+}
+
+// One OSC message: padded address, type tag, big-endian value. out holds
+// OSCQUERY_PATH_MAX + 8 bytes.
+size_t OSCQueryServer::encode(int bit, uint8_t* out) const {
+    bool button = bit < BOARD_BUTTONS;
+    int len = snprintf((char*)out, OSCQUERY_PATH_MAX, button ? "/muis/button/%d" : "/muis/fader/%d",
+                       (button ? bit : bit - BOARD_BUTTONS) + 1);
+    size_t n = (len + 4) & ~3;  // Terminator plus padding to 4 bytes
+    memset(out + len, 0, n - len + 4);
+    out[n] = ',';
+    out[n + 1] = button ? 'i' : 'f';
+    n += 4;
+
+    uint32_t raw;
+    if (button) {
+        raw = (_buttons.load() >> bit) & 1;
+    } else {
+        float value = _faders[bit - BOARD_BUTTONS].load();
+        memcpy(&raw, &value, sizeof(raw));
+    }
+    out[n++] = raw >> 24;
+    out[n++] = raw >> 16;
+    out[n++] = raw >> 8;
+    out[n++] = raw;
+    return n;
+}
+
+void OSCQueryServer::loop() {
+    if (!_lock) return;
+
+    // Drop clients that went away without a close frame
+    if (millis() - _lastCleanup > 1000) {
+        _ws.cleanupClients();
+        _lastCleanup = millis();
+    }
+    if (!_pending.exchange(false)) return;
+
+    // Take the work, send without the lock (the socket has its own)
+    Listener work[OSCQUERY_MAX_LISTENERS];
+    xSemaphoreTake(_lock, portMAX_DELAY);
+    memcpy(work, _listeners, sizeof(work));
+    for (int i = 0; i < OSCQUERY_MAX_LISTENERS; i++) _listeners[i].dirty = 0;
+    xSemaphoreGive(_lock);
+
+    for (int i = 0; i < OSCQUERY_MAX_LISTENERS; i++) {
+        uint32_t dirty = work[i].dirty;
+        while (dirty && _ws.availableForWrite(work[i].id)) {
+            int bit = __builtin_ctz(dirty);
+            uint8_t packet[OSCQUERY_PATH_MAX + 8];
+            _ws.binary(work[i].id, packet, encode(bit, packet));
+            dirty &= dirty - 1;
+        }
+        if (!dirty) continue;
+
+        // Client can't take more: keep the rest pending; whatever the value
+        // is by the next try is what goes out
+        xSemaphoreTake(_lock, portMAX_DELAY);
+        if (_listeners[i].id == work[i].id) {
+            _listeners[i].dirty |= dirty & _listeners[i].listen;
+            _pending = true;
+        }
+        xSemaphoreGive(_lock);
+    }
+}
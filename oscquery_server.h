@@ -0,0 +1,110 @@
+// OSC-Muis - Niels van der Hulst 2026
+
+#ifndef OSCQUERY_SERVER_H
+#define OSCQUERY_SERVER_H
+
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+#include <atomic>
+#include "board_profile.h"
+#include "osc_manager.h"
+#include "analog_inputs.h"
+
+class WiFiManager;
+
+#define OSCQUERY_MAX_LISTENERS 4      // WebSocket clients with LISTEN subscriptions
+#define OSCQUERY_PATH_MAX 32          // Longest namespace path, including terminator
+#define OSCQUERY_MAX_MESSAGE 128      // Largest LISTEN/IGNORE frame accepted
+#define OSCQUERY_NODES (BOARD_BUTTONS + BOARD_ANALOG_INPUTS + OSC_MAX_COMMANDS)
+
+// Every streamable value (buttons, then faders) is one bit of a listen mask
+static_assert(BOARD_BUTTONS + BOARD_ANALOG_INPUTS <= 32, "OSCQuery listen masks are 32 bits");
+
+// OSCQuery server: lets hosts (show control, TouchOSC, Chataigne, ...) find
+// the device and its namespace without typing in addresses.
+//
+// - mDNS: _oscjson._tcp on port 80, next to _http._tcp.
+// - HTTP: GET on a namespace path returns the node as JSON (FULL_PATH,
+//   CONTENTS, TYPE, ACCESS, VALUE, RANGE, DESCRIPTION); "?HOST_INFO" or an
+//   attribute ("?VALUE") returns just that. Served from a middleware on the
+//   portal's web server, so admission control applies as for any route.
+//   "/" is shared with the portal: browsers (Accept: text/html, no query)
+//   still get the portal page.
+// - Namespace: /muis/button/N and /muis/fader/N (read-only, the live
+//   state; DESCRIPTION shows what a press sends), and every /muis/* command
+//   registered with OSCManager (write-only, sent to the OSC port).
+// - LISTEN: a WebSocket on "/" takes {"COMMAND":"LISTEN","DATA":"<path>"}
+//   (and IGNORE); changed values go out as binary OSC messages. Coalesced
+//   per client: a client that can't take more keeps only the latest value
+//   of each node pending, so a slow host never queues up a fader sweep.
+//
+// Portal mode only: headless boots have no web server.
+class OSCQueryServer : public AsyncMiddleware {
+public:
+    OSCQueryServer();
+
+    // Build the namespace from the registered commands, attach the HTTP
+    // middleware and the LISTEN socket and advertise the service. Call after
+    // every OSC command is registered, before the web server starts. Does
+    // nothing when headless.
+    void begin(OSCManager& oscManager, WiFiManager& wifiManager);
+
+    // Latest values for LISTEN clients (loop task)
+    void setButtons(uint32_t state);       // bit i = button i+1 down
+    void setFader(int index, float value); // 0-based input, 0.0-1.0
+
+    // Send changed values to the clients listening for them — call from loop()
+    void loop();
+
+    // Answers namespace queries, passes every other request on
+    void run(AsyncWebServerRequest* request, ArMiddlewareNext next) override;
+
+private:
+    enum NodeKind : uint8_t {
+        NODE_BUTTON,
+        NODE_FADER,
+        NODE_COMMAND
+    };
+    struct Node {
+        char path[OSCQUERY_PATH_MAX];
+        NodeKind kind;
+        uint8_t index;            // Button/fader, 0-based
+    };
+    Node _nodes[OSCQUERY_NODES];
+    int _nodeCount;
+
+    std::atomic<uint32_t> _buttons;
+    std::atomic<float> _faders[ANALOG_SLOTS];
+
+    // Listeners are added and removed on the AsyncTCP task, marked dirty and
+    // flushed on the loop task; all under _lock. Sends happen outside it.
+    struct Listener {
+        uint32_t id;              // WebSocket client id, 0 = free
+        uint32_t listen;          // Value bits subscribed to
+        uint32_t dirty;           // Changed since last sent
+    };
+    Listener _listeners[OSCQUERY_MAX_LISTENERS];
+    SemaphoreHandle_t _lock;
+    std::atomic<bool> _pending;   // Some listener has dirty bits
+
+    AsyncWebSocket _ws;
+    OSCManager* _oscManager;
+    WiFiManager* _wifiManager;
+    unsigned long _lastCleanup;
+
+    void addNode(const char* path, NodeKind kind, int index);
+    const Node* findNode(const char* path) const;
+    bool hasChildren(const char* path) const;
+    static int valueBit(const Node& node);
+    void appendNode(String& json, const char* path, const char* only) const;
+    void appendValue(String& json, const Node& node) const;
+    String hostInfoJson() const;
+
+    void handleMessage(uint32_t id, const char* msg);
+    void setListening(uint32_t id, uint32_t bits, bool listen);
+    void dropListener(uint32_t id);
+    void markDirty(uint32_t bits);
+    size_t encode(int bit, uint8_t* out) const;
+};
+
+#endif
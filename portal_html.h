@@ -76,6 +76,14 @@ const char PORTAL_HTML[] PROGMEM = R"rawliteral(
                 <span class="label">Station IP</span>
                 <span class="value">%STA_IP%</span>
             </div>
+            <div class="status-row %STA_STATUS_CLASS%">
+                <span class="label">Signal</span>
+                <span class="value">%STA_RSSI%</span>
+            </div>
+            <div class="status-row %STA_STATUS_CLASS%">
+                <span class="label">Roams</span>
+                <span class="value">%ROAMS%</span>
+            </div>
         </div>
 
         <div class="status" style="margin-top: 20px;">
@@ -83,10 +91,18 @@ const char PORTAL_HTML[] PROGMEM = R"rawliteral(
                 <span class="label">AP Network</span>
                 <span class="value">%AP_SSID%</span>
             </div>
+            <div class="status-row">
+                <span class="label">Device ID</span>
+                <span class="value">%DEVICE_ID% (%HOSTNAME%.local)</span>
+            </div>
             <div class="status-row">
                 <span class="label">AP IP</span>
                 <span class="value">%AP_IP%</span>
             </div>
+            <div class="status-row">
+                <span class="label">AP Channel</span>
+                <span class="value">%AP_CHANNEL%</span>
+            </div>
             <div class="status-row">
                 <span class="label">AP Clients</span>
                 <span class="value">%AP_CLIENTS%</span>
@@ -96,16 +112,7 @@ const char PORTAL_HTML[] PROGMEM = R"rawliteral(
 
         <div class="status" id="buttonStatus">
             <h2 style="margin-top: 0; color: #fff; font-size: 1.1em;">Buttons</h2>
-            <div style="display: flex; gap: 15px;">
-                <div style="flex: 1; text-align: center; padding: 12px; border-radius: 6px; background: #0f0f23;" id="btn1box">
-                    <div style="color: #888; font-size: 0.85em;">Button 1</div>
-                    <div id="btn1state" style="font-size: 1.2em; margin-top: 4px; color: #555;">-</div>
-                </div>
-                <div style="flex: 1; text-align: center; padding: 12px; border-radius: 6px; background: #0f0f23;" id="btn2box">
-                    <div style="color: #888; font-size: 0.85em;">Button 2</div>
-                    <div id="btn2state" style="font-size: 1.2em; margin-top: 4px; color: #555;">-</div>
-                </div>
-            </div>
+            <div style="display: flex; flex-wrap: wrap; gap: 15px;" id="buttonBoxes"></div>
         </div>
 
         <div class="section">
@@ -151,7 +158,7 @@ const char PORTAL_HTML[] PROGMEM = R"rawliteral(
             </div>
             <div class="status-row">
                 <span class="label">Button Channels</span>
-                <span class="value" id="oscCurrentChannels">Btn1&rarr;%OSC_BUTTON1_CHANNEL%, Btn2&rarr;%OSC_BUTTON2_CHANNEL%</span>
+                <span class="value" id="oscCurrentChannels"></span>
             </div>
 
             <input type="text" id="oscTargetIP" placeholder="Target IP (empty = broadcast)" value="">
@@ -161,19 +168,102 @@ const char PORTAL_HTML[] PROGMEM = R"rawliteral(
                 <option value="8faderspush">Eight Faders (8faderspushX)</option>
                 <option value="custom">Custom</option>
             </select>
-            <input type="text" id="oscCustomFormat" class="hidden" placeholder="Custom format (e.g., /myformat)" style="margin-top: 8px;">
-            <div style="display: flex; gap: 8px; margin-top: 8px;">
-                <input type="number" id="oscButton1Channel" placeholder="Button 1 Channel" value="%OSC_BUTTON1_CHANNEL%" min="1" max="99" style="width: 50%%;">
-                <input type="number" id="oscButton2Channel" placeholder="Button 2 Channel" value="%OSC_BUTTON2_CHANNEL%" min="1" max="99" style="width: 50%%;">
-            </div>
+            <input type="text" id="oscCustomFormat" class="hidden" placeholder="Custom template (e.g., /cue/{ch}/go ,i{btn})" style="margin-top: 8px;">
+            <div style="display: flex; flex-wrap: wrap; gap: 8px; margin-top: 8px;" id="oscChannelInputs"></div>
+            <label style="display: block; margin: 10px 0;">
+                <input type="checkbox" id="oscPrefix" %OSC_PREFIX_CHECKED%>
+                Prefix every address with /%DEVICE_ID% (tells fleet units apart)
+            </label>
             <button class="btn-primary" onclick="saveOSC()">Save OSC Settings</button>
             <button class="btn-secondary" onclick="testOSC()">Test Button 1</button>
             <div id="oscMessage"></div>
         </div>
 
+        <div class="section">
+            <h2>Macros</h2>
+            <div id="macroInputs"></div>
+            <button class="btn-primary" onclick="saveMacros()">Save Macros</button>
+            <div id="macroMessage"></div>
+        </div>
+
+        <div class="section hidden" id="analogSection">
+            <h2>Faders</h2>
+            <div class="status-row">
+                <span class="label">Positions</span>
+                <span class="value" id="analogValues">-</span>
+            </div>
+            <input type="text" id="analogFormat" placeholder="Template (e.g., /fader/{ch} ,f{value})">
+            <div style="display: flex; flex-wrap: wrap; gap: 8px; margin-top: 8px;" id="analogChannelInputs"></div>
+            <button class="btn-primary" onclick="saveAnalog()">Save Fader Settings</button>
+            <div id="analogMessage"></div>
+        </div>
+
+        <div class="section">
+            <h2>Presets</h2>
+            <div class="status-row">
+                <span class="label">Active</span>
+                <span class="value" id="presetActive">none</span>
+            </div>
+            <select id="presetSelect"></select>
+            <button class="btn-primary" onclick="recallPreset()">Switch to Preset</button>
+            <button class="btn-secondary" onclick="clearPreset()">Delete Preset</button>
+            <div style="display: flex; gap: 8px; margin-top: 8px;">
+                <input type="number" id="presetSlot" placeholder="Slot (1-8)" min="1" max="8" style="width: 30%%;">
+                <input type="text" id="presetName" placeholder="Name (e.g., Act 2)" maxlength="23" style="width: 70%%;">
+            </div>
+            <button class="btn-secondary" onclick="storePreset()">Save Current Settings as Preset</button>
+            <div id="presetMessage"></div>
+        </div>
+
+        <div class="section">
+            <h2>Fleet</h2>
+            <div class="status-row">
+                <span class="label">Fleet key</span>
+                <span class="value" id="fleetKeyState">not set</span>
+            </div>
+            <div class="status-row">
+                <span class="label">Last bundle</span>
+                <span class="value" id="fleetLast">none</span>
+            </div>
+            <input type="password" id="fleetKey" placeholder="Fleet key (8-63 characters, same on every unit)" maxlength="63">
+            <button class="btn-secondary" onclick="saveFleetKey()">Save Fleet Key</button>
+            <button class="btn-primary" onclick="pushFleet()">Push OSC Settings and Presets to Fleet</button>
+            <div id="fleetMessage"></div>
+            <div id="fleetUnits"></div>
+        </div>
+
+        <div class="section">
+            <h2>Last Session</h2>
+            <div class="status-row">
+                <span class="label">Ended by</span>
+                <span class="value" id="telemetryReset">-</span>
+            </div>
+            <div id="telemetryRows"></div>
+        </div>
+
         <div class="section">
             <h2>Power</h2>
-            <p style="color: #888; font-size: 0.9em; margin-top: 0;">Put the device to sleep to charge faster or save battery. Press Button 1 to wake.</p>
+            <div class="status-row">
+                <span class="label">Profile</span>
+                <span class="value" id="powerProfile">%POWER_PROFILE%</span>
+            </div>
+            <select id="powerMode" onchange="setPowerMode()">
+                <option value="auto">Auto (show mode on button activity)</option>
+                <option value="show">Show (lowest latency)</option>
+                <option value="standby">Standby (longest battery life)</option>
+            </select>
+            <label style="display: block; margin: 10px 0;">
+                <input type="checkbox" id="showLock" onchange="setShowLock()" %SHOW_LOCK%>
+                Show lock: refuse portal access while a scene is running
+            </label>
+            <div class="status-row">
+                <span class="label">Rejected requests</span>
+                <span class="value" id="rejected">%REJECTED%</span>
+            </div>
+            <p style="color: #888; font-size: 0.9em;">Headless mode reboots without the access point and this portal, for the lowest latency and current draw during a show. Hold both buttons for 3 seconds to bring the portal back.</p>
+            <button class="btn-secondary" onclick="enterHeadless()">Go Headless</button>
+            <div id="headlessMessage"></div>
+            <p style="color: #888; font-size: 0.9em;">Put the device to sleep to charge faster or save battery. Press Button 1 to wake.</p>
             <button class="btn-danger" onclick="sleepDevice()">Sleep Now</button>
             <div id="sleepMessage"></div>
         </div>
@@ -182,8 +272,123 @@ const char PORTAL_HTML[] PROGMEM = R"rawliteral(
     </div>
 
     <script>
+        // Per-button fields, one per button of the board profile the
+        // firmware was built for
+        const CHANNELS = %OSC_CHANNELS%;
+        const BUTTONS = CHANNELS.length;
+
+        function channelsText(channels) {
+            return channels.map(function(ch, i) { return 'Btn' + (i + 1) + '→' + ch; }).join(', ');
+        }
+
+        (function buildButtonFields() {
+            const boxes = document.getElementById('buttonBoxes');
+            const inputs = document.getElementById('oscChannelInputs');
+            const macros = document.getElementById('macroInputs');
+            for (let b = 1; b <= BUTTONS; b++) {
+                const box = document.createElement('div');
+                box.id = 'btn' + b + 'box';
+                box.style.cssText = 'flex: 1; min-width: 70px; text-align: center; padding: 12px; border-radius: 6px; background: #0f0f23;';
+                box.innerHTML = '<div style="color: #888; font-size: 0.85em;">Button ' + b + '</div>' +
+                    '<div id="btn' + b + 'state" style="font-size: 1.2em; margin-top: 4px; color: #555;">-</div>';
+                boxes.appendChild(box);
+
+                const ch = document.createElement('input');
+                ch.type = 'number';
+                ch.id = 'oscButton' + b + 'Channel';
+                ch.placeholder = 'Button ' + b + ' Channel';
+                ch.min = 1;
+                ch.max = 99;
+                ch.value = CHANNELS[b - 1];
+                ch.style.cssText = 'flex: 1; min-width: 80px;';
+                inputs.appendChild(ch);
+
+                const macro = document.createElement('input');
+                macro.type = 'text';
+                macro.id = 'macro' + b;
+                macro.placeholder = b === 1 ? 'Button 1 macro (e.g., /fade/3 ,f1.0; +250 /kmpush5)'
+                                            : 'Button ' + b + ' macro (empty = normal message)';
+                if (b > 1) macro.style.marginTop = '8px';
+                macros.appendChild(macro);
+            }
+            document.getElementById('oscCurrentChannels').textContent = channelsText(CHANNELS);
+        })();
+
+        // Control socket: one WebSocket for all actions, with the device
+        // pushing progress instead of being polled. Every call falls back to
+        // the equivalent HTTP route when the socket isn't open (e.g. captive
+        // portal mini-browsers without WebSocket support).
+        let ws = null;
+        let wsReady = false;
+        let wsSeq = 0;
+        const wsPending = {};
+
+        function openControlSocket() {
+            if (typeof WebSocket === 'undefined') return;
+            ws = new WebSocket('ws://' + location.host + '/ws');
+            ws.onopen = function() { wsReady = true; };
+            ws.onclose = function() {
+                wsReady = false;
+                setTimeout(openControlSocket, 3000);
+            };
+            ws.onmessage = function(e) {
+                const msg = JSON.parse(e.data);
+                if (msg.id !== undefined && wsPending[msg.id]) {
+                    wsPending[msg.id](msg.r);
+                    delete wsPending[msg.id];
+                } else if (msg.ev) {
+                    onPush(msg.ev, msg.d);
+                }
+            };
+        }
+
+        // Run a control action: over the socket if open, else via its HTTP route
+        function ctl(action, method, path, params) {
+            params = params || '';
+            if (wsReady) {
+                return new Promise(function(resolve) {
+                    const id = ++wsSeq;
+                    wsPending[id] = resolve;
+                    ws.send(id + ' ' + action + (params ? ' ' + params : ''));
+                });
+            }
+            const opts = {method: method};
+            if (method === 'POST') {
+                opts.headers = {'Content-Type': 'application/x-www-form-urlencoded'};
+                opts.body = params;
+            }
+            return fetch(path, opts).then(function(r) { return r.json(); });
+        }
+
+        // Events pushed by the device over the control socket
+        let awaitingConnect = false;
+        function onPush(ev, d) {
+            if (ev === 'constatus' && awaitingConnect) {
+                showConnectStatus(d);
+            } else if (ev === 'testosc') {
+                document.getElementById('oscMessage').innerHTML = d.dropped > 0
+                    ? '<div class="message error">Test dropped on ' + d.dropped + ' target(s)</div>'
+                    : '<div class="message success">Sent: ' + d.address + ' to ' + d.targets.join(', ') + '</div>';
+            } else if (ev === 'osc') {
+                showOSCSettings(d);
+            } else if (ev === 'macro') {
+                showMacros(d);
+            } else if (ev === 'analog') {
+                showAnalog(d);
+            } else if (ev === 'presets') {
+                showPresets(d);
+            } else if (ev === 'fleet') {
+                showFleet(d);
+            } else if (ev === 'power') {
+                document.getElementById('powerProfile').textContent = d.profile;
+                document.getElementById('powerMode').value = d.mode;
+            }
+        }
+
+        openControlSocket();
+
         let scanRetries = 0;
-        const maxRetries = 10;
+        const maxRetries = 15;  // full sweep is 13 short channel hops
         let scanning = false;
 
         function showScanButton() {
@@ -214,7 +419,6 @@ const char PORTAL_HTML[] PROGMEM = R"rawliteral(
         function scanNetworks() {
             if (scanning) return;  // Prevent double-clicks
             showScanning();
-            document.getElementById('scanResult').innerHTML = '';
             scanRetries = 0;
             doScan();
         }
@@ -223,29 +427,31 @@ const char PORTAL_HTML[] PROGMEM = R"rawliteral(
             fetch('/scan')
                 .then(function(r) { return r.json(); })
                 .then(function(data) {
-                    // Check if still scanning
-                    if (data && data.status === 'scanning') {
+                    // Cached results are shown right away, even while the
+                    // device refreshes them in the background
+                    if (data.networks.length > 0) {
+                        showNetworks(data.networks);
+                    }
+
+                    if (data.scanning) {
                         scanRetries++;
                         if (scanRetries < maxRetries) {
                             setTimeout(doScan, 1000);
                             return;
                         }
                         showScanButton();
-                        document.getElementById('scanResult').innerHTML =
-                            '<div class="message error">Scan timeout - try again</div>';
+                        if (data.networks.length === 0) {
+                            document.getElementById('scanResult').innerHTML =
+                                '<div class="message error">Scan timeout - try again</div>';
+                        }
                         return;
                     }
 
-                    // Got results
                     showScanButton();
-
-                    if (!Array.isArray(data) || data.length === 0) {
+                    if (data.networks.length === 0) {
                         document.getElementById('scanResult').innerHTML =
                             '<div class="message error">No networks found</div>';
-                        return;
                     }
-
-                    showNetworks(data);
                 })
                 .catch(function(e) {
                     showScanButton();
@@ -266,12 +472,8 @@ const char PORTAL_HTML[] PROGMEM = R"rawliteral(
             const ssid = document.getElementById('ssid').value;
             const password = document.getElementById('password').value;
 
-            fetch('/connect', {
-                method: 'POST',
-                headers: {'Content-Type': 'application/x-www-form-urlencoded'},
-                body: `ssid=${encodeURIComponent(ssid)}&password=${encodeURIComponent(password)}`
-            })
-            .then(r => r.json())
+            ctl('connect', 'POST', '/connect',
+                `ssid=${encodeURIComponent(ssid)}&password=${encodeURIComponent(password)}`)
             .then(result => {
                 if (result.success) {
                     document.getElementById('scanResult').innerHTML =
@@ -288,7 +490,30 @@ const char PORTAL_HTML[] PROGMEM = R"rawliteral(
             });
         }
 
+        // Returns true once the attempt has finished (connected or failed)
+        function showConnectStatus(result) {
+            if (result.status === 'connected') {
+                awaitingConnect = false;
+                document.getElementById('scanResult').innerHTML =
+                    '<div class="message success">Connected! IP: ' + result.ip + ' — page will reload...</div>';
+                setTimeout(function() { location.reload(); }, 2000);
+                return true;
+            }
+            if (result.status === 'failed') {
+                awaitingConnect = false;
+                document.getElementById('scanResult').innerHTML =
+                    '<div class="message error">Connection failed</div>';
+                return true;
+            }
+            return false;
+        }
+
         function pollConnectStatus(attempts) {
+            // With the control socket open the device pushes progress; only
+            // poll when we're on plain HTTP.
+            awaitingConnect = true;
+            if (wsReady) return;
+
             // ~15 s ceiling (30 polls * 500 ms) — backend times out at 10 s
             if (attempts > 30) {
                 document.getElementById('scanResult').innerHTML =
@@ -296,26 +521,16 @@ const char PORTAL_HTML[] PROGMEM = R"rawliteral(
                 return;
             }
             setTimeout(function() {
-                fetch('/constatus')
-                    .then(function(r) { return r.json(); })
+                ctl('constatus', 'GET', '/constatus')
                     .then(function(result) {
-                        if (result.status === 'connected') {
-                            document.getElementById('scanResult').innerHTML =
-                                '<div class="message success">Connected! IP: ' + result.ip + ' — page will reload...</div>';
-                            setTimeout(function() { location.reload(); }, 2000);
-                        } else if (result.status === 'failed') {
-                            document.getElementById('scanResult').innerHTML =
-                                '<div class="message error">Connection failed</div>';
-                        } else {
-                            pollConnectStatus(attempts + 1);
-                        }
+                        if (!showConnectStatus(result)) pollConnectStatus(attempts + 1);
                     })
                     .catch(function() { pollConnectStatus(attempts + 1); });
             }, 500);
         }
 
         function disconnectWiFi() {
-            fetch('/disconnect', {method: 'POST'})
+            ctl('disconnect', 'POST', '/disconnect')
                 .then(function() {
                     // Give the device a moment to actually tear down the STA + bring AP back
                     setTimeout(function() { location.reload(); }, 1500);
@@ -323,8 +538,7 @@ const char PORTAL_HTML[] PROGMEM = R"rawliteral(
         }
 
         function reconnectWiFi() {
-            fetch('/reconnect', {method: 'POST'})
-                .then(function(r) { return r.json(); })
+            ctl('reconnect', 'POST', '/reconnect')
                 .then(function(result) {
                     if (result.success) {
                         document.getElementById('scanResult').innerHTML =
@@ -343,8 +557,7 @@ const char PORTAL_HTML[] PROGMEM = R"rawliteral(
 
         function switchToStaOnly() {
             if (!confirm('Shut down the Access Point now? You will need to be on the same network (or reboot) to access this page again.')) return;
-            fetch('/staonly', {method: 'POST'})
-                .then(function(r) { return r.json(); })
+            ctl('staonly', 'POST', '/staonly')
                 .then(function(result) {
                     if (result.success) {
                         document.getElementById('scanResult').innerHTML =
@@ -375,19 +588,16 @@ const char PORTAL_HTML[] PROGMEM = R"rawliteral(
             const port = document.getElementById('oscPort').value;
             const targetip = document.getElementById('oscTargetIP').value;
             const mode = document.getElementById('oscMode').value;
-            const button1Channel = document.getElementById('oscButton1Channel').value;
-            const button2Channel = document.getElementById('oscButton2Channel').value;
-
             // Validate button channels
-            if (!button1Channel || button1Channel < 1 || button1Channel > 99) {
-                document.getElementById('oscMessage').innerHTML =
-                    '<div class="message error">Button 1 channel must be between 1-99</div>';
-                return;
-            }
-            if (!button2Channel || button2Channel < 1 || button2Channel > 99) {
-                document.getElementById('oscMessage').innerHTML =
-                    '<div class="message error">Button 2 channel must be between 1-99</div>';
-                return;
+            const channels = [];
+            for (let b = 1; b <= BUTTONS; b++) {
+                const ch = document.getElementById('oscButton' + b + 'Channel').value;
+                if (!ch || ch < 1 || ch > 99) {
+                    document.getElementById('oscMessage').innerHTML =
+                        '<div class="message error">Button ' + b + ' channel must be between 1-99</div>';
+                    return;
+                }
+                channels.push(ch);
             }
 
             // Use custom format if "custom" is selected, otherwise use the preset value
@@ -403,21 +613,17 @@ const char PORTAL_HTML[] PROGMEM = R"rawliteral(
                 addressFormat = mode;
             }
 
-            fetch('/osc', {
-                method: 'POST',
-                headers: {'Content-Type': 'application/x-www-form-urlencoded'},
-                body: `port=${port}&targetip=${encodeURIComponent(targetip)}&addressFormat=${encodeURIComponent(addressFormat)}&button1Channel=${button1Channel}&button2Channel=${button2Channel}`
-            })
-            .then(r => r.json())
+            const addressPrefix = document.getElementById('oscPrefix').checked;
+            let params = `port=${port}&targetip=${encodeURIComponent(targetip)}&addressFormat=${encodeURIComponent(addressFormat)}`;
+            params += '&addressPrefix=' + (addressPrefix ? '1' : '0');
+            channels.forEach(function(ch, i) { params += '&button' + (i + 1) + 'Channel=' + ch; });
+            ctl('osc.set', 'POST', '/osc', params)
             .then(result => {
                 if (result.success) {
                     document.getElementById('oscMessage').innerHTML =
                         '<div class="message success">Settings saved! Restart device to apply.</div>';
-                    document.getElementById('oscCurrentTarget').textContent =
-                        (targetip || 'broadcast') + ':' + port;
-                    document.getElementById('oscCurrentFormat').textContent = addressFormat;
-                    document.getElementById('oscCurrentChannels').textContent =
-                        'Btn1→' + button1Channel + ', Btn2→' + button2Channel;
+                    showOSCSettings({port: port, targetip: targetip, addressFormat: addressFormat,
+                        addressPrefix: addressPrefix, channels: channels});
                 } else {
                     document.getElementById('oscMessage').innerHTML =
                         '<div class="message error">' + (result.message || 'Save failed') + '</div>';
@@ -425,10 +631,219 @@ const char PORTAL_HTML[] PROGMEM = R"rawliteral(
             });
         }
 
+        // Reflect saved OSC settings (own save, or pushed from another portal)
+        function showOSCSettings(o) {
+            document.getElementById('oscCurrentTarget').textContent =
+                (o.targetip || 'broadcast') + ':' + o.port;
+            document.getElementById('oscCurrentFormat').textContent = o.addressFormat;
+            document.getElementById('oscCurrentChannels').textContent = channelsText(o.channels);
+            document.getElementById('oscPrefix').checked = o.addressPrefix;
+        }
+
+        function showMacros(m) {
+            m.buttons.forEach(function(b) {
+                document.getElementById('macro' + b.button).value = b.steps;
+            });
+        }
+
+        // One save per button; each only after the previous was accepted
+        function saveMacros() {
+            const save = function(button) {
+                return ctl('macro.set', 'POST', '/macro', 'button=' + button +
+                    '&steps=' + encodeURIComponent(document.getElementById('macro' + button).value))
+                .then(function(r) {
+                    if (!r.success) return {success: false, message: 'Button ' + button + ': ' + r.message};
+                    return button < BUTTONS ? save(button + 1) : r;
+                });
+            };
+            save(1).then(function(result) {
+                document.getElementById('macroMessage').innerHTML = result.success
+                    ? '<div class="message success">Macros saved</div>'
+                    : '<div class="message error">' + (result.message || 'Save failed') + '</div>';
+            })
+            .catch(function() {});
+        }
+
+        function valuesText(values) {
+            return values.map(function(v, i) { return 'In' + (i + 1) + ' ' + v.toFixed(2); }).join(', ');
+        }
+
+        // Only boards with analog inputs answer /analog; the section stays
+        // hidden on the others
+        function showAnalog(a) {
+            document.getElementById('analogSection').classList.remove('hidden');
+            document.getElementById('analogFormat').value = a.format;
+            const inputs = document.getElementById('analogChannelInputs');
+            a.inputs.forEach(function(input) {
+                let ch = document.getElementById('analogInput' + input.input + 'Channel');
+                if (!ch) {
+                    ch = document.createElement('input');
+                    ch.type = 'number';
+                    ch.id = 'analogInput' + input.input + 'Channel';
+                    ch.placeholder = 'Input ' + input.input + ' Channel';
+                    ch.min = 1;
+                    ch.max = 99;
+                    ch.style.cssText = 'flex: 1; min-width: 80px;';
+                    inputs.appendChild(ch);
+                }
+                ch.value = input.channel;
+            });
+            document.getElementById('analogValues').textContent = valuesText(a.values);
+        }
+
+        function saveAnalog() {
+            let params = 'format=' + encodeURIComponent(document.getElementById('analogFormat').value);
+            document.querySelectorAll('#analogChannelInputs input').forEach(function(ch, i) {
+                params += '&input' + (i + 1) + 'Channel=' + ch.value;
+            });
+            ctl('analog.set', 'POST', '/analog', params)
+            .then(function(result) {
+                document.getElementById('analogMessage').innerHTML = result.success
+                    ? '<div class="message success">Fader settings saved</div>'
+                    : '<div class="message error">' + (result.message || 'Save failed') + '</div>';
+            })
+            .catch(function() {});
+        }
+
+        function showPresets(p) {
+            const select = document.getElementById('presetSelect');
+            select.innerHTML = '';
+            let activeName = 'none';
+            p.presets.forEach(function(preset) {
+                const opt = document.createElement('option');
+                opt.value = preset.slot;
+                opt.textContent = preset.slot + ': ' + preset.name + ' (' + preset.addressFormat +
+                    ', ' + channelsText(preset.channels) + ')';
+                select.appendChild(opt);
+                if (preset.slot === p.active) {
+                    activeName = preset.name + (p.modified ? ' (modified)' : '');
+                    select.value = preset.slot;
+                }
+            });
+            document.getElementById('presetActive').textContent = activeName;
+        }
+
+        function presetResult(result) {
+            if (!result.success) {
+                document.getElementById('presetMessage').innerHTML =
+                    '<div class="message error">' + (result.message || 'Failed') + '</div>';
+            } else {
+                document.getElementById('presetMessage').innerHTML = '';
+            }
+        }
+
+        // The device pushes the new state ("presets" and "osc" events) once
+        // loop() has applied the change
+        function recallPreset() {
+            const slot = document.getElementById('presetSelect').value;
+            if (!slot) return;
+            ctl('preset.recall', 'POST', '/preset/recall', 'slot=' + slot).then(presetResult).catch(function() {});
+        }
+
+        function clearPreset() {
+            const slot = document.getElementById('presetSelect').value;
+            if (!slot || !confirm('Delete preset ' + slot + '?')) return;
+            ctl('preset.clear', 'POST', '/preset/clear', 'slot=' + slot).then(presetResult).catch(function() {});
+        }
+
+        function storePreset() {
+            const slot = document.getElementById('presetSlot').value;
+            const name = document.getElementById('presetName').value;
+            ctl('preset.store', 'POST', '/preset', 'slot=' + slot + '&name=' + encodeURIComponent(name))
+            .then(presetResult).catch(function() {});
+        }
+
+        function showFleet(f) {
+            document.getElementById('fleetKeyState').textContent = f.keySet ? 'set' : 'not set';
+            document.getElementById('fleetLast').textContent = f.lastBundle || 'none';
+            const p = f.push;
+            if (p.state === 'idle') return;
+            let html = '<div class="message ' + (p.state === 'done' ? 'success' : '') + '">Bundle ' + p.bundle +
+                (p.state === 'done' ? ': done after ' : ': round ') + p.round + (p.state === 'done' ? ' rounds' : '') + '</div>';
+            p.units.forEach(function(u) {
+                html += '<div class="status-row"><span class="label">' + u.id + ' (' + u.ip + ')</span>' +
+                    '<span class="value">' + u.status + '</span></div>';
+            });
+            document.getElementById('fleetUnits').innerHTML = html;
+        }
+
+        // Previous session from the RTC journal (kept across reboots and deep sleep)
+        function showTelemetry(t) {
+            const crash = ['crash', 'interrupt watchdog', 'task watchdog', 'watchdog'].indexOf(t.reset) >= 0;
+            document.getElementById('telemetryReset').textContent = t.reset + (crash ? ' in ' + t.lastPhase : '') +
+                ' (boot ' + t.boots + ')';
+            const p = t.previous;
+            if (!p) return;
+            const rows = [
+                ['Uptime', p.uptimeS + ' s'],
+                ['Presses', p.presses.join(' / ')],
+                ['Send failures', p.sendFailures],
+                ['Worst press', p.worstPressUs + ' \u00b5s'],
+                ['Worst loop pass', p.worstLoopUs + ' \u00b5s'],
+                ['WiFi outages', p.wifiOutages + ' (' + p.wifiOutageMs + ' ms, worst ' + p.worstOutageMs + ' ms)']
+            ];
+            document.getElementById('telemetryRows').innerHTML = rows.map(function(r) {
+                return '<div class="status-row"><span class="label">' + r[0] + '</span><span class="value">' + r[1] + '</span></div>';
+            }).join('');
+        }
+
+        function fleetResult(result) {
+            document.getElementById('fleetMessage').innerHTML = result.success ? '' :
+                '<div class="message error">' + (result.message || 'Failed') + '</div>';
+        }
+
+        function saveFleetKey() {
+            const key = document.getElementById('fleetKey').value;
+            ctl('fleet.key', 'POST', '/fleet/key', 'key=' + encodeURIComponent(key)).then(function(result) {
+                fleetResult(result);
+                if (result.success) document.getElementById('fleetKey').value = '';
+            }).catch(function() {});
+        }
+
+        // Progress and the units' answers arrive as "fleet" events
+        function pushFleet() {
+            if (!confirm('Replace the OSC settings and presets of every unit with the same fleet key?')) return;
+            ctl('fleet.push', 'POST', '/fleet/push', '').then(fleetResult).catch(function() {});
+        }
+
+        function setPowerMode() {
+            const mode = document.getElementById('powerMode').value;
+            ctl('power.set', 'POST', '/power', 'mode=' + mode)
+            .then(function() { return ctl('power.get', 'GET', '/power'); })
+            .then(function(p) {
+                document.getElementById('powerProfile').textContent = p.profile;
+            })
+            .catch(function() {});
+        }
+
+        function setShowLock() {
+            const enabled = document.getElementById('showLock').checked ? '1' : '0';
+            ctl('showlock', 'POST', '/showlock', 'enabled=' + enabled)
+            .then(function(a) {
+                document.getElementById('showLock').checked = a.showLock;
+                document.getElementById('rejected').textContent =
+                    a.rejected.rateLimited + a.rejected.busy + a.rejected.locked;
+            })
+            .catch(function() {});
+        }
+
+        function enterHeadless() {
+            if (!confirm('Reboot into headless mode? The portal will be unavailable until both buttons are held for 3 seconds.')) return;
+            ctl('headless', 'POST', '/headless')
+            .then(function(result) {
+                document.getElementById('headlessMessage').innerHTML = result.success
+                    ? '<div class="message success">Rebooting headless. Configure via OSC /muis/config.</div>'
+                    : '<div class="message error">' + result.message + '</div>';
+            })
+            .catch(function() {
+                document.getElementById('headlessMessage').innerHTML =
+                    '<div class="message error">Request failed</div>';
+            });
+        }
+
         function sleepDevice() {
             if (!confirm('Put device to sleep? Press Button 1 to wake.')) return;
-            fetch('/sleep', {method: 'POST'})
-            .then(function(r) { return r.json(); })
+            ctl('sleep', 'POST', '/sleep')
             .then(function(result) {
                 document.getElementById('sleepMessage').innerHTML =
                     '<div class="message success">Device sleeping &rarr; press Button 1 to wake.</div>';
@@ -440,9 +855,10 @@ const char PORTAL_HTML[] PROGMEM = R"rawliteral(
         }
 
         function testOSC() {
-            fetch('/testosc', {method: 'POST'})
-            .then(r => r.json())
+            ctl('testosc', 'POST', '/testosc')
             .then(result => {
+                // Socket clients get the outcome as a "testosc" event once sent
+                if (wsReady) return;
                 const targetsStr = result.targets.join(', ');
                 document.getElementById('oscMessage').innerHTML =
                     '<div class="message success">Sent: ' + result.address + ' to ' + targetsStr + '</div>';
@@ -455,16 +871,14 @@ const char PORTAL_HTML[] PROGMEM = R"rawliteral(
 
         // Update button UI from state object
         function updateButtons(s) {
-            var b1 = document.getElementById('btn1state');
-            var b2 = document.getElementById('btn2state');
-            var box1 = document.getElementById('btn1box');
-            var box2 = document.getElementById('btn2box');
-            b1.textContent = s.button1 ? 'PRESSED' : 'Released';
-            b2.textContent = s.button2 ? 'PRESSED' : 'Released';
-            b1.style.color = s.button1 ? '#00d4aa' : '#555';
-            b2.style.color = s.button2 ? '#00d4aa' : '#555';
-            box1.style.borderLeft = s.button1 ? '3px solid #00d4aa' : '3px solid transparent';
-            box2.style.borderLeft = s.button2 ? '3px solid #00d4aa' : '3px solid transparent';
+            for (let b = 1; b <= BUTTONS; b++) {
+                const down = s['button' + b];
+                const state = document.getElementById('btn' + b + 'state');
+                state.textContent = down ? 'PRESSED' : 'Released';
+                state.style.color = down ? '#00d4aa' : '#555';
+                document.getElementById('btn' + b + 'box').style.borderLeft =
+                    down ? '3px solid #00d4aa' : '3px solid transparent';
+            }
         }
 
         // Live updates via Server-Sent Events (single persistent connection).
@@ -477,6 +891,9 @@ const char PORTAL_HTML[] PROGMEM = R"rawliteral(
             evtSource.addEventListener('battery', function(e) {
                 document.querySelector('.battery').textContent = e.data + '%%';
             });
+            evtSource.addEventListener('analog', function(e) {
+                document.getElementById('analogValues').textContent = valuesText(JSON.parse(e.data));
+            });
         } else {
             setInterval(function() {
                 fetch('/buttonstatus')
@@ -497,6 +914,31 @@ const char PORTAL_HTML[] PROGMEM = R"rawliteral(
             })
             .catch(function() {});
 
+        fetch('/macro')
+            .then(function(r) { return r.json(); })
+            .then(showMacros)
+            .catch(function() {});
+
+        fetch('/analog')
+            .then(function(r) { return r.json(); })
+            .then(showAnalog)
+            .catch(function() {});
+
+        fetch('/presets')
+            .then(function(r) { return r.json(); })
+            .then(showPresets)
+            .catch(function() {});
+
+        fetch('/fleet')
+            .then(function(r) { return r.json(); })
+            .then(showFleet)
+            .catch(function() {});
+
+        fetch('/telemetry')
+            .then(function(r) { return r.json(); })
+            .then(showTelemetry)
+            .catch(function() {});
+
         // Load current OSC format into dropdown
         window.addEventListener('load', function() {
             const currentFormat = '%OSC_ADDRESS_FORMAT%';
@@ -521,6 +963,8 @@ const char PORTAL_HTML[] PROGMEM = R"rawliteral(
                 customInput.classList.remove('hidden');
             }
 
+            document.getElementById('powerMode').value = '%POWER_MODE%';
+
             // Load target IP
             const target = '%OSC_TARGET_IP%';
             if (target !== 'broadcast') {
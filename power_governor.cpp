@@ -0,0 +1,173 @@
+// OSC-Muis - Niels van der Hulst 2026
+
+#include "power_governor.h"
+#include "wifi_manager.h"
+#include "arp_keeper.h"
+#include "log_ring.h"
+#include "esp_wifi.h"
+
+// Idle time after the last press before auto mode drops back to standby.
+// Long enough to span the gaps between cues in a scene.
+#define POWER_SHOW_HOLD_MS (5UL * 60UL * 1000UL)
+
+struct PowerProfileSettings {
+    uint32_t cpuMhz;
+    wifi_power_t txPower;
+    wifi_ps_type_t powerSave;      // Only takes effect in STA-only mode
+    unsigned long arpRefreshMs;    // 0 = ArpKeeper default (half the cache lifetime)
+};
+
+// Indexed by PowerProfile
+static const PowerProfileSettings PROFILES[] = {
+    // Standby: the old fixed settings — 80 MHz halves active current, modem
+    // sleep between DTIM beacons, 11 dBm is enough at moderate range.
+    {  80, WIFI_POWER_11dBm, WIFI_PS_MIN_MODEM, 0 },
+    // Show: no modem sleep (a send never waits for the radio to wake), full
+    // clock for the send path, more TX headroom for a moving actor, and ARP
+    // kept fresh well inside the cache lifetime.
+    { 160, WIFI_POWER_17dBm, WIFI_PS_NONE, 30000 },
+};
+
+static PowerGovernor* _governorInstance = nullptr;
+
+static String powerTemplateProcessor(const String& var) {
+    if (!_governorInstance) return String();
+    if (var == "POWER_MODE") return PowerGovernor::modeName(_governorInstance->getMode());
+    if (var == "POWER_PROFILE") return PowerGovernor::profileName(_governorInstance->getProfile());
+    return String();
+}
+
+PowerGovernor::PowerGovernor() {
+    _wifiManager = nullptr;
+    _arpKeeper = nullptr;
+    _mode = POWER_MODE_AUTO;
+    _profile = POWER_PROFILE_STANDBY;
+    _lastActivity = 0;
+    _activityPending = false;
+    _requestedMode = -1;
+}
+
+void PowerGovernor::begin(WiFiManager& wifiManager, ArpKeeper& arpKeeper) {
+    _wifiManager = &wifiManager;
+    _arpKeeper = &arpKeeper;
+    _governorInstance = this;
+
+    registerActions();
+    wifiManager.registerTemplateCallback(powerTemplateProcessor);
+
+    apply(POWER_PROFILE_STANDBY);
+}
+
+String PowerGovernor::getStatusJson() const {
+    String json = "{\"mode\":\"";
+    json += modeName(_mode);
+    json += "\",\"profile\":\"";
+    json += profileName(_profile);
+    json += "\"}";
+    return json;
+}
+
+void PowerGovernor::registerActions() {
+    ControlChannel& control = _wifiManager->getControlChannel();
+
+    control.registerAction("power.get", "/power", HTTP_GET, [](const ControlRequest&) -> String {
+        return _governorInstance->getStatusJson();
+    });
+
+    // Portal toggle — applied from loop() (CPU clock changes don't belong on the async task)
+    control.registerAction("power.set", "/power", HTTP_POST, [](const ControlRequest& req) -> String {
+        PowerMode mode;
+        if (!req.hasParam("mode") || !parseMode(req.getParam("mode").c_str(), mode)) {
+            return "{\"success\":false,\"message\":\"mode must be auto, show or standby\"}";
+        }
+        _governorInstance->setMode(mode);
+        return "{\"success\":true}";
+    });
+}
+
+void PowerGovernor::notifyActivity() {
+    _activityPending = true;
+}
+
+void PowerGovernor::setMode(PowerMode mode) {
+    _requestedMode = mode;
+}
+
+PowerMode PowerGovernor::getMode() const {
+    return _mode;
+}
+
+PowerProfile PowerGovernor::getProfile() const {
+    return _profile;
+}
+
+const char* PowerGovernor::modeName(PowerMode mode) {
+    switch (mode) {
+        case POWER_MODE_SHOW:    return "show";
+        case POWER_MODE_STANDBY: return "standby";
+        default:                 return "auto";
+    }
+}
+
+const char* PowerGovernor::profileName(PowerProfile profile) {
+    return profile == POWER_PROFILE_SHOW ? "show" : "standby";
+}
+
+bool PowerGovernor::parseMode(const char* name, PowerMode& out) {
+    if (strcmp(name, "auto") == 0)    { out = POWER_MODE_AUTO;    return true; }
+    if (strcmp(name, "show") == 0)    { out = POWER_MODE_SHOW;    return true; }
+    if (strcmp(name, "standby") == 0) { out = POWER_MODE_STANDBY; return true; }
+    return false;
+}
+
+void PowerGovernor::loop() {
+    if (_requestedMode >= 0) {
+        _mode = (PowerMode)_requestedMode;
+        _requestedMode = -1;
+        LOG_INFO("Power mode: %s", modeName(_mode));
+        _wifiManager->getControlChannel().push("power", getStatusJson());
+        // A manual switch to auto during a scene starts a fresh hold window
+        // rather than dropping it to standby; from standby, auto stays there
+        // until a press
+        if (_profile == POWER_PROFILE_SHOW) _lastActivity = millis();
+    }
+
+    if (_activityPending) {
+        _activityPending = false;
+        _lastActivity = millis();
+    }
+
+    PowerProfile wanted;
+    switch (_mode) {
+        case POWER_MODE_SHOW:    wanted = POWER_PROFILE_SHOW;    break;
+        case POWER_MODE_STANDBY: wanted = POWER_PROFILE_STANDBY; break;
+        default:
+            // Enter on any recent press, leave only after the full hold time
+            wanted = (_lastActivity != 0 && millis() - _lastActivity < POWER_SHOW_HOLD_MS)
+                ? POWER_PROFILE_SHOW : POWER_PROFILE_STANDBY;
+            break;
+    }
+
+    if (wanted != _profile) {
+        apply(wanted);
+    }
+}
+
+void PowerGovernor::apply(PowerProfile profile) {
+    const PowerProfileSettings& p = PROFILES[profile];
+    bool sceneEnded = (_profile == POWER_PROFILE_SHOW && profile == POWER_PROFILE_STANDBY);
+    _profile = profile;
+
+    setCpuFrequencyMhz(p.cpuMhz);
+    _wifiManager->setRadioProfile(p.txPower, p.powerSave);
+    _arpKeeper->setRefreshInterval(p.arpRefreshMs);
+    _wifiManager->getAdmission().setSceneActive(profile == POWER_PROFILE_SHOW);
+
+    LOG_INFO("Power profile: %s (%u MHz)", profileName(profile), getCpuFrequencyMhz());
+    _wifiManager->getControlChannel().push("power", getStatusJson());
+
+    // Between scenes is the one moment moving the AP can't hurt a cue
+    if (sceneEnded) {
+        _wifiManager->reselectAPChannel();
+    }
+}
@@ -0,0 +1,68 @@
+// OSC-Muis - Niels van der Hulst 2026
+
+#ifndef POWER_GOVERNOR_H
+#define POWER_GOVERNOR_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+
+class WiFiManager;
+class ArpKeeper;
+
+// Hardware power profile currently applied
+enum PowerProfile {
+    POWER_PROFILE_STANDBY,   // 80 MHz, modem sleep, low TX power — between scenes
+    POWER_PROFILE_SHOW       // 160 MHz, no modem sleep, raised TX power — during a scene
+};
+
+// How the profile is chosen
+enum PowerMode {
+    POWER_MODE_AUTO,         // Follow button activity (default)
+    POWER_MODE_SHOW,         // Forced show profile (portal / OSC)
+    POWER_MODE_STANDBY       // Forced standby profile (portal / OSC)
+};
+
+// Switches between a battery-saving standby profile and a low-latency show
+// profile. In auto mode a button press enters show immediately (the scene
+// has started); the device only drops back to standby after
+// POWER_SHOW_HOLD_MS without presses. The asymmetric enter/exit is the
+// hysteresis: scattered cues within a scene never bounce the profile.
+class PowerGovernor {
+public:
+    PowerGovernor();
+
+    // Apply the standby profile and register the power actions (/power).
+    // Call once WiFi is up, before the web server starts.
+    void begin(WiFiManager& wifiManager, ArpKeeper& arpKeeper);
+
+    // Record button activity (call on every press)
+    void notifyActivity();
+
+    // Portal / OSC override
+    void setMode(PowerMode mode);
+    PowerMode getMode() const;
+    PowerProfile getProfile() const;
+
+    static const char* modeName(PowerMode mode);
+    static const char* profileName(PowerProfile profile);
+    static bool parseMode(const char* name, PowerMode& out);
+
+    // Evaluate the idle timeout and apply profile changes (call in loop)
+    void loop();
+
+private:
+    WiFiManager* _wifiManager;
+    ArpKeeper* _arpKeeper;
+
+    PowerMode _mode;
+    PowerProfile _profile;
+    unsigned long _lastActivity;
+    volatile bool _activityPending;   // set by notifyActivity, consumed in loop()
+    volatile int _requestedMode;      // -1 = none; set from async handlers
+
+    void apply(PowerProfile profile);
+    void registerActions();
+    String getStatusJson() const;
+};
+
+#endif
@@ -0,0 +1,339 @@
+// OSC-Muis - Niels van der Hulst 2026
+
+#include "preset_bank.h"
+#include "wifi_manager.h"
+#include <OSCMessage.h>
+
+// Static instance pointer for web/OSC callbacks
+static PresetBank* _presetInstance = nullptr;
+
+PresetBank::PresetBank() {
+    memset(_presets, 0, sizeof(_presets));
+    _active = -1;
+    _activeVersion = 0;
+    _storedSlots = 0;
+    _requestedRecall = -1;
+    _requestedStore = -1;
+    _requestedName[0] = '\0';
+    _requestedClear = -1;
+    _oscManager = nullptr;
+    _wifiManager = nullptr;
+}
+
+void PresetBank::begin(OSCManager& oscManager, WiFiManager& wifiManager) {
+    _oscManager = &oscManager;
+    _wifiManager = &wifiManager;
+    _presetInstance = this;
+    _json.begin();
+
+    // All parsing happens here, once: a switch only copies a ready config
+    int count = 0;
+    _preferences.begin("presets", true);
+    char key[4] = "p0";
+    for (int i = 0; i < PRESET_MAX; i++) {
+        key[1] = '0' + i;
+        StoredPreset stored;
+        if (_preferences.getBytesLength(key) != sizeof(stored)) continue;
+        _preferences.getBytes(key, &stored, sizeof(stored));
+        stored.name[PRESET_NAME_MAX - 1] = '\0';
+        stored.targetIP[OSC_TARGET_IP_MAX - 1] = '\0';
+        stored.addressFormat[OSC_ADDRESS_FORMAT_MAX - 1] = '\0';
+        const char* error = compile(stored, _presets[i]);
+        if (error) {
+            Serial.printf("Preset %d skipped: %s\n", i + 1, error);
+            continue;
+        }
+        count++;
+    }
+    _preferences.end();
+    Serial.printf("Presets: %d stored\n", count);
+    publish();
+
+    // Preset changes are show control: the sender proves the receiver's network
+    oscManager.registerCommand("/muis/preset", onPresetCommand, true);
+    oscManager.registerCommand("/muis/preset/next", onPresetCommand, true);
+    if (!wifiManager.isHeadless()) {
+        registerActions();
+    }
+}
+
+bool PresetBank::validName(const char* name) {
+    size_t len = strlen(name);
+    if (len == 0 || len >= PRESET_NAME_MAX) return false;
+    // Echoed into JSON and the portal unescaped
+    for (size_t i = 0; i < len; i++) {
+        char c = name[i];
+        if (!isalnum((unsigned char)c) && !strchr(" _-.", c)) return false;
+    }
+    return true;
+}
+
+const char* PresetBank::compile(const StoredPreset& stored, Preset& out) {
+    if (!validName(stored.name)) return "Invalid name";
+    for (int i = 0; i < BOARD_BUTTONS; i++) {
+        if (stored.channels[i] < 1 || stored.channels[i] > 99) return "Invalid channel";
+    }
+    IPAddress test;
+    if (stored.targetIP[0] && !test.fromString(stored.targetIP)) return "Invalid target IP";
+
+    Preset preset;
+    memset(&preset, 0, sizeof(preset));
+    const char* error = preset.config.program.compile(stored.addressFormat);
+    if (error) return error;
+    strlcpy(preset.name, stored.name, sizeof(preset.name));
+    strlcpy(preset.config.addressFormat, stored.addressFormat, sizeof(preset.config.addressFormat));
+    preset.config.setTargetIP(stored.targetIP);
+    for (int i = 0; i < BOARD_BUTTONS; i++) preset.config.channels[i] = stored.channels[i];
+    out = preset;
+    return nullptr;
+}
+
+const char* PresetBank::check(const StoredPreset& stored) {
+    Preset scratch;
+    return compile(stored, scratch);
+}
+
+bool PresetBank::getStored(int slot, StoredPreset& out) const {
+    if (slot < 0 || slot >= PRESET_MAX || !_presets[slot].name[0]) return false;
+
+    const Preset& p = _presets[slot];
+    memset(&out, 0, sizeof(out));
+    strlcpy(out.name, p.name, sizeof(out.name));
+    strlcpy(out.targetIP, p.config.targetIP, sizeof(out.targetIP));
+    strlcpy(out.addressFormat, p.config.addressFormat, sizeof(out.addressFormat));
+    for (int i = 0; i < BOARD_BUTTONS; i++) out.channels[i] = p.config.channels[i];
+    return true;
+}
+
+void PresetBank::replaceAll(const StoredPreset* presets) {
+    int count = 0;
+    char key[4] = "p0";
+    _preferences.begin("presets", false);
+    for (int i = 0; i < PRESET_MAX; i++) {
+        key[1] = '0' + i;
+        if (presets[i].name[0] && !compile(presets[i], _presets[i])) {
+            _preferences.putBytes(key, &presets[i], sizeof(presets[i]));
+            count++;
+        } else {
+            _preferences.remove(key);
+            memset(&_presets[i], 0, sizeof(_presets[i]));
+        }
+    }
+    _preferences.end();
+
+    // The live settings were replaced too; no slot matches them for certain
+    _active = -1;
+    Serial.printf("Presets replaced: %d stored\n", count);
+    publish();
+}
+
+bool PresetBank::recall(int slot) {
+    if (slot < 0 || slot >= PRESET_MAX || !_presets[slot].name[0]) return false;
+
+    _oscManager->applyPreset(_presets[slot].config);
+    _active = slot;
+    _activeVersion = _oscManager->getConfigVersion();
+    Serial.printf("Preset %d \"%s\" active\n", slot + 1, _presets[slot].name);
+    publish();
+    return true;
+}
+
+bool PresetBank::recallNext() {
+    for (int n = 1; n <= PRESET_MAX; n++) {
+        int slot = (_active + n + PRESET_MAX) % PRESET_MAX;
+        if (_presets[slot].name[0]) return recall(slot);
+    }
+    return false;
+}
+
+int PresetBank::find(const char* name) const {
+    for (int i = 0; i < PRESET_MAX; i++) {
+        if (_presets[i].name[0] && strcmp(_presets[i].name, name) == 0) return i;
+    }
+    return -1;
+}
+
+const char* PresetBank::store(int slot, const char* name) {
+    if (slot < 0 || slot >= PRESET_MAX) return "No such slot";
+    if (!validName(name)) return "Name must be 1-23 letters, digits, spaces or _-.";
+
+    OSCConfig config;
+    _oscManager->getConfig(config);
+    StoredPreset stored;
+    memset(&stored, 0, sizeof(stored));
+    strlcpy(stored.name, name, sizeof(stored.name));
+    strlcpy(stored.targetIP, config.targetIP, sizeof(stored.targetIP));
+    strlcpy(stored.addressFormat, config.addressFormat, sizeof(stored.addressFormat));
+    for (int i = 0; i < BOARD_BUTTONS; i++) stored.channels[i] = config.channels[i];
+
+    const char* error = compile(stored, _presets[slot]);
+    if (error) return error;
+
+    char key[4] = "p0";
+    key[1] = '0' + slot;
+    _preferences.begin("presets", false);
+    _preferences.putBytes(key, &stored, sizeof(stored));
+    _preferences.end();
+
+    // Storing captures what is live, so the slot matches it
+    _active = slot;
+    _activeVersion = _oscManager->getConfigVersion();
+    Serial.printf("Preset %d \"%s\" stored\n", slot + 1, name);
+    publish();
+    return nullptr;
+}
+
+void PresetBank::clear(int slot) {
+    if (slot < 0 || slot >= PRESET_MAX || !_presets[slot].name[0]) return;
+
+    char key[4] = "p0";
+    key[1] = '0' + slot;
+    _preferences.begin("presets", false);
+    _preferences.remove(key);
+    _preferences.end();
+
+    Serial.printf("Preset %d \"%s\" removed\n", slot + 1, _presets[slot].name);
+    memset(&_presets[slot], 0, sizeof(_presets[slot]));
+    if (_active == slot) _active = -1;
+    publish();
+}
+
+int PresetBank::getActive() const {
+    return _active;
+}
+
+void PresetBank::publish() {
+    uint8_t stored = 0;
+    for (int i = 0; i < PRESET_MAX; i++) {
+        if (_presets[i].name[0]) stored |= 1 << i;
+    }
+    _storedSlots = stored;
+
+    String json = getJson();
+    if (_wifiManager) _wifiManager->getControlChannel().push("presets", json);
+    _json.set(std::move(json));
+}
+
+void PresetBank::loop() {
+    if (_requestedStore >= 0) {
+        char name[PRESET_NAME_MAX];
+        strlcpy(name, _requestedName, sizeof(name));
+        int slot = _requestedStore;
+        _requestedStore = -1;
+        const char* error = store(slot, name);
+        if (error) Serial.printf("Preset %d not stored: %s\n", slot + 1, error);
+    }
+    if (_requestedClear >= 0) {
+        int slot = _requestedClear;
+        _requestedClear = -1;
+        clear(slot);
+    }
+    if (_requestedRecall >= 0) {
+        int slot = _requestedRecall;
+        _requestedRecall = -1;
+        recall(slot);
+    }
+    if (_json.refreshRequested()) publish();
+}
+
+String PresetBank::getJson() const {
+    // Edited since the switch: the live settings no longer match the preset
+    bool modified = _active >= 0 && _oscManager->getConfigVersion() != _activeVersion;
+
+    String json = "{\"active\":" + String(_active + 1);
+    json += ",\"modified\":";
+    json += modified ? "true" : "false";
+    json += ",\"presets\":[";
+    bool first = true;
+    for (int i = 0; i < PRESET_MAX; i++) {
+        const Preset& p = _presets[i];
+        if (!p.name[0]) continue;
+        if (!first) json += ",";
+        first = false;
+        json += "{\"slot\":" + String(i + 1);
+        json += ",\"name\":\"" + String(p.name) + "\"";
+        json += ",\"targetip\":\"" + String(p.config.targetIP) + "\"";
+        json += ",\"addressFormat\":\"" + String(p.config.addressFormat) + "\"";
+        json += ",\"channels\":[";
+        for (int b = 0; b < BOARD_BUTTONS; b++) {
+            if (b > 0) json += ",";
+            json += String(p.config.channels[b]);
+        }
+        json += "]}";
+    }
+    json += "]}";
+    return json;
+}
+
+void PresetBank::registerActions() {
+    ControlChannel& control = _wifiManager->getControlChannel();
+
+    control.registerAction("presets.get", "/presets", HTTP_GET, [](const ControlRequest&) -> String {
+        return _presetInstance->_json.get();
+    });
+
+    // Switch (slot 1-8); applied by loop(), which owns the bank
+    control.registerAction("preset.recall", "/preset/recall", HTTP_POST, [](const ControlRequest& req) -> String {
+        int slot = req.hasParam("slot") ? req.getParam("slot").toInt() - 1 : -1;
+        if (slot < 0 || slot >= PRESET_MAX || !(_presetInstance->_storedSlots & (1 << slot))) {
+            return "{\"success\":false,\"message\":\"No preset in that slot\"}";
+        }
+        _presetInstance->_requestedRecall = slot;
+        return "{\"success\":true}";
+    });
+
+    // Store the current OSC settings as preset slot (1-8) under name
+    control.registerAction("preset.store", "/preset", HTTP_POST, [](const ControlRequest& req) -> String {
+        int slot = req.hasParam("slot") ? req.getParam("slot").toInt() - 1 : -1;
+        String name = req.hasParam("name") ? req.getParam("name") : String();
+        if (slot < 0 || slot >= PRESET_MAX) {
+            return "{\"success\":false,\"message\":\"Slot must be 1-8\"}";
+        }
+        name.trim();
+        if (!validName(name.c_str())) {
+            return "{\"success\":false,\"message\":\"Name must be 1-23 letters, digits, spaces or _-.\"}";
+        }
+        if (_presetInstance->_requestedStore >= 0) {
+            return "{\"success\":false,\"message\":\"Previous save still pending, try again\"}";
+        }
+        strlcpy(_presetInstance->_requestedName, name.c_str(), PRESET_NAME_MAX);
+        _presetInstance->_requestedStore = slot;
+        return "{\"success\":true}";
+    });
+
+    control.registerAction("preset.clear", "/preset/clear", HTTP_POST, [](const ControlRequest& req) -> String {
+        int slot = req.hasParam("slot") ? req.getParam("slot").toInt() - 1 : -1;
+        if (slot < 0 || slot >= PRESET_MAX) {
+            return "{\"success\":false,\"message\":\"Slot must be 1-8\"}";
+        }
+        _presetInstance->_requestedClear = slot;
+        return "{\"success\":true}";
+    });
+}
+
+// /muis/preset          -> reply "/muis/preset slot name" (0 "" = none)
+// /muis/preset i        -> switch to slot 1-8, then reply
+// /muis/preset s        -> switch to the preset with that name, then reply
+// /muis/preset/next     -> switch to the next stored preset, then reply
+void PresetBank::onPresetCommand(OSCMessage& msg) {
+    PresetBank* self = _presetInstance;
+    char address[24];
+    msg.getAddress(address, 0, sizeof(address));
+
+    if (strcmp(address, "/muis/preset/next") == 0) {
+        self->recallNext();
+    } else if (msg.isInt(0)) {
+        int slot = msg.getInt(0) - 1;
+        if (!self->recall(slot)) Serial.printf("Preset %d not stored\n", slot + 1);
+    } else if (msg.isString(0)) {
+        char name[PRESET_NAME_MAX];
+        msg.getString(0, name, sizeof(name));
+        if (!self->recall(self->find(name))) Serial.printf("Preset \"%s\" not found\n", name);
+    }
+
+    OSCMessage out("/muis/preset");
+    int active = self->_active;
+    out.add((int32_t)(active + 1));
+    out.add(active >= 0 ? self->_presets[active].name : "");
+    self->_oscManager->reply(out);
+}
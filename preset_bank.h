@@ -0,0 +1,111 @@
+// OSC-Muis - Niels van der Hulst 2026
+
+#ifndef PRESET_BANK_H
+#define PRESET_BANK_H
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include "osc_manager.h"
+#include "json_cache.h"
+
+class WiFiManager;
+class OSCMessage;
+
+#define PRESET_MAX 8
+#define PRESET_NAME_MAX 24            // Including terminator
+
+// Bank of named OSC presets (target, address template, button channels) for
+// switching between acts mid-show.
+//
+// Every preset is compiled into a complete OSCConfig at boot (or when it is
+// stored), so a switch only publishes the ready config through the OSC
+// settings snapshot: no flash access, no template parsing, no allocation.
+// The port is not part of a preset (the sockets stay bound to it), and a
+// switch is not written to flash — after a reboot the device starts with its
+// saved OSC settings.
+//
+// Presets are switched from the portal, with /muis/preset, or by holding
+// both buttons for 1-3 s (next preset). Everything that touches the bank
+// runs on the loop task; portal requests are queued for loop(), and the
+// portal reads the JSON loop() published (see json_cache.h).
+class PresetBank {
+public:
+    // What is stored in flash: the sources, compiled again at boot
+    struct StoredPreset {
+        char name[PRESET_NAME_MAX];
+        char targetIP[OSC_TARGET_IP_MAX];
+        char addressFormat[OSC_ADDRESS_FORMAT_MAX];
+        uint8_t channels[BOARD_BUTTONS];
+    };
+
+    PresetBank();
+
+    // Load and compile the stored presets, register /muis/preset (and portal
+    // actions unless headless)
+    void begin(OSCManager& oscManager, WiFiManager& wifiManager);
+
+    // Apply presets switched or stored from the portal (call from loop())
+    void loop();
+
+    // Switch to a preset. False if the slot is empty.
+    bool recall(int slot);
+
+    // Switch to the next stored preset after the active one (button gesture)
+    bool recallNext();
+
+    // Slot of a preset by name, or -1
+    int find(const char* name) const;
+
+    // Store the current OSC settings as a preset (persisted). Returns nullptr
+    // or a message.
+    const char* store(int slot, const char* name);
+
+    // Remove a preset (persisted)
+    void clear(int slot);
+
+    // Slot of the last switch, -1 if none since boot
+    int getActive() const;
+
+    // Presets and the active slot as JSON ("presets" event; loop task only,
+    // GET /presets serves the published copy)
+    String getJson() const;
+
+    // Sources of a stored preset. False if the slot is empty.
+    bool getStored(int slot, StoredPreset& out) const;
+
+    // Check a preset without storing it. Returns nullptr or a message.
+    static const char* check(const StoredPreset& stored);
+
+    // Replace the whole bank (fleet push): presets[PRESET_MAX], an empty name
+    // clears the slot. Every preset must have passed check().
+    void replaceAll(const StoredPreset* presets);
+
+private:
+    struct Preset {
+        char name[PRESET_NAME_MAX];   // Empty = unused slot
+        OSCConfig config;             // Ready to publish
+    };
+    Preset _presets[PRESET_MAX];
+    int _active;
+    uint32_t _activeVersion;          // OSC config version the switch published
+    JsonCache _json;                  // getJson() as last published
+    volatile uint8_t _storedSlots;    // Bit per stored preset, for the portal handlers
+
+    // Portal requests, applied by loop()
+    volatile int _requestedRecall;    // -1 = none
+    volatile int _requestedStore;     // -1 = none
+    char _requestedName[PRESET_NAME_MAX];
+    volatile int _requestedClear;     // -1 = none
+
+    OSCManager* _oscManager;
+    WiFiManager* _wifiManager;
+    Preferences _preferences;
+
+    static bool validName(const char* name);
+    static const char* compile(const StoredPreset& stored, Preset& out);
+    void publish();
+    void registerActions();
+    static void onPresetCommand(OSCMessage& msg);
+};
+
+#endif
@@ -0,0 +1,240 @@
+// OSC-Muis - Niels van der Hulst 2026
+
+#include "telemetry.h"
+#include "esp_system.h"
+#include "esp_rom_crc.h"
+
+Telemetry telemetry;
+
+// Not cleared at reset or by deep sleep; lost on power-off
+static RTC_NOINIT_ATTR Telemetry::Record rtcSlots[2];
+static RTC_NOINIT_ATTR uint32_t rtcPhase;
+
+// Phase word: the phase in the low byte, tagged so garbage after power-on
+// isn't read as a phase
+#define TELEMETRY_PHASE_TAG 0x50480000
+
+static const char* const PHASE_NAMES[LOOP_PHASE_COUNT] = {
+    "none", "setup", "wifi", "status", "gestures", "buttons", "macros", "presets",
+    "analog", "osc", "fleet", "diagnostics", "log", "idle", "restart", "sleep"
+};
+
+Telemetry::Telemetry() {
+    memset(&_record, 0, sizeof(_record));
+    memset(&_previous, 0, sizeof(_previous));
+    _hasPrevious = false;
+    _resetReason = ESP_RST_UNKNOWN;
+    _lastPhase = LOOP_PHASE_NONE;
+    _dirty = false;
+    _lastSeal = 0;
+    _wifiDown = false;
+    _wifiDownSince = 0;
+}
+
+void Telemetry::begin() {
+    _resetReason = esp_reset_reason();
+
+    // Newest slot that checks out
+    const Record* newest = nullptr;
+    for (int i = 0; i < 2; i++) {
+        const Record& slot = rtcSlots[i];
+        if (valid(slot) && (!newest || (int32_t)(slot.seq - newest->seq) > 0)) newest = &slot;
+    }
+
+    if (newest) {
+        _record = *newest;
+        _previous = _record.session;
+        _hasPrevious = true;
+        addCounters(_record.total, _record.session);
+        _record.boots++;
+        uint32_t phase = rtcPhase;
+        if ((phase & 0xFFFFFF00) == TELEMETRY_PHASE_TAG && (phase & 0xFF) < LOOP_PHASE_COUNT) {
+            _lastPhase = (LoopPhase)(phase & 0xFF);
+        }
+    } else {
+        memset(&_record, 0, sizeof(_record));
+        _record.magic = TELEMETRY_MAGIC;
+        _record.version = TELEMETRY_VERSION;
+        _record.size = sizeof(Record);
+        _record.boots = 1;
+    }
+    memset(&_record.session, 0, sizeof(_record.session));
+    phase(LOOP_PHASE_SETUP);
+    seal();
+
+    if (_hasPrevious) {
+        uint32_t presses = 0;
+        for (int i = 0; i < BOARD_BUTTONS; i++) presses += _previous.presses[i];
+        Serial.printf("Telemetry: boot %lu, reset: %s in phase %s\n",
+                      (unsigned long)_record.boots, getResetReasonName(), getLastPhaseName());
+        Serial.printf("Telemetry: last session %lu s, %lu presses, %lu send failures, worst press %lu us, "
+                      "worst loop %lu us, %lu WiFi outages (%lu ms)\n",
+                      (unsigned long)_previous.uptimeS, (unsigned long)presses,
+                      (unsigned long)_previous.sendFailures, (unsigned long)_previous.worstPressUs,
+                      (unsigned long)_previous.worstLoopUs, (unsigned long)_previous.wifiOutages,
+                      (unsigned long)_previous.wifiOutageMs);
+    } else {
+        Serial.printf("Telemetry: new journal (reset: %s)\n", getResetReasonName());
+    }
+}
+
+void Telemetry::phase(LoopPhase phase) {
+    rtcPhase = TELEMETRY_PHASE_TAG | phase;
+}
+
+void Telemetry::notePress(int index, uint32_t elapsedUs) {
+    if (index < 0 || index >= BOARD_BUTTONS) return;
+    _record.session.presses[index]++;
+    if (elapsedUs > _record.session.worstPressUs) _record.session.worstPressUs = elapsedUs;
+    _dirty = true;
+}
+
+void Telemetry::noteSendFailure() {
+    _record.session.sendFailures++;
+    _dirty = true;
+}
+
+void Telemetry::noteWiFiDown() {
+    if (_wifiDown) return;
+    _wifiDown = true;
+    _wifiDownSince = millis();
+}
+
+void Telemetry::noteWiFiUp() {
+    if (!_wifiDown) return;
+    _wifiDown = false;
+    uint32_t outageMs = millis() - _wifiDownSince;
+    TelemetryCounters& s = _record.session;
+    s.wifiOutages++;
+    s.wifiOutageMs += outageMs;
+    if (outageMs > s.worstOutageMs) s.worstOutageMs = outageMs;
+    _dirty = true;
+}
+
+void Telemetry::endPass(uint32_t elapsedUs) {
+    if (elapsedUs > _record.session.worstLoopUs) {
+        _record.session.worstLoopUs = elapsedUs;
+        _dirty = true;
+    }
+    if (_dirty || millis() - _lastSeal >= TELEMETRY_SEAL_MS) seal();
+    phase(LOOP_PHASE_IDLE);
+}
+
+void Telemetry::prepareReset(LoopPhase phase) {
+    seal();
+    this->phase(phase);
+}
+
+void Telemetry::seal() {
+    _record.session.uptimeS = millis() / 1000;
+    _record.seq++;
+
+    // Alternate slots; an outage still going on is counted up to now
+    Record& slot = rtcSlots[_record.seq & 1];
+    slot = _record;
+    if (_wifiDown) {
+        uint32_t outageMs = millis() - _wifiDownSince;
+        slot.session.wifiOutages++;
+        slot.session.wifiOutageMs += outageMs;
+        if (outageMs > slot.session.worstOutageMs) slot.session.worstOutageMs = outageMs;
+    }
+    slot.crc = checksum(slot);
+
+    _dirty = false;
+    _lastSeal = millis();
+}
+
+uint32_t Telemetry::checksum(const Record& record) {
+    return esp_rom_crc32_le(0, (const uint8_t*)&record, offsetof(Record, crc));
+}
+
+bool Telemetry::valid(const Record& record) {
+    return record.magic == TELEMETRY_MAGIC && record.version == TELEMETRY_VERSION &&
+           record.size == sizeof(Record) && record.crc == checksum(record);
+}
+
+void Telemetry::addCounters(TelemetryCounters& to, const TelemetryCounters& from) {
+    for (int i = 0; i < BOARD_BUTTONS; i++) to.presses[i] += from.presses[i];
+    to.sendFailures += from.sendFailures;
+    to.worstPressUs = max(to.worstPressUs, from.worstPressUs);
+    to.worstLoopUs = max(to.worstLoopUs, from.worstLoopUs);
+    to.wifiOutages += from.wifiOutages;
+    to.wifiOutageMs += from.wifiOutageMs;
+    to.worstOutageMs = max(to.worstOutageMs, from.worstOutageMs);
+    to.uptimeS += from.uptimeS;
+}
+
+bool Telemetry::hasPrevious() const {
+    return _hasPrevious;
+}
+
+const TelemetryCounters& Telemetry::getPrevious() const {
+    return _previous;
+}
+
+uint32_t Telemetry::getBootCount() const {
+    return _record.boots;
+}
+
+const char* Telemetry::getResetReasonName() const {
+    switch (_resetReason) {
+        case ESP_RST_POWERON:   return "power-on";
+        case ESP_RST_EXT:       return "external";
+        case ESP_RST_SW:        return "reboot";
+        case ESP_RST_PANIC:     return "crash";
+        case ESP_RST_INT_WDT:   return "interrupt watchdog";
+        case ESP_RST_TASK_WDT:  return "task watchdog";
+        case ESP_RST_WDT:       return "watchdog";
+        case ESP_RST_DEEPSLEEP: return "deep sleep";
+        case ESP_RST_BROWNOUT:  return "brownout";
+        case ESP_RST_USB:       return "usb";
+        default:                return "unknown";
+    }
+}
+
+const char* Telemetry::getLastPhaseName() const {
+    return phaseName(_lastPhase);
+}
+
+const char* Telemetry::phaseName(LoopPhase phase) {
+    return phase < LOOP_PHASE_COUNT ? PHASE_NAMES[phase] : "unknown";
+}
+
+void Telemetry::countersJson(String& json, const TelemetryCounters& c) {
+    json += "{\"presses\":[";
+    for (int i = 0; i < BOARD_BUTTONS; i++) {
+        if (i > 0) json += ",";
+        json += String(c.presses[i]);
+    }
+    json += "],\"sendFailures\":" + String(c.sendFailures);
+    json += ",\"worstPressUs\":" + String(c.worstPressUs);
+    json += ",\"worstLoopUs\":" + String(c.worstLoopUs);
+    json += ",\"wifiOutages\":" + String(c.wifiOutages);
+    json += ",\"wifiOutageMs\":" + String(c.wifiOutageMs);
+    json += ",\"worstOutageMs\":" + String(c.worstOutageMs);
+    json += ",\"uptimeS\":" + String(c.uptimeS);
+    json += "}";
+}
+
+String Telemetry::getJson() const {
+    TelemetryCounters session = _record.session;
+    session.uptimeS = millis() / 1000;
+    TelemetryCounters total = _record.total;
+    addCounters(total, session);
+
+    String json = "{\"boots\":" + String(_record.boots);
+    json += ",\"reset\":\"" + String(getResetReasonName()) + "\"";
+    json += ",\"lastPhase\":\"" + String(getLastPhaseName()) + "\"";
+    json += ",\"previous\":";
+    if (_hasPrevious) {
+        countersJson(json, _previous);
+    } else {
+        json += "null";
+    }
+    json += ",\"session\":";
+    countersJson(json, session);
+    json += ",\"total\":";
+    countersJson(json, total);
+    json += "}";
+    return json;
+}
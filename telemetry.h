@@ -0,0 +1,132 @@
+// OSC-Muis - Niels van der Hulst 2026
+
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <Arduino.h>
+#include "board_profile.h"
+
+#define TELEMETRY_MAGIC 0x4D554954    // "MUIT"
+#define TELEMETRY_VERSION 1
+#define TELEMETRY_SEAL_MS 1000        // Uptime (and an ongoing outage) written at least this often
+
+// Where loop() was (last phase before a crash or watchdog reset)
+enum LoopPhase : uint8_t {
+    LOOP_PHASE_NONE,
+    LOOP_PHASE_SETUP,
+    LOOP_PHASE_WIFI,          // WiFi manager, ARP keeper
+    LOOP_PHASE_STATUS,        // Battery, SSE, OSCQuery
+    LOOP_PHASE_GESTURES,      // Both-buttons hold
+    LOOP_PHASE_BUTTONS,       // Press path
+    LOOP_PHASE_MACROS,
+    LOOP_PHASE_PRESETS,
+    LOOP_PHASE_ANALOG,
+    LOOP_PHASE_OSC,           // Routing table, incoming commands, power governor
+    LOOP_PHASE_FLEET,         // Presence, configuration push
+    LOOP_PHASE_DIAGNOSTICS,   // Test message, latency bench
+    LOOP_PHASE_LOG,
+    LOOP_PHASE_IDLE,          // Between passes
+    LOOP_PHASE_RESTART,       // Deliberate reboot (gesture, headless switch)
+    LOOP_PHASE_SLEEP,         // Deep sleep
+    LOOP_PHASE_COUNT
+};
+
+// Counters of one session (boot to reset or deep sleep)
+struct TelemetryCounters {
+    uint32_t presses[BOARD_BUTTONS];
+    uint32_t sendFailures;        // Packets not handed to the network (per interface)
+    uint32_t worstPressUs;        // Press taken to packets sent, macros included
+    uint32_t worstLoopUs;         // Longest loop() pass
+    uint32_t wifiOutages;         // Link losses and roams
+    uint32_t wifiOutageMs;
+    uint32_t worstOutageMs;
+    uint32_t uptimeS;
+};
+
+// Telemetry journal in RTC memory: survives reboots (the hold-both-buttons
+// gesture, a crash, a watchdog reset) and deep sleep, so what happened
+// during a show can be read from the portal on the next boot.
+//
+// The counters are updated in plain RAM (an increment and a flag, no I/O).
+// Once per loop() pass, if something changed, or at least every
+// TELEMETRY_SEAL_MS, the record is copied to one of two CRC-protected RTC
+// slots, alternating: a reset in the middle of a copy still leaves the
+// other one intact. A crash loses at most the pass it happened in.
+//
+// The loop phase is a separate RTC word, written directly at each phase
+// change (one store), so it names the phase a crash or watchdog reset hit.
+// Crashes in other tasks (web server, lwIP) show the phase loop() was in.
+//
+// At boot the last session becomes "previous" and is added to the totals
+// since power-on. A power cycle (or a brownout that corrupts RTC memory)
+// fails the CRC and starts over. Updated from the loop task only; the
+// portal reads a copy from the web server's task (word-sized fields).
+class Telemetry {
+public:
+    // Layout of an RTC slot
+    struct Record {
+        uint32_t magic;
+        uint16_t version;
+        uint16_t size;
+        uint32_t seq;                 // Newest valid slot wins
+        uint32_t boots;
+        TelemetryCounters total;      // Sessions before this one
+        TelemetryCounters session;
+        uint32_t crc;                 // Over everything above
+    };
+
+    Telemetry();
+
+    // Restore the journal and start a new session (call early in setup())
+    void begin();
+
+    // Mark the phase loop() is entering
+    void phase(LoopPhase phase);
+
+    // Hot-path counters
+    void notePress(int index, uint32_t elapsedUs);
+    void noteSendFailure();
+
+    // Station link lost / back (idempotent; the first connect isn't an outage)
+    void noteWiFiDown();
+    void noteWiFiUp();
+
+    // End of a loop() pass: worst pass time, seal when due
+    void endPass(uint32_t elapsedUs);
+
+    // Seal now and mark the phase (before ESP.restart() or deep sleep)
+    void prepareReset(LoopPhase phase);
+
+    bool hasPrevious() const;
+    const TelemetryCounters& getPrevious() const;
+    uint32_t getBootCount() const;
+    const char* getResetReasonName() const;
+    const char* getLastPhaseName() const;
+
+    // Previous session, this one and the totals since power-on as JSON
+    // (GET /telemetry)
+    String getJson() const;
+
+    static const char* phaseName(LoopPhase phase);
+
+private:
+    Record _record;                   // Working copy
+    TelemetryCounters _previous;
+    bool _hasPrevious;
+    int _resetReason;
+    LoopPhase _lastPhase;
+    bool _dirty;
+    unsigned long _lastSeal;
+    bool _wifiDown;
+    unsigned long _wifiDownSince;
+
+    void seal();
+    static uint32_t checksum(const Record& record);
+    static bool valid(const Record& record);
+    static void addCounters(TelemetryCounters& to, const TelemetryCounters& from);
+    static void countersJson(String& json, const TelemetryCounters& counters);
+};
+
+extern Telemetry telemetry;
+
+#endif
@@ -0,0 +1,36 @@
+// OSC-Muis - Niels van der Hulst 2026
+//
+// Minimal checks for the host tests: failures are counted and printed, and
+// the test's exit status is hostTestResult().
+
+#ifndef HOST_TEST_H
+#define HOST_TEST_H
+
+#include <stdio.h>
+
+inline int hostFailures = 0;
+inline int hostChecks = 0;
+
+#define CHECK(cond) do { \
+    hostChecks++; \
+    if (!(cond)) { \
+        printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+        hostFailures++; \
+    } \
+} while (0)
+
+#define CHECK_EQ(actual, expected) do { \
+    hostChecks++; \
+    long long _a = (long long)(actual), _e = (long long)(expected); \
+    if (_a != _e) { \
+        printf("%s:%d: CHECK_EQ(%s, %s) failed: %lld != %lld\n", __FILE__, __LINE__, #actual, #expected, _a, _e); \
+        hostFailures++; \
+    } \
+} while (0)
+
+inline int hostTestResult(const char* name) {
+    printf("%s: %d checks, %d failed\n", name, hostChecks, hostFailures);
+    return hostFailures == 0 ? 0 : 1;
+}
+
+#endif
@@ -0,0 +1,149 @@
+// OSC-Muis - Niels van der Hulst 2026
+//
+// Host stand-in for the parts of the Arduino core the tested modules use.
+// Time is simulated: millis()/micros() return hostTimeUs, which the tests
+// advance with hostAdvanceMs()/hostAdvanceUs().
+
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <math.h>
+#include <ctype.h>
+#include <string>
+#include <algorithm>
+#include <mutex>
+#include <deque>
+#include <signal.h>
+#include <pthread.h>
+
+#define IRAM_ATTR
+#define PROGMEM
+#define RTC_NOINIT_ATTR
+#define RTC_DATA_ATTR
+
+#define LOW 0
+#define HIGH 1
+#define INPUT 1
+#define OUTPUT 3
+#define INPUT_PULLUP 5
+#define INPUT_PULLDOWN 9
+#define FALLING 2
+#define RISING 1
+#define OUTPUT_OPEN_DRAIN 0x12
+
+// XIAO ESP32-C3 pin names (GPIO numbers)
+enum { D0 = 2, D1 = 3, D2 = 4, D3 = 5, D4 = 6, D5 = 7, D6 = 21, D7 = 20, D8 = 8, D9 = 9, D10 = 10, A0 = 2 };
+
+using std::min;
+using std::max;
+
+// Simulated clock
+inline uint64_t hostTimeUs = 0;
+inline unsigned long millis() { return (unsigned long)(hostTimeUs / 1000); }
+inline unsigned long micros() { return (unsigned long)hostTimeUs; }
+inline void hostAdvanceUs(uint64_t us) { hostTimeUs += us; }
+inline void hostAdvanceMs(uint64_t ms) { hostTimeUs += ms * 1000; }
+inline void delay(uint32_t ms) { hostAdvanceMs(ms); }
+inline void delayMicroseconds(uint32_t us) { hostAdvanceUs(us); }
+inline void yield() {}
+
+inline size_t strlcpy(char* dst, const char* src, size_t size) {
+    size_t len = strlen(src);
+    if (size > 0) {
+        size_t n = len < size - 1 ? len : size - 1;
+        memcpy(dst, src, n);
+        dst[n] = '\0';
+    }
+    return len;
+}
+
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t b) = 0;
+    virtual size_t write(const uint8_t* data, size_t len) {
+        size_t n = 0;
+        while (len--) n += write(*data++);
+        return n;
+    }
+};
+
+// FreeRTOS: tasks are host threads, mutexes are std::mutex, and the
+// critical sections of one core are one process-wide lock
+typedef void* TaskHandle_t;
+typedef std::mutex* SemaphoreHandle_t;
+typedef uint32_t TickType_t;
+typedef int portMUX_TYPE;
+#define portMAX_DELAY 0xFFFFFFFFUL
+#define portMUX_INITIALIZER_UNLOCKED 0
+inline std::recursive_mutex hostCriticalLock;
+#define portENTER_CRITICAL(mux) ((void)(mux), hostCriticalLock.lock())
+#define portEXIT_CRITICAL(mux) ((void)(mux), hostCriticalLock.unlock())
+inline TaskHandle_t xTaskGetCurrentTaskHandle() {
+    static thread_local char task;
+    return &task;
+}
+// Scheduler suspension blocks HOST_PREEMPT_SIGNAL, which the tests send a
+// thread to run a higher-priority "task" in its signal handler — preemption
+// on one core, at an arbitrary instruction
+#define HOST_PREEMPT_SIGNAL SIGUSR1
+inline thread_local int hostSuspendDepth = 0;
+inline void hostMaskPreempt(int how) {
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, HOST_PREEMPT_SIGNAL);
+    pthread_sigmask(how, &set, nullptr);
+}
+inline void vTaskSuspendAll() {
+    if (hostSuspendDepth++ == 0) hostMaskPreempt(SIG_BLOCK);
+}
+inline long xTaskResumeAll() {
+    if (--hostSuspendDepth == 0) hostMaskPreempt(SIG_UNBLOCK);
+    return 0;
+}
+inline std::deque<std::mutex> hostMutexes;   // Never deleted, as on the device
+inline SemaphoreHandle_t xSemaphoreCreateMutex() { return &hostMutexes.emplace_back(); }
+inline int xSemaphoreTake(SemaphoreHandle_t mutex, TickType_t) { mutex->lock(); return 1; }
+inline int xSemaphoreGive(SemaphoreHandle_t mutex) { mutex->unlock(); return 1; }
+
+class IPAddress {
+public:
+    IPAddress() : _addr(0) {}
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d)
+        : _addr((uint32_t)a | ((uint32_t)b << 8) | ((uint32_t)c << 16) | ((uint32_t)d << 24)) {}
+    IPAddress(uint32_t addr) : _addr(addr) {}
+    operator uint32_t() const { return _addr; }
+    uint8_t operator[](int i) const { return (_addr >> (8 * i)) & 0xFF; }
+    bool operator==(const IPAddress& other) const { return _addr == other._addr; }
+    bool operator!=(const IPAddress& other) const { return _addr != other._addr; }
+
+private:
+    uint32_t _addr;   // Network order, as on the ESP32
+};
+
+// Serial goes to stdout, quietly unless HOST_VERBOSE is set
+class HostSerial {
+public:
+    size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3))) {
+        if (!getenv("HOST_VERBOSE")) return 0;
+        va_list args;
+        va_start(args, format);
+        int n = vprintf(format, args);
+        va_end(args);
+        return n > 0 ? n : 0;
+    }
+    size_t print(const char* text) { return printf("%s", text); }
+    size_t println(const char* text = "") { return printf("%s\n", text); }
+    size_t write(const uint8_t* data, size_t len) { return printf("%.*s", (int)len, (const char*)data); }
+    int availableForWrite() { return 256; }
+    void flush() {}
+};
+inline HostSerial Serial;
+
+#endif
@@ -0,0 +1,27 @@
+// OSC-Muis - Niels van der Hulst 2026
+//
+// Host stand-in for AsyncUDP: no sockets, the tests call the module's
+// packet handling directly.
+
+#ifndef HOST_ASYNC_UDP_H
+#define HOST_ASYNC_UDP_H
+
+#include <Arduino.h>
+#include <functional>
+
+class AsyncUDPPacket {
+public:
+    uint8_t* data() { return nullptr; }
+    size_t length() { return 0; }
+    IPAddress remoteIP() { return IPAddress(); }
+    size_t write(const uint8_t*, size_t len) { return len; }
+};
+
+class AsyncUDP {
+public:
+    bool listen(uint16_t) { return true; }
+    void onPacket(std::function<void(AsyncUDPPacket&)>) {}
+    void close() {}
+};
+
+#endif
@@ -0,0 +1,24 @@
+// OSC-Muis - Niels van der Hulst 2026
+//
+// Host stand-in for the few ESPAsyncWebServer types the tested modules
+// hold: no server, no clients.
+
+#ifndef HOST_ESP_ASYNC_WEB_SERVER_H
+#define HOST_ESP_ASYNC_WEB_SERVER_H
+
+#include <Arduino.h>
+
+class AsyncEventSource {
+public:
+    explicit AsyncEventSource(const char*) {}
+    size_t count() const { return 0; }
+    size_t avgPacketsWaiting() const { return 0; }
+    void send(const char*, const char*, uint32_t, uint32_t = 0) {}
+};
+
+class AsyncWebServer {
+public:
+    void addHandler(AsyncEventSource*) {}
+};
+
+#endif
@@ -0,0 +1,18 @@
+// OSC-Muis - Niels van der Hulst 2026
+
+#ifndef HOST_ESP_ROM_SYS_H
+#define HOST_ESP_ROM_SYS_H
+
+#include <stdio.h>
+#include <stdarg.h>
+
+// Unbuffered, so it never allocates (safe inside the audit's wrappers)
+static inline int esp_rom_printf(const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    int n = vfprintf(stderr, format, args);
+    va_end(args);
+    return n;
+}
+
+#endif
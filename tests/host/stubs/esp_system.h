@@ -0,0 +1,14 @@
+// OSC-Muis - Niels van der Hulst 2026
+
+#ifndef HOST_ESP_SYSTEM_H
+#define HOST_ESP_SYSTEM_H
+
+typedef enum {
+    ESP_RST_UNKNOWN, ESP_RST_POWERON, ESP_RST_EXT, ESP_RST_SW, ESP_RST_PANIC, ESP_RST_INT_WDT,
+    ESP_RST_TASK_WDT, ESP_RST_WDT, ESP_RST_DEEPSLEEP, ESP_RST_BROWNOUT, ESP_RST_SDIO, ESP_RST_USB
+} esp_reset_reason_t;
+
+inline esp_reset_reason_t hostResetReason = ESP_RST_POWERON;
+inline esp_reset_reason_t esp_reset_reason() { return hostResetReason; }
+
+#endif
@@ -0,0 +1,14 @@
+// OSC-Muis - Niels van der Hulst 2026
+
+#ifndef HOST_ESP_TIMER_H
+#define HOST_ESP_TIMER_H
+
+#include <Arduino.h>
+
+// Types only: the tests feed the scanners' plain-data parts directly
+typedef struct esp_timer* esp_timer_handle_t;
+typedef void (*esp_timer_cb_t)(void* arg);
+
+inline int64_t esp_timer_get_time() { return (int64_t)hostTimeUs; }
+
+#endif
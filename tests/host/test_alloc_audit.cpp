@@ -0,0 +1,149 @@
+// OSC-Muis - Niels van der Hulst 2026
+//
+// Allocation audit: links the --wrap shims from alloc_audit.cpp (built
+// without sanitizers, which replace malloc themselves) and runs the
+// hardware-independent part of the press path — config snapshot copy,
+// compiled template encode, address formatting, deferred log line — inside
+// ALLOC_AUDIT_CRITICAL, then an armed loop() pass draining the log ring.
+// Any allocation there fails the test; an allocation in a critical scope
+// must abort, as on the device.
+
+#include "host_test.h"
+#include "alloc_audit.h"
+#include "config_snapshot.h"
+#include "osc_template.h"
+#include "osc_socket.h"
+#include "log_ring.h"
+#include <sys/wait.h>
+#include <unistd.h>
+#include <signal.h>
+#include <thread>
+#include <atomic>
+
+#ifndef OSC_MUIS_ALLOC_AUDIT
+#error "Build with -DOSC_MUIS_ALLOC_AUDIT and the --wrap linker flags (see Makefile)"
+#endif
+
+TaskHandle_t loopTaskHandle;
+
+// Keeps the compiler from eliding an allocation/free pair
+static void* volatile sink;
+
+// OSCSocket's packet buffer without the socket
+class PacketBuffer : public Print {
+public:
+    void begin() { _length = 0; }
+    size_t write(uint8_t b) override {
+        if (_length >= sizeof(_data)) return 0;
+        _data[_length++] = b;
+        return 1;
+    }
+    size_t write(const uint8_t* data, size_t len) override {
+        size_t n = 0;
+        while (n < len && write(data[n])) n++;
+        return n;
+    }
+    size_t length() const { return _length; }
+
+private:
+    uint8_t _data[OSC_SOCKET_BUFFER_SIZE];
+    size_t _length = 0;
+};
+
+struct PressConfig {
+    OSCTemplate program;
+    int channels[4];
+    bool addressPrefix;
+};
+
+static void testShimCounts() {
+    allocAuditArm();
+    CHECK_EQ(allocAuditCount(), 0);
+
+    // Loop task, armed: counted (logged, not fatal)
+    sink = malloc(24);
+    free(sink);
+    sink = new int[4];
+    delete[] (int*)sink;
+    CHECK_EQ(allocAuditCount(), 2);
+
+    // Other tasks aren't ours to police (starting the thread allocates on
+    // this one, so count from after that)
+    std::atomic<bool> go(false);
+    std::thread other([&go] {
+        while (!go) {}
+        sink = malloc(24);
+        free(sink);
+    });
+    uint32_t before = allocAuditCount();
+    go = true;
+    other.join();
+    CHECK_EQ(allocAuditCount(), before);
+}
+
+static void testCriticalAborts() {
+    fflush(stdout);
+    pid_t child = fork();
+    if (child == 0) {
+        loopTaskHandle = xTaskGetCurrentTaskHandle();
+        allocAuditArm();
+        ALLOC_AUDIT_CRITICAL("test");
+        sink = malloc(16);
+        _exit(0);
+    }
+    int status = 0;
+    waitpid(child, &status, 0);
+    CHECK(WIFSIGNALED(status));
+    CHECK_EQ(WIFSIGNALED(status) ? WTERMSIG(status) : 0, SIGABRT);
+}
+
+static void testPressPath() {
+    ConfigSnapshot<PressConfig> config;
+    PressConfig initial = {};
+    CHECK(initial.program.compile("/cue/{ch}/go ,i{btn} ,f{value} ,s{device}") == nullptr);
+    for (int i = 0; i < 4; i++) initial.channels[i] = i + 1;
+    initial.addressPrefix = true;
+    config.begin(initial);
+
+    PacketBuffer packet;
+    char deviceName[OSC_DEVICE_NAME_MAX] = "OSC-Muis-a1b2c3";
+    char prefix[OSC_ADDRESS_PREFIX_MAX] = "/a1b2c3";
+
+    allocAuditArm();
+    for (int press = 0; press < 200; press++) {
+        int button = press % 4 + 1;
+        {
+            ALLOC_AUDIT_CRITICAL("button path");
+            PressConfig current;
+            config.read(current);
+
+            OSCTemplateContext ctx;
+            ctx.channel = current.channels[button - 1];
+            ctx.button = button;
+            ctx.device = deviceName;
+            ctx.value = 1.0f;
+            ctx.prefix = current.addressPrefix ? prefix : "";
+
+            packet.begin();
+            current.program.encode(packet, ctx);
+            char address[64];
+            current.program.formatAddress(ctx, address, sizeof(address));
+            LOG_INFO_TEXT(address, "OSC sent: %s (btn%d->ch%d) -> %u.%u.%u.%u:%d via %s",
+                button, ctx.channel, 192u, 168u, 1u, 20u, 8001, "sta");
+        }
+        CHECK(packet.length() > 0 && packet.length() <= initial.program.maxEncodedSize);
+
+        // The rest of an armed loop() pass
+        logRing.loop();
+        hostAdvanceMs(5);
+    }
+    CHECK_EQ(allocAuditCount(), 0);
+}
+
+int main() {
+    loopTaskHandle = xTaskGetCurrentTaskHandle();
+    testShimCounts();
+    testCriticalAborts();
+    testPressPath();
+    return hostTestResult("alloc_audit");
+}
@@ -0,0 +1,195 @@
+// OSC-Muis - Niels van der Hulst 2026
+//
+// Captive DNS: replays the query bursts phones send on joining the AP (A,
+// AAAA and HTTPS probes with and without EDNS), malformed and over-long
+// names, and rate-limit bucket exhaustion through CaptiveDNS::respond().
+
+#include "host_test.h"
+#include "captive_dns.h"
+#include <vector>
+
+static const IPAddress AP_IP(192, 168, 4, 1);
+
+// Query as a phone sends it: id, RD set, one question, optional EDNS OPT
+static std::vector<uint8_t> query(uint16_t id, const char* name, uint16_t qtype, bool edns = false) {
+    std::vector<uint8_t> q = { (uint8_t)(id >> 8), (uint8_t)id, 0x01, 0x00, 0, 1, 0, 0, 0, 0, 0, (uint8_t)(edns ? 1 : 0) };
+    const char* label = name;
+    while (*label) {
+        const char* dot = strchr(label, '.');
+        size_t len = dot ? (size_t)(dot - label) : strlen(label);
+        q.push_back((uint8_t)len);
+        q.insert(q.end(), label, label + len);
+        label += len + (dot ? 1 : 0);
+    }
+    q.push_back(0);
+    q.insert(q.end(), { (uint8_t)(qtype >> 8), (uint8_t)qtype, 0x00, 0x01 });
+    if (edns) q.insert(q.end(), { 0x00, 0x00, 0x29, 0x05, 0xC0, 0, 0, 0, 0, 0x00, 0x00 });
+    return q;
+}
+
+static size_t ask(CaptiveDNS& dns, const std::vector<uint8_t>& q, uint32_t client, uint8_t* resp) {
+    return dns.respond(q.data(), q.size(), client, resp);
+}
+
+static size_t questionEnd(const std::vector<uint8_t>& q) {
+    size_t pos = 12;
+    while (q[pos]) pos += q[pos] + 1;
+    return pos + 5;
+}
+
+static void testCapturedProbes() {
+    CaptiveDNS dns;
+    dns.setAnswerIP(AP_IP);
+    uint8_t resp[CAPTIVE_DNS_MAX_PACKET];
+
+    // Android connectivity check (A), captured: id 0x3a1f, RD
+    const uint8_t android[] = {
+        0x3a, 0x1f, 0x01, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x11, 'c', 'o', 'n', 'n', 'e', 'c', 't', 'i', 'v', 'i', 't', 'y', 'c', 'h', 'e', 'c', 'k',
+        0x07, 'g', 's', 't', 'a', 't', 'i', 'c', 0x03, 'c', 'o', 'm', 0x00,
+        0x00, 0x01, 0x00, 0x01
+    };
+    size_t n = dns.respond(android, sizeof(android), 0x0A04A8C0, resp);
+    CHECK_EQ(n, sizeof(android) + 16);
+    CHECK(memcmp(resp, android, 2) == 0);                 // ID echoed
+    CHECK_EQ(resp[2], 0x85);                              // QR, AA, RD kept
+    CHECK_EQ(resp[3], 0x00);                              // NOERROR
+    CHECK_EQ(resp[7], 1);                                 // one answer
+    CHECK(memcmp(resp + 12, android + 12, sizeof(android) - 12) == 0);
+    const uint8_t* answer = resp + sizeof(android);
+    CHECK_EQ(answer[0], 0xC0);                            // name: pointer to the question
+    CHECK_EQ(answer[1], 12);
+    CHECK_EQ(answer[3], 1);                               // type A
+    CHECK_EQ(answer[11], 4);                              // RDLENGTH
+    CHECK(answer[12] == 192 && answer[13] == 168 && answer[14] == 4 && answer[15] == 1);
+
+    // iOS (A + AAAA + HTTPS, with EDNS): the OPT record is dropped, AAAA and
+    // HTTPS get an empty NOERROR answer
+    std::vector<uint8_t> a = query(0x1001, "captive.apple.com", 1, true);
+    n = ask(dns, a, 0x0B04A8C0, resp);
+    CHECK_EQ(n, questionEnd(a) + 16);
+    CHECK_EQ(resp[11], 0);                                // ARCOUNT: OPT dropped
+    for (uint16_t type : { (uint16_t)28, (uint16_t)65 }) {
+        std::vector<uint8_t> q = query(0x1002, "captive.apple.com", type, true);
+        n = ask(dns, q, 0x0B04A8C0, resp);
+        CHECK_EQ(n, questionEnd(q));
+        CHECK_EQ(resp[7], 0);                             // no answer
+        CHECK_EQ(resp[3], 0x00);                          // NOERROR, so the client falls back to A
+    }
+    CHECK_EQ(dns.getAnsweredCount(), 4);
+    CHECK_EQ(dns.getMalformedCount(), 0);
+}
+
+static void testMalformed() {
+    CaptiveDNS dns;
+    dns.setAnswerIP(AP_IP);
+    uint8_t resp[CAPTIVE_DNS_MAX_PACKET];
+    uint32_t malformed = 0;
+
+    std::vector<uint8_t> good = query(7, "example.com", 1);
+
+    // Truncated anywhere: header only, inside the name, inside type/class
+    for (size_t len : { (size_t)0, (size_t)5, (size_t)12, (size_t)16, good.size() - 3, good.size() - 1 }) {
+        CHECK_EQ(dns.respond(good.data(), len, 1, resp), 0);
+        CHECK_EQ(dns.getMalformedCount(), ++malformed);
+    }
+
+    // A label length that runs past the end
+    std::vector<uint8_t> runaway = good;
+    runaway[12] = 60;
+    CHECK_EQ(ask(dns, runaway, 1, resp), 0);
+    CHECK_EQ(dns.getMalformedCount(), ++malformed);
+
+    // Compression pointer in the question
+    std::vector<uint8_t> pointer = good;
+    pointer[12] = 0xC0;
+    CHECK_EQ(ask(dns, pointer, 1, resp), 0);
+    CHECK_EQ(dns.getMalformedCount(), ++malformed);
+
+    // A response, a non-query opcode, two questions
+    std::vector<uint8_t> response = good;
+    response[2] |= 0x80;
+    std::vector<uint8_t> opcode = good;
+    opcode[2] |= 0x28;
+    std::vector<uint8_t> two = good;
+    two[5] = 2;
+    for (auto* q : { &response, &opcode, &two }) {
+        CHECK_EQ(ask(dns, *q, 1, resp), 0);
+        CHECK_EQ(dns.getMalformedCount(), ++malformed);
+    }
+
+    // Names: 255 bytes encoded is the limit, one more is refused
+    std::string name = std::string(63, 'a') + "." + std::string(63, 'b') + "." +
+                       std::string(63, 'c') + "." + std::string(61, 'd');  // 253 characters = 255 encoded
+    std::vector<uint8_t> longest = query(8, name.c_str(), 1);
+    CHECK_EQ(questionEnd(longest) - 4 - 12, 255);
+    CHECK_EQ(ask(dns, longest, 1, resp), questionEnd(longest) + 16);
+
+    std::vector<uint8_t> tooLong = query(9, (name + "b").c_str(), 1);
+    CHECK_EQ(ask(dns, tooLong, 1, resp), 0);
+    CHECK_EQ(dns.getMalformedCount(), ++malformed);
+
+    // Far over any limit: a 500-byte name of 63-byte labels
+    std::string huge;
+    while (huge.size() < 500) huge += std::string(63, 'x') + ".";
+    huge.pop_back();
+    std::vector<uint8_t> hugeQuery = query(10, huge.c_str(), 1);
+    CHECK_EQ(ask(dns, hugeQuery, 1, resp), 0);
+    CHECK_EQ(dns.getMalformedCount(), ++malformed);
+
+    // Malformed queries don't use up a client's tokens
+    CHECK_EQ(dns.getRateLimitedCount(), 0);
+}
+
+static void testBuckets() {
+    CaptiveDNS dns;
+    dns.setAnswerIP(AP_IP);
+    uint8_t resp[CAPTIVE_DNS_MAX_PACKET];
+    hostTimeUs = 5000000;
+
+    // Four phones join at once, each firing a burst of probes within 1 ms:
+    // every query up to the burst size is answered
+    for (int i = 0; i < CAPTIVE_DNS_BURST; i++) {
+        for (uint32_t phone = 1; phone <= 4; phone++) {
+            std::vector<uint8_t> q = query((uint16_t)i, i % 2 ? "www.msftconnecttest.com" : "clients3.google.com",
+                                           i % 3 ? 1 : 28);
+            CHECK(ask(dns, q, phone, resp) > 0);
+        }
+    }
+    CHECK_EQ(dns.getAnsweredCount(), 4 * CAPTIVE_DNS_BURST);
+    CHECK_EQ(dns.getRateLimitedCount(), 0);
+
+    // Bucket exhausted: a probe loop on phone 1 is dropped...
+    std::vector<uint8_t> q = query(99, "example.com", 1);
+    for (int i = 0; i < 10; i++) CHECK_EQ(ask(dns, q, 1, resp), 0);
+    CHECK_EQ(dns.getRateLimitedCount(), 10);
+    // ...while a new client is still answered
+    CHECK(ask(dns, q, 5, resp) > 0);
+
+    // Refill at CAPTIVE_DNS_RATE_PER_S
+    hostAdvanceMs(1000);
+    int answered = 0;
+    for (int i = 0; i < CAPTIVE_DNS_BURST; i++) {
+        if (ask(dns, q, 1, resp) > 0) answered++;
+    }
+    CHECK_EQ(answered, CAPTIVE_DNS_RATE_PER_S);
+
+    // More clients than buckets: the least recently refilled bucket is
+    // recycled, and the newcomer starts with a full burst
+    for (uint32_t client = 10; client < 10 + CAPTIVE_DNS_MAX_CLIENTS; client++) {
+        hostAdvanceMs(1);
+        CHECK(ask(dns, q, client, resp) > 0);
+    }
+    answered = 0;
+    for (int i = 0; i < CAPTIVE_DNS_BURST + 4; i++) {
+        if (ask(dns, q, 100, resp) > 0) answered++;
+    }
+    CHECK_EQ(answered, CAPTIVE_DNS_BURST);
+}
+
+int main() {
+    testCapturedProbes();
+    testMalformed();
+    testBuckets();
+    return hostTestResult("captive_dns");
+}
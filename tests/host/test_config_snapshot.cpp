@@ -0,0 +1,143 @@
+// OSC-Muis - Niels van der Hulst 2026
+//
+// ConfigSnapshot under threads: concurrent writers and readers never see a
+// torn config, and a reader that preempts a writer mid-publish (the AsyncTCP
+// task reading while loop() saves, on one core) completes instead of
+// spinning. Preemption is a signal to the writer thread whose handler does
+// the read; a hung reader fails the test by timeout.
+
+#include "host_test.h"
+#include "config_snapshot.h"
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include <semaphore.h>
+
+#define WORDS 64                      // Big enough that a copy is several stores
+
+struct Payload {
+    uint32_t words[WORDS];
+};
+
+static bool consistent(const Payload& p) {
+    for (int i = 1; i < WORDS; i++) {
+        if (p.words[i] != p.words[0]) return false;
+    }
+    return true;
+}
+
+static bool publish(ConfigSnapshot<Payload>& snapshot, uint32_t value) {
+    return snapshot.update([value](Payload& p) {
+        for (int i = 0; i < WORDS; i++) p.words[i] = value;
+        return true;
+    });
+}
+
+// Several writers and readers, truly parallel
+static void testParallel() {
+    ConfigSnapshot<Payload> snapshot;
+    Payload initial = {};
+    snapshot.begin(initial);
+
+    std::atomic<bool> stop(false);
+    std::atomic<uint32_t> torn(0), reads(0), backwards(0);
+
+    std::vector<std::thread> readers;
+    for (int r = 0; r < 3; r++) {
+        readers.emplace_back([&] {
+            uint32_t lastVersion = 0;
+            while (!stop) {
+                Payload p;
+                uint32_t version = snapshot.version();
+                snapshot.read(p);
+                if (!consistent(p)) torn++;
+                if (version < lastVersion) backwards++;
+                lastVersion = version;
+                reads++;
+            }
+        });
+    }
+    std::vector<std::thread> writers;
+    for (int w = 0; w < 2; w++) {
+        writers.emplace_back([&, w] {
+            for (uint32_t i = 0; i < 20000; i++) publish(snapshot, i * 2 + w);
+        });
+    }
+    for (auto& t : writers) t.join();
+    stop = true;
+    for (auto& t : readers) t.join();
+
+    CHECK_EQ(torn.load(), 0);
+    CHECK_EQ(backwards.load(), 0);
+    CHECK(reads.load() > 0);
+    CHECK_EQ(snapshot.version(), 1 + 40000);
+    CHECK(consistent(snapshot.read()));
+}
+
+// Preempting reader: runs on the writer's thread, in a signal handler, and
+// posts readDone (sem_post is async-signal-safe)
+static ConfigSnapshot<Payload>* preemptSnapshot;
+static std::atomic<uint32_t> preemptTorn(0);
+static sem_t readDone;
+
+static void preemptingReader(int) {
+    Payload p;
+    preemptSnapshot->read(p);
+    if (!consistent(p)) preemptTorn++;
+    sem_post(&readDone);
+}
+
+static void testPreemption() {
+    ConfigSnapshot<Payload> snapshot;
+    Payload initial = {};
+    snapshot.begin(initial);
+    preemptSnapshot = &snapshot;
+    sem_init(&readDone, 0, 0);
+
+    struct sigaction action = {};
+    action.sa_handler = preemptingReader;
+    sigemptyset(&action.sa_mask);
+    sigaction(HOST_PREEMPT_SIGNAL, &action, nullptr);
+
+    std::atomic<bool> stop(false);
+    std::thread writer([&] {
+        for (uint32_t i = 1; !stop; i++) publish(snapshot, i);
+    });
+
+    // Let the writer run a random few microseconds, then preempt it wherever
+    // it is. Signals don't queue, so each read is waited for before the next;
+    // a reader stuck on an odd counter never posts.
+    const int PREEMPTIONS = 2000;
+    int reads = 0;
+    srand(1);
+    for (int n = 0; n < PREEMPTIONS; n++) {
+        std::this_thread::sleep_for(std::chrono::microseconds(rand() % 50));
+        pthread_kill(writer.native_handle(), HOST_PREEMPT_SIGNAL);
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += 2;
+        if (sem_timedwait(&readDone, &deadline) != 0) break;
+        reads++;
+    }
+    CHECK_EQ(reads, PREEMPTIONS);
+    if (reads != PREEMPTIONS) {
+        // The writer thread is spinning in its own signal handler
+        printf("preempting reader hung on an in-progress write\n");
+        int result = hostTestResult("config_snapshot");
+        fflush(stdout);
+        _exit(result);
+    }
+    stop = true;
+    writer.join();
+    signal(HOST_PREEMPT_SIGNAL, SIG_DFL);
+
+    CHECK_EQ(preemptTorn.load(), 0);
+    CHECK(snapshot.version() > 1);
+}
+
+int main() {
+    testParallel();
+    testPreemption();
+    return hostTestResult("config_snapshot");
+}
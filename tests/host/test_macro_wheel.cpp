@@ -0,0 +1,224 @@
+// OSC-Muis - Niels van der Hulst 2026
+//
+// Macro timer wheel on the simulated clock, advanced every millisecond as
+// loop() would: steps never fire early and at most one tick late, whatever
+// the press's phase against the tick clock, for single- and multi-round
+// delays; cancel removes exactly one button's pending steps; and steps
+// re-encoded while pending fire under their original (button, step).
+
+#include "host_test.h"
+#include "macro_wheel.h"
+#include <vector>
+#include <random>
+
+#define BUTTONS 16
+#define STEPS 8
+
+typedef MacroWheel<BUTTONS * STEPS> Wheel;
+
+static std::mt19937 rng(1);
+
+struct Expected {
+    uint8_t button;
+    uint8_t step;
+    uint64_t dueMs;
+    bool fired;
+    bool cancelled;
+};
+
+struct Fired {
+    uint8_t button;
+    uint8_t step;
+    uint64_t atMs;
+};
+
+static uint64_t nowMs() {
+    return hostTimeUs / 1000;
+}
+
+// Run the clock 1 ms at a time until nothing is pending (or the limit)
+static void run(Wheel& wheel, std::vector<Fired>& fired, uint64_t limitMs) {
+    uint64_t end = nowMs() + limitMs;
+    while (wheel.getPendingCount() > 0 && nowMs() < end) {
+        hostAdvanceMs(1);
+        wheel.advance([&](int button, int step) { fired.push_back({ (uint8_t)button, (uint8_t)step, nowMs() }); });
+    }
+}
+
+// Every fired step matches one expected entry, on time
+static void checkTimes(std::vector<Expected>& expected, const std::vector<Fired>& fired) {
+    for (const Fired& f : fired) {
+        Expected* match = nullptr;
+        for (Expected& e : expected) {
+            if (e.button == f.button && e.step == f.step && !e.fired) match = &e;
+        }
+        CHECK(match != nullptr);
+        if (!match) continue;
+        match->fired = true;
+        CHECK(!match->cancelled);
+        CHECK(f.atMs >= match->dueMs);                           // never early
+        CHECK(f.atMs <= match->dueMs + MACRO_WHEEL_TICK_MS);     // at most one tick late
+        if (f.atMs < match->dueMs || f.atMs > match->dueMs + MACRO_WHEEL_TICK_MS) {
+            printf("  btn %d step %d due %llu fired %llu\n", f.button, f.step,
+                   (unsigned long long)match->dueMs, (unsigned long long)f.atMs);
+        }
+    }
+    for (const Expected& e : expected) CHECK(e.fired || e.cancelled);
+}
+
+// Single presses at every phase against the tick clock, with delays around
+// one revolution (64 ticks = 320 ms) and far beyond it
+static void testTiming() {
+    const uint32_t delays[] = { 1, 4, 5, 6, 9, 10, 11, 315, 316, 319, 320, 321, 325, 326, 639, 640, 641,
+                                1000, 5003, 60000 };
+    for (uint32_t delay : delays) {
+        for (int phase = 0; phase < MACRO_WHEEL_TICK_MS * 2; phase++) {
+            Wheel wheel;
+            std::vector<Expected> expected;
+            std::vector<Fired> fired;
+
+            // The wheel is running when the second step is scheduled, so its
+            // offset is taken from a tick boundary in the past
+            hostAdvanceMs(1 + rng() % 1000);
+            CHECK(wheel.schedule(1, 0, 2 * MACRO_WHEEL_TICK_MS + 1));
+            expected.push_back({ 1, 0, nowMs() + 2 * MACRO_WHEEL_TICK_MS + 1, false, false });
+            for (int i = 0; i < phase; i++) {
+                hostAdvanceMs(1);
+                wheel.advance([&](int button, int step) { fired.push_back({ (uint8_t)button, (uint8_t)step, nowMs() }); });
+            }
+            CHECK(wheel.schedule(2, 0, delay));
+            expected.push_back({ 2, 0, nowMs() + delay, false, false });
+
+            run(wheel, fired, delay + 100);
+            CHECK_EQ(fired.size(), 2);
+            checkTimes(expected, fired);
+        }
+    }
+}
+
+// All entries in use at once, scheduled at random moments while others fire
+static void testLoaded() {
+    for (int round = 0; round < 20; round++) {
+        Wheel wheel;
+        std::vector<Expected> expected;
+        std::vector<Fired> fired;
+        for (int b = 1; b <= BUTTONS; b++) {
+            uint32_t offset = 0;
+            for (int s = 0; s < STEPS; s++) {
+                offset += 1 + rng() % (s % 2 ? 2000 : 40);
+                CHECK(wheel.schedule(b, s, offset));
+                expected.push_back({ (uint8_t)b, (uint8_t)s, nowMs() + offset, false, false });
+            }
+            for (uint32_t i = rng() % 7; i > 0; i--) {
+                hostAdvanceMs(1);
+                wheel.advance([&](int button, int step) { fired.push_back({ (uint8_t)button, (uint8_t)step, nowMs() }); });
+            }
+        }
+        CHECK_EQ(wheel.getPendingCount() + (int)fired.size(), BUTTONS * STEPS);
+        if (wheel.getPendingCount() == BUTTONS * STEPS) CHECK(!wheel.schedule(BUTTONS + 1, 0, 10));
+
+        run(wheel, fired, 20000);
+        CHECK_EQ(wheel.getPendingCount(), 0);
+        checkTimes(expected, fired);
+    }
+}
+
+// A missed loop pass: late steps catch up in order on the next advance()
+static void testCatchUp() {
+    Wheel wheel;
+    std::vector<Fired> fired;
+    hostAdvanceMs(3);
+    wheel.schedule(1, 0, 100);
+    wheel.schedule(1, 1, 200);
+    wheel.schedule(1, 2, 700);
+    hostAdvanceMs(450);
+    wheel.advance([&](int button, int step) { fired.push_back({ (uint8_t)button, (uint8_t)step, nowMs() }); });
+    CHECK_EQ(fired.size(), 2);
+    CHECK(fired.size() == 2 && fired[0].step == 0 && fired[1].step == 1);
+    run(wheel, fired, 1000);
+    CHECK_EQ(fired.size(), 3);
+}
+
+static void testCancel() {
+    Wheel wheel;
+    std::vector<Expected> expected;
+    std::vector<Fired> fired;
+    hostAdvanceMs(17);
+    // Buttons 1-3 share slots (same offsets), over several rounds
+    for (int b = 1; b <= 3; b++) {
+        for (int s = 0; s < STEPS; s++) {
+            uint32_t offset = 50 + s * 150;
+            CHECK(wheel.schedule(b, s, offset));
+            expected.push_back({ (uint8_t)b, (uint8_t)s, nowMs() + offset, false, b == 2 });
+        }
+    }
+    CHECK(wheel.isPending(2));
+    wheel.cancel(2);
+    CHECK(!wheel.isPending(2));
+    CHECK(wheel.isPending(1) && wheel.isPending(3));
+    CHECK_EQ(wheel.getPendingCount(), 2 * STEPS);
+
+    // Cancel halfway through: the rest of button 3 never fires
+    run(wheel, fired, 500);
+    wheel.cancel(3);
+    for (Expected& e : expected) {
+        if (e.button == 3 && e.dueMs > nowMs()) e.cancelled = true;
+    }
+    CHECK(!wheel.isPending(3));
+    run(wheel, fired, 5000);
+    checkTimes(expected, fired);
+    for (const Fired& f : fired) CHECK(f.button != 2);
+    CHECK(!wheel.isPending(1));
+
+    // Cancelling an idle button does nothing; the freed entries are reusable
+    wheel.cancel(9);
+    for (int i = 0; i < BUTTONS * STEPS; i++) CHECK(wheel.schedule(4, i % STEPS, 10 + i));
+    CHECK(!wheel.schedule(4, 0, 10));
+}
+
+// Steps are encoded packets looked up when they fire: re-encoding them
+// while pending (OSC settings changed) sends the new packet for the same
+// (button, step), at the original time
+static void testReencode() {
+    Wheel wheel;
+    std::vector<Fired> fired;
+    int encoded[BUTTONS][STEPS];
+    for (int b = 0; b < BUTTONS; b++) {
+        for (int s = 0; s < STEPS; s++) encoded[b][s] = 1;
+    }
+    std::vector<int> sent;
+
+    hostAdvanceMs(2);
+    uint64_t start = nowMs();
+    for (int s = 0; s < 4; s++) wheel.schedule(5, s, 100 + s * 400);
+    auto fire = [&](int button, int step) {
+        fired.push_back({ (uint8_t)button, (uint8_t)step, nowMs() });
+        sent.push_back(encoded[button - 1][step]);
+    };
+    while (nowMs() < start + 700) {
+        hostAdvanceMs(1);
+        wheel.advance(fire);
+    }
+    for (int s = 0; s < STEPS; s++) encoded[4][s] = 2;  // encodeAll()
+    CHECK_EQ(wheel.getPendingCount(), 2);
+    while (wheel.getPendingCount() > 0) {
+        hostAdvanceMs(1);
+        wheel.advance(fire);
+    }
+    CHECK_EQ(fired.size(), 4);
+    for (size_t i = 0; i < fired.size(); i++) {
+        CHECK_EQ(fired[i].button, 5);
+        CHECK_EQ(fired[i].step, i);
+        CHECK(fired[i].atMs >= start + 100 + i * 400 && fired[i].atMs <= start + 100 + i * 400 + MACRO_WHEEL_TICK_MS);
+        CHECK_EQ(sent[i], i < 2 ? 1 : 2);
+    }
+}
+
+int main() {
+    testTiming();
+    testLoaded();
+    testCatchUp();
+    testCancel();
+    testReencode();
+    return hostTestResult("macro_wheel");
+}
@@ -0,0 +1,268 @@
+// OSC-Muis - Niels van der Hulst 2026
+//
+// Key matrix debouncer (4x4 pad profile): bounce patterns, multi-key
+// rollover and idle/wake sequences fed into MatrixDebouncer::update() one
+// scan at a time. Checks the 4-sample latency, exactly one press edge per
+// settled press, and the bitwise counters against a per-key reference.
+
+#define BOARD_XIAO_C3_4X4_MATRIX
+#include "host_test.h"
+#include "matrix_scanner.h"
+#include <vector>
+#include <random>
+
+#define KEYS 16
+
+static std::mt19937 rng(1);
+
+// One key, the way the header describes it: the state flips after 4
+// consecutive samples that disagree with it
+struct ReferenceKey {
+    bool state = false;
+    int disagree = 0;
+
+    bool update(bool sample) {
+        if (sample == state) {
+            disagree = 0;
+            return false;
+        }
+        if (++disagree < 4) return false;
+        disagree = 0;
+        state = sample;
+        return state;
+    }
+};
+
+// The scanner around the debouncer: counts press edges, and after
+// MATRIX_IDLE_SCANS all-up scans goes idle and resets the debouncer, as
+// MatrixScanner::scan()/sleep() do
+struct Pad {
+    MatrixDebouncer debouncer = {};
+    uint32_t presses[KEYS] = {};
+    uint16_t idleScans = 0;
+    bool idle = false;
+    int scans = 0;
+
+    uint32_t scan(uint32_t sample) {
+        scans++;
+        uint32_t pressed = debouncer.update(sample);
+        for (int k = 0; k < KEYS; k++) {
+            if (pressed & (1u << k)) presses[k]++;
+        }
+        if (sample == 0 && debouncer.state == 0) {
+            if (++idleScans >= MATRIX_IDLE_SCANS) {
+                idle = true;
+                idleScans = 0;
+                debouncer = {};
+            }
+        } else {
+            idleScans = 0;
+        }
+        return pressed;
+    }
+
+    // Column interrupt: the first key down restarts the scan
+    void wake() {
+        idle = false;
+    }
+};
+
+static uint32_t key(int k) {
+    return 1u << k;
+}
+
+// Clean press and release of every key: the edge comes with the 4th sample
+static void testLatency() {
+    for (int k = 0; k < KEYS; k++) {
+        Pad pad;
+        for (int i = 1; i <= 3; i++) CHECK_EQ(pad.scan(key(k)), 0);
+        CHECK_EQ(pad.scan(key(k)), key(k));
+        CHECK_EQ(pad.debouncer.state, key(k));
+        for (int i = 0; i < 20; i++) CHECK_EQ(pad.scan(key(k)), 0);   // held: no repeat
+
+        // Release: state clears after 4 samples, no edge reported
+        for (int i = 1; i <= 3; i++) {
+            CHECK_EQ(pad.scan(0), 0);
+            CHECK_EQ(pad.debouncer.state, key(k));
+        }
+        CHECK_EQ(pad.scan(0), 0);
+        CHECK_EQ(pad.debouncer.state, 0);
+        CHECK_EQ(pad.presses[k], 1);
+    }
+}
+
+// Contact bounce: any agreeing sample restarts the count, so the edge comes
+// 4 samples after the contact settles, and only once
+static void testBounce() {
+    struct Pattern {
+        const char* samples;      // '1' = contact closed
+        int edgeAt;               // 1-based sample with the press edge, 0 = none
+    };
+    const Pattern patterns[] = {
+        { "1111", 4 },
+        { "1011111", 6 },
+        { "1101101111", 10 },
+        { "1110111", 0 },         // never 4 in a row
+        { "111011110000", 8 },
+        { "10101010101", 0 },     // chatter
+        { "0001111", 7 },
+        { "11111110111", 4 },     // release glitch after the press: no second edge
+    };
+    for (const Pattern& p : patterns) {
+        Pad pad;
+        int edgeAt = 0, edges = 0;
+        for (int i = 0; p.samples[i]; i++) {
+            if (pad.scan(p.samples[i] == '1' ? key(5) : 0)) {
+                edges++;
+                if (!edgeAt) edgeAt = i + 1;
+            }
+        }
+        CHECK_EQ(edgeAt, p.edgeAt);
+        CHECK_EQ(edges, p.edgeAt ? 1 : 0);
+    }
+
+    // Release bounce never re-triggers: down, then a bouncy release
+    Pad pad;
+    for (int i = 0; i < 10; i++) pad.scan(key(3));
+    const char* release = "0100101100010000000";
+    for (int i = 0; release[i]; i++) pad.scan(release[i] == '1' ? key(3) : 0);
+    CHECK_EQ(pad.presses[3], 1);
+    CHECK_EQ(pad.debouncer.state, 0);
+}
+
+// Bitwise counters against the per-key reference on random bouncy streams
+static void testAgainstReference() {
+    MatrixDebouncer debouncer = {};
+    ReferenceKey reference[32];
+    int mismatches = 0;
+    for (int scan = 0; scan < 200000; scan++) {
+        // Each key: long steady periods with bursts of bounce
+        static uint32_t held = 0;
+        if (rng() % 50 == 0) held ^= key(rng() % 32);
+        uint32_t noise = 0;
+        for (int k = 0; k < 32; k++) {
+            if (rng() % 10 == 0) noise |= key(k);
+        }
+        uint32_t sample = held ^ noise;
+
+        uint32_t pressed = debouncer.update(sample);
+        for (int k = 0; k < 32; k++) {
+            bool refPressed = reference[k].update(sample & key(k));
+            if (refPressed != ((pressed & key(k)) != 0) || reference[k].state != ((debouncer.state & key(k)) != 0)) {
+                mismatches++;
+            }
+        }
+    }
+    CHECK_EQ(mismatches, 0);
+}
+
+// Several keys held at once, pressed and released staggered: each key's
+// edge comes 4 samples after its own press, unaffected by the others
+static void testRollover() {
+    Pad pad;
+    const int pressAt[KEYS] = { 0, 1, 1, 2, 5, 5, 5, 5, 9, 10, 11, 12, 13, 14, 15, 15 };
+    const int releaseAt[KEYS] = { 40, 30, 41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51, 52, 53, 54 };
+    int edgeAt[KEYS];
+    for (int k = 0; k < KEYS; k++) edgeAt[k] = -1;
+
+    for (int t = 0; t < 80; t++) {
+        uint32_t sample = 0;
+        for (int k = 0; k < KEYS; k++) {
+            if (t >= pressAt[k] && t < releaseAt[k]) sample |= key(k);
+        }
+        // Key 7 bounces while the others are held
+        if (t == 6) sample &= ~key(7);
+        uint32_t pressed = pad.scan(sample);
+        for (int k = 0; k < KEYS; k++) {
+            if (pressed & key(k)) edgeAt[k] = t;
+        }
+        if (t == 20) CHECK_EQ(pad.debouncer.state, 0xFFFF);   // all 16 down
+    }
+    for (int k = 0; k < KEYS; k++) {
+        CHECK_EQ(pad.presses[k], 1);
+        CHECK_EQ(edgeAt[k], (k == 7 ? 7 : pressAt[k]) + 3);
+    }
+    CHECK_EQ(pad.debouncer.state, 0);
+
+    // Ghost-free rollover: a key pressed while its neighbours are held still
+    // reports; a held key released and pressed again reports again
+    Pad again;
+    for (int t = 0; t < 10; t++) again.scan(key(0) | key(1));
+    for (int t = 0; t < 10; t++) again.scan(key(1));
+    for (int t = 0; t < 10; t++) again.scan(key(0) | key(1) | key(4));
+    CHECK_EQ(again.presses[0], 2);
+    CHECK_EQ(again.presses[1], 1);
+    CHECK_EQ(again.presses[4], 1);
+}
+
+// Idle and wake: the pad stops scanning after MATRIX_IDLE_SCANS all-up
+// scans, never while a key is held or still settling, and a key that wakes
+// it reports one press 4 scans later
+static void testIdleWake() {
+    Pad pad;
+    for (int i = 0; i < MATRIX_IDLE_SCANS - 1; i++) pad.scan(0);
+    CHECK(!pad.idle);
+    pad.scan(0);
+    CHECK(pad.idle);
+
+    // Wake on a press that bounces on the way down
+    pad.wake();
+    const char* down = "1011111111";
+    int edgeAt = 0;
+    for (int i = 0; down[i]; i++) {
+        if (pad.scan(down[i] == '1' ? key(9) : 0)) edgeAt = i + 1;
+    }
+    CHECK_EQ(edgeAt, 6);
+    CHECK_EQ(pad.presses[9], 1);
+
+    // Held far longer than the idle time: never goes idle
+    for (int i = 0; i < 5 * MATRIX_IDLE_SCANS; i++) pad.scan(key(9));
+    CHECK(!pad.idle);
+
+    // Released: the debounced state must clear before idle counting starts
+    int scansToIdle = 0;
+    while (!pad.idle && scansToIdle < 1000) {
+        pad.scan(0);
+        scansToIdle++;
+    }
+    CHECK_EQ(scansToIdle, 3 + MATRIX_IDLE_SCANS);
+    CHECK_EQ(pad.presses[9], 1);
+
+    // A glitch wakes the pad but settles to nothing: no press, idle again
+    pad.wake();
+    pad.scan(key(2));
+    pad.scan(0);
+    scansToIdle = 1;
+    while (!pad.idle && scansToIdle < 1000) {
+        pad.scan(0);
+        scansToIdle++;
+    }
+    CHECK(pad.idle);
+    CHECK_EQ(scansToIdle, MATRIX_IDLE_SCANS);
+    CHECK_EQ(pad.presses[2], 0);
+
+    // Idle noise during the count restarts it
+    pad.wake();
+    for (int i = 0; i < MATRIX_IDLE_SCANS - 10; i++) pad.scan(0);
+    pad.scan(key(12));
+    CHECK(!pad.idle);
+    for (int i = 0; i < MATRIX_IDLE_SCANS - 1; i++) pad.scan(0);
+    CHECK(!pad.idle);
+    pad.scan(0);
+    CHECK(pad.idle);
+
+    // Wake with two keys at once: both report
+    pad.wake();
+    for (int i = 0; i < 4; i++) pad.scan(key(0) | key(15));
+    CHECK_EQ(pad.presses[0], 1);
+    CHECK_EQ(pad.presses[15], 1);
+}
+
+int main() {
+    testLatency();
+    testBounce();
+    testAgainstReference();
+    testRollover();
+    testIdleWake();
+    return hostTestResult("matrix_debouncer");
+}
@@ -0,0 +1,78 @@
+// OSC-Muis - Niels van der Hulst 2026
+//
+// Which incoming packets prove the receiver's interface: the configured
+// target and show-control commands do; configuration and diagnostic
+// commands, foreign OSC and our own looped-back broadcasts don't, so a
+// fleet tool or a laptop querying status on the venue network never cuts
+// the broadcasts to a LuPlayer host on the device's own AP.
+
+#include "host_test.h"
+#include "osc_heard.h"
+
+static uint32_t ip(uint8_t a, uint8_t b, uint8_t c, uint8_t d) {
+    return (uint32_t)a | (uint32_t)b << 8 | (uint32_t)c << 16 | (uint32_t)d << 24;
+}
+
+// The commands the sketch registers, with their heard flag
+struct Command {
+    const char* address;
+    bool heard;
+};
+static const Command COMMANDS[] = {
+    { "/muis/config", false },
+    { "/muis/config/port", false },
+    { "/muis/config/target", false },
+    { "/muis/config/format", false },
+    { "/muis/config/channel", false },
+    { "/muis/config/prefix", false },
+    { "/muis/status", false },
+    { "/muis/headless", false },
+    { "/muis/telemetry", false },
+    { "/muis/fleet", false },
+    { "/muis/macro", false },
+    { "/muis/analog", false },
+    { "/muis/showlock", false },
+    { "/muis/preset", true },
+    { "/muis/preset/next", true },
+    { "/muis/power", true },
+};
+
+static const uint32_t STA_IP = ip(10, 0, 0, 23);
+static const uint32_t LAPTOP = ip(10, 0, 0, 50);
+static const uint32_t SHOW_PC = ip(10, 0, 0, 10);
+static const uint32_t BROADCAST = 0;
+
+// Broadcast target: only show-control commands count, from any sender
+static void testBroadcastTarget() {
+    for (const Command& c : COMMANDS) {
+        CHECK_EQ(oscProvesReceiver(LAPTOP, STA_IP, BROADCAST, c.heard), c.heard);
+        if (oscProvesReceiver(LAPTOP, STA_IP, BROADCAST, c.heard) != c.heard) printf("  %s\n", c.address);
+    }
+    // Unregistered OSC (a neighbouring unit's presses, LuPlayer chatter)
+    CHECK(!oscProvesReceiver(ip(10, 0, 0, 24), STA_IP, BROADCAST, false));
+}
+
+// Unicast target: anything from it counts, commands or not; others only
+// with a show-control command
+static void testUnicastTarget() {
+    CHECK(oscProvesReceiver(SHOW_PC, STA_IP, SHOW_PC, false));
+    CHECK(oscProvesReceiver(SHOW_PC, STA_IP, SHOW_PC, true));
+    CHECK(!oscProvesReceiver(LAPTOP, STA_IP, SHOW_PC, false));
+    CHECK(oscProvesReceiver(LAPTOP, STA_IP, SHOW_PC, true));
+}
+
+// Our own broadcast coming back on the same interface is never proof, not
+// even when it is a show-control command (a fleet peer's relay) or the
+// target is misconfigured to our own address
+static void testLoopback() {
+    CHECK(!oscProvesReceiver(STA_IP, STA_IP, BROADCAST, true));
+    CHECK(!oscProvesReceiver(STA_IP, STA_IP, STA_IP, false));
+    CHECK(!oscProvesReceiver(STA_IP, STA_IP, STA_IP, true));
+}
+
+int main() {
+    testBroadcastTarget();
+    testUnicastTarget();
+    testLoopback();
+    return hostTestResult("osc_heard");
+}
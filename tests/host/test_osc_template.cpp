@@ -0,0 +1,346 @@
+// OSC-Muis - Niels van der Hulst 2026
+//
+// OSC templates: random templates built from the syntax are compiled,
+// encoded with random contexts and decoded again — the message must carry
+// exactly the expanded address and arguments, stay within maxEncodedSize
+// and keep every field 4-byte aligned. Random character soup must either
+// be rejected (leaving the template empty) or encode within the same
+// bounds.
+
+#include "host_test.h"
+#include "osc_template.h"
+#include "osc_socket.h"
+#include <vector>
+#include <random>
+
+static std::mt19937 rng(1);
+
+static int randomInt(int lo, int hi) {
+    return std::uniform_int_distribution<int>(lo, hi)(rng);
+}
+
+// Packet sink with room to spare, so an overrun shows as a length
+class PacketBuffer : public Print {
+public:
+    size_t write(uint8_t b) override {
+        data.push_back(b);
+        return 1;
+    }
+    std::vector<uint8_t> data;
+};
+
+// Decoded message
+struct Decoded {
+    std::string address;
+    std::string typeTags;
+    struct Value {
+        char type;
+        int32_t i;
+        float f;
+        std::string s;
+    };
+    std::vector<Value> args;
+};
+
+// OSC string at pos: NUL-terminated, zero-padded to a multiple of 4
+static bool readString(const std::vector<uint8_t>& p, size_t& pos, std::string& out) {
+    size_t end = pos;
+    while (end < p.size() && p[end]) end++;
+    if (end >= p.size()) return false;
+    out.assign((const char*)p.data() + pos, end - pos);
+    size_t next = (end & ~(size_t)3) + 4;
+    if (next > p.size()) return false;
+    for (size_t i = end; i < next; i++) {
+        if (p[i]) return false;
+    }
+    pos = next;
+    return true;
+}
+
+static bool readWord(const std::vector<uint8_t>& p, size_t& pos, uint32_t& out) {
+    if (pos + 4 > p.size()) return false;
+    out = (uint32_t)p[pos] << 24 | (uint32_t)p[pos + 1] << 16 | (uint32_t)p[pos + 2] << 8 | p[pos + 3];
+    pos += 4;
+    return true;
+}
+
+static bool decode(const std::vector<uint8_t>& p, Decoded& out) {
+    size_t pos = 0;
+    if (!readString(p, pos, out.address) || !readString(p, pos, out.typeTags)) return false;
+    if (out.typeTags.empty() || out.typeTags[0] != ',') return false;
+    for (size_t t = 1; t < out.typeTags.size(); t++) {
+        Decoded::Value v = { out.typeTags[t], 0, 0.0f, "" };
+        uint32_t word;
+        switch (v.type) {
+            case 'i':
+                if (!readWord(p, pos, word)) return false;
+                v.i = (int32_t)word;
+                break;
+            case 'f':
+                if (!readWord(p, pos, word)) return false;
+                memcpy(&v.f, &word, sizeof(word));
+                break;
+            case 's':
+                if (!readString(p, pos, v.s)) return false;
+                break;
+            case 'T':
+            case 'F':
+                break;
+            default:
+                return false;
+        }
+        out.args.push_back(v);
+    }
+    return pos == p.size();
+}
+
+// A context within the documented ranges
+struct Context {
+    OSCTemplateContext ctx;
+    char device[OSC_DEVICE_NAME_MAX];
+    char prefix[OSC_ADDRESS_PREFIX_MAX];
+};
+
+static void randomContext(Context& c) {
+    static const char chars[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789-";
+    int deviceLen = randomInt(0, OSC_DEVICE_NAME_MAX - 1);
+    for (int i = 0; i < deviceLen; i++) c.device[i] = chars[randomInt(0, sizeof(chars) - 2)];
+    c.device[deviceLen] = '\0';
+    int prefixLen = randomInt(0, 1) ? OSC_ADDRESS_PREFIX_MAX - 1 : 0;
+    c.prefix[0] = '/';
+    for (int i = 1; i < prefixLen; i++) c.prefix[i] = "0123456789abcdef"[randomInt(0, 15)];
+    c.prefix[prefixLen] = '\0';
+    c.ctx.channel = randomInt(0, 3) ? randomInt(1, 99) : 0;
+    c.ctx.button = randomInt(1, 999);
+    c.ctx.device = c.device;
+    c.ctx.value = std::uniform_real_distribution<float>(0.0f, 1.0f)(rng);
+    c.ctx.prefix = c.prefix;
+}
+
+// A template built from the syntax, and what it should expand to
+struct Generated {
+    std::string source;
+    std::vector<std::string> addressParts;  // "{ch}", "{btn}", "{device}" or literal text
+    bool appendChannel;
+    struct Arg {
+        char type;
+        std::string placeholder;              // "" = literal
+        int32_t i;
+        float f;
+        std::vector<std::string> parts;       // String argument
+    };
+    std::vector<Arg> args;
+};
+
+static const char* const PLACEHOLDERS[] = { "{ch}", "{btn}", "{device}" };
+
+static std::string randomLiteral(const char* chars, int maxLen) {
+    std::string s;
+    int len = randomInt(1, maxLen);
+    for (int i = 0; i < len; i++) s += chars[randomInt(0, strlen(chars) - 1)];
+    return s;
+}
+
+static void randomText(std::vector<std::string>& parts, std::string& source, const char* chars, int maxParts) {
+    int n = randomInt(1, maxParts);
+    for (int i = 0; i < n; i++) {
+        std::string part = randomInt(0, 2) ? randomLiteral(chars, 6) : PLACEHOLDERS[randomInt(0, 2)];
+        parts.push_back(part);
+        source += part;
+    }
+}
+
+static Generated generate() {
+    Generated g;
+    g.appendChannel = randomInt(0, 3) != 0;
+    g.source = "/";
+    g.addressParts.push_back("/");
+    randomText(g.addressParts, g.source, "abcdefghijklmnopqrstuvwxyz0123456789/_-.", 4);
+
+    int argCount = randomInt(0, OSC_TEMPLATE_MAX_ARGS);
+    for (int a = 0; a < argCount; a++) {
+        Generated::Arg arg = { "ifsTF"[randomInt(0, 4)], "", 0, 0.0f, {} };
+        g.source += " ,";
+        g.source += arg.type;
+        if (arg.type == 'i' || arg.type == 'f') {
+            int pick = randomInt(0, arg.type == 'f' ? 3 : 2);
+            if (pick == 1) arg.placeholder = "{ch}";
+            else if (pick == 2) arg.placeholder = "{btn}";
+            else if (pick == 3) arg.placeholder = "{value}";
+            if (!arg.placeholder.empty()) {
+                g.source += arg.placeholder;
+            } else if (arg.type == 'i') {
+                arg.i = (int32_t)rng();
+                g.source += std::to_string(arg.i);
+            } else {
+                char number[16];
+                snprintf(number, sizeof(number), "%g",
+                         std::uniform_real_distribution<float>(-1000.0f, 1000.0f)(rng));
+                arg.f = strtof(number, nullptr);
+                g.source += number;
+            }
+        } else if (arg.type == 's') {
+            randomText(arg.parts, g.source, "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789/.:;!#$%&()*+-=?@[]^_`|~", 3);
+        }
+        g.args.push_back(arg);
+    }
+    return g;
+}
+
+static std::string expand(const std::vector<std::string>& parts, const OSCTemplateContext& ctx) {
+    std::string s;
+    for (const std::string& part : parts) {
+        if (part == "{ch}") s += std::to_string(ctx.channel);
+        else if (part == "{btn}") s += std::to_string(ctx.button);
+        else if (part == "{device}") s += ctx.device;
+        else s += part;
+    }
+    return s;
+}
+
+// Bounds and alignment hold for any compiled template and context
+static void checkBounds(const OSCTemplate& program, const OSCTemplateContext& ctx, PacketBuffer& packet) {
+    program.encode(packet, ctx);
+    CHECK(packet.data.size() <= program.maxEncodedSize);
+    CHECK(program.maxEncodedSize <= OSC_SOCKET_BUFFER_SIZE);
+    CHECK_EQ(packet.data.size() % 4, 0);
+}
+
+static void testRoundTrip() {
+    int compiled = 0;
+    for (int n = 0; n < 20000; n++) {
+        Generated g = generate();
+        OSCTemplate program;
+        const char* error = program.compile(g.source.c_str(), g.appendChannel);
+        if (error) {
+            // Only size limits may refuse a template built from the syntax
+            bool sizeLimit = !strcmp(error, "Template too long") || !strcmp(error, "Template too complex") ||
+                             !strcmp(error, "Message too long");
+            CHECK(sizeLimit);
+            if (!sizeLimit) printf("  rejected \"%s\": %s\n", g.source.c_str(), error);
+            continue;
+        }
+        compiled++;
+
+        for (int c = 0; c < 4; c++) {
+            Context context;
+            randomContext(context);
+            const OSCTemplateContext& ctx = context.ctx;
+            PacketBuffer packet;
+            checkBounds(program, ctx, packet);
+
+            Decoded d;
+            bool ok = decode(packet.data, d);
+            CHECK(ok);
+            if (!ok) continue;
+
+            // Address: prefix, expansion, and the channel for a plain address
+            std::string address = std::string(ctx.prefix) + expand(g.addressParts, ctx);
+            bool plain = true;
+            for (const std::string& part : g.addressParts) {
+                if (part[0] == '{') plain = false;
+            }
+            if (plain && g.appendChannel) address += std::to_string(ctx.channel);
+            CHECK(d.address == address);
+
+            char formatted[OSC_ADDRESS_PREFIX_MAX + OSC_TEMPLATE_POOL_SIZE + 64];
+            program.formatAddress(ctx, formatted, sizeof(formatted));
+            CHECK(address == formatted);
+
+            // Arguments; none means the single float 1.0
+            if (g.args.empty()) {
+                CHECK(d.typeTags == ",f");
+                CHECK(d.args.size() == 1 && d.args[0].f == 1.0f);
+                continue;
+            }
+            CHECK_EQ(d.args.size(), g.args.size());
+            for (size_t a = 0; a < g.args.size() && a < d.args.size(); a++) {
+                const Generated::Arg& want = g.args[a];
+                const Decoded::Value& got = d.args[a];
+                CHECK_EQ(got.type, want.type);
+                int placeholder = want.placeholder == "{ch}" ? ctx.channel : ctx.button;
+                if (want.type == 'i') {
+                    CHECK_EQ(got.i, want.placeholder.empty() ? want.i : placeholder);
+                } else if (want.type == 'f') {
+                    float expected = want.placeholder.empty() ? want.f
+                                   : want.placeholder == "{value}" ? ctx.value : (float)placeholder;
+                    CHECK(got.f == expected);
+                } else if (want.type == 's') {
+                    CHECK(got.s == expand(want.parts, ctx));
+                }
+            }
+        }
+    }
+    // Most generated templates fit; the size limits only cut the tail
+    CHECK(compiled > 15000);
+}
+
+// Character soup weighted towards the syntax
+static void testSoup() {
+    static const char chars[] = "/{}ch btndevicevalue,ifsTF0123456789.-+e /a_\t\x01\x7f\xff";
+    int compiled = 0;
+    for (int n = 0; n < 50000; n++) {
+        std::string source;
+        int len = randomInt(0, 160);
+        for (int i = 0; i < len; i++) source += chars[randomInt(0, sizeof(chars) - 2)];
+
+        OSCTemplate program;
+        if (program.compile(source.c_str(), randomInt(0, 1))) {
+            OSCTemplate empty;
+            memset(&empty, 0, sizeof(empty));
+            CHECK(memcmp(&program, &empty, sizeof(program)) == 0);
+            continue;
+        }
+        compiled++;
+        for (int c = 0; c < 4; c++) {
+            Context context;
+            randomContext(context);
+            PacketBuffer packet;
+            checkBounds(program, context.ctx, packet);
+            Decoded d;
+            CHECK(decode(packet.data, d));
+            CHECK(memcmp(d.typeTags.c_str(), program.typeTags, d.typeTags.size() + 1) == 0);
+        }
+    }
+    CHECK(compiled > 0);
+}
+
+static void testQuotes() {
+    const char* const rejected[] = {
+        "/cue\"/go", "/cue'/go", "/cue\\/go", "/go ,s\"x", "/go ,sit's", "/go ,sa\\nb",
+        "/go ,i1 ,s\"", "/go \"", "/go ,i\"1\"", "\"/go"
+    };
+    for (const char* source : rejected) {
+        OSCTemplate program;
+        const char* error = program.compile(source);
+        CHECK(error && strcmp(error, "Quotes and backslashes are not allowed") == 0);
+        CHECK_EQ(program.argCount, 0);
+    }
+    OSCTemplate program;
+    CHECK(program.compile("/cue/{ch}/go ,sdon`t ,i{btn}") == nullptr);
+}
+
+// Worst case exactly at the buffer: longest device name, widest numbers
+static void testLimits() {
+    OSCTemplate program;
+    CHECK(program.compile("/{device}/{device} ,s{device}{device} ,s{device}{device} ,i{ch}") == nullptr);
+    Context context;
+    memset(context.device, 'd', OSC_DEVICE_NAME_MAX - 1);
+    context.device[OSC_DEVICE_NAME_MAX - 1] = '\0';
+    strcpy(context.prefix, "/abcdef");
+    context.ctx = { 99, 999, context.device, 1.0f, context.prefix };
+    PacketBuffer packet;
+    checkBounds(program, context.ctx, packet);
+    CHECK_EQ(packet.data.size(), program.maxEncodedSize);
+
+    // One more device string over the buffer
+    CHECK(program.compile("/{device}/{device} ,s{device}{device}{device}{device} ,s{device}{device}{device}") != nullptr);
+}
+
+int main() {
+    testRoundTrip();
+    testSoup();
+    testQuotes();
+    testLimits();
+    return hostTestResult("osc_template");
+}
@@ -0,0 +1,135 @@
+#!/usr/bin/env python3
+# OSC-Muis - Niels van der Hulst 2026
+"""Measure the arrival latency of the /oscbench probes per send path.
+
+Run this on the OSC target (stop the OSC application first, or use another
+port), then POST /oscbench on the unit. Each bench round sends one
+/muis/bench probe per path (0 = WiFiUDP, 1 = QoS socket) behind the same
+best-effort filler burst. Every probe carries the unit's micros() at send
+time.
+
+The clocks of host and unit aren't synchronised, but within one round the
+offset is the same for both probes. So for each round:
+
+    delta = (arrival_qos - sent_qos) - (arrival_udp - sent_udp)
+
+is how much later (positive) or earlier (negative) the QoS probe arrived
+than the WiFiUDP one, send-call time included. Unlike the numbers on the
+unit (GET /oscbench times only the send call), this includes queueing in
+the WiFi driver and on air.
+
+    python3 tools/bench_receiver.py                 # listen on 8001
+    python3 tools/bench_receiver.py --port 9000 --rounds 20
+
+Only the Python standard library is needed.
+"""
+
+import argparse
+import socket
+import struct
+import sys
+import time
+
+from fleet import OSC_PORT, read_string
+
+PATHS = ("WiFiUDP", "QoS socket")
+ROUNDS = 20           # ROUNDS in OSCManager::runLatencyBench()
+
+
+def parse_probe(packet):
+    """(round, path, sent_us) of a /muis/bench probe, or None."""
+    try:
+        address, pos = read_string(packet, 0)
+        tags, pos = read_string(packet, pos)
+        if address != "/muis/bench" or tags != ",iii":
+            return None
+        return struct.unpack(">iiI", packet[pos:pos + 12])
+    except (ValueError, struct.error):
+        return None
+
+
+def one_way(probe):
+    """Arrival minus send time in microseconds (includes the clock offset)."""
+    sent_us, arrived_us = probe
+    return arrived_us - sent_us
+
+
+def summary(values):
+    values = sorted(values)
+    return "avg %7.0f us  median %7.0f us  worst %7.0f us" % (
+        sum(values) / len(values), values[len(values) // 2], values[-1])
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--port", type=int, default=OSC_PORT,
+                        help="port the unit sends OSC to (default: %(default)s)")
+    parser.add_argument("--rounds", type=int, default=ROUNDS,
+                        help="rounds to wait for (default: %(default)s)")
+    parser.add_argument("--timeout", type=float, default=30,
+                        help="seconds to wait for the bench (default: %(default)s)")
+    args = parser.parse_args()
+
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    sock.bind(("", args.port))
+    sock.settimeout(0.5)
+    print("Listening on port %d, start the bench with POST /oscbench" % args.port)
+
+    # round -> path -> (sent_us, arrived_us); the unit's micros() wraps at 2^32
+    probes = {}
+    end = time.time() + args.timeout
+    last = None
+    while time.time() < end:
+        try:
+            packet, _ = sock.recvfrom(512)
+        except socket.timeout:
+            if last and time.time() - last > 1:
+                break       # bench over
+            continue
+        arrived_us = int(time.perf_counter() * 1e6) & 0xFFFFFFFF
+        probe = parse_probe(packet)
+        if not probe:
+            continue
+        round_number, path, sent_us = probe
+        if path in (0, 1):
+            probes.setdefault(round_number, {})[path] = (sent_us, arrived_us)
+            last = time.time()
+            if len(probes) >= args.rounds and all(len(p) == 2 for p in probes.values()):
+                break
+    sock.close()
+
+    if not probes:
+        print("No probes received")
+        return 1
+
+    def wrap(us):
+        return (us + 2 ** 31) % 2 ** 32 - 2 ** 31
+
+    # Per-path one-way times relative to the fastest probe seen, and the
+    # paired per-round difference (offset-free)
+    per_path = {0: [], 1: []}
+    deltas = []
+    for round_number in sorted(probes):
+        pair = probes[round_number]
+        for path, probe in pair.items():
+            per_path[path].append(one_way(probe))
+        if len(pair) == 2:
+            deltas.append(wrap(one_way(pair[1]) - one_way(pair[0])))
+
+    first = next(v for values in per_path.values() for v in values)
+    base = min(wrap(v - first) for values in per_path.values() for v in values)
+    for path in (0, 1):
+        values = [wrap(v - first) - base for v in per_path[path]]
+        lost = args.rounds - len(values)
+        if values:
+            print("%-10s %s  (relative to the fastest probe; %d lost)" % (PATHS[path], summary(values), max(lost, 0)))
+        else:
+            print("%-10s no probes" % PATHS[path])
+    if deltas:
+        print("QoS - UDP  %s  over %d paired rounds" % (summary(deltas), len(deltas)))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
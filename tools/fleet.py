@@ -0,0 +1,139 @@
+#!/usr/bin/env python3
+# OSC-Muis - Niels van der Hulst 2026
+"""List the OSC-Muis units on the network with their battery and link state.
+
+Asks every unit to announce itself (/muis/fleet, broadcast to the OSC port),
+then collects their /muis/presence announcements on the fleet port. Units
+answer at a random moment within a second, so a large fleet doesn't reply in
+one burst.
+
+    python3 tools/fleet.py                  # query, list what answered
+    python3 tools/fleet.py --watch          # keep listening, redraw every 2 s
+
+Only the Python standard library is needed.
+"""
+
+import argparse
+import socket
+import struct
+import sys
+import time
+
+FLEET_PORT = 9001      # FLEET_PORT in fleet_presence.h
+OSC_PORT = 8001        # The units' OSC port (command input)
+STALE_AFTER_S = 30     # Three missed announcements
+
+FIELDS = ("id", "host", "ip", "prefix", "battery", "rssi", "channel", "roams", "uptime", "mode")
+
+
+def osc_string(text):
+    data = text.encode() + b"\0"
+    return data + b"\0" * (-len(data) % 4)
+
+
+def read_string(packet, pos):
+    end = packet.index(b"\0", pos)
+    return packet[pos:end].decode(errors="replace"), (end + 4) & ~3
+
+
+def parse_presence(packet):
+    """Fields of a /muis/presence message as a dict, or None."""
+    try:
+        address, pos = read_string(packet, 0)
+        if address != "/muis/presence":
+            return None
+        tags, pos = read_string(packet, pos)
+        values = []
+        for tag in tags[1:]:
+            if tag == "s":
+                value, pos = read_string(packet, pos)
+            elif tag == "i":
+                (value,) = struct.unpack(">i", packet[pos:pos + 4])
+                pos += 4
+            elif tag == "f":
+                (value,) = struct.unpack(">f", packet[pos:pos + 4])
+                pos += 4
+            else:
+                return None
+            values.append(value)
+    except (ValueError, struct.error):
+        return None
+    return dict(zip(FIELDS, values))
+
+
+def format_uptime(seconds):
+    hours, rest = divmod(seconds, 3600)
+    return "%d:%02d:%02d" % (hours, rest // 60, rest % 60)
+
+
+def print_table(units, now):
+    columns = ("ID", "HOST", "IP", "PREFIX", "BATT", "RSSI", "CH", "ROAMS", "UPTIME", "MODE", "SEEN")
+    rows = []
+    for unit_id in sorted(units):
+        unit, seen = units[unit_id]
+        age = now - seen
+        rows.append((
+            unit["id"], unit["host"], unit["ip"], unit["prefix"] or "-",
+            "%d%%" % unit["battery"],
+            "%d dBm" % unit["rssi"] if unit["rssi"] else "-",
+            str(unit["channel"]), str(unit["roams"]), format_uptime(unit["uptime"]), unit["mode"],
+            "%ds ago%s" % (age, " (stale)" if age > STALE_AFTER_S else ""),
+        ))
+    widths = [max([len(c)] + [len(r[i]) for r in rows]) for i, c in enumerate(columns)]
+    line = "  ".join("%-*s" % (w, c) for w, c in zip(widths, columns))
+    print(line.rstrip())
+    for row in rows:
+        print("  ".join("%-*s" % (w, c) for w, c in zip(widths, row)).rstrip())
+    print("%d unit%s" % (len(rows), "" if len(rows) == 1 else "s"))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--broadcast", default="255.255.255.255",
+                        help="address the query is sent to (default: %(default)s)")
+    parser.add_argument("--osc-port", type=int, default=OSC_PORT,
+                        help="the units' OSC port (default: %(default)s)")
+    parser.add_argument("--port", type=int, default=FLEET_PORT,
+                        help="fleet port to listen on (default: %(default)s)")
+    parser.add_argument("--time", type=float, default=2.0,
+                        help="seconds to collect answers (default: %(default)s)")
+    parser.add_argument("--watch", action="store_true",
+                        help="keep listening to the periodic announcements")
+    args = parser.parse_args()
+
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    sock.setsockopt(socket.SOL_SOCKET, socket.SO_BROADCAST, 1)
+    sock.bind(("", args.port))
+    sock.settimeout(0.2)
+
+    query = osc_string("/muis/fleet") + osc_string(",")
+    sock.sendto(query, (args.broadcast, args.osc_port))
+
+    units = {}
+    start = time.time()
+    redraw = start + args.time
+    try:
+        while True:
+            now = time.time()
+            if now >= redraw:
+                if args.watch:
+                    print("\033[H\033[J", end="")
+                print_table(units, int(now))
+                if not args.watch:
+                    break
+                redraw = now + 2.0
+            try:
+                packet, _ = sock.recvfrom(512)
+            except socket.timeout:
+                continue
+            unit = parse_presence(packet)
+            if unit and len(unit) == len(FIELDS):
+                units[unit["id"]] = (unit, int(time.time()))
+    except KeyboardInterrupt:
+        pass
+    return 0 if units else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
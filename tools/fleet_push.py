@@ -0,0 +1,213 @@
+#!/usr/bin/env python3
+# OSC-Muis - Niels van der Hulst 2026
+"""Push OSC settings and presets to every OSC-Muis unit that has the fleet key.
+
+Builds a bundle from the options, signs it with the fleet key (HMAC-SHA256)
+and multicasts it to the units in chunks (fleet_config.h). Every unit answers
+each round; the next round repeats only the chunks someone is missing. Units
+that announce themselves (see fleet.py) but never answer are listed too.
+
+    python3 tools/fleet_push.py --key SECRET --target 192.168.1.10 --format /kmpush
+    python3 tools/fleet_push.py --key SECRET --preset "1|Act 1|192.168.1.10|1,2|/cue/{ch}/go"
+
+Options that are left out stay as they are on the units. The key can also
+come from the MUIS_FLEET_KEY environment variable.
+
+Only the Python standard library is needed.
+"""
+
+import argparse
+import hashlib
+import hmac
+import os
+import socket
+import struct
+import sys
+import time
+
+from fleet import FLEET_PORT, OSC_PORT, osc_string, parse_presence, read_string
+
+CONFIG_PORT = 9002             # FLEET_CONFIG_PORT in fleet_config.h
+CONFIG_GROUP = "239.255.77.1"  # FLEET_CONFIG_GROUP
+BUNDLE_MAX = 2048              # FLEET_BUNDLE_MAX, signature included
+CHUNK_DATA = 192               # FLEET_CHUNK_DATA
+ROUND_S = 0.6                  # FLEET_ROUND_MS
+MIN_ROUNDS = 2
+MAX_ROUNDS = 6
+
+STATUS = ("applied", "incomplete", "wrong key", "invalid", "stale", "show lock")
+APPLIED, INCOMPLETE, SIGNATURE, INVALID, STALE, LOCKED = range(len(STATUS))
+
+
+def osc_int(value):
+    return struct.pack(">i", value)
+
+
+def osc_blob(data):
+    return osc_int(len(data)) + data + b"\0" * (-len(data) % 4)
+
+
+def build_text(args):
+    lines = ["v=1"]
+    if args.port is not None:
+        lines.append("port=%d" % args.port)
+    if args.target is not None:
+        lines.append("target=" + ("" if args.target == "broadcast" else args.target))
+    if args.format is not None:
+        lines.append("format=" + args.format)
+    if args.channels is not None:
+        lines.append("channels=" + args.channels)
+    if args.prefix is not None:
+        lines.append("prefix=%d" % (args.prefix == "on"))
+    if args.preset or args.clear_presets:
+        lines.append("presets=")
+        lines.extend("preset=" + preset for preset in args.preset)
+    return ("\n".join(lines) + "\n").encode()
+
+
+def sign(key, bundle_id, text):
+    return text + hmac.new(key, struct.pack(">I", bundle_id) + text, hashlib.sha256).digest()
+
+
+def parse_ack(packet):
+    """(unit, id, status, chunks, last) of a /muis/fleet/ack, or None."""
+    try:
+        address, pos = read_string(packet, 0)
+        tags, pos = read_string(packet, pos)
+        if address != "/muis/fleet/ack" or tags != ",siiii":
+            return None
+        unit, pos = read_string(packet, pos)
+        return (unit,) + struct.unpack(">iiii", packet[pos:pos + 16])
+    except (ValueError, struct.error):
+        return None
+
+
+def collect_roster(args):
+    """Units that announce themselves within --time seconds: id -> ip."""
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    sock.setsockopt(socket.SOL_SOCKET, socket.SO_BROADCAST, 1)
+    sock.bind(("", FLEET_PORT))
+    sock.settimeout(0.2)
+    sock.sendto(osc_string("/muis/fleet") + osc_string(","), (args.broadcast, args.osc_port))
+
+    roster = {}
+    end = time.time() + args.time
+    while time.time() < end:
+        try:
+            packet, _ = sock.recvfrom(512)
+        except socket.timeout:
+            continue
+        unit = parse_presence(packet)
+        if unit and "ip" in unit:
+            roster[unit["id"]] = unit["ip"]
+    sock.close()
+    return roster
+
+
+def push(sock, key, text, bundle_id, units):
+    """Send the bundle in rounds until every answering unit is done.
+    Returns the highest id a unit reported as already applied, or 0."""
+    bundle = sign(key, bundle_id, text)
+    chunks = [bundle[i:i + CHUNK_DATA] for i in range(0, len(bundle), CHUNK_DATA)]
+    count = len(chunks)
+    pending = set(range(count))
+    print("Bundle %d: %d bytes in %d chunks" % (bundle_id, len(bundle), count))
+
+    for round_number in range(1, MAX_ROUNDS + 1):
+        for index in sorted(pending):
+            message = osc_string("/muis/fleet/chunk") + osc_string(",iiib")
+            message += osc_int(bundle_id) + osc_int(index) + osc_int(count) + osc_blob(chunks[index])
+            sock.sendto(message, (CONFIG_GROUP, CONFIG_PORT))
+            time.sleep(0.002)
+        commit = osc_string("/muis/fleet/commit") + osc_string(",ii") + osc_int(bundle_id) + osc_int(count)
+        sock.sendto(commit, (CONFIG_GROUP, CONFIG_PORT))
+
+        end = time.time() + ROUND_S
+        while time.time() < end:
+            try:
+                packet, (ip, _) = sock.recvfrom(512)
+            except socket.timeout:
+                continue
+            ack = parse_ack(packet)
+            if ack and ack[1] == bundle_id and 0 <= ack[2] < len(STATUS):
+                units[ack[0]] = (ip, ack[2], ack[3], ack[4])
+
+        newest = max([last for _, status, _, last in units.values() if status == STALE] or [0])
+        if newest:
+            return newest
+        pending = set()
+        waiting = False
+        for _, status, received, _ in units.values():
+            if status == INCOMPLETE:
+                pending |= {i for i in range(count) if not received & (1 << i)}
+            waiting = waiting or status in (INCOMPLETE, LOCKED)
+        print("Round %d: %d answered, %d applied" % (
+            round_number, len(units), sum(1 for u in units.values() if u[1] == APPLIED)))
+        if round_number >= MIN_ROUNDS and not waiting:
+            break
+    return 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--key", default=os.environ.get("MUIS_FLEET_KEY"),
+                        help="fleet key, as set in the portal (default: $MUIS_FLEET_KEY)")
+    parser.add_argument("--port", type=int, help="OSC port (applies after the units reboot)")
+    parser.add_argument("--target", help="OSC target IP, or 'broadcast'")
+    parser.add_argument("--format", help="address format / template, e.g. /kmpush")
+    parser.add_argument("--channels", help="channel per button, e.g. 1,2")
+    parser.add_argument("--prefix", choices=("on", "off"), help="prefix every address with the device id")
+    parser.add_argument("--preset", action="append", default=[],
+                        help="slot|name|target|channels|format; replaces the preset bank (repeat for more)")
+    parser.add_argument("--clear-presets", action="store_true",
+                        help="replace the preset bank with the --preset options only (none = empty)")
+    parser.add_argument("--interface", help="local address to multicast from (default: the route's)")
+    parser.add_argument("--broadcast", default="255.255.255.255",
+                        help="address the presence query is sent to (default: %(default)s)")
+    parser.add_argument("--osc-port", type=int, default=OSC_PORT,
+                        help="the units' OSC port, for the presence query (default: %(default)s)")
+    parser.add_argument("--time", type=float, default=1.5,
+                        help="seconds to collect presence before pushing (default: %(default)s)")
+    args = parser.parse_args()
+
+    if not args.key or not 8 <= len(args.key) <= 63:
+        parser.error("a fleet key of 8-63 characters is required")
+    key = args.key.encode()
+    text = build_text(args)
+    if len(text) + 32 > BUNDLE_MAX:
+        parser.error("bundle too large (%d bytes, at most %d)" % (len(text) + 32, BUNDLE_MAX))
+
+    roster = collect_roster(args)
+
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.setsockopt(socket.IPPROTO_IP, socket.IP_MULTICAST_TTL, 1)
+    if args.interface:
+        sock.setsockopt(socket.IPPROTO_IP, socket.IP_MULTICAST_IF, socket.inet_aton(args.interface))
+    sock.bind(("", 0))
+    sock.settimeout(0.1)
+
+    # Ids only go up; seconds since 1970 stay ahead of ids the units make up
+    bundle_id = int(time.time())
+    units = {}
+    newest = push(sock, key, text, bundle_id, units)
+    if newest:
+        print("Units are ahead of bundle %d, sending again as %d" % (bundle_id, newest + 1))
+        units = {}
+        push(sock, key, text, newest + 1, units)
+
+    print()
+    print("%-8s %-16s %s" % ("ID", "IP", "STATUS"))
+    for unit_id in sorted(set(units) | set(roster)):
+        if unit_id in units:
+            ip, status, _, _ = units[unit_id]
+            print("%-8s %-16s %s" % (unit_id, ip, STATUS[status]))
+        else:
+            print("%-8s %-16s %s" % (unit_id, roster[unit_id], "no answer"))
+    applied = sum(1 for u in units.values() if u[1] == APPLIED)
+    print("%d of %d units applied the bundle" % (applied, len(set(units) | set(roster))))
+    return 0 if units and applied == len(set(units) | set(roster)) else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -1,6 +1,8 @@
 // OSC-Muis - Niels van der Hulst 2026
 
 #include "wifi_manager.h"
+#include "log_ring.h"
+#include "telemetry.h"
 #include "portal_html.h"
 #include "esp_wifi.h"
 #include <ESPmDNS.h>
@@ -8,12 +10,16 @@
 // 11 dBm (~12 mW) is well below the default 19.5 dBm but still enough to
 // reach typical venue WiFi at moderate distance. Halving TX power
 // noticeably reduces average current draw on a small LiPo.
+// This is the boot default; the power governor switches it per profile.
 #define WIFI_TX_POWER WIFI_POWER_11dBm
 
+// Max number of modules that can add template variables to the portal
+#define MAX_TEMPLATE_CALLBACKS 4
+
 // Static instance pointers for callbacks
 static WiFiManager* _instance = nullptr;
 static const WiFiManagerConfig* _configPtr = nullptr;
-static TemplateProcessorCallback _customProcessorCallback = nullptr;
+static TemplateProcessorCallback _customProcessorCallbacks[MAX_TEMPLATE_CALLBACKS] = {};
 
 // Template processor for HTML placeholders
 static String processTemplate(const String& var) {
@@ -28,12 +34,30 @@ static String processTemplate(const String& var) {
         if (state.staConnected) return "AP + Station";
         return "Access Point";
     }
-    if (var == "STA_SSID") return state.staConnected ? state.staSSID : "-";
+    if (var == "STA_SSID") return state.staConnected ? String(state.staSSID) : String("-");
     if (var == "STA_IP") return state.staConnected ? WiFi.localIP().toString() : "-";
+    if (var == "STA_RSSI") return state.staConnected ? String(WiFi.RSSI()) + " dBm" : "-";
+    if (var == "ROAMS") {
+        if (state.roamCount == 0) return "none";
+        const WiFiRoamRecord& last = state.roamHistory[(state.roamCount - 1) % WIFI_ROAM_HISTORY];
+        return String(state.roamCount) + " (last " + String(last.outageMs) + " ms)";
+    }
     if (var == "STA_STATUS_CLASS") return state.staConnected ? "" : "hidden";
     if (var == "AP_CLIENTS") return String(WiFi.softAPgetStationNum());
     if (var == "AP_SSID") return _configPtr ? String(_configPtr->apSSID) : "";
+    if (var == "DEVICE_ID") return String(_instance->getDeviceId());
+    if (var == "HOSTNAME") return String(_instance->getHostname());
     if (var == "AP_IP") return WiFi.softAPIP().toString();
+    if (var == "AP_CHANNEL") {
+        String ch = String(state.apChannel) + " (" + state.apChannelReason;
+        if (state.apChannelScore >= 0) ch += ", score " + String(state.apChannelScore);
+        return ch + ")";
+    }
+    if (var == "SHOW_LOCK") return _instance->getAdmission().isShowLockArmed() ? "checked" : "";
+    if (var == "REJECTED") {
+        const AdmissionControl& a = _instance->getAdmission();
+        return String(a.getRateLimitedCount() + a.getBusyCount() + a.getLockedCount());
+    }
     if (var == "DISCONNECT_CLASS") return state.staConnected ? "" : "hidden";
     // Show "Reconnect" only when there are saved creds and we're not currently connected
     if (var == "RECONNECT_CLASS") return (state.staEnabled && !state.staConnected) ? "" : "hidden";
@@ -42,9 +66,9 @@ static String processTemplate(const String& var) {
     if (var == "PORTAL_TITLE") return _configPtr ? String(_configPtr->portalTitle) : "WiFi Manager";
     if (var == "PORTAL_SUBTITLE") return _configPtr ? String(_configPtr->portalSubtitle) : "";
 
-    // Try custom processor if registered
-    if (_customProcessorCallback) {
-        String result = _customProcessorCallback(var);
+    // Try custom processors in registration order
+    for (int i = 0; i < MAX_TEMPLATE_CALLBACKS && _customProcessorCallbacks[i]; i++) {
+        String result = _customProcessorCallbacks[i](var);
         if (result.length() > 0) return result;
     }
 
@@ -53,33 +77,66 @@ static String processTemplate(const String& var) {
 
 
 WiFiManager::WiFiManager() : _webServer(80) {
+    _deviceId[0] = '\0';
+    _deviceName[0] = '\0';
+    _hostname[0] = '\0';
+    _lastPushedConnectResult = WIFI_CONN_IDLE;
+    _txPower = WIFI_TX_POWER;
+    _staOnlyPowerSave = WIFI_PS_MIN_MODEM;
+    _state.staSSID[0] = '\0';
+    _state.staPassword[0] = '\0';
+    _state.pendingSSID[0] = '\0';
+    _state.pendingPassword[0] = '\0';
     _state.staEnabled = false;
     _state.staConnected = false;
+    _state.headless = false;
     _state.batteryPercent = 100;
     _state.broadcastIP = IPAddress(192, 168, 4, 255);
     _state.apActive = true;
+    _state.apChannel = WIFI_MANAGER_DEFAULT_CHANNEL;
+    _state.apChannelScore = -1;
+    _state.apChannelReason = "fixed";
+    _state.apChannelReselect = false;
     _state.apShutdownTime = 0;
     _state.connectRequested = false;
     _state.disconnectRequested = false;
     _state.reconnectRequested = false;
     _state.apOffRequested = false;
+    _state.scanRequested = false;
     _state.connectStartTime = 0;
     _state.connectResult = WIFI_CONN_IDLE;
+    _state.rssiAvg = 0;
+    _state.lastRssiCheck = 0;
+    _state.roaming = false;
+    _state.roamCount = 0;
+    _mdnsServiceCount = 0;
 }
 
 void WiFiManager::begin(const WiFiManagerConfig& config) {
     _config = config;
     _instance = this;
     _configPtr = &_config;
+    _scanner.begin();
+    initIdentity();
 
     // Load saved WiFi credentials
     loadSavedWiFi();
 
+    if (_state.headless) {
+        if (_state.staEnabled && _state.staSSID[0]) {
+            beginHeadless();
+            return;
+        }
+        Serial.println("Headless mode set but no saved network — starting the portal");
+        _state.headless = false;
+    }
+
     // Set up WiFi Access Point
     WiFi.disconnect(true);
     delay(100);
     WiFi.mode(WIFI_AP);
     delay(100);
+    chooseAPChannel();
     setupAccessPoint();
 
     // Connect to saved WiFi if available
@@ -89,6 +146,48 @@ void WiFiManager::begin(const WiFiManagerConfig& config) {
     initCaptivePortal();
 }
 
+void WiFiManager::initIdentity() {
+    // Factory MAC, first byte in the lowest bits; the last three bytes are
+    // the per-unit part
+    uint64_t mac = ESP.getEfuseMac();
+    snprintf(_deviceId, sizeof(_deviceId), "%02x%02x%02x",
+             (uint8_t)(mac >> 24), (uint8_t)(mac >> 32), (uint8_t)(mac >> 40));
+
+    if (_config.appendDeviceId) {
+        snprintf(_deviceName, sizeof(_deviceName), "%s-%s", _config.apSSID, _deviceId);
+        for (char* c = _deviceName + strlen(_config.apSSID); *c; c++) *c = toupper(*c);
+    } else {
+        strlcpy(_deviceName, _config.apSSID, sizeof(_deviceName));
+    }
+    _config.apSSID = _deviceName;  // Everything below advertises the unique name
+
+    // Host names are lower case letters, digits and '-'
+    size_t i = 0;
+    for (const char* c = _deviceName; *c && i < sizeof(_hostname) - 1; c++) {
+        _hostname[i++] = isalnum((unsigned char)*c) ? tolower(*c) : '-';
+    }
+    _hostname[i] = '\0';
+
+    // DHCP host name too, so the venue router's lease list tells units apart.
+    // Must be set before the STA interface starts.
+    WiFi.setHostname(_hostname);
+    Serial.printf("Device ID %s: %s / %s.local\n", _deviceId, _deviceName, _hostname);
+}
+
+void WiFiManager::beginHeadless() {
+    Serial.println("Headless mode: STA only, portal stack not started");
+
+    WiFi.disconnect(true);
+    delay(100);
+    WiFi.mode(WIFI_STA);
+    _state.apActive = false;
+
+    // Same async connect as the portal path; connectToSavedWiFi() keeps STA-only
+    connectToSavedWiFi();
+
+    // Only the roaming sweeps use the scanner now; nothing serves /scan
+}
+
 void WiFiManager::setupAccessPoint() {
     Serial.println("Starting WiFi Access Point...");
     // NOTE: caller is responsible for setting WiFi mode (WIFI_AP or WIFI_AP_STA)
@@ -113,9 +212,9 @@ void WiFiManager::setupAccessPoint() {
     Serial.printf("Starting AP with SSID: %s\n", _config.apSSID);
     bool success;
     if (_config.apPassword && strlen(_config.apPassword) >= 8) {
-        success = WiFi.softAP(_config.apSSID, _config.apPassword, _config.apChannel);
+        success = WiFi.softAP(_config.apSSID, _config.apPassword, _state.apChannel);
     } else {
-        success = WiFi.softAP(_config.apSSID, NULL, _config.apChannel);
+        success = WiFi.softAP(_config.apSSID, NULL, _state.apChannel);
     }
 
     delay(1000);  // Give AP time to start
@@ -123,7 +222,7 @@ void WiFiManager::setupAccessPoint() {
     if (success) {
         // Apply reduced TX power for battery life. Must be called after the
         // radio is up; mode changes can reset it so we re-apply elsewhere too.
-        WiFi.setTxPower(WIFI_TX_POWER);
+        WiFi.setTxPower(_txPower);
 
         Serial.println("AP started successfully!");
         Serial.printf("  SSID: %s\n", _config.apSSID);
@@ -135,9 +234,94 @@ void WiFiManager::setupAccessPoint() {
     }
 }
 
+// Non-overlapping 2.4 GHz channels the AP picks from
+static const uint8_t AP_CHANNEL_CANDIDATES[] = {1, 6, 11};
+
+// A re-selection must beat the current channel's score by this factor (%)
+// to be worth moving the AP for.
+#define AP_CHANNEL_SWITCH_PERCENT 70
+
+void WiFiManager::chooseAPChannel() {
+    if (_config.apChannel != 0) {
+        _state.apChannel = _config.apChannel;
+        _state.apChannelReason = "fixed";
+        return;
+    }
+
+    // With a saved network, start the AP where the STA will land: the radio
+    // has one channel, so an AP elsewhere gets dragged across on connect and
+    // its clients lose the link for the switch.
+    if (_state.staEnabled) {
+        _preferences.begin("wifi", true);
+        uint8_t staChannel = _preferences.getUChar("channel", 0);
+        _preferences.end();
+        if (staChannel != 0) {
+            _state.apChannel = staChannel;
+            _state.apChannelScore = -1;
+            _state.apChannelReason = "follows STA";
+            Serial.printf("AP channel %u (saved STA channel)\n", staChannel);
+            return;
+        }
+    }
+
+    // Nothing else on the radio yet, so a quick blocking sweep is fine here
+    Serial.println("Scanning for the least congested AP channel...");
+    _scanner.sweepBlocking();
+    int score;
+    _state.apChannel = bestAPChannel(score);
+    _state.apChannelScore = score;
+    _state.apChannelReason = "auto";
+    Serial.printf("AP channel %u (congestion score %d)\n", _state.apChannel, score);
+}
+
+uint8_t WiFiManager::bestAPChannel(int& score) const {
+    uint8_t best = AP_CHANNEL_CANDIDATES[0];
+    score = _scanner.channelScore(best, _config.apSSID);
+    for (size_t i = 1; i < sizeof(AP_CHANNEL_CANDIDATES); i++) {
+        int s = _scanner.channelScore(AP_CHANNEL_CANDIDATES[i], _config.apSSID);
+        if (s < score) {
+            score = s;
+            best = AP_CHANNEL_CANDIDATES[i];
+        }
+    }
+    return best;
+}
+
+void WiFiManager::followSTAChannel() {
+    // The AP has been pulled onto the STA channel by the driver; record it,
+    // and remember it so the next boot starts the AP there directly.
+    uint8_t channel = WiFi.channel();
+    if (channel == 0) return;
+    if (_config.apChannel == 0) {
+        _state.apChannel = channel;
+        _state.apChannelScore = -1;
+        _state.apChannelReason = "follows STA";
+    }
+
+    _preferences.begin("wifi", false);
+    if (_preferences.getUChar("channel", 0) != channel) {
+        _preferences.putUChar("channel", channel);
+    }
+    _preferences.end();
+}
+
+void WiFiManager::reselectAPChannel() {
+    if (_config.apChannel != 0 || !_state.apActive || _state.staConnected) return;
+    if (WiFi.softAPgetStationNum() > 0) return;
+
+    // Evaluate once a fresh sweep is in the cache (see loop())
+    _scanner.requestSweep(true);
+    _state.apChannelReselect = true;
+}
+
 void WiFiManager::initCaptivePortal() {
     // Start DNS server for captive portal redirect
-    _dnsServer.start(53, "*", WiFi.softAPIP());
+    _dnsServer.start(WiFi.softAPIP());
+
+    // Admission control runs before every handler, including those other
+    // modules register later (see admission_control.h)
+    _admission.begin();
+    _webServer.addMiddleware(&_admission);
 
     // Serve the main portal page
     _webServer.on("/", HTTP_GET, [](AsyncWebServerRequest *request) {
@@ -164,93 +348,78 @@ void WiFiManager::initCaptivePortal() {
         request->redirect("/");
     });
 
-    // Scan for networks
-    _webServer.on("/scan", HTTP_GET, [](AsyncWebServerRequest *request) {
-        int n = WiFi.scanComplete();
-
-        // Return status if scan not ready yet
-        if (n == WIFI_SCAN_FAILED) {
-            // Ensure station mode is enabled for scanning
-            wifi_mode_t currentMode = WiFi.getMode();
-            if (currentMode == WIFI_AP) {
-                WiFi.mode(WIFI_AP_STA);
-                WiFi.disconnect();  // Disconnect STA but keep mode
-            } else if (currentMode == WIFI_AP_STA && !_instance->isSTAConnected()) {
-                // If in AP_STA mode but not connected, ensure clean state for scanning
-                WiFi.disconnect();
-            }
-            WiFi.scanNetworks(true);  // Start async scan
-            request->send(200, "application/json", "{\"status\":\"scanning\"}");
-            return;
-        }
-        if (n == WIFI_SCAN_RUNNING) {
-            request->send(200, "application/json", "{\"status\":\"scanning\"}");
-            return;
-        }
+    // Scan results — served instantly from the background scanner's cache.
+    // Never touches the STA association; a stale cache just kicks off a
+    // refresh sweep, and the client polls again while "scanning" is true.
+    _webServer.on("/scan", HTTP_GET, [this](AsyncWebServerRequest *request) {
+        _state.scanRequested = true;
+        request->send(200, "application/json", _scanner.toJson());
+    });
+
+    // Control actions — reachable over the /ws control socket and as their
+    // classic HTTP routes (see control_channel.h).
+    _control.begin(_webServer);
+    _control.setAdmission(&_admission);
 
-        // Build results JSON
-        String json = "[";
-        for (int i = 0; i < n; i++) {
-            if (i > 0) json += ",";
-            json += "{\"ssid\":\"" + WiFi.SSID(i) + "\",";
-            json += "\"rssi\":" + String(WiFi.RSSI(i)) + ",";
-            json += "\"secure\":" + String(WiFi.encryptionType(i) != WIFI_AUTH_OPEN) + "}";
+    // Rejection counters and show lock state
+    _control.registerAction("admission", "/admission", HTTP_GET, [this](const ControlRequest&) -> String {
+        return _admission.getStatsJson();
+    });
+
+    // Arm/disarm the show lock (enabled=1|0). Can't be reached while the lock
+    // is engaged, which is the point — use OSC /muis/showlock to lift it.
+    _control.registerAction("showlock", "/showlock", HTTP_POST, [this](const ControlRequest& req) -> String {
+        if (!req.hasParam("enabled")) {
+            return "{\"success\":false,\"message\":\"Missing parameters\"}";
         }
-        json += "]";
-        WiFi.scanDelete();
-        request->send(200, "application/json", json);
+        _admission.setShowLockArmed(req.getParam("enabled") == "1");
+        return _admission.getStatsJson();
     });
 
     // Connect to a network — defers actual work to loop() to keep async handler non-blocking
-    _webServer.on("/connect", HTTP_POST, [this](AsyncWebServerRequest *request) {
-        if (!request->hasParam("ssid", true) || !request->hasParam("password", true)) {
-            request->send(200, "application/json", "{\"success\":false,\"message\":\"Missing parameters\"}");
-            return;
+    _control.registerAction("connect", "/connect", HTTP_POST, [this](const ControlRequest& req) -> String {
+        if (!req.hasParam("ssid") || !req.hasParam("password")) {
+            return "{\"success\":false,\"message\":\"Missing parameters\"}";
         }
 
-        _state.pendingSSID = request->getParam("ssid", true)->value();
-        _state.pendingPassword = request->getParam("password", true)->value();
+        String ssid = req.getParam("ssid");
+        String password = req.getParam("password");
+        if (ssid.length() >= WIFI_SSID_MAX || password.length() >= WIFI_PASSWORD_MAX) {
+            return "{\"success\":false,\"message\":\"SSID or password too long\"}";
+        }
+        strlcpy(_state.pendingSSID, ssid.c_str(), sizeof(_state.pendingSSID));
+        strlcpy(_state.pendingPassword, password.c_str(), sizeof(_state.pendingPassword));
         _state.connectResult = WIFI_CONN_IDLE;
         _state.connectRequested = true;
 
-        request->send(200, "application/json", "{\"success\":true,\"status\":\"connecting\"}");
+        return "{\"success\":true,\"status\":\"connecting\"}";
     });
 
-    // Poll connection status (called by frontend after POST /connect)
-    _webServer.on("/constatus", HTTP_GET, [this](AsyncWebServerRequest *request) {
-        const char* status;
-        switch (_state.connectResult) {
-            case WIFI_CONN_CONNECTING: status = "connecting"; break;
-            case WIFI_CONN_SUCCESS:    status = "connected";  break;
-            case WIFI_CONN_FAILED:     status = "failed";     break;
-            default:                   status = "idle";       break;
-        }
-        String json = "{\"status\":\"";
-        json += status;
-        json += "\"";
-        if (_state.connectResult == WIFI_CONN_SUCCESS) {
-            json += ",\"ip\":\"" + WiFi.localIP().toString() + "\"";
-        }
-        json += "}";
-        request->send(200, "application/json", json);
+    // Connection status. Socket clients get this pushed as "constatus" events;
+    // HTTP clients poll it after POST /connect.
+    _control.registerAction("constatus", "/constatus", HTTP_GET, [this](const ControlRequest&) -> String {
+        return getConnectStatusJson();
     });
 
     // Disconnect from network — defers actual work to loop()
-    _webServer.on("/disconnect", HTTP_POST, [this](AsyncWebServerRequest *request) {
+    _control.registerAction("disconnect", "/disconnect", HTTP_POST, [this](const ControlRequest&) -> String {
         _state.disconnectRequested = true;
-        request->send(200, "application/json", "{\"success\":true}");
+        return "{\"success\":true}";
     });
 
     // Retry the saved network — defers to loop(), reuses the connect state machine
-    _webServer.on("/reconnect", HTTP_POST, [this](AsyncWebServerRequest *request) {
-        if (!_state.staEnabled || _state.staSSID.length() == 0) {
-            request->send(200, "application/json",
-                "{\"success\":false,\"message\":\"No saved network\"}");
-            return;
+    _control.registerAction("reconnect", "/reconnect", HTTP_POST, [this](const ControlRequest&) -> String {
+        if (!_state.staEnabled || !_state.staSSID[0]) {
+            return "{\"success\":false,\"message\":\"No saved network\"}";
         }
         _state.reconnectRequested = true;
         _state.connectResult = WIFI_CONN_IDLE;
-        request->send(200, "application/json", "{\"success\":true,\"status\":\"connecting\"}");
+        return "{\"success\":true,\"status\":\"connecting\"}";
+    });
+
+    // Roam history (outage per roam) for diagnosing multi-AP venues
+    _webServer.on("/roams", HTTP_GET, [this](AsyncWebServerRequest *request) {
+        request->send(200, "application/json", getRoamHistoryJson());
     });
 
     // Report which side of the radio the client is connected through.
@@ -267,27 +436,21 @@ void WiFiManager::initCaptivePortal() {
 
     // Switch to STA-only immediately — only valid when STA is connected.
     // Defers to loop() so the response gets back before we tear down AP.
-    _webServer.on("/staonly", HTTP_POST, [this](AsyncWebServerRequest *request) {
+    _control.registerAction("staonly", "/staonly", HTTP_POST, [this](const ControlRequest& req) -> String {
         if (!_state.staConnected) {
-            request->send(200, "application/json",
-                "{\"success\":false,\"message\":\"Not connected to a station network\"}");
-            return;
+            return "{\"success\":false,\"message\":\"Not connected to a station network\"}";
         }
         if (!_state.apActive) {
-            request->send(200, "application/json",
-                "{\"success\":false,\"message\":\"AP already off\"}");
-            return;
+            return "{\"success\":false,\"message\":\"AP already off\"}";
         }
         // Refuse if the requester is on the AP — they'd kick themselves off.
         // The UI normally hides the button in this case but check anyway.
-        IPAddress clientIP = request->client()->remoteIP();
+        IPAddress clientIP = req.remoteIP();
         if (clientIP[0] == 192 && clientIP[1] == 168 && clientIP[2] == 4) {
-            request->send(200, "application/json",
-                "{\"success\":false,\"message\":\"You are connected via the AP — switching off the AP would disconnect you\"}");
-            return;
+            return "{\"success\":false,\"message\":\"You are connected via the AP — switching off the AP would disconnect you\"}";
         }
         _state.apOffRequested = true;
-        request->send(200, "application/json", "{\"success\":true}");
+        return "{\"success\":true}";
     });
 
     // Handle all other requests
@@ -299,70 +462,131 @@ void WiFiManager::initCaptivePortal() {
     // External modules (e.g. OSCManager) need a chance to register their
     // routes first; the sketch must call startWebServer() afterwards.
 
-    // Start initial WiFi scan
-    WiFi.scanNetworks(true);
+    // Fill the scan cache in the background so the first /scan has results
+    _scanner.requestSweep(true);
 
     Serial.println("Captive portal initialized");
     Serial.printf("Portal will be available at http://%s\n", WiFi.softAPIP().toString().c_str());
 }
 
+String WiFiManager::getConnectStatusJson() const {
+    const char* status;
+    switch (_state.connectResult) {
+        case WIFI_CONN_CONNECTING: status = "connecting"; break;
+        case WIFI_CONN_SUCCESS:    status = "connected";  break;
+        case WIFI_CONN_FAILED:     status = "failed";     break;
+        default:                   status = "idle";       break;
+    }
+    String json = "{\"status\":\"";
+    json += status;
+    json += "\"";
+    if (_state.connectResult == WIFI_CONN_SUCCESS) {
+        json += ",\"ip\":\"" + WiFi.localIP().toString() + "\"";
+    }
+    json += "}";
+    return json;
+}
+
 void WiFiManager::startWebServer() {
+    if (_state.headless) {
+        Serial.println("Headless: web server not started");
+        return;
+    }
     _webServer.begin();
     Serial.println("Web server started");
 }
 
 void WiFiManager::loadSavedWiFi() {
     _preferences.begin("wifi", true);
-    _state.staSSID = _preferences.getString("ssid", "");
-    _state.staPassword = _preferences.getString("password", "");
+    _state.staSSID[0] = '\0';
+    _state.staPassword[0] = '\0';
+    _preferences.getString("ssid", _state.staSSID, sizeof(_state.staSSID));
+    _preferences.getString("password", _state.staPassword, sizeof(_state.staPassword));
     _state.staEnabled = _preferences.getBool("enabled", false);
+    _state.headless = _preferences.getBool("headless", false);
     _preferences.end();
 
-    if (_state.staEnabled && _state.staSSID.length() > 0) {
-        Serial.printf("Found saved WiFi: %s\n", _state.staSSID.c_str());
+    if (_state.staEnabled && _state.staSSID[0]) {
+        Serial.printf("Found saved WiFi: %s\n", _state.staSSID);
     }
 }
 
 void WiFiManager::connectToSavedWiFi() {
-    if (!_state.staEnabled || _state.staSSID.length() == 0) return;
+    if (!_state.staEnabled || !_state.staSSID[0]) return;
 
-    Serial.printf("Starting async connect to saved WiFi: %s\n", _state.staSSID.c_str());
+    Serial.printf("Starting async connect to saved WiFi: %s\n", _state.staSSID);
 
     // Kick off the connection non-blockingly. The state machine in
     // processWiFiRequests() will observe completion (or timeout) from loop()
     // and handle the success/failure paths uniformly with web-initiated connects.
-    WiFi.mode(WIFI_AP_STA);
-    WiFi.setTxPower(WIFI_TX_POWER);  // Mode change can reset TX power
-    WiFi.begin(_state.staSSID.c_str(), _state.staPassword.c_str());
+    WiFi.mode(_state.headless ? WIFI_STA : WIFI_AP_STA);
+    WiFi.setTxPower(_txPower);  // Mode change can reset TX power
+    // In multi-AP venues, join the strongest BSSID rather than the first one found
+    WiFi.setScanMethod(WIFI_ALL_CHANNEL_SCAN);
+    WiFi.setSortMethod(WIFI_CONNECT_AP_BY_SIGNAL);
+    WiFi.begin(_state.staSSID, _state.staPassword);
 
     _state.connectResult = WIFI_CONN_CONNECTING;
     _state.connectStartTime = millis();
 }
 
 void WiFiManager::loop() {
-    // Process DNS requests (only when AP is active)
-    if (_state.apActive) {
-        _dnsServer.processNextRequest();
-    }
-
     // Handle deferred connect/disconnect requests from async HTTP handlers
     processWiFiRequests();
 
+    // Background scan: refresh on portal request, paused while connecting
+    if (_state.scanRequested) {
+        _state.scanRequested = false;
+        _scanner.requestSweep();
+    }
+    _scanner.loop(_state.connectResult != WIFI_CONN_CONNECTING);
+
+    // Between-scenes AP channel re-selection, once its sweep has finished
+    if (_state.apChannelReselect && !_scanner.isSweeping()) {
+        _state.apChannelReselect = false;
+        if (_state.apActive && !_state.staConnected && WiFi.softAPgetStationNum() == 0) {
+            int score;
+            uint8_t best = bestAPChannel(score);
+            int current = _scanner.channelScore(_state.apChannel, _config.apSSID);
+            _state.apChannelReason = "auto";
+            if (best != _state.apChannel && score * 100 < current * AP_CHANNEL_SWITCH_PERCENT) {
+                LOG_INFO("Moving AP from channel %u (score %d) to %u (score %d)",
+                    _state.apChannel, current, best, score);
+                _state.apChannel = best;
+                _state.apChannelScore = score;
+                setupAccessPoint();
+            } else {
+                _state.apChannelScore = current;
+            }
+        }
+    }
+
     // Update connection status
     updateConnectionStatus();
 
+    // Push connect progress to socket clients instead of having them poll
+    if (_state.connectResult != _lastPushedConnectResult) {
+        _lastPushedConnectResult = _state.connectResult;
+        _control.push("constatus", getConnectStatusJson());
+    }
+    _control.loop();
+
+    // Watch link quality and move to a stronger AP before the link drops
+    updateRoaming();
+
     // Check if it's time to shut down the AP.
     // Use signed-difference comparison so this stays correct across millis() rollover (~49 days).
     if (_state.apShutdownTime > 0 && (int32_t)(millis() - _state.apShutdownTime) > 0 && _state.staConnected) {
-        Serial.println("Shutting down AP, switching to STA-only with modem sleep");
+        LOG_INFO("Shutting down AP, switching to STA-only with modem sleep");
         _dnsServer.stop();
         WiFi.softAPdisconnect(true);
         WiFi.mode(WIFI_STA);
-        WiFi.setTxPower(WIFI_TX_POWER);
-        esp_wifi_set_ps(WIFI_PS_MIN_MODEM);
+        WiFi.setTxPower(_txPower);
+        esp_wifi_set_ps(_staOnlyPowerSave);
         _state.apActive = false;
         _state.apShutdownTime = 0;
-        Serial.printf("Now in STA-only mode, IP: %s\n", WiFi.localIP().toString().c_str());
+        IPAddress ip = WiFi.localIP();
+        LOG_INFO("Now in STA-only mode, IP: %u.%u.%u.%u", ip[0], ip[1], ip[2], ip[3]);
     }
 }
 
@@ -371,10 +595,10 @@ void WiFiManager::processWiFiRequests() {
     // connect state machine by feeding it the saved credentials.
     if (_state.reconnectRequested) {
         _state.reconnectRequested = false;
-        if (_state.staEnabled && _state.staSSID.length() > 0) {
-            Serial.printf("Processing /reconnect to %s\n", _state.staSSID.c_str());
-            _state.pendingSSID = _state.staSSID;
-            _state.pendingPassword = _state.staPassword;
+        if (_state.staEnabled && _state.staSSID[0]) {
+            LOG_INFO_TEXT(_state.staSSID, "Processing /reconnect to %s");
+            strlcpy(_state.pendingSSID, _state.staSSID, sizeof(_state.pendingSSID));
+            strlcpy(_state.pendingPassword, _state.staPassword, sizeof(_state.pendingPassword));
             _state.connectRequested = true;
         }
     }
@@ -385,7 +609,7 @@ void WiFiManager::processWiFiRequests() {
     if (_state.apOffRequested) {
         _state.apOffRequested = false;
         if (_state.staConnected && _state.apActive) {
-            Serial.println("Processing /staonly — scheduling immediate AP shutdown");
+            LOG_INFO("Processing /staonly — scheduling immediate AP shutdown");
             // 500 ms grace so the HTTP response gets out cleanly
             _state.apShutdownTime = millis() + 500;
         }
@@ -394,7 +618,7 @@ void WiFiManager::processWiFiRequests() {
     // Handle a pending disconnect request from /disconnect
     if (_state.disconnectRequested) {
         _state.disconnectRequested = false;
-        Serial.println("Processing deferred disconnect request");
+        LOG_INFO("Processing deferred disconnect request");
 
         _preferences.begin("wifi", false);
         _preferences.putBool("enabled", false);
@@ -411,20 +635,20 @@ void WiFiManager::processWiFiRequests() {
         if (!_state.apActive) {
             _state.apActive = true;
             setupAccessPoint();
-            _dnsServer.start(53, "*", WiFi.softAPIP());
+            _dnsServer.start(WiFi.softAPIP());
         }
 
         _state.broadcastIP = IPAddress(192, 168, 4, 255);
-        Serial.println("Disconnected from WiFi, AP only mode");
+        LOG_INFO("Disconnected from WiFi, AP only mode");
     }
 
     // Handle a pending connect request from /connect
     if (_state.connectRequested) {
         _state.connectRequested = false;
-        Serial.printf("Processing deferred connect request to %s\n", _state.pendingSSID.c_str());
+        LOG_INFO_TEXT(_state.pendingSSID, "Processing deferred connect request to %s");
 
-        _state.staSSID = _state.pendingSSID;
-        _state.staPassword = _state.pendingPassword;
+        strlcpy(_state.staSSID, _state.pendingSSID, sizeof(_state.staSSID));
+        strlcpy(_state.staPassword, _state.pendingPassword, sizeof(_state.staPassword));
         _state.staEnabled = true;
 
         // Save credentials
@@ -436,9 +660,11 @@ void WiFiManager::processWiFiRequests() {
 
         // Kick off connection (non-blocking — status polled below)
         WiFi.mode(WIFI_AP_STA);
-        WiFi.setTxPower(WIFI_TX_POWER);
+        WiFi.setTxPower(_txPower);
+        WiFi.setScanMethod(WIFI_ALL_CHANNEL_SCAN);
+        WiFi.setSortMethod(WIFI_CONNECT_AP_BY_SIGNAL);
         WiFi.disconnect();
-        WiFi.begin(_state.staSSID.c_str(), _state.staPassword.c_str());
+        WiFi.begin(_state.staSSID, _state.staPassword);
 
         _state.connectResult = WIFI_CONN_CONNECTING;
         _state.connectStartTime = millis();
@@ -449,29 +675,61 @@ void WiFiManager::processWiFiRequests() {
         if (WiFi.status() == WL_CONNECTED) {
             _state.staConnected = true;
             _state.broadcastIP = WiFi.broadcastIP();  // honors actual subnet mask
-            _state.apShutdownTime = millis() + 600000;  // Shut down AP in 10 minutes
             _state.connectResult = WIFI_CONN_SUCCESS;
+            IPAddress ip = WiFi.localIP();
+            LOG_INFO_TEXT(_state.staSSID, "Connected to %s, IP: %u.%u.%u.%u", ip[0], ip[1], ip[2], ip[3]);
+            followSTAChannel();
+
+            if (_state.headless) {
+                // No AP to keep awake for: modem sleep from the start
+                esp_wifi_set_ps(_staOnlyPowerSave);
+                return;
+            }
+
+            _state.apShutdownTime = millis() + 600000;  // Shut down AP in 10 minutes
 
-            // Tear down any previous mDNS instance before re-registering
-            // (some ESPmDNS versions silently fail a second begin() otherwise)
-            MDNS.end();
-            if (MDNS.begin("osc-muis")) {
-                MDNS.addService("http", "tcp", 80);
-                Serial.println("mDNS started: http://osc-muis.local");
+            if (startMDNS()) {
+                LOG_INFO("mDNS started: http://%s.local", _hostname);
             }
-            Serial.printf("Connected to %s, IP: %s\n",
-                _state.staSSID.c_str(), WiFi.localIP().toString().c_str());
-            Serial.println("AP will shut down in 10 minutes");
+            LOG_INFO("AP will shut down in 10 minutes");
         } else if (millis() - _state.connectStartTime > 10000) {
             _state.staConnected = false;
             _state.connectResult = WIFI_CONN_FAILED;
-            WiFi.mode(WIFI_AP);
-            Serial.println("Deferred connection attempt failed (timeout)");
+            // Headless has no AP to fall back to; the driver keeps retrying
+            // and updateConnectionStatus() picks the link up when it's back
+            if (!_state.headless) WiFi.mode(WIFI_AP);
+            LOG_WARN("Deferred connection attempt failed (timeout)");
         }
     }
 }
 
+bool WiFiManager::startMDNS() {
+    // Tear down any previous mDNS instance before re-registering
+    // (some ESPmDNS versions silently fail a second begin() otherwise)
+    MDNS.end();
+    if (!MDNS.begin(_hostname)) return false;
+    MDNS.addService("http", "tcp", 80);
+    for (int i = 0; i < _mdnsServiceCount; i++) {
+        MDNS.addService(_mdnsServices[i].service, _mdnsServices[i].proto, _mdnsServices[i].port);
+    }
+    return true;
+}
+
 void WiFiManager::updateConnectionStatus() {
+    // A roam deliberately drops the link for a moment; don't treat that as a
+    // lost connection unless it doesn't come back in time.
+    if (_state.roaming) {
+        if (WiFi.status() == WL_CONNECTED) {
+            finishRoam(true);
+        } else if (millis() - _state.connectStartTime > WIFI_ROAM_TIMEOUT_MS) {
+            finishRoam(false);
+            // Fall through: staConnected is still true, so the loss path below
+            // brings the AP back and reconnects to the saved network.
+        } else {
+            return;
+        }
+    }
+
     if (_state.staEnabled && !_state.staConnected && WiFi.status() == WL_CONNECTED) {
         _state.staConnected = true;
         _state.broadcastIP = WiFi.broadcastIP();  // honors actual subnet mask
@@ -479,42 +737,134 @@ void WiFiManager::updateConnectionStatus() {
         // after a reconnect (since it was zeroed when AP shut down or on disconnect).
         if (_state.apActive) {
             _state.apShutdownTime = millis() + 600000;
-            Serial.println("AP shutdown re-armed for 10 minutes");
+            LOG_INFO("AP shutdown re-armed for 10 minutes");
+        }
+        telemetry.noteWiFiUp();
+        IPAddress ip = WiFi.localIP();
+        LOG_INFO("WiFi reconnected, IP: %u.%u.%u.%u", ip[0], ip[1], ip[2], ip[3]);
+        followSTAChannel();
+        if (_state.headless) {
+            esp_wifi_set_ps(_staOnlyPowerSave);
+            return;
         }
-        Serial.printf("WiFi reconnected, IP: %s\n", WiFi.localIP().toString().c_str());
 
-        // Tear down any previous mDNS instance before re-registering
-        MDNS.end();
-        if (MDNS.begin("osc-muis")) {
-            MDNS.addService("http", "tcp", 80);
-            Serial.println("mDNS restarted: http://osc-muis.local");
+        if (startMDNS()) {
+            LOG_INFO("mDNS restarted: http://%s.local", _hostname);
         }
     } else if (_state.staConnected && WiFi.status() != WL_CONNECTED) {
         _state.staConnected = false;
         _state.broadcastIP = IPAddress(192, 168, 4, 255);
-        Serial.println("WiFi connection lost, using AP broadcast");
-
-        // If AP was shut down, bring it back and try to reconnect STA
-        if (!_state.apActive) {
-            Serial.println("Re-enabling AP and attempting STA reconnect");
+        telemetry.noteWiFiDown();
+        LOG_WARN(_state.headless ? "WiFi connection lost (headless, no AP fallback)"
+                                 : "WiFi connection lost, using AP broadcast");
+
+        // If AP was shut down, bring it back and try to reconnect STA.
+        // Not in headless mode: the portal comes back via the button gesture.
+        if (!_state.apActive && !_state.headless) {
+            LOG_INFO("Re-enabling AP and attempting STA reconnect");
             esp_wifi_set_ps(WIFI_PS_NONE);
             WiFi.mode(WIFI_AP_STA);
             delay(100);
             setupAccessPoint();
-            _dnsServer.start(53, "*", WiFi.softAPIP());
+            _dnsServer.start(WiFi.softAPIP());
             _state.apActive = true;
         }
 
         // Try to reconnect to saved network
-        if (_state.staEnabled && _state.staSSID.length() > 0) {
-            Serial.printf("Reconnecting to %s...\n", _state.staSSID.c_str());
-            WiFi.begin(_state.staSSID.c_str(), _state.staPassword.c_str());
+        if (_state.staEnabled && _state.staSSID[0]) {
+            LOG_INFO_TEXT(_state.staSSID, "Reconnecting to %s...");
+            WiFi.begin(_state.staSSID, _state.staPassword);
             _state.connectResult = WIFI_CONN_CONNECTING;
             _state.connectStartTime = millis();
         }
     }
 }
 
+void WiFiManager::updateRoaming() {
+    if (!_state.staConnected || _state.roaming || _state.connectResult == WIFI_CONN_CONNECTING) {
+        _state.rssiAvg = 0;
+        return;
+    }
+    if (millis() - _state.lastRssiCheck < WIFI_ROAM_CHECK_MS) return;
+    _state.lastRssiCheck = millis();
+
+    int rssi = WiFi.RSSI();
+    if (rssi == 0) return;  // no reading
+    // EMA (alpha = 0.5): rides out single fades while still reacting in a few seconds
+    _state.rssiAvg = (_state.rssiAvg == 0) ? rssi : (_state.rssiAvg + rssi) / 2;
+
+    if (_state.rssiAvg > WIFI_ROAM_TRIGGER_RSSI) return;
+
+    // Weak link: keep the candidate list fresh in the background
+    _scanner.requestSweep();
+
+    // Pick the strongest other BSSID of our SSID from the last sweeps
+    const uint8_t* current = WiFi.BSSID();
+    const WiFiScanEntry* best = nullptr;
+    for (int i = 0; i < _scanner.getCount(); i++) {
+        const WiFiScanEntry& e = _scanner.getEntry(i);
+        if (strcmp(_state.staSSID, e.ssid) != 0) continue;
+        if (current && memcmp(e.bssid, current, 6) == 0) continue;
+        best = &e;  // cache is sorted strongest first
+        break;
+    }
+    if (!best || best->rssi < _state.rssiAvg + WIFI_ROAM_HYSTERESIS_DB) return;
+
+    LOG_INFO("Roaming: %d dBm -> ..:%02X:%02X:%02X ch%u at %d dBm",
+        _state.rssiAvg, best->bssid[3], best->bssid[4], best->bssid[5], best->channel, best->rssi);
+
+    WiFiRoamRecord& rec = _state.roamHistory[_state.roamCount % WIFI_ROAM_HISTORY];
+    rec.at = millis();
+    rec.outageMs = 0;
+    rec.fromRssi = _state.rssiAvg;
+    rec.toRssi = best->rssi;
+    rec.channel = best->channel;
+    rec.success = false;
+
+    _state.roaming = true;
+    _state.connectStartTime = millis();
+    telemetry.noteWiFiDown();
+    // Known channel + BSSID: the driver skips the full scan and associates directly
+    WiFi.begin(_state.staSSID, _state.staPassword, best->channel, best->bssid);
+}
+
+void WiFiManager::finishRoam(bool success) {
+    WiFiRoamRecord& rec = _state.roamHistory[_state.roamCount % WIFI_ROAM_HISTORY];
+    rec.outageMs = millis() - rec.at;
+    rec.success = success;
+    _state.roamCount++;
+    _state.roaming = false;
+    _state.rssiAvg = 0;
+
+    if (success) {
+        telemetry.noteWiFiUp();  // A failed roam stays down until the reconnect
+        _state.broadcastIP = WiFi.broadcastIP();
+        followSTAChannel();
+        LOG_INFO("Roam complete in %lu ms, RSSI now %d dBm", rec.outageMs, WiFi.RSSI());
+    } else {
+        LOG_WARN("Roam failed after %lu ms", rec.outageMs);
+    }
+}
+
+String WiFiManager::getRoamHistoryJson() const {
+    String json = "{\"count\":" + String(_state.roamCount) + ",\"roams\":[";
+    int n = _state.roamCount < WIFI_ROAM_HISTORY ? _state.roamCount : WIFI_ROAM_HISTORY;
+    for (int i = 0; i < n; i++) {
+        const WiFiRoamRecord& r = _state.roamHistory[(_state.roamCount - 1 - i) % WIFI_ROAM_HISTORY];
+        if (i > 0) json += ",";
+        json += "{\"agoS\":" + String((millis() - r.at) / 1000);
+        json += ",\"outageMs\":" + String(r.outageMs);
+        json += ",\"fromRssi\":" + String(r.fromRssi);
+        json += ",\"toRssi\":" + String(r.toRssi);
+        json += ",\"channel\":" + String(r.channel);
+        json += ",\"success\":";
+        json += r.success ? "true" : "false";
+        json += "}";
+    }
+    json += "]}";
+    return json;
+}
+
 IPAddress WiFiManager::getBroadcastIP() const {
     return _state.broadcastIP;
 }
@@ -539,6 +889,18 @@ IPAddress WiFiManager::getSTAIP() const {
     return WiFi.localIP();
 }
 
+const char* WiFiManager::getDeviceName() const {
+    return _deviceName;
+}
+
+const char* WiFiManager::getDeviceId() const {
+    return _deviceId;
+}
+
+const char* WiFiManager::getHostname() const {
+    return _hostname;
+}
+
 void WiFiManager::setBatteryPercent(int percent) {
     _state.batteryPercent = percent;
 }
@@ -552,33 +914,63 @@ const WiFiManagerState& WiFiManager::getState() const {
 }
 
 void WiFiManager::registerTemplateCallback(TemplateProcessorCallback callback) {
-    _customProcessorCallback = callback;
+    for (int i = 0; i < MAX_TEMPLATE_CALLBACKS; i++) {
+        if (!_customProcessorCallbacks[i]) {
+            _customProcessorCallbacks[i] = callback;
+            return;
+        }
+    }
+    Serial.println("WARNING: too many template callbacks, ignoring");
+}
+
+void WiFiManager::setRadioProfile(wifi_power_t txPower, wifi_ps_type_t staOnlyPowerSave) {
+    _txPower = txPower;
+    _staOnlyPowerSave = staOnlyPowerSave;
+
+    if (WiFi.getMode() != WIFI_OFF) {
+        WiFi.setTxPower(_txPower);
+    }
+    // Modem sleep only applies once the AP is down; with the AP up the radio
+    // has to stay awake for its clients and the setting is re-applied on shutdown.
+    if (!_state.apActive && _state.staConnected) {
+        esp_wifi_set_ps(_staOnlyPowerSave);
+    }
 }
 
 AsyncWebServer& WiFiManager::getWebServer() {
     return _webServer;
 }
 
-std::vector<IPAddress> WiFiManager::getBroadcastIPAddresses() const {
-    std::vector<IPAddress> addresses;
+ControlChannel& WiFiManager::getControlChannel() {
+    return _control;
+}
 
-    // Get all active network broadcast addresses
-    wifi_mode_t mode = WiFi.getMode();
+AdmissionControl& WiFiManager::getAdmission() {
+    return _admission;
+}
 
-    // Add STA network broadcast if connected (honors actual subnet mask, not just /24)
-    if ((mode == WIFI_AP_STA || mode == WIFI_STA) && _state.staConnected) {
-        addresses.push_back(WiFi.broadcastIP());
+void WiFiManager::addMDNSService(const char* service, const char* proto, uint16_t port) {
+    if (_mdnsServiceCount >= WIFI_MDNS_MAX_SERVICES) {
+        Serial.printf("WARNING: no room for mDNS service %s\n", service);
+        return;
     }
+    _mdnsServices[_mdnsServiceCount].service = service;
+    _mdnsServices[_mdnsServiceCount].proto = proto;
+    _mdnsServices[_mdnsServiceCount].port = port;
+    _mdnsServiceCount++;
+}
 
-    // Add AP network broadcast if AP is active
-    if (mode == WIFI_AP_STA || mode == WIFI_AP) {
-        addresses.push_back(IPAddress(192, 168, 4, 255));
-    }
+void WiFiManager::setHeadless(bool headless) {
+    _preferences.begin("wifi", false);
+    _preferences.putBool("headless", headless);
+    _preferences.end();
+    Serial.printf("Headless mode %s (takes effect after reboot)\n", headless ? "on" : "off");
+}
 
-    // Fallback to AP broadcast if no networks are available
-    if (addresses.empty()) {
-        addresses.push_back(IPAddress(192, 168, 4, 255));
-    }
+bool WiFiManager::isHeadless() const {
+    return _state.headless;
+}
 
-    return addresses;
+const WiFiScanner& WiFiManager::getScanner() const {
+    return _scanner;
 }
@@ -5,10 +5,12 @@
 
 #include <Arduino.h>
 #include <WiFi.h>
-#include <DNSServer.h>
 #include <ESPAsyncWebServer.h>
 #include <Preferences.h>
-#include <vector>
+#include "wifi_scanner.h"
+#include "captive_dns.h"
+#include "control_channel.h"
+#include "admission_control.h"
 
 // Callback type for custom template variable processing
 // Return non-empty string if variable is handled, empty string otherwise
@@ -18,11 +20,12 @@ typedef String (*TemplateProcessorCallback)(const String& var);
 struct WiFiManagerConfig {
     const char* apSSID;
     const char* apPassword;      // Min 8 chars, or empty for open network
-    uint8_t apChannel;           // WiFi channel (1-13)
+    uint8_t apChannel;           // WiFi channel (1-13), or 0 = choose automatically
     const char* countryCode;     // Country code for WiFi regulations (e.g., "NL", "US")
     const char* portalTitle;     // Title shown in captive portal
     const char* portalSubtitle;  // Subtitle shown in captive portal
     int displayPort;             // Port number to display in portal (e.g., OSC port)
+    bool appendDeviceId;         // Suffix the AP name and mDNS host with the device ID (fleets)
 };
 
 // Connection attempt state (for non-blocking /connect handling)
@@ -33,28 +36,69 @@ enum WiFiConnectResult {
     WIFI_CONN_FAILED
 };
 
-// Runtime state of the WiFi manager
+// Roaming: move to a stronger BSSID of the same SSID before the link drops
+#define WIFI_ROAM_CHECK_MS 2000          // RSSI sampling period
+#define WIFI_ROAM_TRIGGER_RSSI (-70)     // Below this (smoothed) we look for a better AP
+#define WIFI_ROAM_HYSTERESIS_DB 8        // Candidate must beat the current link by this much
+#define WIFI_ROAM_TIMEOUT_MS 5000        // Give up on a roam and fall back to normal reconnect
+#define WIFI_ROAM_HISTORY 8              // Roam records kept for the portal
+
+// One completed (or failed) roam attempt
+struct WiFiRoamRecord {
+    unsigned long at;            // millis() when the roam started
+    unsigned long outageMs;      // Time without a usable link
+    int8_t fromRssi;
+    int8_t toRssi;               // Candidate RSSI from the scan
+    uint8_t channel;             // Channel of the new BSSID
+    bool success;
+};
+
+// Extra mDNS services advertised next to http (see addMDNSService)
+#define WIFI_MDNS_MAX_SERVICES 2
+
+// Credential buffers (802.11 limits plus terminator)
+#define WIFI_SSID_MAX 33
+#define WIFI_PASSWORD_MAX 65
+
+// Device ID: the last three bytes of the factory MAC in hex ("a1b2c3")
+#define WIFI_DEVICE_ID_MAX 7
+
+// Runtime state of the WiFi manager. Fixed-size storage only, so the state
+// never touches the heap after boot.
 struct WiFiManagerState {
-    String staSSID;
-    String staPassword;
+    char staSSID[WIFI_SSID_MAX];
+    char staPassword[WIFI_PASSWORD_MAX];
     bool staEnabled;
     bool staConnected;
+    bool headless;               // Portal stack not started this boot (see setHeadless)
     int batteryPercent;
     IPAddress broadcastIP;       // Current broadcast address
 
     // AP lifecycle
     bool apActive;               // Whether the AP is currently running
+    uint8_t apChannel;           // Channel the AP is on (chosen at boot, may change)
+    int apChannelScore;          // Congestion score of apChannel (-1 = not measured)
+    const char* apChannelReason; // "fixed", "auto", "follows STA"
+    bool apChannelReselect;      // Re-choose once the current sweep finishes
     unsigned long apShutdownTime; // millis() when AP should shut down (0 = no shutdown scheduled)
 
     // Deferred connect/disconnect requests (set from async HTTP handlers, processed in loop())
-    String pendingSSID;
-    String pendingPassword;
+    char pendingSSID[WIFI_SSID_MAX];
+    char pendingPassword[WIFI_PASSWORD_MAX];
     volatile bool connectRequested;
     volatile bool disconnectRequested;
     volatile bool reconnectRequested;   // /reconnect — retry saved network
     volatile bool apOffRequested;       // /staonly — drop AP immediately (requires STA connected)
+    volatile bool scanRequested;        // /scan — refresh the scan cache if stale
     unsigned long connectStartTime;
     WiFiConnectResult connectResult;
+
+    // Roaming
+    int rssiAvg;                 // Smoothed RSSI of the current link (0 = no sample yet)
+    unsigned long lastRssiCheck;
+    bool roaming;                // Roam in progress — link loss is expected, don't fall back to AP
+    WiFiRoamRecord roamHistory[WIFI_ROAM_HISTORY];  // Ring buffer
+    uint32_t roamCount;          // Total roams since boot (ring index = roamCount % WIFI_ROAM_HISTORY)
 };
 
 // Default configuration values
@@ -78,9 +122,6 @@ public:
     // Get current broadcast IP (updates when STA connects/disconnects)
     IPAddress getBroadcastIP() const;
 
-    // Get all broadcast IPs (AP + STA when in dual mode)
-    std::vector<IPAddress> getBroadcastIPAddresses() const;
-
     // Get AP IP address
     IPAddress getAPIP() const;
 
@@ -96,36 +137,107 @@ public:
     // Get STA IP address (if connected)
     IPAddress getSTAIP() const;
 
+    // Device name (the AP network name, e.g. "OSC-MUIS-A1B2C3")
+    const char* getDeviceName() const;
+
+    // MAC-derived ID that tells units of a fleet apart ("a1b2c3")
+    const char* getDeviceId() const;
+
+    // mDNS / DHCP host name ("osc-muis-a1b2c3")
+    const char* getHostname() const;
+
     // Set battery percentage for portal display
     void setBatteryPercent(int percent);
 
     // Get battery percentage
     int getBatteryPercent() const;
 
+    // Headless mode: after the next reboot only the STA link comes up — no AP,
+    // captive DNS, web server, control socket or mDNS, so none of their heap
+    // or CPU is spent during a show. Persisted; only honoured when a network
+    // is saved. isHeadless() reports the mode of the current boot.
+    void setHeadless(bool headless);
+    bool isHeadless() const;
+
     // Get current state (for advanced use)
     const WiFiManagerState& getState() const;
 
     // Register callback for custom template variable processing
-    // This allows other modules to provide their own template variables
+    // This allows other modules to provide their own template variables.
+    // Several modules may register; they are asked in registration order.
     void registerTemplateCallback(TemplateProcessorCallback callback);
 
+    // Radio settings used from now on (TX power, and the power-save mode
+    // applied once the AP is down). Applied immediately where relevant.
+    void setRadioProfile(wifi_power_t txPower, wifi_ps_type_t staOnlyPowerSave);
+
     // Get web server for registering additional endpoints
     AsyncWebServer& getWebServer();
 
+    // Control socket for registering actions (also registers their HTTP routes)
+    ControlChannel& getControlChannel();
+
+    // Rate limits / show lock in front of every web route and socket action
+    AdmissionControl& getAdmission();
+
+    // Background scan cache (per-BSSID, strongest first)
+    const WiFiScanner& getScanner() const;
+
+    // Roam history as JSON (most recent first)
+    String getRoamHistoryJson() const;
+
+    // Advertise another service over mDNS next to _http._tcp (e.g.
+    // "oscjson", "tcp", 80) whenever mDNS is (re)started. Strings must be
+    // literals (the pointers are kept). Call in setup.
+    void addMDNSService(const char* service, const char* proto, uint16_t port);
+
+    // Re-run automatic AP channel selection (e.g. between scenes). Only acts
+    // when the channel is automatic, the AP is up, STA is not connected and no
+    // client is on the AP — moving the AP would otherwise drop someone.
+    void reselectAPChannel();
+
 private:
     WiFiManagerConfig _config;
     WiFiManagerState _state;
 
-    DNSServer _dnsServer;
+    char _deviceId[WIFI_DEVICE_ID_MAX];
+    char _deviceName[WIFI_SSID_MAX];
+    char _hostname[WIFI_SSID_MAX];
+
+    wifi_power_t _txPower;              // Re-applied after every mode change
+    wifi_ps_type_t _staOnlyPowerSave;   // Applied when switching to STA-only
+
+    WiFiScanner _scanner;
+    CaptiveDNS _dnsServer;
     AsyncWebServer _webServer;
+    ControlChannel _control;
+    AdmissionControl _admission;
+    WiFiConnectResult _lastPushedConnectResult;
     Preferences _preferences;
 
+    struct MDNSService {
+        const char* service;
+        const char* proto;
+        uint16_t port;
+    };
+    MDNSService _mdnsServices[WIFI_MDNS_MAX_SERVICES];
+    int _mdnsServiceCount;
+
+    void initIdentity();
+    void beginHeadless();
     void setupAccessPoint();
+    void chooseAPChannel();
+    void followSTAChannel();
+    uint8_t bestAPChannel(int& score) const;
     void initCaptivePortal();
     void loadSavedWiFi();
     void connectToSavedWiFi();
+    bool startMDNS();
     void updateConnectionStatus();
+    void updateRoaming();
+    void finishRoam(bool success);
     void processWiFiRequests();
+    String getConnectStatusJson() const;
 };
 
 #endif
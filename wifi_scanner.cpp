@@ -0,0 +1,229 @@
+// OSC-Muis - Niels van der Hulst 2026
+
+#include "wifi_scanner.h"
+#include <WiFi.h>
+
+// Append s to json as a JSON string body (escapes quotes and backslashes)
+static void appendJsonEscaped(String& json, const char* s) {
+    for (; *s; s++) {
+        if (*s == '"' || *s == '\\') json += '\\';
+        json += *s;
+    }
+}
+
+WiFiScanner::WiFiScanner() {
+    _count = 0;
+    _channel = 0;
+    _scanRunning = false;
+    _sweepRequested = false;
+    _sweep = 0;
+    _nextStepAt = 0;
+    _lastSweepDone = 0;
+}
+
+void WiFiScanner::begin() {
+    WiFiScanList empty = {};
+    _published.begin(empty);
+}
+
+void WiFiScanner::requestSweep(bool force) {
+    if (_channel != 0) return;  // already sweeping
+    if (!force && _lastSweepDone != 0 && millis() - _lastSweepDone < WIFI_SCAN_STALE_MS) return;
+    _sweepRequested = true;
+}
+
+void WiFiScanner::loop(bool allowed) {
+    if (_scanRunning) {
+        int n = WiFi.scanComplete();
+        if (n == WIFI_SCAN_RUNNING) return;
+
+        _scanRunning = false;
+        if (n >= 0) {
+            mergeResults(n, _channel);
+            publish();
+        }
+        WiFi.scanDelete();
+
+        // Give the home channel some airtime before the next hop
+        _nextStepAt = millis() + WIFI_SCAN_GAP_MS;
+        if (++_channel > WIFI_SCAN_CHANNEL_COUNT) {
+            finishSweep();
+        }
+        return;
+    }
+
+    if (!allowed) return;
+
+    if (_sweepRequested && _channel == 0) {
+        _sweepRequested = false;
+        _channel = 1;
+        _nextStepAt = millis();
+    }
+
+    if (_channel != 0 && (int32_t)(millis() - _nextStepAt) >= 0) {
+        startChannel();
+    }
+}
+
+void WiFiScanner::startChannel() {
+    // scanNetworks() brings up the STA interface itself if we're AP-only;
+    // it never disconnects an existing association.
+    int16_t r = WiFi.scanNetworks(true, false, false, WIFI_SCAN_DWELL_MS, _channel);
+    if (r == WIFI_SCAN_FAILED) {
+        // Radio busy (e.g. mid-connect) — retry this channel a bit later
+        _nextStepAt = millis() + WIFI_SCAN_GAP_MS;
+        return;
+    }
+    _scanRunning = true;
+}
+
+void WiFiScanner::sweepBlocking() {
+    int n = WiFi.scanNetworks(false, false, false, WIFI_SCAN_DWELL_MS);
+    if (n > 0) mergeResults(n, 0);
+    WiFi.scanDelete();
+    finishSweep();
+}
+
+int WiFiScanner::channelScore(uint8_t channel, const char* excludeSsid) const {
+    // 20 MHz channels 5 MHz apart: neighbours up to 4 away still overlap
+    static const int OVERLAP_PERCENT[] = {100, 70, 40, 15, 5};
+
+    int score = 0;
+    for (int i = 0; i < _count; i++) {
+        const WiFiScanEntry& e = _entries[i];
+        if (excludeSsid && strcmp(e.ssid, excludeSsid) == 0) continue;
+
+        int distance = abs((int)e.channel - (int)channel);
+        if (distance > 4) continue;
+
+        // -95 dBm is at the noise floor and costs nothing extra; -45 dBm costs 50
+        int loudness = e.rssi + 95;
+        if (loudness < 0) loudness = 0;
+        score += (10 + loudness) * OVERLAP_PERCENT[distance] / 100;
+    }
+    return score;
+}
+
+void WiFiScanner::mergeResults(int n, uint8_t channel) {
+    for (int i = 0; i < n; i++) {
+        const uint8_t* bssid = WiFi.BSSID(i);
+        if (!bssid) continue;
+
+        // Update an existing entry for this BSSID, or take a free / the weakest slot
+        int slot = -1;
+        for (int j = 0; j < _count; j++) {
+            if (memcmp(_entries[j].bssid, bssid, 6) == 0) { slot = j; break; }
+        }
+        if (slot < 0) {
+            if (_count < WIFI_SCAN_MAX_RESULTS) {
+                slot = _count++;
+            } else {
+                // Cache is sorted, so the last entry is the weakest
+                if (WiFi.RSSI(i) <= _entries[_count - 1].rssi) continue;
+                slot = _count - 1;
+            }
+        }
+
+        WiFiScanEntry& e = _entries[slot];
+        String ssid = WiFi.SSID(i);
+        strncpy(e.ssid, ssid.c_str(), sizeof(e.ssid) - 1);
+        e.ssid[sizeof(e.ssid) - 1] = '\0';
+        memcpy(e.bssid, bssid, 6);
+        e.rssi = WiFi.RSSI(i);
+        e.channel = channel ? channel : WiFi.channel(i);
+        e.secure = WiFi.encryptionType(i) != WIFI_AUTH_OPEN;
+        e.lastSweep = _sweep;
+
+        // Keep sorted by RSSI (insertion step — the list is short)
+        while (slot > 0 && _entries[slot - 1].rssi < _entries[slot].rssi) {
+            WiFiScanEntry tmp = _entries[slot - 1];
+            _entries[slot - 1] = _entries[slot];
+            _entries[slot] = tmp;
+            slot--;
+        }
+        while (slot < _count - 1 && _entries[slot + 1].rssi > _entries[slot].rssi) {
+            WiFiScanEntry tmp = _entries[slot + 1];
+            _entries[slot + 1] = _entries[slot];
+            _entries[slot] = tmp;
+            slot++;
+        }
+    }
+}
+
+void WiFiScanner::finishSweep() {
+    _channel = 0;
+    _lastSweepDone = millis();
+    if (_lastSweepDone == 0) _lastSweepDone = 1;  // 0 means "never"
+
+    // Expire BSSIDs that have gone quiet (AP switched off, walked out of range)
+    int kept = 0;
+    for (int i = 0; i < _count; i++) {
+        if ((uint16_t)(_sweep - _entries[i].lastSweep) < WIFI_SCAN_EXPIRE_SWEEPS) {
+            _entries[kept++] = _entries[i];
+        }
+    }
+    _count = kept;
+    _sweep++;
+    publish();
+}
+
+void WiFiScanner::publish() {
+    _published.update([this](WiFiScanList& next) {
+        memcpy(next.entries, _entries, sizeof(next.entries));
+        next.count = _count;
+        return true;
+    });
+}
+
+bool WiFiScanner::isSweeping() const {
+    return _channel != 0 || _sweepRequested;
+}
+
+bool WiFiScanner::hasResults() const {
+    return _lastSweepDone != 0;
+}
+
+unsigned long WiFiScanner::getAge() const {
+    return _lastSweepDone == 0 ? 0 : millis() - _lastSweepDone;
+}
+
+int WiFiScanner::getCount() const {
+    return _count;
+}
+
+const WiFiScanEntry& WiFiScanner::getEntry(int index) const {
+    return _entries[index];
+}
+
+String WiFiScanner::toJson() const {
+    WiFiScanList list;
+    _published.read(list);
+
+    String json = "{\"age\":";
+    json += String(getAge() / 1000);
+    json += ",\"scanning\":";
+    json += isSweeping() ? "true" : "false";
+    json += ",\"networks\":[";
+
+    bool first = true;
+    for (int i = 0; i < list.count; i++) {
+        const WiFiScanEntry& e = list.entries[i];
+        if (e.ssid[0] == '\0') continue;  // hidden network
+
+        // Sorted strongest first, so the first BSSID per SSID is the one to show
+        bool seen = false;
+        for (int j = 0; j < i; j++) {
+            if (strcmp(list.entries[j].ssid, e.ssid) == 0) { seen = true; break; }
+        }
+        if (seen) continue;
+
+        if (!first) json += ",";
+        first = false;
+        json += "{\"ssid\":\"";
+        appendJsonEscaped(json, e.ssid);
+        json += "\",\"rssi\":" + String(e.rssi);
+        json += ",\"secure\":" + String(e.secure ? 1 : 0) + "}";
+    }
+    json += "]}";
+    return json;
+}
@@ -0,0 +1,101 @@
+// OSC-Muis - Niels van der Hulst 2026
+
+#ifndef WIFI_SCANNER_H
+#define WIFI_SCANNER_H
+
+#include <Arduino.h>
+#include "config_snapshot.h"
+
+#define WIFI_SCAN_MAX_RESULTS 24      // Distinct BSSIDs kept in the cache
+#define WIFI_SCAN_CHANNEL_COUNT 13    // Channels swept (EU / NL regulatory domain)
+#define WIFI_SCAN_DWELL_MS 60         // Active dwell per channel
+#define WIFI_SCAN_GAP_MS 150          // Back on the home channel between channels
+#define WIFI_SCAN_STALE_MS 30000      // Cache older than this is refreshed on request
+#define WIFI_SCAN_EXPIRE_SWEEPS 3     // Drop BSSIDs not seen for this many sweeps
+
+// One BSS seen during a sweep
+struct WiFiScanEntry {
+    char ssid[33];
+    uint8_t bssid[6];
+    int8_t rssi;
+    uint8_t channel;
+    bool secure;
+    uint16_t lastSweep;               // Sweep number it was last seen in
+};
+
+// The cache as the portal sees it, published by the loop task
+struct WiFiScanList {
+    WiFiScanEntry entries[WIFI_SCAN_MAX_RESULTS];
+    int count;
+};
+
+// Background WiFi scanner that never tears down the STA association.
+//
+// Instead of one long all-channel scan (which parks the radio off-channel for
+// ~2 s and used to require WiFi.disconnect()), it scans one channel at a time
+// with a short dwell and returns to the home channel between channels, so
+// OSC and portal traffic keep flowing during a sweep. Results are merged into
+// a per-BSSID cache sorted by RSSI, which the portal is served from instantly.
+//
+// Everything but toJson() runs on the loop task. The cache is re-sorted and
+// compacted in place while sweeping, so the /scan handler (AsyncTCP task,
+// which preempts loop()) reads a copy published after each merge instead.
+class WiFiScanner {
+public:
+    WiFiScanner();
+
+    // Publish the empty cache (call once, before the web server starts)
+    void begin();
+
+    // Ask for a fresh sweep (ignored while one is running).
+    // force = false only sweeps if the cache is older than WIFI_SCAN_STALE_MS.
+    void requestSweep(bool force = false);
+
+    // Advance the sweep. allowed = false pauses it (e.g. while a STA connect
+    // is in progress — scanning would disturb the association).
+    void loop(bool allowed);
+
+    bool isSweeping() const;
+    bool hasResults() const;
+
+    // ms since the last completed sweep (0 if none yet)
+    unsigned long getAge() const;
+
+    // Per-BSSID cache, strongest first
+    int getCount() const;
+    const WiFiScanEntry& getEntry(int index) const;
+
+    // Blocking all-channel scan straight into the cache (~1 s). Only for
+    // boot, before the AP is up and nothing else is using the radio.
+    void sweepBlocking();
+
+    // Congestion score for a channel: every BSS on or overlapping the channel
+    // adds a base cost (BSS count) plus a cost for how loud it is, weighted
+    // by spectral overlap. Lower is better. BSSes named excludeSsid (our own
+    // AP) are ignored.
+    int channelScore(uint8_t channel, const char* excludeSsid) const;
+
+    // Portal JSON: {"age":s,"scanning":bool,"networks":[...]} deduplicated by
+    // SSID (strongest BSSID wins), sorted by RSSI. Safe from any task: built
+    // from the published copy.
+    String toJson() const;
+
+private:
+    WiFiScanEntry _entries[WIFI_SCAN_MAX_RESULTS];
+    int _count;
+    ConfigSnapshot<WiFiScanList> _published;
+
+    uint8_t _channel;                 // Channel being scanned (0 = idle)
+    bool _scanRunning;                // Async scan of _channel in flight
+    bool _sweepRequested;
+    uint16_t _sweep;                  // Completed sweep counter
+    unsigned long _nextStepAt;
+    unsigned long _lastSweepDone;
+
+    void startChannel();
+    void mergeResults(int n, uint8_t channel);
+    void finishSweep();
+    void publish();
+};
+
+#endif